@@ -17,6 +17,58 @@ clear && printf '\e[3J'
 rm -f doubt_test
 rm -rf doubt_test.dSYM
 
+# if --release is passed, build an optimised ./doubt instead: no sanitizers, and with
+# RELEASE defined the require_* checks, debug logging and allocation tracking compile out
+if [ "$1" == "--release" ]; then
+    RELEASE_FLAGS=(
+        -Wall -Wextra -Wpedantic -Werror
+        -Wno-unused-parameter -Wno-extra-semi
+        -fcolor-diagnostics
+        -g -O2
+        -std=c23
+        -DRELEASE
+        -DCOMPILING
+        -o doubt
+        doubt.c
+    )
+
+    echo "Compiling the release build..."
+    if clang "${RELEASE_FLAGS[@]}"; then
+        echo "Compilation succeeded: ./doubt"
+        exit 0
+    else
+        error_exit "Compilation failed."
+    fi
+fi
+
+# if --bench is passed, build the release flags with BENCH defined as ./doubt_bench and run the
+# microbenchmarks: results go to bench.json, tagged with the commit, and any further arguments
+# go to the benchmarks, eg., ./compile.sh --bench --compare bench.before.json
+if [ "$1" == "--bench" ]; then
+    BENCH_COMMIT="$(git rev-parse --short HEAD 2>/dev/null || echo unknown)"
+    BENCH_FLAGS=(
+        -Wall -Wextra -Wpedantic -Werror
+        -Wno-unused-parameter -Wno-extra-semi
+        -fcolor-diagnostics
+        -g -O2
+        -std=c23
+        -DRELEASE
+        -DBENCH
+        "-DBENCH_COMMIT=\"${BENCH_COMMIT}\""
+        -DCOMPILING
+        -o doubt_bench
+        doubt.c
+    )
+
+    echo "Compiling the benchmarks..."
+    if clang "${BENCH_FLAGS[@]}"; then
+        ./doubt_bench --out bench.json "${@:2}"
+        exit $?
+    else
+        error_exit "Compilation failed."
+    fi
+fi
+
 # if --tidy is passed, skip clang-tidy checks
 if [ "$1" == "--tidy" ]; then
     # Define clang-tidy checks (adjust as needed)
@@ -79,7 +79,7 @@ constexpr char __glo_example1[] =
 "        sigma = sample(gamma(1, 1))\n"
 "    in\n"
 "        log(\"x =\", f(10, m, c))\n"
-"        observe(normal(f(10, m, c), sigma));\n"
+"        observe(normal(f(10, m, c), sigma), 30.0)\n"
 "        return [m, c, sigma]\n";
 
 
@@ -127,14 +127,17 @@ constexpr char __glo_example1[] =
 
 #define ARRAY_SIZE_SMALL 16
 
-// #ifdef TEST
+/// @note a RELEASE build (cf. `compile.sh --release`) compiles out the checks, the debug
+///     ... logging and the allocator bookkeeping below
+#ifndef RELEASE
     #define DEBUG_LOGGING_ON
     #define DEBUG_ABORT_ON_ASSERT
     #define DEBUG_ABORT_ON_ERROR
     #define DEBUG_REQUIRE_ASSERTS
+    #define DEBUG_MEMORY
+    #define ARRAY_REQUIRE_CHECKS
     #define TRACEBACK_ABORT_ON_OVERFLOW
-    // #define DEBUG_MEMORY
-// #endif
+#endif
 
 #pragma endregion
 
@@ -143,6 +146,7 @@ constexpr char __glo_example1[] =
 #include <stdlib.h>
 #include <stdio.h>
 #include <stdint.h>
+#include <stddef.h>
 #include <string.h>
 #include <assert.h>
 #include <stdbool.h>
@@ -156,7 +160,12 @@ constexpr char __glo_example1[] =
 #include <float.h>
 #include <stdarg.h>
 #include <pthread.h>
+#include <sched.h>
+#include <stdatomic.h>
+#include <setjmp.h>
 #include <unistd.h> /// @note include `sleep`
+#include <signal.h>
+#include <sys/time.h> /// @note include `setitimer`
 
 #ifdef _WIN32
     /// @note Windows specific includes
@@ -175,6 +184,13 @@ constexpr char __glo_example1[] =
     #include <string.h>
 #endif
 
+#ifndef _WIN32
+    /// @note in-use: mmap (dataframe ingestion)
+    #include <fcntl.h>
+    #include <sys/mman.h>
+    #include <sys/stat.h>
+#endif
+
 #pragma endregion
 
 #pragma region cLibSafeReplacements
@@ -248,15 +264,14 @@ int clib_memset_zero_safe(void *dest, size_t dest_size, size_t count) {
 
 int clib_vsnprintf_safe(char *buffer, size_t size, const char *format, va_list args) {
     // Check for nullptr pointers
-    if (buffer == nullptr || format == nullptr) {
+    if (format == nullptr || (buffer == nullptr && size > 0)) {
         errno = EINVAL; // Invalid argument
         return -1;
     }
 
-    // Ensure that size is greater than zero to hold at least the nullptr terminator
-    if (size == 0) {
-        errno = ERANGE; // Range error
-        return -1;
+    /// @note (nullptr, 0) measures the formatted length, as FixStr_fmt_va_new relies on
+    if (buffer == nullptr) {
+        return vsnprintf(nullptr, 0, format, args); // NOLINT
     }
 
     #pragma clang diagnostic push
@@ -459,15 +474,16 @@ int clib_memcpy_safe(void *dest, size_t dest_size, const void *src, size_t count
 #pragma region GlobalContextMacroH
 
 #define ctx() __glo_GlobalContext
+#define ctx_local() __tls_InterpContext
 #define ctx_last_time() __glo_GlobalContext.debug.last_time
-#define ctx_current_arena() __glo_GlobalContext.arenas.current
-#define ctx_current_heap() __glo_GlobalContext.heaps.current
+#define ctx_current_arena() __tls_InterpContext.arenas.current
+#define ctx_current_heap() __tls_InterpContext.heaps.current
 #define ctx_change_arena(alloc_name) ctx_current_arena() = alloc_name;
 
 #define ctx_trace_me(moreinfo)\
-    Tracer_push(ctx().debug.callstack, s(__func__), moreinfo, s(__FILE__), __LINE__)
+    Tracer_push(ctx_local().debug.callstack, s(__func__), moreinfo, s(__FILE__), __LINE__)
 
-#define ctx_trace_print(depth) Tracer_print_stack(ctx().debug.callstack, depth)
+#define ctx_trace_print(depth) Tracer_print_stack(ctx_local().debug.callstack, depth)
 
 #pragma endregion
 
@@ -556,6 +572,7 @@ typedef enum MetaType {
     BXD_FIX_OBJECT = 't',
     BXD_FIX_ARRAY_VIEW = '-',
     BXD_FIX_VEC_TAGS = '#',
+    BXD_FIX_ITER = '&', /// lazy, pull-based stream (cf. FixIter)
 
 
     /// @brief NUMERIC TYPES
@@ -623,6 +640,13 @@ typedef enum MetaType {
     /// a dataframe is a collection of columns given by VEC_ types
     BXD_FLX_DATAFRAME = 'F',
 
+    /// @brief running summaries of a stream of posterior draws (cf. FlxSampleSink)
+    BXD_FLX_SAMPLE_SINK = 'Z',
+    /// @brief sequential Monte Carlo particles (cf. FlxParticles)
+    BXD_FLX_PARTICLES = 'W',
+    /// @brief a model traced into a dependency graph of its sample/observe terms (cf. FixModelGraph)
+    BXD_FIX_MODEL_GRAPH = 'N',
+
 
     /// @brief the underlying is unboxed (ie., data is stored directly in the collection)
     ///    ... the collection is boxed (ie., the payload is a ptr to the value)
@@ -959,6 +983,7 @@ FixStr bt_nameof(MetaType type) {
         [BXD_FIX_TYPE] = "type",
         [BXD_FIX_OBJECT] = "object",
         [BXD_FIX_ARRAY_VIEW] = "array_view",
+        [BXD_FIX_ITER] = "iter",
         [BXD_FIX_VEC_TAGS] = "vec_tags",
         [BXD_FIX_NUM_128BIT] = "num_128bit",
         [BXD_FIX_NUM_DOUBLE] = "num_double",
@@ -984,6 +1009,9 @@ FixStr bt_nameof(MetaType type) {
         [BXD_FLX_TENSOR] = "tensor",
         [BXD_FLX_TENSOR_DOUBLE] = "tensor_double",
         [BXD_FLX_DATAFRAME] = "dataframe",
+        [BXD_FLX_SAMPLE_SINK] = "sample_sink",
+        [BXD_FLX_PARTICLES] = "particles",
+        [BXD_FIX_MODEL_GRAPH] = "model_graph",
         [BXD_FLX_VEC_BOOL] = "vec_bool",
         [BXD_FLX_VEC_INT] = "vec_int",
         [BXD_FLX_VEC_TAGS] = "vec_tags",
@@ -991,6 +1019,9 @@ FixStr bt_nameof(MetaType type) {
         [BXD_FLX_VEC_OBJS] = "vec_objs",
     };
 
+    if((size_t) type >= sizeof(names) / sizeof(names[0]) || names[type] == nullptr) {
+        return s("unknown");
+    }
     return FixStr_from_cstr(names[type]);
 }
 
@@ -1058,14 +1089,48 @@ void Box_aro_free(Box b);
 #pragma region FixIter
 
 
+typedef struct FixIter FixIter;
+
+/// @brief Pulls the next element into *out; false once the stream is exhausted
+typedef bool (*FixIterNext)(FixIter *iter, Box *out);
+
+/// @brief A lazy stream: each pull computes one element from O(1) state
+/// @note ranges step `range_from` by `range_step`; adaptors (take/drop) pull from `iter_state`;
+///     ... fn-streams call `iter_fn` once per element; whole-body Metropolis chains keep their
+///     ... current draw in `chain_draw`. meta.size is the length when known.
 typedef struct FixIter {
-    size_t iter_index;
-    size_t iter_from;
-    size_t iter_to;
+    MetaData meta;
+    FixIterNext next;
+    size_t iter_index;  /// elements produced so far
+    size_t iter_from;   /// elements to skip from the source before the first pull
+    size_t iter_to;     /// bound on iter_index (SIZE_MAX = unbounded)
+    size_t iter_cursor; /// next index read from an array/view source
     Box iter_fn;
     Box iter_state;
+    struct FixScope *iter_scope;
+    struct FixGenFrame *gen_frame;
+    double range_from;
+    double range_step;
+    bool range_is_int;
+    Box chain_draw;          /// the state of a whole-body Metropolis chain ...
+    double chain_log_weight; /// ... and the observe() weight of the run that produced it
 } FixIter;
 
+FixIter *FixIter_range_new(double from, double to, double step);
+FixIter *FixIter_take_new(Box source, size_t count);
+FixIter *FixIter_drop_new(Box source, size_t count);
+FixIter *FixIter_fn_new(Box fn, struct FixScope *scope, size_t limit);
+bool FixIter_next(FixIter *iter, Box *out);
+FixIter *FixIter_clone(FixIter *iter);
+bool Box_is_iterable(Box source);
+bool Box_iter_next(Box source, size_t index, Box *out);
+Box Box_iter_pass(Box source);
+FixStr FixIter_to_FixStr(FixIter *iter);
+FixStr FixIter_peek_to_FixStr(FixIter *iter, size_t max);
+
+/// @note how many elements log() prints of a stream
+#define FIXITER_PRINT_MAX 10
+
 #pragma endregion
 
 #pragma region FixErrorH
@@ -1075,6 +1140,7 @@ typedef enum FixErrorType {
     BXE_NATIVE = 1,
     BXE_INTERPRETER,
     BXE_NOT_IMPLEMENTED,
+    BXE_PARSER,
 } FixErrorType;
 
 typedef struct FixError {
@@ -1103,6 +1169,9 @@ typedef struct FixArray {
 } FixArray;
 
 
+/// @brief A zero-copy window [start, end) onto a FixArray's storage
+/// @note reads go through `data` each time, so a view stays valid if its (heap) array regrows;
+///     ... a borrowed view is LIVING_PINNED until its first write copies it (copy-on-mutation)
 typedef struct FixArrayView {
     MetaData meta;
     FixArray *data;
@@ -1120,6 +1189,14 @@ Box FixArray_overwrite(FixArray *array, size_t index, Box element);
 Box FixArray_weak_unset(FixArray *array, size_t index);
 void FixArray_aro_free(FixArray *box_array);
 
+// FixArrayView functions
+FixArrayView *FixArrayView_new(FixArray *array, size_t start, size_t end);
+FixArrayView *FixArrayView_of_Box(Box sequence, size_t start, size_t end);
+bool Box_as_sequence(Box sequence, Box **out_data, size_t *out_len);
+Box FixArrayView_set(FixArrayView *view, size_t index, Box element);
+FixArray *FixArrayView_to_FixArray_new(FixArrayView *view);
+FixStr FixArrayView_to_FixStr(FixArrayView *view);
+
 
 #pragma endregion
 
@@ -1209,6 +1286,7 @@ typedef enum FixFnType {
     FN_ASYNC = 'a',
     FN_LOOP = 'l',
     FN_GENERATOR = 'g',
+    FN_MEMO = 'o',
     FN_NATIVE = 'n',
     FN_NATIVE_0 = '0',
     FN_NATIVE_1 = '1',
@@ -1230,11 +1308,138 @@ typedef struct FixFnAsync  {
     /// @todo etc.
 } FixFnAsync;
 
+#define GEN_MAX_RESUME_DEPTH 16
+
+/// @brief A `loop fn` body, checked once at definition
+/// @note `depth` is the nesting of statement-level nodes (block, let, if, loop, for, yield)
+///     ... and so the number of resume slots a running generator needs
+typedef struct FixGenCode {
+    struct Ast *body;
+    size_t depth;
+    bool has_yield;
+} FixGenCode;
+
+/// @brief The single activation record of a running generator
+/// @note locals are bound once into `locals` and every resume runs against them;
+///     ... `resume` holds one slot per statement-level node on the path to the pending
+///     ... yield, so suspending is a store into `yielded` and a return -- nothing is copied
+typedef struct FixGenFrame {
+    FixGenCode *code;
+    FixScope locals;
+    Box yielded;
+    bool finished;
+    struct FixGenResume {
+        bool active;        /// the node has been entered and not yet completed
+        bool in_body;       /// loop: the current pass has bound its elements
+        bool branch;        /// if: the branch taken on entry
+        bool has_sequence;  /// loop: some binding is a stream
+        size_t pc;          /// block: statement index; loop: pass number
+        FixArray *sources;
+    } resume[GEN_MAX_RESUME_DEPTH];
+} FixGenFrame;
+
 
 // FixFn functions
 static FixFn *FixFn_new(FixFnType type, FixStr name,
     FixDict args_defaults, FixScope enclosure, void *fnptr, void *code);
 Box FixFn_call(FixFn *ffn, FixScope scope, FixArray args);
+FixGenCode *FixGenCode_new(struct Ast *body);
+FixGenFrame *FixGenFrame_clone(FixGenFrame *frame);
+Box FixFn_interp_generator_fn(FixFn *fn, FixScope function_scope, FixArray args);
+
+/// @brief A `memo fn` body with a bounded LRU of its results, keyed on its arguments
+/// @note only calls whose arguments are all unboxed scalars are cached (Box_hash reads
+///     ... arena pointers as strings); the cache is emptied at each new inference step
+#define MEMO_CAPACITY 64
+#define MEMO_MAX_ARGS 8
+
+typedef struct FixMemoEntry {
+    size_t hash;
+    Box args[MEMO_MAX_ARGS];
+    size_t num_args;
+    Box result;
+    size_t prev;    /// recency list, most recent at `head`
+    size_t next;
+    size_t chain;   /// next entry in the same bucket
+} FixMemoEntry;
+
+typedef struct FixMemoCode {
+    struct Ast *body;
+    size_t step;            /// ctx().inference.step the entries were computed in
+    size_t num_entries;
+    size_t head;
+    size_t tail;
+    size_t num_hits;
+    size_t num_misses;
+    pthread_mutex_t lock;   /// held for lookups and inserts, not while the body runs
+    size_t buckets[MEMO_CAPACITY];
+    FixMemoEntry entries[MEMO_CAPACITY];
+} FixMemoCode;
+
+FixMemoCode *FixMemoCode_new(struct Ast *body);
+Box FixFn_interp_memo_fn(FixFn *fn, FixScope function_scope, FixArray args);
+
+/// @brief A `loop fn` model traced into a DAG of its sample, observe and deterministic
+///     ... bindings, so a change to one latent recomputes only the terms downstream of it
+/// @note nodes are in program order (a topological order); `affected` lists, per node, the
+///     ... nodes to re-evaluate when its value changes: its own prior term, the terms of its
+///     ... children, and everything reached through deterministic bindings -- the factors
+///     ... of its Markov blanket
+#define MODEL_MAX_NODES 256
+#define MODEL_MAX_EDGES 1024
+#define MODEL_ADAPT_SWEEPS 200
+#define MODEL_INITIAL_STEP 0.5
+
+typedef enum {
+    MODEL_NODE_SAMPLE,
+    MODEL_NODE_DETERMINISTIC,
+    MODEL_NODE_OBSERVE,
+} FixModelNodeKind;
+
+typedef struct FixModelNode {
+    FixModelNodeKind kind;
+    FixStr name;              /// the bound variable (empty for observe)
+    struct Ast *expression;   /// the distribution (sample, observe) or the value (deterministic)
+    struct Ast *data;         /// observe: the observed data
+    Box value;                /// sample/deterministic: the current value
+    double log_density;       /// sample/observe: the current term
+    double step;              /// sample: random-walk proposal scale
+    size_t affected_start;
+    size_t affected_end;
+} FixModelNode;
+
+typedef struct FixModelGraph {
+    MetaData meta;
+    struct FlxGraph *graph;   /// one node per FixModelNode, edges from parent to child
+    FixModelNode *nodes;
+    size_t num_nodes;
+    size_t *affected;
+    struct Ast *result;       /// the body's final expression, evaluated for each draw
+    FixScope scope;           /// current values of the bindings
+    double log_density;
+    size_t num_evaluations;   /// node evaluations so far
+    size_t num_sweeps;
+    size_t num_accepted;
+    size_t *undo_nodes;       /// the nodes a proposal changed, with their old state
+    Box *undo_values;
+    double *undo_terms;
+    size_t num_undo;
+    double undo_log_density;
+    struct FixInferModel *fit_model;  /// #VI, #MAP: the latents as fitted (cf. FixModelGraph_fit) ...
+    struct FixInferResult *fit;
+    size_t *fit_nodes;                /// ... where fitted parameter j is sample node fit_nodes[j]
+} FixModelGraph;
+
+FixModelGraph *FixModelGraph_trace(struct Ast *body, FixScope *scope);
+bool FixModelGraph_init(FixModelGraph *model);
+double FixModelGraph_update(FixModelGraph *model, size_t node, Box value);
+void FixModelGraph_revert(FixModelGraph *model);
+double FixModelGraph_recompute(FixModelGraph *model);
+bool FixModelGraph_sweep(FixModelGraph *model);
+Box FixModelGraph_result(FixModelGraph *model);
+FixStr FixModelGraph_to_FixStr(FixModelGraph *model);
+FixIter *FixIter_mcmc_new(FixModelGraph *model);
+FixIter *FixIter_metropolis_new(FixIter *model);
 Box FixFn_test_native2(FixFn *fn, FixScope parent, Box one, Box two);
 #pragma endregion
 
@@ -1349,7 +1554,10 @@ typedef enum {
     DIST_POWER_LAW,
 } FixDistType;
 
+#define DIST_MAX_INLINE_PARAMS 4
+
 typedef struct FixDist {
+    MetaData meta;
     FixDistType type;
     FixStr *param_names;
     FixStr *param_descriptions;
@@ -1358,17 +1566,127 @@ typedef struct FixDist {
     double (*sample_fn_ptr)(struct FixDist *dist);
     double (*pdf_fn_ptr)(struct FixDist *dist, double x);
     double (*log_pdf_fn_ptr)(struct FixDist *dist, double x);
+    double param_data[DIST_MAX_INLINE_PARAMS];  /// inline storage `params` points to (cf. FixDist_new)
 } FixDist;
 
+FixDist *FixDist_new(FixDistType type, const double *params, size_t num_params);
+bool FixDist_params_valid(FixDistType type, const double *params, size_t num_params);
+FixStr FixDist_to_FixStr(FixDist *dist);
+
 typedef enum {
     INFERENCE_MCMC,
     INFERENCE_VI,
     INFERENCE_MAP
 } InferMethod;
 
-typedef struct {
-    double ** samples;
-    size_t *num_samples;
+/// @brief Streaming posterior summaries: draws are folded into running statistics as they
+///     ... arrive, so memory is constant in the number of draws
+/// @note per parameter: Welford mean/variance, a merging t-digest for quantiles and exact
+///     ... autocorrelations up to SAMPLE_MAX_LAG; raw draws may also be spilled to a binary
+///     ... file (SAMPLE_SPILL_MAGIC, uint64 num_params, then one row of doubles per draw)
+#define TDIGEST_COMPRESSION 100.0
+#define TDIGEST_MAX_CENTROIDS 256
+#define TDIGEST_BUFFER_SIZE 512
+#define SAMPLE_MAX_LAG 32
+#define SAMPLE_SPILL_MAGIC "DOUBTSP1"
+#define SAMPLE_SPILL_BUFFER (1 << 20)
+
+typedef struct FixCentroid {
+    double mean;
+    double weight;
+} FixCentroid;
+
+typedef struct FixTDigest {
+    FixCentroid centroids[TDIGEST_MAX_CENTROIDS];
+    double buffer[TDIGEST_BUFFER_SIZE];  /// unmerged draws, folded in when full or queried
+    size_t num_centroids;
+    size_t num_buffered;
+    double total_weight;
+    double min;
+    double max;
+} FixTDigest;
+
+typedef struct FixSampleStats {
+    size_t count;
+    double mean;
+    double m2;
+    double shift;                             /// first draw; lag sums are of (x - shift)
+    double sum;                               /// sum of (x - shift)
+    double head[SAMPLE_MAX_LAG];              /// first draws, shifted
+    double recent[SAMPLE_MAX_LAG];            /// ring of the last draws, shifted
+    double lag_products[SAMPLE_MAX_LAG + 1];  /// sum over t of y[t] * y[t - k]
+    FixTDigest digest;
+} FixSampleStats;
+
+typedef struct FlxSampleSink {
+    MetaData meta;
+    FixSampleStats *data;  /// one per parameter
+    size_t num_params;
+    size_t num_draws;
+    FILE *spill;
+} FlxSampleSink;
+
+FlxSampleSink *FlxSampleSink_new(size_t num_params, const char *spill_path);
+bool FlxSampleSink_push(FlxSampleSink *sink, const double *draw);
+bool FlxSampleSink_push_Box(FlxSampleSink *sink, Box draw);
+bool FlxSampleSink_close(FlxSampleSink *sink);
+double FlxSampleSink_mean(FlxSampleSink *sink, size_t param);
+double FlxSampleSink_variance(FlxSampleSink *sink, size_t param);
+double FlxSampleSink_quantile(FlxSampleSink *sink, size_t param, double q);
+double FlxSampleSink_autocorrelation(FlxSampleSink *sink, size_t param, size_t lag);
+double FlxSampleSink_effective_size(FlxSampleSink *sink, size_t param);
+struct FlxMatrixF *FlxSampleSink_read_spill(const char *path);
+FixStr FlxSampleSink_to_FixStr(FlxSampleSink *sink);
+
+/// @brief Sequential Monte Carlo particle state, stored as a structure of arrays
+/// @note values are parameter-major, `data[p * num_particles + i]`, so each parameter is one
+///     ... contiguous column; weights are scanned into `cumulative` with a parallel prefix sum
+///     ... and resampled systematically (one uniform draw, N evenly spaced points)
+/// @note running the particles' model streams costs far more than a kernel step or scan,
+///     ... so pulls are split across threads from SMC_PARALLEL_MIN_PULLS particles
+#define SMC_DEFAULT_PARTICLES 1000
+#define SMC_PARALLEL_MIN_PARTICLES 4096
+#define SMC_PARALLEL_MIN_PULLS 64
+#define SMC_RESAMPLE_THRESHOLD 0.5
+
+typedef struct FlxParticles {
+    MetaData meta;
+    double *data;          /// values, parameter-major
+    double *scratch;       /// gather target, swapped with data after resampling
+    double *log_weights;
+    double *cumulative;    /// normalised prefix sums of the weights
+    size_t *ancestors;
+    Box *streams;          /// interpreted models: each particle's own model stream
+    Box *values;           /// ... and the value of its latest run
+    size_t num_particles;
+    size_t num_params;
+    size_t cursor;         /// next resampled particle handed out as a draw
+    double ess;
+    double log_evidence;   /// running estimate of the log marginal likelihood
+    double log_total;      /// log of the unnormalised weight total at the last scan
+    size_t num_steps;
+    size_t num_resamples;
+} FlxParticles;
+
+/// @brief Advances particles [start, end); runs on a compute thread, so must not allocate or log
+typedef void (*FlxParticleKernel)(FlxParticles *particles, size_t start, size_t end, void *user);
+
+FlxParticles *FlxParticles_new(size_t num_particles, size_t num_params);
+bool FlxParticles_reserve(FlxParticles *particles, size_t num_params);
+void FlxParticles_propagate(FlxParticles *particles, FlxParticleKernel kernel, void *user);
+double FlxParticles_normalise(FlxParticles *particles);
+void FlxParticles_systematic(FlxParticles *particles, double u);
+void FlxParticles_resample(FlxParticles *particles);
+FixStr FlxParticles_to_FixStr(FlxParticles *particles);
+FixIter *FixIter_smc_new(FixIter *model, size_t num_particles);
+
+typedef struct FixInferResult {
+    FlxSampleSink *sink;  /// draws are summarised on arrival, never stored per sample
+    double *location;     /// VI: the variational mean, MAP: the mode (both constrained)
+    double *scale;        /// VI: sd of each unconstrained factor, MAP: nullptr
+    double objective;     /// VI: ELBO estimate, MAP: log joint at the mode
+    size_t iterations;
+    bool converged;
 } FixInferResult;
 
 /**
@@ -1385,6 +1703,37 @@ typedef struct FixInferModel {
     size_t num_target_samples;
 } FixInferModel;
 
+/// @brief Gradient-based inference (INFERENCE_VI, INFERENCE_MAP) over a FixInferModel
+/// @note the likelihood's params are the model's params, with priors[j] the prior of params[j]
+///     ... (nullptr for flat); positive (eg., gamma) and unit-interval (beta) priors are fitted
+///     ... in an unconstrained space through log/logit transforms. Gradients are central
+///     ... differences of the log joint, whose per-datum likelihood sum is split across
+///     ... compute threads once there are INFER_PARALLEL_MIN_DATA data
+#define INFER_PARALLEL_MIN_DATA 4096
+#define OBSERVE_CHUNK 1024
+#define INFER_GRADIENT_STEP 1e-5
+#define VI_MAX_ITERATIONS 10000
+#define VI_MINIBATCH_SIZE 256
+#define VI_STEP_SIZE 0.1
+#define VI_ELBO_WINDOW 200
+#define VI_TOLERANCE 1e-4
+#define MAP_MAX_ITERATIONS 500
+#define MAP_HISTORY 8
+#define MAP_TOLERANCE 1e-10
+
+double FixDist_normal_log_pdf(FixDist *dist, double x);
+double FixDist_gamma_log_pdf(FixDist *dist, double x);
+double FixDist_log_pdf_sum(const FixDist *dist, const double *xs, size_t n);
+double FixInferModel_log_joint(const FixInferModel *model, const double *zeta, const double *batch, size_t batch_len);
+double FixInferModel_gradient(const FixInferModel *model, const double *zeta,
+    const double *batch, size_t batch_len, double *out_grad);
+FixInferResult *FixInferResult_vi(const FixInferModel *model);
+FixInferResult *FixInferResult_map(const FixInferModel *model);
+FixInferResult *FixInferResult_infer(const FixInferModel *model, InferMethod method);
+FixInferResult *FixModelGraph_fit(FixModelGraph *model, InferMethod method);
+Box FixModelGraph_fit_result(FixModelGraph *model, bool draw);
+FixIter *FixIter_vi_new(FixModelGraph *model);
+
 
 #pragma endregion
 
@@ -1416,7 +1765,7 @@ FixStr Boxed_to_FixStr(Boxed *boxed);
 #pragma region FixErrorTypeH
 
 
-#define error_print_all() error_print_lastN(ctx().debug.num_errors)
+#define error_print_all() error_print_lastN(ctx_local().debug.num_errors)
 
 FixError *error_push(FixError error);
 FixError error_getlast(FixArray errors);
@@ -1548,7 +1897,8 @@ void log_message(LogLevel level, FixStr format, ...) {
     #define sMSG(message) s(message)
     #define watch(var, cond) var
     #define debugger NOOP
-    #define log_assert(condition, ...) NOOP
+    /// @note unevaluated, but its operands still count as used
+    #define log_assert(condition, ...) ((void) sizeof(condition))
 #endif
 
 
@@ -1558,8 +1908,11 @@ void log_message(LogLevel level, FixStr format, ...) {
     #define require_positive(expr) assert((expr) > 0)
     #define require_null(expr) assert((expr) == nullptr)
 #else
-    /// @todo swap out all checks
-    #define require_not_null(expr)
+    /// @note unevaluated expressions, so they can still sit inside a comma expression
+    #define require(condition) ((void) sizeof(condition))
+    #define require_not_null(expr) ((void) sizeof(expr))
+    #define require_positive(expr) ((void) sizeof(expr))
+    #define require_null(expr) ((void) sizeof(expr))
 #endif
 
 
@@ -1587,6 +1940,8 @@ typedef struct Arena {
     size_t num_blocks;
     bool is_live;
     LifetimeType lifetime;
+    size_t live_bytes;      /// handed out since the last reset
+    size_t peak_bytes;
 } Arena;
 
 #define Arena_is_forever(a_ptr) ((a_ptr)->lifetime == LIFETIME_FOREVER)
@@ -1605,6 +1960,7 @@ void Arena_aro_free_underlying(Arena *a);
 void *Arena_new(size_t size, MetaType type);
 void *Arena_cextend(void *ptr, size_t old_size, size_t new_size);
 void Arena_reset(Arena *a);
+void Arena_adopt(Arena *into, Arena *from);
 void Arena_rewind(Arena *a, size_t pAst_size);
 void Arena_print_stats(Arena *a);
 // void Arena_test_main();
@@ -1616,12 +1972,17 @@ void Arena_print_stats(Arena *a);
 
 #pragma region ErrorH
 
-#define require_index_bounded(index, limit) \
-if ((index) >= (limit)) log_message(LL_ERROR, sMSG("Index out of bounds: %zu >= %zu"), (size_t)(index), (size_t)(limit))
+#ifdef DEBUG_REQUIRE_ASSERTS
+    #define require_index_bounded(index, limit) \
+    if ((index) >= (limit)) log_message(LL_ERROR, sMSG("Index out of bounds: %zu >= %zu"), (size_t)(index), (size_t)(limit))
 
-#define require_enum_bounded(enum_val, max_val) \
-if ((enum_val) < 0 || (enum_val) >= (max_val)) log_message(LL_ERROR, sMSG("Enum out of range: %d"), (int)(enum_val)); \
+    #define require_enum_bounded(enum_val, max_val) \
+    if ((enum_val) < 0 || (enum_val) >= (max_val)) log_message(LL_ERROR, sMSG("Enum out of range: %d"), (int)(enum_val)); \
 
+#else
+    #define require_index_bounded(index, limit) NOOP
+    #define require_enum_bounded(enum_val, max_val) NOOP
+#endif
 
 #define require_resources_cleanup(...) \
     void *_NULLables[] = {__VA_ARGS__};\
@@ -1636,22 +1997,60 @@ if ((enum_val) < 0 || (enum_val) >= (max_val)) log_message(LL_ERROR, sMSG("Enum
 
 #pragma region TracebackH
 
+#define TRACER_CAPACITY 512
+
 typedef struct TraceEntry {
     FixStr fn_name;
     FixStr argument;
+    struct Ast *node;   /// in place of `argument`: formatted only if the trace is printed
+    uint64_t time;      /// cf. Tracer_ticks
     FixStr file;
     size_t line;
 } TraceEntry;
 
+/// @brief A ring of the most recent TRACER_CAPACITY entries of one thread
+/// @note `top` counts pushes: entry `i` lives in `data[i % TRACER_CAPACITY]`. Only the owning
+///     ... thread writes, so a push is a few plain stores and a release of `top`; a signal
+///     ... handler on that thread can read it at any point (cf. Tracer_snapshot)
 typedef struct CallStack {
-    TraceEntry data[512];
-    size_t top;
+    TraceEntry data[TRACER_CAPACITY];
+    atomic_size_t top;
 } CallStack;
 
 
 void Tracer_pop(CallStack *traces);
 void Tracer_print_stack(CallStack *ts, size_t depth);
 void Tracer_push(CallStack *traces, FixStr fn_name, FixStr arg, FixStr file, size_t line);
+void Tracer_overflow(CallStack *traces);
+size_t Tracer_snapshot(CallStack *traces, TraceEntry *out, size_t max);
+
+/// @brief A cheap timestamp: the CPU's cycle or virtual counter, else the monotonic clock in ns
+static inline uint64_t Tracer_ticks(void) {
+    #if defined(__x86_64__) || defined(__i386__)
+        return __builtin_ia32_rdtsc();
+    #elif defined(__aarch64__)
+        uint64_t ticks;
+        __asm__ volatile("mrs %0, cntvct_el0" : "=r"(ticks));
+        return ticks;
+    #else
+        struct timespec now;
+        clock_gettime(CLOCK_MONOTONIC, &now);
+        return (uint64_t) now.tv_sec * 1000000000ull + (uint64_t) now.tv_nsec;
+    #endif
+}
+
+/// @brief Records the evaluation of `node`: a few stores, with no formatting
+static inline void Tracer_push_node(CallStack *traces, FixStr fn_name, struct Ast *node, FixStr file, size_t line) {
+    size_t top = atomic_load_explicit(&traces->top, memory_order_relaxed);
+    #ifdef TRACEBACK_ABORT_ON_OVERFLOW
+        if(top >= TRACER_CAPACITY) { Tracer_overflow(traces); }
+    #endif
+
+    traces->data[top % TRACER_CAPACITY] = (TraceEntry) {
+        .fn_name = fn_name, .node = node, .time = Tracer_ticks(), .file = file, .line = line
+    };
+    atomic_store_explicit(&traces->top, top + 1, memory_order_release);
+}
 
 #pragma endregion
 
@@ -1661,8 +2060,6 @@ void Tracer_push(CallStack *traces, FixStr fn_name, FixStr arg, FixStr file, siz
 #define ARRAY_SIZE_MEDIUM 256
 
 
-#define ARRAY_REQUIRE_CHECKS
-
 #ifdef ARRAY_REQUIRE_CHECKS
     #define require_small_array(count)\
         log_assert(count <= ARRAY_SIZE_SMALL, sMSG("Small array beyond capacity."));
@@ -1679,11 +2076,11 @@ void Tracer_push(CallStack *traces, FixStr fn_name, FixStr arg, FixStr file, siz
     #define require_capacity_bounded(capacity, index)\
         log_assert(index < capacity, sMSG("Index out of bounds."));
 #else
-    #define require_small_array(count) NOOP
-    #define require_medium_array(count) NOOP
-    #define require_not_null_array(arr) NOOP
-    #define require_size_bounded(arr, index) NOOP
-    #define require_capacity_bounded(arr, index) NOOP
+    #define require_small_array(count) ((void) sizeof(count))
+    #define require_medium_array(count) ((void) sizeof(count))
+    #define require_not_null_array(arr) ((void) sizeof(arr))
+    #define require_size_bounded(arr, index) ((void) sizeof(index))
+    #define require_capacity_bounded(arr, index) ((void) sizeof(index))
 #endif
 
 
@@ -1804,64 +2201,81 @@ void Tracer_push(CallStack *traces, FixStr fn_name, FixStr arg, FixStr file, siz
 /// ar_compiler, maybe reset after each file compilation?
 
 
-#define DEBUG_MEMORY
+/// @brief Where an allocation was asked for: the function and line using the allocating macro
+typedef struct AllocSite {
+    const char *fn_name;
+    size_t line;
+} AllocSite;
 
-#ifdef DEBUG_MEMORY
-    //  ctx_debug_memory() = {0};
+typedef enum AllocKind {
+    ALLOC_ARENA,
+    ALLOC_HEAP,
+    ALLOC_RAW,      /// cnew: including the blocks behind arenas and the heap's objects
+    ALLOC_KIND_ENUM_SIZE
+} AllocKind;
 
+#define alloc_site_here() ((AllocSite) {.fn_name = __func__, .line = __LINE__})
 
-    //__glo_GlobalContext.aro_free(ptr)
-    #define aro_free(ptr) NOOP
-    #define Arena_alloc(size) Arena_new(size, 0)
-    #define Heap_alloc(size) Heap_cnew(size, 0)
+/// @note the arena and heap allocators are reached through fixed signatures (cf.
+///     ... ctx_allocators), so their macros leave the site with the thread (cf. AllocProfile_record)
+#define alloc_site_mark() (ctx_local().debug.alloc_site = alloc_site_here())
 
-    #define ctx_debug_memory()\
-        __glo_GlobalContext.debug.os_memory
+//__glo_GlobalContext.aro_free(ptr)
+#define aro_free(ptr) NOOP
+#define Arena_alloc(size) (alloc_site_mark(), Arena_new(size, 0))
+#define Heap_alloc(size) (alloc_site_mark(), Heap_cnew(size, 0))
 
-    #define ctx_allocators()\
-        __glo_GlobalContext.allocators
+#define ctx_allocators()\
+    __glo_GlobalContext.allocators
 
-    #define aro_new(boxed_type) \
-        ctx_allocators().aro_new(sizeof(boxed_type##_T), boxed_type)
-    #define gco_new(boxed_type) \
-        ctx_allocators().gco_new(sizeof(boxed_type##_T), boxed_type)
+#define aro_new(boxed_type) \
+    (alloc_site_mark(), ctx_allocators().aro_new(sizeof(boxed_type##_T), boxed_type))
+#define gco_new(boxed_type) \
+    (alloc_site_mark(), ctx_allocators().gco_new(sizeof(boxed_type##_T), boxed_type))
 
-    #define ctx_debug_memory_reset() \
-        ctx_debug_memory().num_allocations = 0; \
-        ctx_debug_memory().is_free = false;
+/// @brief A raw allocation still live, or, with `is_free`, the tombstone of a freed one
+typedef struct MemTrackEntry {
+    void *ptr;
+    size_t size;
+    AllocSite site;
+    bool is_free;
+} MemTrackEntry;
+
+/// @brief The raw (cnew) allocations, kept for leak reports (cf. cfree_log_leaks)
+/// @note an open-addressed table keyed by pointer that grows as needed. Its own storage comes
+///     ... straight from calloc, so it never tracks itself
+typedef struct MemTrack {
+    MemTrackEntry *entries;
+    size_t capacity;
+    size_t num_used;        /// live entries and tombstones
+    size_t num_live;
+    size_t live_bytes;
+    size_t peak_bytes;
+    atomic_bool is_locked;
+} MemTrack;
+
+void *mem_cnew(size_t alloc_size, AllocSite site);
+void *mem_cextend(void *ptr, size_t alloc_size, AllocSite site);
+void mem_cfree(void *ptr);
+void mem_log_leaks(void);
+
+/// @note raw allocations go through mem_cnew and co. in every build, so an AllocProfile sees
+///     ... them; only with DEBUG_MEMORY are they logged and tracked until freed
+#define ctx_debug_memory()\
+    __glo_GlobalContext.debug.os_memory
+
+#define cnew(alloc_size) mem_cnew((alloc_size), alloc_site_here())
+#define cextend(ptr, alloc_size) mem_cextend((ptr), (alloc_size), alloc_site_here())
+#define cfree(ptr) mem_cfree(ptr)
 
+#ifdef DEBUG_MEMORY
     /// @todo -- instead, have alloca as an a-allocator
     #define stack_new(alloc_size) \
-        ((log_message(LL_DEBUG, sMSG("Allocating %zu bytes (alloca)"), (alloc_size)), \
-        ctx_debug_memory().allocations[ctx_debug_memory().num_allocations++] = alloca(alloc_size)))
-
-    #define cnew(alloc_size) \
-        ((log_message(LL_DEBUG, sMSG("Allocating %zu bytes (malloc)"), (alloc_size)), \
-        ctx_debug_memory().allocations[ctx_debug_memory().num_allocations++] = malloc(alloc_size)))
-
-
-    #define cextend(ptr, alloc_size) \
-        (log_message(LL_DEBUG, sMSG("Reallocating %zu bytes (realloc)"), (alloc_size)), \
-        ctx_debug_memory().allocations[ctx_debug_memory().num_allocations++] = realloc(ptr, alloc_size))
-
-    #define cfree(ptr) \
-        (log_message(LL_DEBUG, sMSG("Freeing memory: %p"), ptr), \
-        ctx_debug_memory().is_free = true, \
-        free(ptr))
-
-    #define cfree_log_leaks() \
-        for(size_t i = 0; i < ctx_debug_memory().num_allocations; i++) { \
-            if(ctx_debug_memory().is_free) { \
-                log_message(LL_DEBUG, sMSG("Freed memory: %p"), ctx_debug_memory().allocations[i]); \
-            } else { \
-                log_message(LL_DEBUG, sMSG("Leaked memory: %p"), ctx_debug_memory().allocations[i]); \
-            } \
-        }
+        (log_message(LL_DEBUG, sMSG("Allocating %zu bytes (alloca)"), (alloc_size)), alloca(alloc_size))
 
+    #define cfree_log_leaks() mem_log_leaks()
 #else
-    #define cnew(count, size) calloc(count, size)
-    #define cextend(ptr, count_size) realloc(ptr, count_size)
-    #define cfree(ptr) free(ptr)
+    #define stack_new(alloc_size) alloca(alloc_size)
     #define cfree_log_leaks() NOOP
 #endif
 
@@ -1903,6 +2317,7 @@ typedef struct Heap {
 
 
 void *Heap_cnew(size_t alloc_size, MetaType type);
+void Heap_cfree(void *data);
 void Heap_data_cnew(size_t initial_capacity, size_t gc_threshold);
 void Heap_destroy(Heap *heap);
 void Heap_gc_aro_free(MetaValue *obj);
@@ -1923,8 +2338,8 @@ void Heap_gc_aro_free(MetaValue *obj);
 #pragma region ThreadManagementH
 
 /// @brief Thread management
-/// ... we use the system threads for now, but we can switch to a custom thread pool later
-/// ... for now, we just need to manage the main thread, the GC thread, and the UI thread
+/// ... system threads for the main, GC and UI threads; compute work runs on the
+/// ... work-stealing TaskPool below (ctx().threads.compute are its worker threads)
 /// ... the main thread is the main execution thread
 /// ... the GC thread is the garbage collection thread
 /// ... the UI thread is the user interface thread (used by user code)
@@ -1940,9 +2355,72 @@ typedef struct Thread {
 } Thread;
 
 
-
-/// @todo -- get this from the system
-#define CPU_CORES 4
+/// @brief The compute pool: one worker per core, each with a Chase-Lev deque of tasks
+/// @note the thread that starts the pool (the interpreter) is worker 0 and has no thread
+///     ... of its own; it runs tasks while it waits in Task_join. Workers push and pop their
+///     ... own deque at the bottom and steal from the top of the others'.
+/// @note a task lives in the spawner's memory (usually its stack) until it is joined
+/// @note a task runs with its spawner's heap; off the spawner's thread it allocates on an
+///     ... arena of its own, which the spawner adopts when it joins the task, so what a task
+///     ... returns lives exactly as long as the spawner's arena (eg., an instance's scratch)
+/// @note only a worker may push to (or pop) its own deque: any other thread that spawns, eg.,
+///     ... a host thread calling into an instance, hands its tasks to the pool's shared
+///     ... injection queue instead, which the workers drain once their deques are empty
+#define CPU_CORES_MAX 64
+#define TASK_DEQUE_CAPACITY 1024
+#define TASK_ARENA_BLOCK (16 * 1024)
+
+typedef struct Task {
+    void *(*fn)(void *);
+    void *arg;
+    void *result;
+    atomic_bool done;
+    struct Task *next;  /// in the injection queue
+    Arena *parent;          /// the spawner's arena, which adopts `arena` (cf. Task_join)
+    struct Heap *heap;      /// the spawner's heap
+    Arena arena;            /// what the task allocated away from `parent`
+} Task;
+
+typedef struct TaskDeque {
+    atomic_int_fast64_t top;
+    atomic_int_fast64_t bottom;
+    _Atomic(Task *) buffer[TASK_DEQUE_CAPACITY];
+} TaskDeque;
+
+typedef struct TaskWorker {
+    Thread thread;
+    TaskDeque deque;
+    CallStack traces;       /// the worker's call stack
+    size_t index;
+    struct TaskPool *pool;
+} TaskWorker;
+
+typedef struct TaskPool {
+    TaskWorker *workers;
+    size_t num_workers;
+    atomic_size_t pending;  /// spawned and not yet taken
+    atomic_bool shutdown;
+    pthread_mutex_t lock;
+    pthread_cond_t wake;
+    Task *injected;             /// tasks spawned off the pool, oldest first (guarded by `lock`)
+    Task *injected_last;
+    pthread_t owner;            /// the thread that started the pool, which acts as worker 0
+    pthread_mutex_t heap_lock;  /// serialises Heap_cnew while the pool is running
+} TaskPool;
+
+bool TaskPool_start(size_t num_workers);
+void TaskPool_stop(void);
+size_t TaskPool_num_workers(void);
+Arena *TaskPool_arena(void);
+void TaskPool_run(void *tasks, size_t task_size, size_t num_tasks, void *(*worker)(void *));
+void Task_spawn(Task *task, void *(*fn)(void *), void *arg);
+void *Task_join(Task *task);
+
+/// @note the worker the current thread is (nullptr off the pool)
+static _Thread_local TaskWorker *TaskPool_self = nullptr;
+
+/// @note serialises starting and stopping the pool, which any thread may do first
+static pthread_mutex_t TaskPool_start_lock = PTHREAD_MUTEX_INITIALIZER;
 
 #pragma endregion
 
@@ -1983,7 +2461,6 @@ typedef struct ParseContext {
 struct GlobalContext {
 
     struct {
-        Arena *current;
         Arena compiler;
         Arena interpreter_global;
         Arena interpreter_local;
@@ -1991,7 +2468,6 @@ struct GlobalContext {
     } arenas;
 
     struct {
-        Heap *current;
         Heap interpreter;
     } heaps;
 
@@ -1999,7 +2475,9 @@ struct GlobalContext {
         Thread *main;
         Thread *gc;
         Thread *ui;
-        Thread *compute[CPU_CORES];
+        Thread *compute[CPU_CORES_MAX];
+        size_t num_compute;
+        _Atomic(TaskPool *) pool;   /// published once the pool is fully started
     } threads;
 
 
@@ -2032,16 +2510,12 @@ struct GlobalContext {
 
         struct GlobalPerfMetrics *perf_metrics;
         size_t num_metrics;
-        struct CallStack *callstack;
-        FixError errors[ARRAY_SIZE_SMALL]; // @todo -- make this a dynamic array
-        size_t num_errors;
+        CallStack traces;   /// the main thread's (cf. InterpContext.debug.callstack)
+        struct Profiler *_Atomic profiler;   /// the running one, read by its SIGPROF handler
+        struct AstCounters *_Atomic counters;   /// the running one, cf. interp_eval_counted
+        struct AllocProfile *_Atomic allocs;    /// the running one, cf. AllocProfile_record
 
-        struct {
-            void *allocations[1024];
-            size_t num_allocations;
-            FixStr line;
-            bool is_free;
-        } os_memory;
+        MemTrack os_memory;     /// cf. DEBUG_MEMORY
     } debug;
 
     ParseContext pctx;
@@ -2050,11 +2524,83 @@ struct GlobalContext {
         bool _none;
     } interpreter;
 
+    /// @note `step` counts inference steps (MCMC sweeps, SMC rounds): memo caches
+    ///     ... filled during an earlier step are stale
+    struct {
+        atomic_size_t step;
+    } inference;
+
 
 
 } ctx() = {0};
 
 
+/// @brief The state of the evaluation running on the current thread
+/// @note the GlobalContext keeps what evaluations share: the prelude, interned strings, the
+///     ... parsed program and the arenas and heap behind them. Each thread that evaluates
+///     ... sets up its own InterpContext first (cf. InterpContext_enter), so any number of
+///     ... models can run at once, one per thread.
+/// @brief A place an error unwinds to: an embedding call or a `try` (cf. interp_try)
+/// @note points nest innermost-first, and each keeps the evaluation state to restore there
+typedef struct InterpRecover {
+    jmp_buf target;
+    struct InterpRecover *prev;
+    Arena *arena;
+    Heap *heap;
+    size_t trace_depth;
+    size_t frame_depth;
+} InterpRecover;
+
+#define INTERP_MAX_FRAMES 64
+
+/// @brief A doubt call in progress: the fn called, and the call node, whose line is where
+///     ... its caller had got to (cf. interp_eval_call_fn)
+typedef struct InterpFrame {
+    FixStr fn_name;
+    struct Ast *call;
+} InterpFrame;
+
+typedef struct InterpContext {
+    struct {
+        Arena *current;
+    } arenas;
+
+    struct {
+        Heap *current;
+    } heaps;
+
+    struct {
+        struct CallStack *callstack;
+        FixError errors[ARRAY_SIZE_SMALL];  /// the most recent errors, oldest overwritten first
+        size_t num_errors;
+        InterpRecover *recover;             /// the innermost recovery point; without one errors abort
+        InterpFrame frames[INTERP_MAX_FRAMES];  /// the doubt calls in progress, outermost first
+        size_t num_frames;                  /// may pass INTERP_MAX_FRAMES: deeper calls go unrecorded
+        uint64_t child_ticks;               /// spent so far in the children of the node being counted
+        AllocSite alloc_site;               /// of the arena or heap allocation under way (cf. alloc_site_mark)
+    } debug;
+
+    /// @note the log-density of the current model execution: observe() adds to it,
+    ///     ... samplers reset it before running the model body and read it afterwards
+    struct {
+        double log_weight;
+        size_t num_observed;
+    } inference;
+
+    /// @note xoshiro256** state, seeded from the OS on first use (cf. InterpContext_seed)
+    struct {
+        uint64_t state[4];
+        bool seeded;
+    } rng;
+} InterpContext;
+
+_Thread_local InterpContext ctx_local() = {0};
+
+void InterpContext_enter(Arena *arena, Heap *heap, CallStack *callstack);
+void InterpContext_seed(uint64_t seed);
+double InterpContext_random(void);
+
+
 
 
 void GlobalContext_setup(void) {
@@ -2102,6 +2648,83 @@ double LastTime_elapsed_ms(void) {
 // void perf_LastTime_end();
 // double perf_LastTime_elapsed_ms();
 
+#define PROFILER_INTERVAL_US 1000
+#define PROFILER_MAX_SAMPLES (8 * 1024)
+#define PROFILER_MAX_DEPTH 32
+#define PROFILER_MAX_LINES 1024
+#define PROFILER_TOP_N 20
+
+/// @brief A function in a sampled stack and the source line it had got to (1-based, 0 if unknown)
+typedef struct ProfilerFrame {
+    FixStr fn_name;
+    size_t line;
+} ProfilerFrame;
+
+/// @brief What the evaluating thread was doing when a SIGPROF arrived: `<top>` then each doubt
+///     ... call in progress, the innermost PROFILER_MAX_DEPTH kept
+typedef struct ProfilerSample {
+    ProfilerFrame frames[PROFILER_MAX_DEPTH];
+    size_t num_frames;
+} ProfilerSample;
+
+/// @brief A sampling profiler: every `interval_us` of CPU time (cf. setitimer(ITIMER_PROF))
+///     ... the running thread records its doubt call stack and current node
+/// @note samples go in a buffer allocated up front, as the handler can't allocate. Once it
+///     ... is full further samples are only counted (cf. Profiler_num_dropped)
+typedef struct Profiler {
+    ProfilerSample *samples;
+    size_t capacity;
+    atomic_size_t num_samples;
+    long interval_us;
+    struct sigaction previous;
+} Profiler;
+
+bool Profiler_start(Profiler *prof, long interval_us, size_t capacity);
+void Profiler_stop(Profiler *prof);
+void Profiler_free(Profiler *prof);
+size_t Profiler_num_recorded(Profiler *prof);
+size_t Profiler_num_dropped(Profiler *prof);
+void Profiler_write_collapsed(Profiler *prof, FILE *out);
+void Profiler_print_hot_lines(Profiler *prof, FixStr *source_lines, size_t num_lines, size_t top_n);
+void Profiler_test_main(void);
+
+#define ALLOC_PROFILE_MAX_SITES 2048
+
+typedef struct AllocProfileEntry {
+    AllocSite site;
+    AllocKind kind;
+    MetaType type;
+    size_t count;
+    size_t bytes;
+} AllocProfileEntry;
+
+/// @brief Allocation counts and bytes per site, allocator and MetaType, while it runs
+/// @note every thread records into the one table, under a spin lock. Once it is full,
+///     ... further sites are only counted in total
+typedef struct AllocProfile {
+    AllocProfileEntry entries[ALLOC_PROFILE_MAX_SITES];
+    size_t num_entries;
+    size_t num_untracked;
+    size_t bytes_untracked;
+    atomic_bool is_locked;
+} AllocProfile;
+
+AllocProfile *AllocProfile_start(void);
+void AllocProfile_stop(void);
+void AllocProfile_free(AllocProfile *prof);
+void AllocProfile_record(AllocKind kind, AllocSite site, size_t alloc_size, MetaType type);
+void AllocProfile_write_json(AllocProfile *prof, FILE *out);
+void AllocProfile_test_main(void);
+
+/// @brief Records an arena or heap allocation against the site its macro marked, clearing
+///     ... the mark so that an unmarked call isn't put on a stale site
+static inline void AllocProfile_record_marked(AllocKind kind, size_t alloc_size, MetaType type) {
+    if(atomic_load_explicit(&ctx().debug.allocs, memory_order_relaxed) == nullptr) { return; }
+    AllocSite site = ctx_local().debug.alloc_site;
+    ctx_local().debug.alloc_site = (AllocSite) {0};
+    AllocProfile_record(kind, site, alloc_size, type);
+}
+
 
 
 #pragma endregion
@@ -2327,18 +2950,108 @@ typedef struct FlxGraph {
     FixGraphEdge *edges;
     size_t num_nodes;
     size_t num_edges;
+    size_t node_capacity;
+    size_t edge_capacity;
 } FlxGraph;
+
+/// @note nodes and edges are dense arrays; an edge's source and target are node indices
+FlxGraph *FlxGraph_new(MetaType type, size_t node_capacity, size_t edge_capacity);
+size_t FlxGraph_add_node(FlxGraph *graph, Box value);
+bool FlxGraph_add_edge(FlxGraph *graph, size_t source, size_t target, Box weight);
+bool FlxGraph_has_edge(FlxGraph *graph, size_t source, size_t target);
+FixStr FlxGraph_to_FixStr(FlxGraph *graph);
 #pragma endregion
 
 #pragma region FlxDataFrameH
 
+#define DATAFRAME_MAX_COLUMNS 64
+
+/// @brief A row selection vector, one bit per row packed into 64-bit words
+/// @note meta.size is the number of rows, meta.capacity the number of words
+///     ... filters produce these, and ops consume them without materialising rows
+typedef struct FixBitmask {
+    MetaData meta;
+    uint64_t *data;
+} FixBitmask;
+
+#define FixBitmask_num_words(num_rows) (((num_rows) + 63) / 64)
+#define FixBitmask_test(mask, row) ((((mask)->data[(row) >> 6]) >> ((row) & 63)) & 1ULL)
+
+typedef enum FlxCmpOp {
+    CMP_LT, CMP_LE, CMP_GT, CMP_GE, CMP_EQ, CMP_NE
+} FlxCmpOp;
 
+typedef enum FlxAggOp {
+    AGG_COUNT, AGG_SUM, AGG_MEAN, AGG_MIN, AGG_MAX
+} FlxAggOp;
+
+/// @brief A columnar table of unboxed vectors
+/// @note columns are FlxVecDouble (BXD_FLX_VEC_DOUBLE_N), FlxVecInt (BXD_FLX_VEC_INT),
+///     FlxVecBool (BXD_FLX_VEC_BOOL) or FlxVecCat (BXD_FLX_VEC_TAGS)
+/// @note meta.size is the number of columns, all columns have `num_rows` rows
+///     ... columns are shared by reference, so `select` is zero-copy
 typedef struct FlxDataFrame {
     MetaData meta;
-    Boxed *columns;
+    Boxed **columns;
+    FixStr *names;
+    size_t num_rows;
+
+    /// @note set when columns point into a mapped columnar file (see FlxDataFrame_map_columnar)
+    void *mapping;
+    size_t mapping_size;
 } FlxDataFrame;
 
 
+/// @brief CSV ingestion
+/// @note the file is mmap'd and split into newline-aligned chunks parsed on separate threads
+///     ... column types are inferred from the first CSV_INFER_ROWS data rows: int, double, bool,
+///     ... else categorical. An int column that later meets a fraction, NaN or missing value
+///     ... is widened to double and parsed again, rather than truncated
+#define CSV_PARALLEL_MIN_BYTES (1024 * 1024)
+#define CSV_MAX_CATEGORIES 256
+#define CSV_INFER_ROWS 1024
+
+typedef struct FlxCsvChunk {
+    const char *start;
+    const char *end;
+    size_t num_rows;
+    size_t row_offset;
+    size_t num_errors;
+    bool overflowed;
+    bool widen[DATAFRAME_MAX_COLUMNS];  /// int columns holding a non-integer in this chunk
+
+    char delimiter;
+    FlxDataFrame *df;
+
+    /// @note per-chunk categories (pointing into the mapping), merged serially after parsing
+    FixStr *local_categories;           // [num_columns * CSV_MAX_CATEGORIES]
+    size_t *num_local_categories;       // [num_columns]
+} FlxCsvChunk;
+
+
+/// @brief Binary columnar format, reloaded zero-copy with mmap
+/// @note layout: FlxColumnarHeader, FlxColumnarColumn[num_columns], then 64-byte aligned
+///     ... names, raw column data and category (offset, size) tables; native byte order
+#define COLUMNAR_MAGIC "DOUBTCF1"
+#define COLUMNAR_ALIGN 64
+
+typedef struct FlxColumnarHeader {
+    char magic[8];
+    uint64_t num_rows;
+    uint64_t num_columns;
+} FlxColumnarHeader;
+
+typedef struct FlxColumnarColumn {
+    uint64_t type;
+    uint64_t elem_size;
+    uint64_t name_offset;
+    uint64_t name_size;
+    uint64_t data_offset;
+    uint64_t num_categories;
+    uint64_t categories_offset;
+} FlxColumnarColumn;
+
+
 #pragma endregion
 
 #pragma region FlxMatrixAndTensorH
@@ -2351,6 +3064,8 @@ typedef struct FlxMatrix {
     size_t columns;
 } FlxMatrix;
 
+/// @brief A dense row-major matrix of unboxed doubles
+/// @note meta.size is rows * columns
 typedef struct FlxMatrixF {
     MetaData meta;
     double *data;
@@ -2358,6 +3073,84 @@ typedef struct FlxMatrixF {
     size_t columns;
 } FlxMatrixF;
 
+#define FlxMatrixF_at(m, row, col) ((m)->data[(row) * (m)->columns + (col)])
+
+/// @brief GEMM blocking: MRxNR register tile, MCxKC packed A block, KCxNC packed B panel
+/// @note the micro-kernel runs over packed, contiguous panels so the compiler can keep
+///     ... the MRxNR accumulators in vector registers (no target-specific intrinsics)
+#define GEMM_MR 4
+#define GEMM_NR 8
+#define GEMM_MC 64
+#define GEMM_KC 256
+#define GEMM_NC 512
+#define LINALG_PARALLEL_MIN_FLOPS (1 << 20)
+
+/// @brief A row-range of a linear algebra kernel, run on one compute thread
+typedef struct FlxLinalgTask {
+    const FlxMatrixF *a;
+    const FlxMatrixF *b;
+    FlxMatrixF *c;
+    const double *x;
+    double *y;
+    size_t row_start;
+    size_t row_end;
+    double *packed_a;
+    double *packed_b;
+} FlxLinalgTask;
+
+FlxMatrixF *FlxMatrixF_new(size_t rows, size_t columns);
+FlxMatrixF *FlxMatrixF_copy(const FlxMatrixF *m);
+void FlxMatrixF_gemm(const FlxMatrixF *a, const FlxMatrixF *b, FlxMatrixF *c);
+FlxMatrixF *FlxMatrixF_matmul_new(const FlxMatrixF *a, const FlxMatrixF *b);
+void FlxMatrixF_gemv(const FlxMatrixF *a, const double *x, double *y);
+bool FlxMatrixF_cholesky(FlxMatrixF *a);
+void FlxMatrixF_solve_lower(const FlxMatrixF *l, const double *b, double *x);
+void FlxMatrixF_solve_lower_transpose(const FlxMatrixF *l, const double *b, double *x);
+double FlxMatrixF_cholesky_logdet(const FlxMatrixF *l);
+bool FlxMatrixF_logdet(const FlxMatrixF *a, double *out_logdet);
+double FlxMatrixF_mvn_log_pdf(const double *x, const double *mean, const FlxMatrixF *chol);
+FixStr FlxMatrixF_to_FixStr(FlxMatrixF *m);
+
+#define TENSOR_MAX_DIMS 8
+
+/// @brief An N-dimensional strided view over unboxed doubles
+/// @note element (i0, .., in) lives at data[offset + sum_k ik * strides[k]]; strides are in elements
+///     ... and may be 0 (broadcast) or negative (reversed slice). meta.size is the element count.
+/// @note views (slice, transpose) share `data` with `base` and are LIVING_PINNED; only owners free data
+typedef struct FlxTensorF {
+    MetaData meta;
+    double *data;
+    size_t offset;
+    size_t ndim;
+    size_t shape[TENSOR_MAX_DIMS];
+    ptrdiff_t strides[TENSOR_MAX_DIMS];
+    struct FlxTensorF *base;
+} FlxTensorF;
+
+/// @brief Elementwise kernel ops: dst = a `op` b (ASSIGN ignores a)
+typedef enum FlxElemOp {
+    ELEM_ASSIGN,
+    ELEM_ADD,
+    ELEM_SUB,
+    ELEM_MUL,
+    ELEM_DIV,
+} FlxElemOp;
+
+FlxTensorF *FlxTensorF_new(size_t ndim, const size_t *shape);
+FlxTensorF *FlxTensorF_from_data(double *data, size_t ndim, const size_t *shape, FlxTensorF *base);
+FlxTensorF *FlxTensorF_copy(const FlxTensorF *t);
+FlxTensorF *FlxTensorF_slice(const FlxTensorF *t, size_t axis, size_t start, size_t stop, ptrdiff_t step);
+FlxTensorF *FlxTensorF_transpose(const FlxTensorF *t);
+FlxTensorF *FlxTensorF_permute(const FlxTensorF *t, const size_t *axes);
+bool FlxTensorF_is_contiguous(const FlxTensorF *t);
+bool FlxTensorF_broadcast_shape(const FlxTensorF *a, const FlxTensorF *b, size_t *out_ndim, size_t *out_shape);
+bool FlxTensorF_apply(FlxTensorF *dst, FlxElemOp op, const FlxTensorF *src);
+void FlxTensorF_apply_scalar(FlxTensorF *dst, FlxElemOp op, double value);
+FlxTensorF *FlxTensorF_binary_new(const FlxTensorF *a, FlxElemOp op, const FlxTensorF *b);
+bool FlxElemOp_from_FixStr(FixStr op, FlxElemOp *out_op);
+bool FlxTensorF_view_of_Box(Box box, FlxTensorF *out_view);
+FixStr FlxTensorF_to_FixStr(FlxTensorF *t);
+
 #pragma endregion
 
 #pragma region FlxVectorsH
@@ -2378,10 +3171,13 @@ typedef struct FlxVecFixStr {
     FixStr *data;
 } FlxVecFixStr;
 
+/// @brief A categorical vector: `data` holds codes into `categories`
 typedef struct FlxVecCat {
     MetaData meta;
     int *data;
     FixStr *categories;
+    size_t num_categories;
+    size_t max_categories;
 } FlxVecCat;
 
 typedef struct FlxVecChar {
@@ -2415,7 +3211,8 @@ typedef FixStruct BXD_FIX_STRUCT_T;
 // typedef Fix BXD_FIX_TRAIT_T;
 // typedef Fix BXD_FIX_TYPE_T;
 // typedef BXD_FIX_OBJECT BXD_FIX_OBJECT_T;
-// typedef Fix BXD_FIX_ARRAY_VIEW_T;
+typedef FixArrayView BXD_FIX_ARRAY_VIEW_T;
+typedef FixIter BXD_FIX_ITER_T;
 // typedef Fix BXD_FIX_VEC_TAGS_T;
 // typedef Fix BXD_FIX_NUM_128BIT_T;
 typedef double BXD_FIX_NUM_DOUBLE_T;
@@ -2431,19 +3228,22 @@ typedef FlxDict BXD_FLX_DICT_T;
 // typedef Flx BXD_FLX_QUEUE_PRIORITY_T;
 // typedef Flx BXD_FLX_STACK_T;
 // typedef Flx BXD_FLX_SET_T;
-// typedef Flx BXD_FLX_GRAPH_DIRECTED_WEIGHTED_T;
-// typedef Flx BXD_FLX_GRAPH_DIRECTED_UNWEIGHTED_T;
-// typedef Flx BXD_FLX_GRAPH_UNDIRECTED_WEIGHTED_T;
-// typedef Flx BXD_FLX_GRAPH_UNDIRECTED_UNWEIGHTED_T;
-// typedef Flx BXD_FLX_VEC_DOUBLE_N_T;
+typedef FlxGraph BXD_FLX_GRAPH_DIRECTED_WEIGHTED_T;
+typedef FlxGraph BXD_FLX_GRAPH_DIRECTED_UNWEIGHTED_T;
+typedef FlxGraph BXD_FLX_GRAPH_UNDIRECTED_WEIGHTED_T;
+typedef FlxGraph BXD_FLX_GRAPH_UNDIRECTED_UNWEIGHTED_T;
+typedef FlxVecDouble BXD_FLX_VEC_DOUBLE_N_T;
 // typedef Flx BXD_FLX_MATRIX_T;
-// typedef Flx BXD_FLX_MATRIX_DOUBLE_T;
+typedef FlxMatrixF BXD_FLX_MATRIX_DOUBLE_T;
 // typedef Flx BXD_FLX_TENSOR_T;
-// typedef Flx BXD_FLX_TENSOR_DOUBLE_T;
-// typedef Flx BXD_FLX_DATAFRAME_T;
+typedef FlxTensorF BXD_FLX_TENSOR_DOUBLE_T;
+typedef FlxDataFrame BXD_FLX_DATAFRAME_T;
+typedef FlxSampleSink BXD_FLX_SAMPLE_SINK_T;
+typedef FlxParticles BXD_FLX_PARTICLES_T;
+typedef FixModelGraph BXD_FIX_MODEL_GRAPH_T;
 typedef FlxVecBool BXD_FLX_VEC_BOOL_T;
 typedef FlxVecInt BXD_FLX_VEC_INT_T;
-// typedef Flx BXD_FLX_VEC_TAGS_T;
+typedef FlxVecCat BXD_FLX_VEC_TAGS_T;
 typedef FlxVecFixStr BXD_FLX_VEC_STR_T;
 typedef FlxVector BXD_FLX_VEC_OBJS_T;
 
@@ -2630,10 +3430,13 @@ double Box_force_numeric(Box o) {
 
 // #define Box_is_ptr(box) (box.type == UBX_PTR)
 #define Box_is_error(box) (box.type == UBX_PTR_ERROR)
+#define Box_is_exit(box) (box.type == UBX_STATE && box.payload == BXS_EXIT)
+/// @note an evaluation that raised: an error value, or the exit state interp_error leaves behind
+#define Box_is_failed(box) (Box_is_error(box) || Box_is_exit(box))
 #define Box_is_null(box) (box.type == UBX_NULL && ((void*)box.payload) == nullptr)
 #define Box_is_state(box, cs_type) (box.type == UBX_BOOL && box.payload == cs_type)
 #define Box_is_state_end(box) (box.type == UBX_BOOL && \
-    box.payload == BXS_BREAK || box.payload == BXS_RETURN || box.payload == BXS_YIELD)
+    (box.payload == BXS_BREAK || box.payload == BXS_RETURN || box.payload == BXS_YIELD))
 
 #define Box_is_hashof(boxTag, tagFixStr) (boxTag.type == UBX_INT && ((size_t) Box_unwrap_int(boxTag) == FixStr_hash(tagFixStr)))
 
@@ -2670,10 +3473,53 @@ bool Box_is_numeric(Box o) {
 
 
 
-FlxVecCat FlxVecCat_new(size_t num_categories);
+FlxVecDouble *FlxVecDouble_new(size_t capacity);
+FlxVecInt *FlxVecInt_new(size_t capacity);
+FlxVecBool *FlxVecBool_new(size_t capacity);
+FlxVecCat *FlxVecCat_new(size_t capacity, size_t max_categories);
+void FlxVecDouble_push(FlxVecDouble *vec, double value);
+void FlxVecInt_push(FlxVecInt *vec, int value);
+void FlxVecBool_push(FlxVecBool *vec, bool value);
+int FlxVecCat_code_of(FlxVecCat *cat, FixStr category);
+int FlxVecCat_intern(FlxVecCat *cat, FixStr category);
+void FlxVecCat_push(FlxVecCat *cat, FixStr category);
 FlxDict FlxVecCat_histogram(FlxVecCat *cat);
+/// @brief Elements printed of a column before the rest is elided: a dataframe column can
+///     ... have millions of rows, and columns are printed in debug logs (cf. native_log_call)
+#define FLXVEC_PRINT_MAX 16
+
+FixStr FlxVecDouble_to_FixStr(FlxVecDouble *vec);
+FixStr FlxVecInt_to_FixStr(FlxVecInt *vec);
+FixStr FlxVecBool_to_FixStr(FlxVecBool *vec);
 FixStr FlxVecCat_to_FixStr(FlxVecCat *cat);
 
+FixBitmask FixBitmask_cnew(size_t num_rows, bool all_set);
+void FixBitmask_cfree(FixBitmask *mask);
+void FixBitmask_and(FixBitmask *out, const FixBitmask *other);
+void FixBitmask_or(FixBitmask *out, const FixBitmask *other);
+void FixBitmask_not(FixBitmask *out);
+size_t FixBitmask_count(const FixBitmask *mask);
+
+FixBitmask FlxVecDouble_filter(FlxVecDouble *vec, FlxCmpOp op, double rhs);
+FixBitmask FlxVecInt_filter(FlxVecInt *vec, FlxCmpOp op, double rhs);
+FixBitmask FlxVecCat_filter_eq(FlxVecCat *cat, FixStr category);
+double FlxVecDouble_aggregate(FlxVecDouble *vec, const FixBitmask *sel, FlxAggOp op);
+
+FlxDataFrame *FlxDataFrame_new(size_t num_columns);
+bool FlxDataFrame_add_column(FlxDataFrame *df, FixStr name, Boxed *column);
+Boxed *FlxDataFrame_column(FlxDataFrame *df, FixStr name);
+FixBitmask FlxDataFrame_filter(FlxDataFrame *df, FixStr name, FlxCmpOp op, double rhs);
+FlxDataFrame *FlxDataFrame_select(FlxDataFrame *df, FixStr *names, size_t num_names);
+FlxDataFrame *FlxDataFrame_compact(FlxDataFrame *df, const FixBitmask *sel);
+FlxDataFrame *FlxDataFrame_group_by(FlxDataFrame *df, FixStr key, FixStr value, FlxAggOp op, const FixBitmask *sel);
+FlxDataFrame *FlxDataFrame_join(FlxDataFrame *left, FlxDataFrame *right, FixStr key);
+FixStr FlxDataFrame_to_FixStr(FlxDataFrame *df);
+
+FlxDataFrame *FlxDataFrame_read_csv(const char *filename, char delimiter);
+bool FlxDataFrame_write_columnar(FlxDataFrame *df, const char *filename);
+FlxDataFrame *FlxDataFrame_map_columnar(const char *filename);
+void FlxDataFrame_unmap(FlxDataFrame *df);
+
 
 Box FixIter_update(FixIter *iter, Box result);
 Box FixIter_get(FixIter *iter);
@@ -2835,6 +3681,7 @@ typedef enum AstType {
     AST_GENERIC_TYPE,
 
     AST_RANGE_SUGAR,
+    AST_TRY,
 
     AST_ENUM_SIZE,
 } AstType;
@@ -2888,6 +3735,7 @@ FixStr Ast_nameof(AstType ast) {
         [AST_IGNORE] = "ast(ignore)",
         [AST_TYPE_ANNOTATION] = "ast(type_annotation)",
         [AST_RANGE_SUGAR] = "ast(range_sugar)",
+        [AST_TRY] = "ast(try)",
         [AST_ENUM_SIZE] = "ast(<ERROR(NUM_TYPES)>)"
     };
 
@@ -2989,6 +3837,7 @@ struct Ast {
             Ast *body;
             bool is_macro;
             bool is_generator;  // Add this flag
+            bool is_memo;       /// `memo fn`: results cached on the arguments
         } fn;
         struct AstFnAnon {
             struct AnonFnParam {
@@ -3034,12 +3883,17 @@ struct Ast {
             Ast *body;
             Ast *else_body;
         } if_stmt;
+        struct AstTry {
+            Ast *body;
+            Ast *fallback;  /// evaluated if the body raises; nullptr for `null`
+        } try_stmt;
         struct AstLoop {
             Ast **bindings;
             size_t num_bindings;
             Ast *body;
             Ast *condition;
             bool yields;
+            bool parallel;  /// `par for`: iterations run on the compute pool
         } loop;
         struct AstLet {
             Ast **bindings;
@@ -3145,12 +3999,14 @@ FixStr Ast_mutation_to_json(Ast *node, size_t indent) ;
 
 #define ctx_parser() (&ctx().pctx)
 
+/// @note these act on the ParseContext `p` being parsed, so independent sources can be parsed
+///     ... into contexts of their own (cf. DoubtInstance_load)
 #define ctx_parser_append(node) \
-    ctx().pctx.parser.meta.size++;\
-    ctx().pctx.parser.data = node
+    p->parser.meta.size++;\
+    p->parser.data = node
 
 #define pctx_trace(arg) \
-    Tracer_push(&ctx_parser()->parser.traces, s(__func__), arg, s(__FILE__), __LINE__)
+    Tracer_push(&p->parser.traces, s(__func__), arg, s(__FILE__), __LINE__)
 
 /// @todo rationalize this better, eg., wrt sizeof's
 #define PARSING_PREALLOC (128 * 1024)
@@ -3211,6 +4067,9 @@ Ast *parse_let(ParseContext *p);
 Ast *parse_const(ParseContext *p);
 Ast *parse_keyword(ParseContext *p,FixStr keyword, AstType type);
 Ast *parse_function(ParseContext *p,bool is_loop);
+Ast *parse_memo(ParseContext *p);
+Ast *parse_par(ParseContext *p);
+Ast *parse_try(ParseContext *p);
 Ast *parse_post_anon(ParseContext *p);
 Ast *parse_mutation(ParseContext *p);
 
@@ -3234,10 +4093,41 @@ FixArray *CliArgs_to_FixArray(int argc, char **argv);
 // double lib_rand_0to1();
 double lib_rand_normal(double mean, double stddev);
 Box native_log(FixFn *self, FixScope parent, FixArray args);
+Box native_observe(FixFn *self, FixScope parent, FixArray args);
+Box native_log_pdf(FixFn *self, FixScope parent, Box distObject, Box data);
+Box native_normal(FixFn *self, FixScope parent, FixArray args);
+Box native_gamma(FixFn *self, FixScope parent, FixArray args);
+Box native_exponential(FixFn *self, FixScope parent, FixArray args);
+Box native_uniform(FixFn *self, FixScope parent, FixArray args);
+Box native_beta(FixFn *self, FixScope parent, FixArray args);
 Box native_range(FixFn *self, FixScope parent, FixArray args);
 Box native_infer(FixFn *self, FixScope parent, Box loopFn, Box strategyTag);
 Box native_sample(FixFn *self, FixScope parent, Box distObject);
 Box native_take(FixFn *self, FixScope parent, FixArray args);
+Box native_drop(FixFn *self, FixScope parent, Box sequence, Box count);
+Box native_window(FixFn *self, FixScope parent, Box sequence, Box size);
+Box native_chunk(FixFn *self, FixScope parent, Box sequence, Box size);
+Box native_par_map(FixFn *self, FixScope parent, Box fn, Box sequence);
+Box native_par_reduce(FixFn *self, FixScope parent, Box fn, Box sequence, Box init);
+Box native_read_csv(FixFn *self, FixScope parent, Box path);
+Box native_save_columns(FixFn *self, FixScope parent, Box frame, Box path);
+Box native_load_columns(FixFn *self, FixScope parent, Box path);
+Box native_column(FixFn *self, FixScope parent, Box frame, Box name);
+Box native_filter(FixFn *self, FixScope parent, FixArray args);
+Box native_select(FixFn *self, FixScope parent, FixArray args);
+Box native_group_by(FixFn *self, FixScope parent, FixArray args);
+Box native_join(FixFn *self, FixScope parent, Box left, Box right, Box key);
+Box native_aggregate(FixFn *self, FixScope parent, Box column, Box op);
+Box native_summarize(FixFn *self, FixScope parent, FixArray args);
+Box native_matrix(FixFn *self, FixScope parent, Box rows);
+Box native_matmul(FixFn *self, FixScope parent, Box left, Box right);
+Box native_cholesky(FixFn *self, FixScope parent, Box matrix);
+Box native_logdet(FixFn *self, FixScope parent, Box matrix);
+Box native_solve(FixFn *self, FixScope parent, Box matrix, Box rhs);
+Box native_mvnormal_log_pdf(FixFn *self, FixScope parent, Box x, Box mean, Box cov);
+Box native_tensor(FixFn *self, FixScope parent, Box data);
+Box native_transpose(FixFn *self, FixScope parent, Box data);
+Box native_slice(FixFn *self, FixScope parent, Box data, Box start, Box stop);
 
 
 
@@ -3274,6 +4164,27 @@ Box native_round(FixFn *self, FixScope parent, FixArray args);
         .location = s(__FILE__ ":" _STR(__LINE__))});\
     interp_graceful_exit()
 
+/// @brief Guards the block that follows: an error raised inside it unwinds back here and
+///     ... runs the `else` branch instead, with the cause in the thread's error log
+/// @note the guarded block must end with interp_try_end; locals it assigns and the
+///     ... `else` branch reads must be volatile (cf. setjmp)
+/// @example
+///     InterpRecover point;
+///     interp_try(&point) {
+///         result = interp_eval_ast(node, scope);
+///         interp_try_end(&point);
+///     } else {
+///         result = Box_null();
+///     }
+#define interp_try(point) \
+    InterpRecover_push(point);\
+    if(setjmp((point)->target) == 0)
+
+#define interp_try_end(point) InterpRecover_pop(point)
+
+void InterpRecover_push(InterpRecover *point);
+void InterpRecover_pop(InterpRecover *point);
+
 #pragma endregion
 
 #pragma region BoxedPrecache
@@ -3300,13 +4211,46 @@ Box native_round(FixFn *self, FixScope parent, FixArray args);
 
 #pragma region InterpreterEvaluatorH
 
-void interp_graceful_exit(void);
+__attribute__((noreturn)) void interp_graceful_exit(void);
 
 // Running code
 Box interp_run_from_source(ParseContext *p, FixStr source, int argc, char **argv);
 Box interp_run_ast(Ast *ast);
 
+/// @brief An isolated interpreter for embedding: a program loaded once and called many times
+/// @note a host calls GlobalContext_setup() once, then uses any number of instances, each from
+///     ... one thread at a time. Errors come back as `false` plus DoubtInstance_error rather
+///     ... than aborting the process.
+/// @note what a call returns lives in the instance's scratch arena, which the next call on
+///     ... the instance reclaims; the message of the last error is copied into the instance
+/// @example
+///     DoubtInstance *model = DoubtInstance_new();
+///     if(DoubtInstance_load(model, source) && DoubtInstance_call(model, s("f"), args, &result)) { ... }
+///     DoubtInstance_free(model);
+#define DOUBT_ERROR_MESSAGE_MAX 512
+
+typedef struct DoubtInstance {
+    Arena program;          /// the source, its AST and the globals it defines
+    Arena scratch;          /// what a call allocates
+    Heap heap;
+    CallStack traces;
+    ParseContext pctx;
+    FixScope globals;
+    InterpContext context;  /// the instance's evaluation state between calls (eg., its RNG)
+    FixError error;         /// why the last load or call failed ...
+    char error_message[DOUBT_ERROR_MESSAGE_MAX];  /// ... with its message, which outlives the call
+    bool loaded;
+} DoubtInstance;
+
+DoubtInstance *DoubtInstance_new(void);
+void DoubtInstance_free(DoubtInstance *instance);
+bool DoubtInstance_load(DoubtInstance *instance, FixStr source);
+bool DoubtInstance_call(DoubtInstance *instance, FixStr fn_name, FixArray args, Box *out_result);
+bool DoubtInstance_run_main(DoubtInstance *instance, Box *out_result);
+FixError DoubtInstance_error(DoubtInstance *instance);
+
 Box interp_eval_if(Ast *node, FixScope *scope);
+Box interp_eval_try(Ast *node, FixScope *scope);
 Box interp_eval_vec(Ast *node, FixScope *scope);
 Box interp_eval_literal(Ast *node, FixScope *scope);
 Box interp_eval_identifier(Ast *node, FixScope *scope);
@@ -3341,6 +4285,49 @@ Box interp_eval_load_module(Ast *node);
 
 #pragma endregion
 
+#pragma region BenchH
+
+/// @note compile with -DBENCH (cf. ./compile.sh --bench) for a binary that runs these
+///     ... instead of the interpreter
+#define BENCH_DEFAULT_REPS 30
+#define BENCH_DEFAULT_WARMUP 5
+#define BENCH_MAX_REPS 1000
+#define BENCH_DICT_KEYS 64
+#define BENCH_ARENA_BLOCK (4 * 1024 * 1024)
+#define BENCH_REGRESSION_PCT 10.0
+
+/// @note identifies the build in the results (cf. ./compile.sh --bench)
+#ifndef BENCH_COMMIT
+    #define BENCH_COMMIT "unknown"
+#endif
+
+/// @brief A microbenchmark: `run` does `ops` operations, and each repetition is timed as a whole
+typedef struct BenchCase {
+    const char *name;
+    size_t ops;                     /// operations per repetition
+    void (*run)(size_t ops);
+} BenchCase;
+
+/// @brief A benchmark's repetitions summarised per operation
+/// @note ticks are Tracer_ticks(): CPU cycles on x86 (at the TSC's constant rate), the
+///     ... virtual counter on arm64
+typedef struct BenchResult {
+    const char *name;
+    size_t ops;
+    size_t reps;
+    double median_ns;
+    double p99_ns;
+    double median_ticks;
+    double ops_per_sec;
+} BenchResult;
+
+BenchResult Bench_run(BenchCase *bench, size_t warmup, size_t reps);
+void Bench_write_json(BenchResult *results, size_t num_results, size_t warmup, FILE *out);
+size_t Bench_compare(BenchResult *results, size_t num_results, FILE *baseline, double threshold_pct);
+int bench_main(int argc, char **argv);
+
+#pragma endregion
+
 #pragma region InterpreterMinimalRuntimeH
 Box interp_eval_fn(Box fn_obj, int num_args, Box *args);
 Box interp_eval_uop(FixStr op, Box operand);
@@ -3368,25 +4355,26 @@ Box FixFn_Ast_call(FixFn *fn, FixArray args, FixScope parent);
 void ctx_setup(struct GlobalContext *ctx, Heap *heap, Arena *arena) {
     require_not_null(ctx);
 
+    bool default_arena = arena == nullptr, default_heap = heap == nullptr;
     heap = heap ? heap : &ctx->heaps.interpreter;
     arena = arena ? arena : &ctx->arenas.compiler;
 
-    ctx->arenas.current = arena;
-    ctx->heaps.current = heap;
+    ctx_local().arenas.current = arena;
+    ctx_local().heaps.current = heap;
     ctx->allocators.aro_new = Arena_new;
     ctx->allocators.aro_free = Arena_aro_free;
     ctx->allocators.gco_new = Heap_cnew;
 
-    if(arena == nullptr) {
-        log_message(LL_INFO, sMSG("Setting up default arenas."));
+    if(default_arena) {
         Arena_init(&ctx->arenas.compiler, 8 * ARENA_1MB);
         Arena_init(&ctx->arenas.interpreter_global, 8 * ARENA_1MB);
         Arena_init(&ctx->arenas.interpreter_local, 2 * ARENA_1MB);
+        log_message(LL_INFO, sMSG("Set up default arenas."));
         /// @todo -- may not be the right approach
         // Arena_init(&ctx->arenas.gc_backing, 8 * ARENA_1MB);
     }
 
-    if(heap == nullptr) {
+    if(default_heap) {
         log_message(LL_INFO, sMSG("Setting up default heaps."));
         Heap_data_cnew(
             HEAP_BASE_CAPACITY,
@@ -3394,11 +4382,93 @@ void ctx_setup(struct GlobalContext *ctx, Heap *heap, Arena *arena) {
         );
     }
 
-    ctx->debug.callstack = nullptr; /// @todo
+    ctx_local().debug.callstack = &ctx->debug.traces;
     ctx->debug.perf_metrics = nullptr; /// @todo
 
-    require_not_null(ctx->arenas.current);
-    require_not_null(ctx->heaps.current);
+    require_not_null(ctx_current_arena());
+    require_not_null(ctx_current_heap());
+}
+
+/// @brief Sets up the calling thread to evaluate: allocating on `arena` and `heap`, tracing
+///     ... into `callstack`, with no errors yet and a fresh random stream
+void InterpContext_enter(Arena *arena, Heap *heap, CallStack *callstack) {
+    require_not_null(arena);
+    require_not_null(heap);
+
+    ctx_local() = (InterpContext) {0};
+    ctx_local().arenas.current = arena;
+    ctx_local().heaps.current = heap;
+    ctx_local().debug.callstack = callstack;
+}
+
+/// @brief Makes `point` the current thread's innermost recovery point (cf. interp_try)
+void InterpRecover_push(InterpRecover *point) {
+    CallStack *traces = ctx_local().debug.callstack;
+    point->prev = ctx_local().debug.recover;
+    point->arena = ctx_current_arena();
+    point->heap = ctx_current_heap();
+    point->trace_depth = traces == nullptr ? 0 : traces->top;
+    point->frame_depth = ctx_local().debug.num_frames;
+    ctx_local().debug.recover = point;
+}
+
+void InterpRecover_pop(InterpRecover *point) {
+    ctx_local().debug.recover = point->prev;
+}
+
+/// @note the frame is written before it is counted, so a SIGPROF handler on this thread
+///     ... (cf. Profiler_on_sigprof) only ever sees whole frames
+static inline void interp_frame_push(FixStr fn_name, Ast *call) {
+    size_t depth = ctx_local().debug.num_frames;
+    if(depth < INTERP_MAX_FRAMES) {
+        ctx_local().debug.frames[depth] = (InterpFrame) {.fn_name = fn_name, .call = call};
+    }
+    atomic_signal_fence(memory_order_release);
+    ctx_local().debug.num_frames = depth + 1;
+}
+
+static inline void interp_frame_pop(void) {
+    ctx_local().debug.num_frames--;
+}
+
+static uint64_t InterpContext_splitmix64(uint64_t *x) {
+    uint64_t z = (*x += 0x9E3779B97F4A7C15ull);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+    return z ^ (z >> 31);
+}
+
+/// @brief Restarts the current thread's random stream from `seed`, for reproducible runs
+void InterpContext_seed(uint64_t seed) {
+    for(size_t i = 0; i < 4; i++) {
+        ctx_local().rng.state[i] = InterpContext_splitmix64(&seed);
+    }
+    ctx_local().rng.seeded = true;
+}
+
+static inline uint64_t InterpContext_rotl(uint64_t x, int k) {
+    return (x << k) | (x >> (64 - k));
+}
+
+/// @brief A uniform draw in [0, 1) from the current thread's stream
+/// @note no syscall or lock per draw: only the first draw on a thread reads the OS
+double InterpContext_random(void) {
+    if(!ctx_local().rng.seeded) {
+        uint64_t hi = (uint64_t) (clib_random_improved() * 4294967296.0);
+        uint64_t lo = (uint64_t) (clib_random_improved() * 4294967296.0);
+        InterpContext_seed((hi << 32) | lo);
+    }
+
+    uint64_t *s = ctx_local().rng.state;
+    uint64_t result = InterpContext_rotl(s[1] * 5, 7) * 9;
+    uint64_t t = s[1] << 17;
+    s[2] ^= s[0];
+    s[3] ^= s[1];
+    s[1] ^= s[2];
+    s[0] ^= s[3];
+    s[2] ^= t;
+    s[3] = InterpContext_rotl(s[3], 45);
+    return (double) (result >> 11) * 0x1.0p-53;
 }
 
 #pragma endregion
@@ -3538,10 +4608,12 @@ FixStr FixStr_col_new(const char *color_code, FixStr str) {
 /// ....  eg., """quote""" -> quote
 /// @param str
 /// @return
+/// @brief Strips one pair of matching delimiters, eg., the quotes around a string literal
+/// @note only the one pair: the contents may begin and end with the same character ("a", "aba")
 FixStr FixStr_trim_delim(FixStr str) {
     if (str.size < 2) return str;
 
-    while (str.cstr[0] == str.cstr[str.size - 1]) {
+    if (str.cstr[0] == str.cstr[str.size - 1]) {
         str = (FixStr) {.cstr = str.cstr + 1, .size = str.size - 2};
     }
     return str;
@@ -3697,7 +4769,7 @@ FixStr FixStr_glue_new(FixStr left, FixStr right) {
     if(left.size == 0) return right;
 
     size_t new_len = left.size + right.size;
-    char *buffer = (char *) Arena_alloc(new_len);
+    char *buffer = (char *) Arena_alloc(new_len + 1);
     if (!buffer) { error_oom(); return FixStr_empty(); }
 
     require_safe(clib_memcpy_safe(buffer, left.size, left.cstr, left.size));
@@ -3710,7 +4782,7 @@ FixStr FixStr_glue_new(FixStr left, FixStr right) {
 
 FixStr FixStr_glue_sep_new(FixStr left, FixStr sep, FixStr right) {
     size_t new_len = left.size + sep.size + right.size;
-    char *buffer = (char *) Arena_alloc(new_len);
+    char *buffer = (char *) Arena_alloc(new_len + 1);
     if (!buffer) { error_oom(); return FixStr_empty(); }
 
     /// old: memcpy(buffer, left.cstr, left.size);
@@ -3853,7 +4925,7 @@ char base37_to_char(uint8_t value) {
 FixStr FixStr_repeat_new(FixStr str, size_t count) {
     if(count == 0) return FixStr_empty();
     size_t new_len = str.size * count;
-    char *buffer = (char *) Arena_alloc(new_len);
+    char *buffer = (char *) Arena_alloc(new_len + 1);
     if (!buffer) { error_oom(); return FixStr_empty(); }
 
     for (size_t i = 0; i < count; i++) {
@@ -4249,6 +5321,147 @@ int string_test_main(void) {
 #endif
 
 
+/// ----- Raw allocations ----- ///
+
+#ifdef DEBUG_MEMORY
+static void MemTrack_lock(MemTrack *track) {
+    while(atomic_exchange_explicit(&track->is_locked, true, memory_order_acquire)) { sched_yield(); }
+}
+
+static void MemTrack_unlock(MemTrack *track) {
+    atomic_store_explicit(&track->is_locked, false, memory_order_release);
+}
+
+static size_t MemTrack_slot(void *ptr, size_t capacity) {
+    return (((uintptr_t) ptr >> 4) * 0x9E3779B97F4A7C15ull) & (capacity - 1);
+}
+
+/// @brief Rehashes the live entries into a table at most a quarter full, dropping tombstones
+static bool MemTrack_grow(MemTrack *track) {
+    size_t capacity = 1024;
+    while(capacity < 4 * (track->num_live + 1)) { capacity *= 2; }
+
+    MemTrackEntry *entries = calloc(capacity, sizeof(MemTrackEntry));
+    if(entries == nullptr) { return false; }
+
+    for(size_t i = 0; i < track->capacity; i++) {
+        MemTrackEntry *entry = &track->entries[i];
+        if(entry->ptr == nullptr || entry->is_free) { continue; }
+
+        size_t slot = MemTrack_slot(entry->ptr, capacity);
+        while(entries[slot].ptr != nullptr) { slot = (slot + 1) & (capacity - 1); }
+        entries[slot] = *entry;
+    }
+
+    free(track->entries);
+    track->entries = entries;
+    track->capacity = capacity;
+    track->num_used = track->num_live;
+    return true;
+}
+
+static void MemTrack_add(MemTrack *track, void *ptr, size_t size, AllocSite site) {
+    if(2 * (track->num_used + 1) > track->capacity && !MemTrack_grow(track)) {
+        log_message(LL_WARNING, sMSG("Out of memory to track %p: it won't be in the leak report"), ptr);
+        return;
+    }
+
+    size_t slot = MemTrack_slot(ptr, track->capacity);
+    while(track->entries[slot].ptr != nullptr && !track->entries[slot].is_free) {
+        slot = (slot + 1) & (track->capacity - 1);
+    }
+    if(track->entries[slot].ptr == nullptr) { track->num_used++; }
+    track->entries[slot] = (MemTrackEntry) {.ptr = ptr, .size = size, .site = site, .is_free = false};
+
+    track->num_live++;
+    track->live_bytes += size;
+    if(track->live_bytes > track->peak_bytes) { track->peak_bytes = track->live_bytes; }
+}
+
+/// @return false if `ptr` isn't a live tracked allocation
+static bool MemTrack_remove(MemTrack *track, void *ptr) {
+    if(track->capacity == 0) { return false; }
+
+    size_t slot = MemTrack_slot(ptr, track->capacity);
+    for(; track->entries[slot].ptr != nullptr; slot = (slot + 1) & (track->capacity - 1)) {
+        MemTrackEntry *entry = &track->entries[slot];
+        if(entry->ptr != ptr || entry->is_free) { continue; }
+
+        entry->is_free = true;
+        track->num_live--;
+        track->live_bytes -= entry->size;
+        return true;
+    }
+    return false;
+}
+#endif
+
+void *mem_cnew(size_t alloc_size, AllocSite site) {
+    void *ptr = malloc(alloc_size);
+    if(ptr == nullptr) { return nullptr; }
+
+    #ifdef DEBUG_MEMORY
+        log_message(LL_DEBUG, sMSG("Allocating %zu bytes (malloc)"), alloc_size);
+        MemTrack_lock(&ctx_debug_memory());
+        MemTrack_add(&ctx_debug_memory(), ptr, alloc_size, site);
+        MemTrack_unlock(&ctx_debug_memory());
+    #endif
+
+    if(atomic_load_explicit(&ctx().debug.allocs, memory_order_relaxed) != nullptr) {
+        AllocProfile_record(ALLOC_RAW, site, alloc_size, 0);
+    }
+    return ptr;
+}
+
+void *mem_cextend(void *ptr, size_t alloc_size, AllocSite site) {
+    void *new_ptr = realloc(ptr, alloc_size);
+    if(new_ptr == nullptr) { return nullptr; }
+
+    #ifdef DEBUG_MEMORY
+        log_message(LL_DEBUG, sMSG("Reallocating %zu bytes (realloc)"), alloc_size);
+        MemTrack_lock(&ctx_debug_memory());
+        if(ptr != nullptr) { MemTrack_remove(&ctx_debug_memory(), ptr); }
+        MemTrack_add(&ctx_debug_memory(), new_ptr, alloc_size, site);
+        MemTrack_unlock(&ctx_debug_memory());
+    #endif
+
+    if(atomic_load_explicit(&ctx().debug.allocs, memory_order_relaxed) != nullptr) {
+        AllocProfile_record(ALLOC_RAW, site, alloc_size, 0);
+    }
+    return new_ptr;
+}
+
+void mem_cfree(void *ptr) {
+    #ifdef DEBUG_MEMORY
+        log_message(LL_DEBUG, sMSG("Freeing memory: %p"), ptr);
+        MemTrack_lock(&ctx_debug_memory());
+        bool was_live = ptr == nullptr || MemTrack_remove(&ctx_debug_memory(), ptr);
+        MemTrack_unlock(&ctx_debug_memory());
+        if(!was_live) { log_message(LL_WARNING, sMSG("Freeing memory that isn't live: %p"), ptr); }
+    #endif
+
+    free(ptr);
+}
+
+/// @brief Logs each raw allocation never freed, with the site that made it
+void mem_log_leaks(void) {
+    #ifdef DEBUG_MEMORY
+        MemTrack *track = &ctx_debug_memory();
+        MemTrack_lock(track);
+        for(size_t i = 0; i < track->capacity; i++) {
+            MemTrackEntry *entry = &track->entries[i];
+            if(entry->ptr == nullptr || entry->is_free) { continue; }
+            log_message(LL_DEBUG, sMSG("Leaked memory: %p (%zu bytes, from %s:%zu)"),
+                entry->ptr, entry->size, entry->site.fn_name, entry->site.line);
+        }
+        log_message(LL_DEBUG, sMSG("Raw allocations: %zu live (%zu bytes), peak %zu bytes"),
+            track->num_live, track->live_bytes, track->peak_bytes);
+        MemTrack_unlock(track);
+    #endif
+}
+
+
+
 static bool Arena_block_cnew(Arena *a, size_t size) {
     require_not_null(a);
     require_positive(size);
@@ -4269,14 +5482,14 @@ static bool Arena_block_cnew(Arena *a, size_t size) {
         void **new_blocks = cextend(a->blocks, new_capacity * sizeof(void *));
         if (!new_blocks) {
             error_oom();
-            free(block);
+            cfree(block);
             return false;
         }
 
         size_t *new_block_sizes = cextend(a->block_sizes, new_capacity * sizeof(size_t));
         if (!new_block_sizes) {
             error_oom();
-            free(block);
+            cfree(block);
             return false;
         }
 
@@ -4399,12 +5612,15 @@ void Arena_aro_free_underlying(Arena *a) {
     require_not_null(a);
 
     for(size_t i = 0; i < a->num_blocks; i++) {
-        free(a->blocks[i]);
+        cfree(a->blocks[i]);
     }
-    free(a->blocks);
+    cfree(a->blocks);
+    cfree(a->block_sizes);
 
     a->blocks = nullptr;
+    a->block_sizes = nullptr;
     a->num_blocks = 0;
+    a->live_bytes = 0;
 }
 
 void *Arena_new(size_t alloc_size, MetaType type) {
@@ -4437,6 +5653,10 @@ void *Arena_new(size_t alloc_size, MetaType type) {
         box->meta.lifetime = a->lifetime;
     }
     a->used += alloc_size;
+
+    a->live_bytes += alloc_size;
+    if(a->live_bytes > a->peak_bytes) { a->peak_bytes = a->live_bytes; }
+    AllocProfile_record_marked(ALLOC_ARENA, alloc_size, type);
     return ptr;
 }
 
@@ -4485,6 +5705,42 @@ void *Arena_cextend(void *ptr, size_t old_size, size_t new_size) {
 void Arena_reset(Arena *a) {
     require_not_null(a);
     a->used = 0;
+    a->live_bytes = 0;
+}
+
+/// @brief Moves every block of `from` into `into`, to be freed with it; `from` is left empty
+/// @note the blocks go before `into`'s current block, which it carries on filling
+void Arena_adopt(Arena *into, Arena *from) {
+    require_not_null(into);
+    require_not_null(from);
+    require_positive(into->num_blocks);
+
+    size_t num_blocks = into->num_blocks + from->num_blocks;
+    size_t capacity = (num_blocks + 31) / 32 * 32;
+    void **blocks = cextend(into->blocks, capacity * sizeof(void *));
+    if(blocks == nullptr) { error_oom(); return; }
+    into->blocks = blocks;
+    size_t *block_sizes = cextend(into->block_sizes, capacity * sizeof(size_t));
+    if(block_sizes == nullptr) { error_oom(); return; }
+    into->block_sizes = block_sizes;
+
+    size_t current = into->num_blocks - 1;
+    blocks[num_blocks - 1] = blocks[current];
+    block_sizes[num_blocks - 1] = block_sizes[current];
+    for(size_t i = 0; i < from->num_blocks; i++) {
+        blocks[current + i] = from->blocks[i];
+        block_sizes[current + i] = from->block_sizes[i];
+    }
+    into->num_blocks = num_blocks;
+    into->live_bytes += from->live_bytes;
+    if(into->live_bytes > into->peak_bytes) { into->peak_bytes = into->live_bytes; }
+
+    cfree(from->blocks);
+    cfree(from->block_sizes);
+    from->blocks = nullptr;
+    from->block_sizes = nullptr;
+    from->num_blocks = 0;
+    from->live_bytes = 0;
 }
 
 /// @todo: maybe Arena_reset_withzero()
@@ -4532,7 +5788,7 @@ void Heap_data_cnew(size_t initial_capacity, size_t gc_threshold) {
     cnew_carray(h, initial_capacity);
 }
 
-void *Heap_cnew(size_t alloc_size, MetaType type) {
+static void *Heap_cnew_unsynchronized(size_t alloc_size, MetaType type) {
     Heap *heap = ctx_current_heap();
     MetaValue *obj = nullptr;
 
@@ -4542,8 +5798,8 @@ void *Heap_cnew(size_t alloc_size, MetaType type) {
         heap->free_list = heap->free_list->meta.next;
     } else {
         // Expand the data array if necessary
-        if (is_empty_ref(heap)) {
-            size_t new_capacity = HeapArray_next_capacity(capacity_ref(heap));
+        if (len_ref(heap) >= capacity_ref(heap)) {
+            size_t new_capacity = HeapArray_next_capacity(capacity_ref(heap) + 1);
             MetaValue **new_data = cextend(heap->data, sizeof(MetaValue *) * new_capacity);
             if (!new_data) {
                 log_message(LL_ERROR, sMSG("Heap allocation failed: no space to expand data array."));
@@ -4579,9 +5835,58 @@ void *Heap_cnew(size_t alloc_size, MetaType type) {
         return nullptr;
     }
 
+    AllocProfile_record_marked(ALLOC_HEAP, alloc_size, type);
     return obj->data;
 }
 
+/// @brief Frees every object of `heap` and its object table
+void Heap_destroy(Heap *heap) {
+    require_not_null(heap);
+
+    for(size_t i = 0; i < len_ref(heap); i++) {
+        cfree(heap->data[i]->data);
+        cfree(heap->data[i]);
+    }
+    cfree(heap->data);
+    *heap = (Heap) {0};
+}
+
+/// @note pool tasks may allocate concurrently, so the free list and object table are
+///     ... guarded while the pool is running
+void *Heap_cnew(size_t alloc_size, MetaType type) {
+    TaskPool *pool = ctx().threads.pool;
+    if(pool == nullptr) { return Heap_cnew_unsynchronized(alloc_size, type); }
+
+    pthread_mutex_lock(&pool->heap_lock);
+    void *data = Heap_cnew_unsynchronized(alloc_size, type);
+    pthread_mutex_unlock(&pool->heap_lock);
+    return data;
+}
+
+/// @brief Returns the object holding `data` to the free list, for a constructor that gives up
+///     ... on an object it has just made; the table is scanned from its newest object
+void Heap_cfree(void *data) {
+    if(data == nullptr) { return; }
+
+    TaskPool *pool = ctx().threads.pool;
+    if(pool != nullptr) { pthread_mutex_lock(&pool->heap_lock); }
+
+    Heap *heap = ctx_current_heap();
+    for(size_t i = len_ref(heap); i > 0; i--) {
+        MetaValue *obj = heap->data[i - 1];
+        if(obj->data != data) { continue; }
+
+        cfree(obj->data);
+        obj->data = nullptr;
+        obj->meta.state = LIVING_DEAD;
+        obj->meta.next = heap->free_list;
+        heap->free_list = obj;
+        break;
+    }
+
+    if(pool != nullptr) { pthread_mutex_unlock(&pool->heap_lock); }
+}
+
 void Heap_test_main(void) {
     log_assert(false, sMSG("Heap tests not implemented"));
 }
@@ -4614,74 +5919,588 @@ void Thread_wait(Thread *thread)  { pthread_cond_wait(&thread->cond, &thread->mu
 void Thread_lock(Thread *thread) { pthread_mutex_lock(&thread->mutex); }
 void Thread_unlock(Thread *thread) { pthread_mutex_unlock(&thread->mutex); }
 
-void *thread_test_worker(void *arg) {
-    Thread *thread = (Thread *) arg;
-    Thread_lock(thread);
-    log_message(LL_INFO, sMSG("Worker thread started."));
-    Thread_wait(thread);
-    log_message(LL_INFO, sMSG("Worker thread signaled."));
-    Thread_unlock(thread);
-    return nullptr;
-}
+/// ----- Compute pool ----- ///
 
-void thread_test_main(void) {
-    Thread thread;
-    Thread_init(&thread);
-    Thread_start(&thread, thread_test_worker, &thread);
-    sleep(1);
-    Thread_lock(&thread);
-    log_message(LL_INFO, sMSG("Main thread signaling worker."));
-    Thread_signal(&thread);
-    Thread_unlock(&thread);
-    Thread_join(&thread);
-    Thread_destroy(&thread);
+/// @brief Owner only: pushes at the bottom; false when the deque is full
+static bool TaskDeque_push(TaskDeque *deque, Task *task) {
+    int_fast64_t bottom = atomic_load_explicit(&deque->bottom, memory_order_relaxed);
+    int_fast64_t top = atomic_load_explicit(&deque->top, memory_order_acquire);
+    if(bottom - top >= TASK_DEQUE_CAPACITY) { return false; }
+
+    atomic_store_explicit(&deque->buffer[bottom % TASK_DEQUE_CAPACITY], task, memory_order_relaxed);
+    atomic_store_explicit(&deque->bottom, bottom + 1, memory_order_release);
+    return true;
 }
 
-#pragma endregion
+/// @brief Owner only: pops the most recently pushed task, racing thieves for the last one
+static Task *TaskDeque_pop(TaskDeque *deque) {
+    int_fast64_t bottom = atomic_load_explicit(&deque->bottom, memory_order_relaxed) - 1;
+    atomic_store_explicit(&deque->bottom, bottom, memory_order_seq_cst);
+    int_fast64_t top = atomic_load_explicit(&deque->top, memory_order_seq_cst);
 
-#pragma region TracebackImpl
+    if(top > bottom) {
+        atomic_store_explicit(&deque->bottom, bottom + 1, memory_order_relaxed);
+        return nullptr;
+    }
 
-#define Tracer_print_last(ts) (Tracer_print_stack(ts, 16))
+    Task *task = atomic_load_explicit(&deque->buffer[bottom % TASK_DEQUE_CAPACITY], memory_order_relaxed);
+    if(top == bottom) {
+        if(!atomic_compare_exchange_strong_explicit(&deque->top, &top, top + 1,
+                memory_order_seq_cst, memory_order_relaxed)) {
+            task = nullptr;
+        }
+        atomic_store_explicit(&deque->bottom, bottom + 1, memory_order_relaxed);
+    }
+    return task;
+}
 
-void Tracer_print_stack(CallStack *ts, size_t depth) {
-    log_message(LL_INFO, s("Traceback (most recent call last):\n"));
-    for (int i = ts->top - 1; i >= 0 && depth--; i--) {
-        FixStr arg = FixStr_is_empty(ts->data[i].argument) ?
-            s("(nullptr)") : ts->data[i].argument;
+/// @brief Any thread: takes the oldest task, or nullptr if empty or another thief won
+static Task *TaskDeque_steal(TaskDeque *deque) {
+    int_fast64_t top = atomic_load_explicit(&deque->top, memory_order_seq_cst);
+    int_fast64_t bottom = atomic_load_explicit(&deque->bottom, memory_order_seq_cst);
+    if(top >= bottom) { return nullptr; }
 
-        log_message(LL_INFO, s("   %.*s:%d\t\tat %.*s(' %.*s ')"),
-            fmt(ts->data[i].file), ts->data[i].line,
-            fmt(ts->data[i].fn_name), fmt(arg)
-        );
+    Task *task = atomic_load_explicit(&deque->buffer[top % TASK_DEQUE_CAPACITY], memory_order_relaxed);
+    if(!atomic_compare_exchange_strong_explicit(&deque->top, &top, top + 1,
+            memory_order_seq_cst, memory_order_relaxed)) {
+        return nullptr;
+    }
+    return task;
+}
+
+/// @brief The worker the current thread is: a pool thread, or the thread that started the
+///     ... pool as worker 0; nullptr for any other thread
+static TaskWorker *TaskPool_current(void) {
+    if(TaskPool_self != nullptr) { return TaskPool_self; }
+    TaskPool *pool = ctx().threads.pool;
+    return pool != nullptr && pthread_equal(pool->owner, pthread_self()) ? &pool->workers[0] : nullptr;
+}
+
+/// @brief Queues a task spawned off the pool, waking a worker for it
+static void TaskPool_inject(TaskPool *pool, Task *task) {
+    pthread_mutex_lock(&pool->lock);
+    task->next = nullptr;
+    if(pool->injected_last == nullptr) {
+        pool->injected = task;
+    } else {
+        pool->injected_last->next = task;
+    }
+    pool->injected_last = task;
+    atomic_fetch_add_explicit(&pool->pending, 1, memory_order_relaxed);
+    pthread_cond_signal(&pool->wake);
+    pthread_mutex_unlock(&pool->lock);
+}
+
+/// @brief Takes the oldest injected task, if any
+static Task *TaskPool_take_injected(TaskPool *pool) {
+    if(atomic_load_explicit(&pool->pending, memory_order_relaxed) == 0) { return nullptr; }
+
+    pthread_mutex_lock(&pool->lock);
+    Task *task = pool->injected;
+    if(task != nullptr) {
+        pool->injected = task->next;
+        if(pool->injected == nullptr) { pool->injected_last = nullptr; }
+    }
+    pthread_mutex_unlock(&pool->lock);
+    return task;
+}
+
+/// @brief Work for `self` (nullptr off the pool): its own newest task, else the oldest task
+///     ... of another worker, else the oldest injected task
+static Task *TaskPool_find(TaskPool *pool, TaskWorker *self) {
+    Task *task = self == nullptr ? nullptr : TaskDeque_pop(&self->deque);
+    size_t first = self == nullptr ? 0 : self->index + 1;
+    for(size_t k = 0; task == nullptr && k < pool->num_workers; k++) {
+        TaskWorker *victim = &pool->workers[(first + k) % pool->num_workers];
+        if(victim != self) { task = TaskDeque_steal(&victim->deque); }
+    }
+    if(task == nullptr) { task = TaskPool_take_injected(pool); }
+    if(task != nullptr) { atomic_fetch_sub_explicit(&pool->pending, 1, memory_order_relaxed); }
+    return task;
+}
+
+/// @note unless it is run where its spawner left off (eg., inline), the task evaluates in
+///     ... its spawner's heap and on its own arena, with no recovery point or model weight of
+///     ... whatever this thread was running before; the rest of the thread's state is kept
+/// @note tasks nest as deep as joins steal, so only what is swapped is saved, not the context
+static void Task_run(Task *task) {
+    if(task->parent == ctx_current_arena() || task->parent == nullptr || task->heap == nullptr) {
+        task->result = task->fn(task->arg);
+        atomic_store_explicit(&task->done, true, memory_order_release);
+        return;
+    }
+
+    Arena *arena = ctx_current_arena();
+    Heap *heap = ctx_current_heap();
+    InterpRecover *recover = ctx_local().debug.recover;
+    size_t num_frames = ctx_local().debug.num_frames;
+    double log_weight = ctx_local().inference.log_weight;
+    size_t num_observed = ctx_local().inference.num_observed;
+
+    if(!Arena_init(&task->arena, TASK_ARENA_BLOCK)) { error_oom(); }
+    task->arena.lifetime = task->parent->lifetime;
+    ctx_current_arena() = &task->arena;
+    ctx_current_heap() = task->heap;
+    ctx_local().debug.recover = nullptr;
+    ctx_local().debug.num_frames = 0;
+    ctx_local().inference.log_weight = 0.0;
+    ctx_local().inference.num_observed = 0;
+
+    task->result = task->fn(task->arg);
+
+    ctx_current_arena() = arena;
+    ctx_current_heap() = heap;
+    ctx_local().debug.recover = recover;
+    ctx_local().debug.num_frames = num_frames;
+    ctx_local().inference.log_weight = log_weight;
+    ctx_local().inference.num_observed = num_observed;
+    atomic_store_explicit(&task->done, true, memory_order_release);
+}
+
+static void *TaskPool_worker(void *arg) {
+    TaskWorker *self = (TaskWorker *) arg;
+    TaskPool *pool = self->pool;
+    TaskPool_self = self;
+    ctx_local().debug.callstack = &self->traces;
+
+    while(!atomic_load(&pool->shutdown)) {
+        Task *task = TaskPool_find(pool, self);
+        if(task != nullptr) { Task_run(task); continue; }
+
+        pthread_mutex_lock(&pool->lock);
+        while(atomic_load(&pool->pending) == 0 && !atomic_load(&pool->shutdown)) {
+            pthread_cond_wait(&pool->wake, &pool->lock);
+        }
+        pthread_mutex_unlock(&pool->lock);
+    }
+    return nullptr;
+}
+
+/// @brief Starts `num_workers` compute workers (0: one per online core)
+/// @note the calling thread becomes worker 0; idempotent once started, and safe to race:
+///     ... the pool is published only once its workers are running
+bool TaskPool_start(size_t num_workers) {
+    if(ctx().threads.pool != nullptr) { return true; }
+
+    pthread_mutex_lock(&TaskPool_start_lock);
+    if(ctx().threads.pool != nullptr) {
+        pthread_mutex_unlock(&TaskPool_start_lock);
+        return true;
+    }
+
+    if(num_workers == 0) {
+        long cores = sysconf(_SC_NPROCESSORS_ONLN);
+        num_workers = cores > 0 ? (size_t) cores : 1;
+    }
+    if(num_workers > CPU_CORES_MAX) { num_workers = CPU_CORES_MAX; }
+
+    TaskPool *pool = cnew(sizeof(TaskPool));
+    TaskWorker *workers = cnew(num_workers * sizeof(TaskWorker));
+    if(pool == nullptr || workers == nullptr) {
+        error_oom();
+        cfree(pool);
+        cfree(workers);
+        pthread_mutex_unlock(&TaskPool_start_lock);
+        return false;
+    }
+    memset(workers, 0, num_workers * sizeof(TaskWorker));
+
+    pool->workers = workers;
+    pool->num_workers = num_workers;
+    atomic_init(&pool->pending, 0);
+    atomic_init(&pool->shutdown, false);
+    pthread_mutex_init(&pool->lock, nullptr);
+    pthread_cond_init(&pool->wake, nullptr);
+    pool->injected = nullptr;
+    pool->injected_last = nullptr;
+    pool->owner = pthread_self();
+    pthread_mutex_init(&pool->heap_lock, nullptr);
+
+    for(size_t w = 0; w < num_workers; w++) {
+        TaskWorker *worker = &workers[w];
+        worker->index = w;
+        worker->pool = pool;
+        atomic_init(&worker->deque.top, 0);
+        atomic_init(&worker->deque.bottom, 0);
+    }
+
+    ctx().threads.num_compute = num_workers;
+    for(size_t w = 1; w < num_workers; w++) {
+        ctx().threads.compute[w] = &workers[w].thread;
+        Thread_init(&workers[w].thread);
+        Thread_start(&workers[w].thread, TaskPool_worker, &workers[w]);
+    }
+    ctx().threads.pool = pool;
+    pthread_mutex_unlock(&TaskPool_start_lock);
+    return true;
+}
+
+/// @brief Stops and joins the workers
+void TaskPool_stop(void) {
+    pthread_mutex_lock(&TaskPool_start_lock);
+    TaskPool *pool = ctx().threads.pool;
+    if(pool == nullptr) {
+        pthread_mutex_unlock(&TaskPool_start_lock);
+        return;
+    }
+
+    pthread_mutex_lock(&pool->lock);
+    atomic_store(&pool->shutdown, true);
+    pthread_cond_broadcast(&pool->wake);
+    pthread_mutex_unlock(&pool->lock);
+
+    for(size_t w = 1; w < pool->num_workers; w++) {
+        Thread_join(&pool->workers[w].thread);
+        Thread_destroy(&pool->workers[w].thread);
+        ctx().threads.compute[w] = nullptr;
+    }
+    pthread_mutex_destroy(&pool->lock);
+    pthread_cond_destroy(&pool->wake);
+    pthread_mutex_destroy(&pool->heap_lock);
+
+    ctx().threads.pool = nullptr;
+    ctx().threads.num_compute = 0;
+    cfree(pool->workers);
+    cfree(pool);
+    pthread_mutex_unlock(&TaskPool_start_lock);
+}
+
+/// @brief The number of compute workers, starting the pool on first use
+size_t TaskPool_num_workers(void) {
+    if(ctx().threads.pool == nullptr && !TaskPool_start(0)) { return 1; }
+    return ctx().threads.num_compute;
+}
+
+/// @brief The arena allocations of the current task go to (the current arena off the pool)
+Arena *TaskPool_arena(void) {
+    return ctx_current_arena();
+}
+
+/// @brief Makes `task` (running fn(arg)) available to the pool; it runs inline when the
+///     ... pool has a single worker or the current deque is full
+void Task_spawn(Task *task, void *(*fn)(void *), void *arg) {
+    require_not_null(task);
+    require_not_null(fn);
+
+    task->fn = fn;
+    task->arg = arg;
+    task->result = nullptr;
+    atomic_init(&task->done, false);
+    task->parent = ctx_current_arena();
+    task->heap = ctx_current_heap();
+    task->arena = (Arena) {0};
+
+    if(TaskPool_num_workers() < 2) {
+        Task_run(task);
+        return;
+    }
+
+    TaskPool *pool = ctx().threads.pool;
+    TaskWorker *self = TaskPool_current();
+    if(self == nullptr) {
+        TaskPool_inject(pool, task);
+        return;
+    }
+    if(!TaskDeque_push(&self->deque, task)) {
+        Task_run(task);
+        return;
+    }
+
+    atomic_fetch_add_explicit(&pool->pending, 1, memory_order_relaxed);
+    pthread_mutex_lock(&pool->lock);
+    pthread_cond_signal(&pool->wake);
+    pthread_mutex_unlock(&pool->lock);
+}
+
+/// @brief Waits for `task`, running other tasks meanwhile, and returns its result
+void *Task_join(Task *task) {
+    require_not_null(task);
+
+    TaskPool *pool = ctx().threads.pool;
+    TaskWorker *self = TaskPool_current();
+    while(!atomic_load_explicit(&task->done, memory_order_acquire)) {
+        Task *other = pool == nullptr ? nullptr : TaskPool_find(pool, self);
+        if(other != nullptr) {
+            Task_run(other);
+        } else {
+            sched_yield();
+        }
+    }
+
+    if(task->arena.blocks != nullptr) { Arena_adopt(task->parent, &task->arena); }
+    return task->result;
+}
+
+/// @brief Runs `worker` over an array of `num_tasks` task records of `task_size` bytes:
+///     ... the first on the calling thread, the rest spawned onto the pool
+void TaskPool_run(void *tasks, size_t task_size, size_t num_tasks, void *(*worker)(void *)) {
+    require_not_null(tasks);
+    require(num_tasks > 0 && num_tasks <= CPU_CORES_MAX);
+
+    if(num_tasks == 1) {
+        worker(tasks);
+        return;
+    }
+
+    Task handles[CPU_CORES_MAX];
+    for(size_t t = 1; t < num_tasks; t++) {
+        Task_spawn(&handles[t], worker, (char *) tasks + t * task_size);
+    }
+    worker(tasks);
+    for(size_t t = 1; t < num_tasks; t++) {
+        Task_join(&handles[t]);
+    }
+}
+
+typedef struct TaskPoolTestFib {
+    int n;
+    long result;
+} TaskPoolTestFib;
+
+static void *TaskPool_test_fib(void *arg) {
+    TaskPoolTestFib *fib = (TaskPoolTestFib *) arg;
+    if(fib->n < 2) {
+        fib->result = fib->n;
+        return fib;
+    }
+
+    TaskPoolTestFib left = { .n = fib->n - 1 }, right = { .n = fib->n - 2 };
+    Task task;
+    Task_spawn(&task, TaskPool_test_fib, &left);
+    TaskPool_test_fib(&right);
+    Task_join(&task);
+    fib->result = left.result + right.result;
+    return fib;
+}
+
+static void *TaskPool_test_alloc(void *arg) {
+    long *sum = (long *) arg;
+    for(long i = 0; i < 1000; i++) {
+        long *cell = Arena_alloc(sizeof(long));
+        *cell = i;
+        *sum += *cell;
+    }
+    return arg;
+}
+
+typedef struct TaskPoolTestHost {
+    Thread thread;
+    Arena arena;
+    Heap *heap;
+    CallStack traces;
+    TaskPoolTestFib fib;
+} TaskPoolTestHost;
+
+/// @brief A host thread off the pool: starts it if need be, then spawns through the injection queue
+static void *TaskPool_test_host(void *arg) {
+    TaskPoolTestHost *host = (TaskPoolTestHost *) arg;
+    InterpContext_enter(&host->arena, host->heap, &host->traces);
+    TaskPool_start(4);
+    TaskPool_test_fib(&host->fib);
+    return nullptr;
+}
+
+void TaskPool_test_main(void) {
+    TaskPool_stop();
+
+    /// host threads racing to start the pool, then spawning from off the pool at once
+    TaskPoolTestHost hosts[3] = { { .fib.n = 18 }, { .fib.n = 18 }, { .fib.n = 18 } };
+    for(size_t h = 0; h < 3; h++) {
+        Arena_init(&hosts[h].arena, ARENA_1MB);
+        hosts[h].heap = ctx_current_heap();
+        Thread_init(&hosts[h].thread);
+        Thread_start(&hosts[h].thread, TaskPool_test_host, &hosts[h]);
+    }
+    for(size_t h = 0; h < 3; h++) {
+        Thread_join(&hosts[h].thread);
+        Thread_destroy(&hosts[h].thread);
+        Arena_aro_free_underlying(&hosts[h].arena);
+        log_assert(hosts[h].fib.result == 2584, sMSG("Each host thread should compute fib(18)"));
+    }
+    log_assert(TaskPool_num_workers() == 4, sMSG("Racing starts should start a single pool"));
+    TaskPool_stop();
+
+    log_assert(TaskPool_start(4) && TaskPool_num_workers() == 4, sMSG("The pool should start the requested workers"));
+
+    /// nested spawns: each task spawns its left half and steals back while joining
+    TaskPoolTestFib fib = { .n = 20 };
+    TaskPool_test_fib(&fib);
+    log_assert(fib.result == 6765, sMSG("Nested spawn/join should compute fib(20)"));
+
+    /// concurrent arena allocation: each task allocates from its own arena, adopted on join
+    long sums[4] = {0};
+    TaskPool_run(sums, sizeof(long), 4, TaskPool_test_alloc);
+    for(size_t t = 0; t < 4; t++) {
+        log_assert(sums[t] == 999 * 1000 / 2, sMSG("Each task should see only its own allocations"));
+    }
+
+    TaskPool_stop();
+    log_assert(ctx().threads.pool == nullptr, sMSG("Stopping should release the pool"));
+}
+
+typedef struct InterpContextTestRun {
+    Thread thread;
+    Arena arena;
+    Heap *heap;
+    CallStack traces;
+    double draws[3];
+    size_t num_errors;
+    size_t arena_used;
+} InterpContextTestRun;
+
+/// @brief A stand-in for one model run on its own thread
+static void *InterpContext_test_run(void *arg) {
+    InterpContextTestRun *run = (InterpContextTestRun *) arg;
+    InterpContext_enter(&run->arena, run->heap, &run->traces);
+
+    InterpContext_seed(7);
+    for(size_t i = 0; i < 3; i++) { run->draws[i] = InterpContext_random(); }
+    Arena_alloc(64);
+    ctx_trace_me(s("run"));
+    error_push_runtime(BXE_NATIVE, s("raised on the run thread"), s(""));
+
+    run->num_errors = ctx_local().debug.num_errors;
+    run->arena_used = ctx_current_arena()->used;
+    return nullptr;
+}
+
+void InterpContext_test_main(void) {
+    InterpContext_seed(7);
+    double draws[3];
+    for(size_t i = 0; i < 3; i++) {
+        draws[i] = InterpContext_random();
+        log_assert(draws[i] >= 0.0 && draws[i] < 1.0, sMSG("Draws should be in [0, 1)"));
+    }
+
+    Arena *arena = ctx_current_arena();
+    size_t arena_used = arena->used;
+    size_t num_errors = ctx_local().debug.num_errors;
+
+    InterpContextTestRun runs[2] = {0};
+    for(size_t r = 0; r < 2; r++) {
+        Arena_init(&runs[r].arena, ARENA_1MB);
+        runs[r].heap = ctx_current_heap();
+        Thread_init(&runs[r].thread);
+        Thread_start(&runs[r].thread, InterpContext_test_run, &runs[r]);
+    }
+    for(size_t r = 0; r < 2; r++) {
+        Thread_join(&runs[r].thread);
+        Thread_destroy(&runs[r].thread);
+
+        log_assert(runs[r].num_errors == 1 && runs[r].traces.top == 1,
+            sMSG("A run should only see its own errors and traces"));
+        log_assert(runs[r].arena_used > 0, sMSG("A run should allocate on its own arena"));
+        for(size_t i = 0; i < 3; i++) {
+            log_assert(runs[r].draws[i] == draws[i], sMSG("The same seed should give the same stream on any thread"));
+        }
+        Arena_aro_free_underlying(&runs[r].arena);
+    }
+
+    log_assert(ctx_current_arena() == arena && arena->used == arena_used,
+        sMSG("Other runs should not touch this thread's arena"));
+    log_assert(ctx_local().debug.num_errors == num_errors, sMSG("Other runs should not touch this thread's errors"));
+
+    /// the error log keeps the most recent errors without overflowing
+    for(size_t i = 0; i < 2 * ARRAY_SIZE_SMALL; i++) {
+        error_push_runtime(BXE_NATIVE, s("filler"), s(""));
+    }
+    log_assert(ctx_local().debug.num_errors == num_errors + 2 * ARRAY_SIZE_SMALL, sMSG("Every error should be counted"));
+    ctx_local().debug.num_errors = num_errors;
+}
+
+void *thread_test_worker(void *arg) {
+    Thread *thread = (Thread *) arg;
+    Thread_lock(thread);
+    log_message(LL_INFO, sMSG("Worker thread started."));
+    Thread_wait(thread);
+    log_message(LL_INFO, sMSG("Worker thread signaled."));
+    Thread_unlock(thread);
+    return nullptr;
+}
+
+void thread_test_main(void) {
+    Thread thread;
+    Thread_init(&thread);
+    Thread_start(&thread, thread_test_worker, &thread);
+    sleep(1);
+    Thread_lock(&thread);
+    log_message(LL_INFO, sMSG("Main thread signaling worker."));
+    Thread_signal(&thread);
+    Thread_unlock(&thread);
+    Thread_join(&thread);
+    Thread_destroy(&thread);
+}
+
+#pragma endregion
+
+#pragma region TracebackImpl
+
+#define Tracer_print_last(ts) (Tracer_print_stack(ts, 16))
+
+void Tracer_print_stack(CallStack *ts, size_t depth) {
+    log_message(LL_INFO, s("Traceback (most recent call last):\n"));
+
+    TraceEntry entries[TRACER_CAPACITY];
+    size_t num_entries = Tracer_snapshot(ts, entries, depth);
+    depth -= num_entries;
+
+    for (size_t i = 0; i < num_entries; i++) {
+        FixStr arg = entries[i].argument;
+        if (FixStr_is_empty(arg) && entries[i].node != nullptr) {
+            arg = FixStr_firstN(Ast_to_FixStr(entries[i].node), 20);
+        }
+        arg = FixStr_is_empty(arg) ? s("(nullptr)") : arg;
+
+        log_message(LL_INFO, s("   %.*s:%d\t\tat %.*s(' %.*s ')"),
+            fmt(entries[i].file), entries[i].line,
+            fmt(entries[i].fn_name), fmt(arg)
+        );
     }
 
     if (depth > 0) {
         log_message(LL_INFO,  sMSG("   <-- TRACEBACK FINISHED EARLY -->\n"));
     }
 }
+/// @brief Debug builds stop at a full ring, as a sign of runaway recursion or looping
+void Tracer_overflow(CallStack *traces) {
+    log_message(LL_INFO, sMSG("Traceback overflow: tracer history is full!\n"));
+    Tracer_print_stack(traces, 16);
+    abort();
+}
+
 void Tracer_push(CallStack *traces, FixStr name, FixStr arg, FixStr file, size_t line) {
-    if (traces->top >= 512) {
-        log_message(LL_INFO, sMSG("Traceback overflow: cycling tracer history!\n"));
+    size_t top = atomic_load_explicit(&traces->top, memory_order_relaxed);
+    #ifdef TRACEBACK_ABORT_ON_OVERFLOW
+        if (top >= TRACER_CAPACITY) {
+            Tracer_overflow(traces);
+        }
+    #endif
 
-        #ifdef TRACEBACK_ABORT_ON_OVERFLOW
-            Tracer_print_stack(traces, 16);
-            abort();
-        #endif
+    traces->data[top % TRACER_CAPACITY] = (TraceEntry) {
+        .fn_name = name, .argument = arg, .time = Tracer_ticks(), .file = file, .line = line
+    };
+    atomic_store_explicit(&traces->top, top + 1, memory_order_release);
+}
 
-        traces->top = 0;
-    }
+/// @brief Copies up to `max` of the most recent entries into `out`, newest first
+/// @note safe from a signal handler that interrupted a push on the same thread: the slot
+///     ... being overwritten is the oldest, which is never copied
+/// @return the number of entries copied
+size_t Tracer_snapshot(CallStack *traces, TraceEntry *out, size_t max) {
+    size_t top = atomic_load_explicit(&traces->top, memory_order_acquire);
+    size_t available = top < TRACER_CAPACITY ? top : TRACER_CAPACITY - 1;
+    size_t n = max < available ? max : available;
 
-    traces->data[traces->top].fn_name = name;
-    traces->data[traces->top].argument = arg;
-    traces->data[traces->top].file = file;
-    traces->data[traces->top].line = line;
-    traces->top++;
+    for (size_t i = 0; i < n; i++) {
+        out[i] = traces->data[(top - 1 - i) % TRACER_CAPACITY];
+    }
+    return n;
 }
 
 // Pop a function from the call stack
 void Tracer_pop(CallStack *traces) {
-    if (traces->top > 0) {
-        traces->top--;
+    if (atomic_load_explicit(&traces->top, memory_order_relaxed) > 0) {
+        atomic_fetch_sub_explicit(&traces->top, 1, memory_order_release);
     } else {
         log_message(LL_INFO, sMSG("Traceback underflow: Mis_matched push/pop calls!\n"));
     }
@@ -4713,6 +6532,16 @@ void Tracer_test_main(void) {
     // Print the stack
     Tracer_print_stack(&cs, 10);
 
+    // Snapshots are newest first, a node recorded in place of a formatted argument
+    Ast node = { .type = AST_INT, .integer.value = 7 };
+    Tracer_push_node(&cs, s("eval"), &node, s("eval.c"), 50);
+    TraceEntry recent[8];
+    log_assert(Tracer_snapshot(&cs, recent, 8) == 4, sMSG("A snapshot should hold every live entry"));
+    log_assert(recent[0].node == &node && FixStr_is_empty(recent[0].argument), sMSG("The node should be kept unformatted"));
+    log_assert(FixStr_eq(recent[1].fn_name, s("baz")) && recent[1].time <= recent[0].time,
+        sMSG("Entries should be timestamped in order"));
+    Tracer_print_stack(&cs, 1);
+
     printf("Traceback Tests Completed.\n\n");
 }
 
@@ -4771,125 +6600,725 @@ void perf_time_report(void) {
     printf("Time elapsed: %ld.%09ld seconds\n", seconds, ns);
 }
 
-#pragma endregion
 
-#pragma region CliImpl
+/// ----- Sampling profiler ----- ///
 
+/// @note runs on whichever thread was using the CPU, so reads that thread's InterpContext. It
+///     ... only copies: no locks, no allocation, no logging
+/// @note the current line is that of the node most recently entered (cf. interp_trace): once a
+///     ... child returns, the time its parent spends is put on the child's line
+static void Profiler_on_sigprof(int signum) {
+    (void) signum;
+    Profiler *prof = atomic_load_explicit(&ctx().debug.profiler, memory_order_acquire);
+    CallStack *traces = ctx_local().debug.callstack;
+    if(prof == nullptr || traces == nullptr) { return; }
 
-void cli_parse_args(int argc, char *argv[], CliOption *out_opts, size_t num_opts) {
-    /// @note the first entry in out_opts will be the argv data up until the first option
-    /// ... defined by a leading `-` or `--`
-    /// ... this is to allow for positional arguments to be parsed
-    /// ... before the named options
+    size_t index = atomic_fetch_add_explicit(&prof->num_samples, 1, memory_order_relaxed);
+    if(index >= prof->capacity) { return; }
 
-    // Parse positional arguments
-    for (int i = 1; i < argc; i++) {
-        if (argv[i][0] == '-') break;
-        out_opts[0].value = FixStr_from_cstr(argv[i]);
-        out_opts[0].is_set = true;
-    }
+    TraceEntry latest = {0};
+    Tracer_snapshot(traces, &latest, 1);
 
-    for (int i = 1; i < argc; i++) {
-        for (size_t j = 0; j < num_opts; j++) {
-            if (FixStr_eq(s(argv[i]), out_opts[j].name)) {
-                out_opts[j].is_set = true;
-                if (i + 1 < argc) {
-                    out_opts[j].value = FixStr_from_cstr(argv[i + 1]);
-                }
-            }
-        }
-    }
-}
+    size_t depth = ctx_local().debug.num_frames;
+    atomic_signal_fence(memory_order_acquire);
+    size_t num_calls = depth < INTERP_MAX_FRAMES ? depth : INTERP_MAX_FRAMES;
+    InterpFrame *calls = ctx_local().debug.frames;
 
-void cli_print_opts(const CliOption options[], int num_options) {
-    printf("Command-Line Options:\n");
-    printf("----------------------------\n");
-    for (int i = 0; i < num_options; i++) {
-        printf("Option: %-10.*s | Set: %-5s | Value: %.*s | Default: %.*s\n",
-               fmt(options[i].name),
-               options[i].is_set ? "Yes" : "No",
-               fmt(options[i].value),
-               fmt(options[i].or_else));
+    /// @note stack entry `i` is the caller of call `i`: `<top>` for the first
+    size_t first = num_calls + 1 > PROFILER_MAX_DEPTH ? num_calls + 1 - PROFILER_MAX_DEPTH : 0;
+    ProfilerSample *sample = &prof->samples[index];
+    sample->num_frames = 0;
+    for(size_t i = first; i <= num_calls; i++) {
+        Ast *at = i < num_calls ? calls[i].call : latest.node;
+        sample->frames[sample->num_frames++] = (ProfilerFrame) {
+            .fn_name = i == first && first > 0 ? s("...") : i == 0 ? s("<top>") : calls[i - 1].fn_name,
+            .line = at == nullptr ? 0 : at->line + 1
+        };
     }
-    printf("----------------------------\n");
 }
 
+/// @brief Starts sampling every `interval_us` of the process's CPU time, into a buffer of
+///     ... `capacity` samples
+/// @return false if another profiler is running or the timer could not be set up
+bool Profiler_start(Profiler *prof, long interval_us, size_t capacity) {
+    require_not_null(prof);
+    require_positive(interval_us);
 
-#pragma endregion
+    *prof = (Profiler) {.capacity = capacity, .interval_us = interval_us};
+    prof->samples = cnew(capacity * sizeof(ProfilerSample));
+    if(prof->samples == nullptr) { error_oom(); return false; }
 
-#pragma region TestImpl
+    Profiler *none = nullptr;
+    if(!atomic_compare_exchange_strong(&ctx().debug.profiler, &none, prof)) {
+        log_message(LL_WARNING, sMSG("A profiler is already running."));
+        Profiler_free(prof);
+        return false;
+    }
 
+    struct sigaction action = {0};
+    action.sa_handler = Profiler_on_sigprof;
+    action.sa_flags = SA_RESTART;
+    sigemptyset(&action.sa_mask);
 
-void TestReport_push(TestReport *report, bool result, FixStr message) {
-    if (report->num_results > 32) {
-        log_message(LL_ERROR, sMSG("Warning: TestSuite capacity exceeded."));
-        return;
-    }
+    struct itimerval timer = {
+        .it_interval = {.tv_sec = interval_us / 1000000, .tv_usec = interval_us % 1000000},
+        .it_value = {.tv_sec = interval_us / 1000000, .tv_usec = interval_us % 1000000},
+    };
 
-    report->results[report->num_results] = result;
-    report->messages[report->num_results] = FixStr_copy(message);
-    report->num_results++;
+    if(sigaction(SIGPROF, &action, &prof->previous) != 0) {
+        log_message(LL_WARNING, sMSG("Could not install the SIGPROF handler: %s"), strerror(errno));
+        atomic_store(&ctx().debug.profiler, nullptr);
+        Profiler_free(prof);
+        return false;
+    }
+    if(setitimer(ITIMER_PROF, &timer, nullptr) != 0) {
+        log_message(LL_WARNING, sMSG("Could not start the profiling timer: %s"), strerror(errno));
+        sigaction(SIGPROF, &prof->previous, nullptr);
+        atomic_store(&ctx().debug.profiler, nullptr);
+        Profiler_free(prof);
+        return false;
+    }
+    return true;
 }
 
+/// @brief Stops the timer and puts back the previous SIGPROF handler; the samples are kept
+void Profiler_stop(Profiler *prof) {
+    require_not_null(prof);
 
-void TestSuite_register(TestSuite *ts, UnitTestFnPtr fnptr) {
-    if (ts->num_tests > 32) {
-        log_message(LL_ERROR, sMSG("Warning: TestSuite capacity exceeded."));
-        return;
-    }
+    struct itimerval off = {0};
+    setitimer(ITIMER_PROF, &off, nullptr);
+    sigaction(SIGPROF, &prof->previous, nullptr);
+    atomic_store(&ctx().debug.profiler, nullptr);
+}
 
-    ts->tests[ts->num_tests] = fnptr;
-    ts->num_tests++;
+void Profiler_free(Profiler *prof) {
+    require_not_null(prof);
+    if(prof->samples != nullptr) { cfree(prof->samples); }
+    prof->samples = nullptr;
 }
 
-void TestSuite_run(TestSuite *ts) {
-    Arena_init(&ctx().arenas.compiler, ARENA_1MB);
-    ctx_change_arena(&ctx().arenas.compiler);
+size_t Profiler_num_recorded(Profiler *prof) {
+    size_t num_samples = atomic_load(&prof->num_samples);
+    return num_samples < prof->capacity ? num_samples : prof->capacity;
+}
 
-    if (ts->num_tests > 32) {
-        log_message(LL_ERROR, sMSG("Warning: TestSuite capacity exceeded."));
-        return;
-    }
+size_t Profiler_num_dropped(Profiler *prof) {
+    return atomic_load(&prof->num_samples) - Profiler_num_recorded(prof);
+}
 
-    for (size_t i = 0; i < ts->num_tests; ++i) {
-        ts->tests[i](&ts->reports[i]);
+static int ProfilerFrame_cmp(ProfilerFrame left, ProfilerFrame right) {
+    int cmp = FixStr_cmp(left.fn_name, right.fn_name);
+    if(cmp != 0) { return cmp; }
+    return (left.line > right.line) - (left.line < right.line);
+}
+
+static int ProfilerSample_cmp(const void *left, const void *right) {
+    const ProfilerSample *a = left, *b = right;
+    size_t n = a->num_frames < b->num_frames ? a->num_frames : b->num_frames;
+    for(size_t i = 0; i < n; i++) {
+        int cmp = ProfilerFrame_cmp(a->frames[i], b->frames[i]);
+        if(cmp != 0) { return cmp; }
     }
+    return (a->num_frames > b->num_frames) - (a->num_frames < b->num_frames);
 }
 
-void TestSuite_print(TestSuite *ts) {
-    printf("=== Test Suite Report ===\n");
+/// @brief Writes one `<top>:12;outer:4;inner:7 <count>` line per distinct stack: the
+///     ... collapsed format flamegraph.pl, inferno and speedscope read
+/// @note sorts the samples in place
+void Profiler_write_collapsed(Profiler *prof, FILE *out) {
+    require_not_null(prof);
+    require_not_null(out);
 
-    for (size_t i = 0; i < ts->num_tests; ++i) {
-        printf("Test #%zu:\n", i + 1);
-        for (size_t j = 0; j < ts->reports[i].num_results; ++j) {
-            printf("  [%s] %.*s\n",
-                ts->reports[i].results[j] ? "PASS" : "FAIL",
-                fmt(ts->reports[i].messages[j])
-            );
+    size_t num_samples = Profiler_num_recorded(prof);
+    qsort(prof->samples, num_samples, sizeof(ProfilerSample), ProfilerSample_cmp);
+
+    for(size_t i = 0; i < num_samples; ) {
+        size_t run = 1;
+        while(i + run < num_samples && ProfilerSample_cmp(&prof->samples[i], &prof->samples[i + run]) == 0) {
+            run++;
         }
-    }
 
-    printf("=========================\n");
+        ProfilerSample *sample = &prof->samples[i];
+        for(size_t f = 0; f < sample->num_frames; f++) {
+            fprintf(out, "%s%.*s:%zu", f == 0 ? "" : ";", fmt(sample->frames[f].fn_name), sample->frames[f].line);
+        }
+        fprintf(out, " %zu\n", run);
+        i += run;
+    }
 }
 
+typedef struct ProfilerLine {
+    ProfilerFrame at;
+    size_t self;    /// samples with this line innermost
+    size_t total;   /// samples with this line anywhere on the stack
+} ProfilerLine;
 
-void unittest_sample_test_1(TestReport *r) {
-    test_assert(r, 1 + 1 == 2, "Basic arithmetic works");
-    test_assert(r, 2 * 2 == 5, "Deliberate failure example");
+static int ProfilerLine_cmp_hottest(const void *left, const void *right) {
+    const ProfilerLine *a = left, *b = right;
+    if(a->self != b->self) { return a->self < b->self ? 1 : -1; }
+    if(a->total != b->total) { return a->total < b->total ? 1 : -1; }
+    return ProfilerFrame_cmp(a->at, b->at);
 }
 
-void unittest_sample_test_2(TestReport *r) {
-    test_assert(r, strlen("test") == 4, "FixString size is correct");
+/// @brief The table slot for `at`, claiming an empty one if it's new, or nullptr if full
+static ProfilerLine *ProfilerLine_find(ProfilerLine *lines, ProfilerFrame at) {
+    size_t slot = (FixStr_hash(at.fn_name) ^ (at.line * 0x9E3779B97F4A7C15ull)) % PROFILER_MAX_LINES;
+    for(size_t probe = 0; probe < PROFILER_MAX_LINES; probe++) {
+        ProfilerLine *line = &lines[(slot + probe) % PROFILER_MAX_LINES];
+        if(line->total == 0) { line->at = at; return line; }
+        if(ProfilerFrame_cmp(line->at, at) == 0) { return line; }
+    }
+    return nullptr;
 }
 
-int unittest_test_main(void) {
-    TestSuite suite = test_suite(
-        unittest_sample_test_1,
-        unittest_sample_test_2
-    );
+/// @brief Prints the `top_n` lines with the most samples innermost, with their share of all
+///     ... samples and the source line itself (`source_lines` holds the program's, 0-based)
+void Profiler_print_hot_lines(Profiler *prof, FixStr *source_lines, size_t num_lines, size_t top_n) {
+    require_not_null(prof);
+
+    size_t num_samples = Profiler_num_recorded(prof);
+    printf("Profile: %zu samples every %ldus (~%.3fs of CPU), %zu dropped\n",
+        num_samples, prof->interval_us, (double) num_samples * (double) prof->interval_us / 1e6,
+        Profiler_num_dropped(prof));
+    if(num_samples == 0) { return; }
+
+    ProfilerLine *lines = cnew(PROFILER_MAX_LINES * sizeof(ProfilerLine));
+    if(lines == nullptr) { error_oom(); return; }
+    memset(lines, 0, PROFILER_MAX_LINES * sizeof(ProfilerLine));
+
+    size_t num_untracked = 0;
+    for(size_t i = 0; i < num_samples; i++) {
+        ProfilerSample *sample = &prof->samples[i];
+        for(size_t f = 0; f < sample->num_frames; f++) {
+            /// @note a recursive call's line counts once towards its total
+            bool seen = false;
+            for(size_t g = f + 1; g < sample->num_frames && !seen; g++) {
+                seen = ProfilerFrame_cmp(sample->frames[f], sample->frames[g]) == 0;
+            }
 
-    TestSuite_run(&suite);
-    TestSuite_print(&suite);
+            ProfilerLine *line = ProfilerLine_find(lines, sample->frames[f]);
+            if(line == nullptr) { num_untracked++; continue; }
+            line->total += seen ? 0 : 1;
+            line->self += f + 1 == sample->num_frames ? 1 : 0;
+        }
+    }
+
+    size_t num_used = 0;
+    for(size_t i = 0; i < PROFILER_MAX_LINES; i++) {
+        if(lines[i].total > 0) { lines[num_used++] = lines[i]; }
+    }
+    qsort(lines, num_used, sizeof(ProfilerLine), ProfilerLine_cmp_hottest);
+
+    printf("%7s %7s %8s  %-24s %s\n", "self%", "total%", "samples", "function:line", "source");
+    for(size_t i = 0; i < top_n && i < num_used; i++) {
+        ProfilerLine *line = &lines[i];
+        FixStr code = line->at.line > 0 && line->at.line <= num_lines && source_lines != nullptr
+            ? FixStr_firstN(FixStr_trim(source_lines[line->at.line - 1]), 48)
+            : FixStr_empty();
+
+        char where[64];
+        snprintf(where, sizeof(where), "%.*s:%zu", fmt(line->at.fn_name), line->at.line);
+        printf("%6.1f%% %6.1f%% %8zu  %-24s %.*s\n",
+            100.0 * (double) line->self / (double) num_samples,
+            100.0 * (double) line->total / (double) num_samples,
+            line->self, where, fmt(code));
+    }
+
+    if(num_untracked > 0) {
+        printf("(%zu frames over the %d-line table went uncounted)\n", num_untracked, PROFILER_MAX_LINES);
+    }
+    cfree(lines);
+}
+
+
+/// ----- Node counters ----- ///
+
+#define COUNTERS_MAX_LINES 4096
+
+typedef struct AstCounter {
+    atomic_uint_fast64_t count;
+    atomic_uint_fast64_t ticks;   /// self time: the children's ticks taken out (cf. Tracer_ticks)
+} AstCounter;
+
+/// @brief Deterministic counts of every node evaluated and the ticks spent in each, per node
+///     ... type and per source line (`by_line` is indexed as Ast.line, from 0)
+/// @note while one is running interp_eval_ast goes through interp_eval_counted: two
+///     ... timestamps and four relaxed adds a node. Evaluations on any thread are counted
+typedef struct AstCounters {
+    AstCounter by_type[AST_ENUM_SIZE];
+    AstCounter by_line[COUNTERS_MAX_LINES];
+    AstCounter other_lines;
+} AstCounters;
+
+/// @brief Starts counting every node evaluated, until AstCounters_stop
+/// @return the new counters, or nullptr if some are already running
+AstCounters *AstCounters_start(void) {
+    AstCounters *counters = cnew(sizeof(AstCounters));
+    if(counters == nullptr) { error_oom(); return nullptr; }
+    memset(counters, 0, sizeof(AstCounters));
+
+    AstCounters *none = nullptr;
+    if(!atomic_compare_exchange_strong(&ctx().debug.counters, &none, counters)) {
+        log_message(LL_WARNING, sMSG("Node counters are already running."));
+        cfree(counters);
+        return nullptr;
+    }
+    return counters;
+}
+
+/// @brief Stops counting; the counts are kept until AstCounters_free
+void AstCounters_stop(void) {
+    atomic_store(&ctx().debug.counters, nullptr);
+}
+
+void AstCounters_free(AstCounters *counters) {
+    require_not_null(counters);
+    cfree(counters);
+}
+
+static inline void AstCounter_add(AstCounter *counter, uint64_t ticks) {
+    atomic_fetch_add_explicit(&counter->count, 1, memory_order_relaxed);
+    atomic_fetch_add_explicit(&counter->ticks, ticks, memory_order_relaxed);
+}
+
+static inline void AstCounters_record(AstCounters *counters, Ast *node, uint64_t ticks) {
+    AstCounter_add(&counters->by_type[node->type], ticks);
+    AstCounter_add(node->line < COUNTERS_MAX_LINES ? &counters->by_line[node->line] : &counters->other_lines, ticks);
+}
+
+typedef struct AstCounterRow {
+    AstType type;
+    uint64_t count;
+    uint64_t ticks;
+} AstCounterRow;
+
+static int AstCounterRow_cmp_hottest(const void *left, const void *right) {
+    const AstCounterRow *a = left, *b = right;
+    if(a->ticks != b->ticks) { return a->ticks < b->ticks ? 1 : -1; }
+    return (a->count < b->count) - (a->count > b->count);
+}
+
+/// @brief Prints the program annotated with each line's node count and self ticks, then the
+///     ... totals per node type, hottest first
+void AstCounters_print_listing(AstCounters *counters, FixStr *source_lines, size_t num_lines) {
+    require_not_null(counters);
+
+    uint64_t total_count = 0, total_ticks = 0;
+    AstCounterRow rows[AST_ENUM_SIZE];
+    size_t num_rows = 0;
+    for(size_t type = 0; type < AST_ENUM_SIZE; type++) {
+        uint64_t count = atomic_load(&counters->by_type[type].count);
+        uint64_t ticks = atomic_load(&counters->by_type[type].ticks);
+        total_count += count;
+        total_ticks += ticks;
+        if(count > 0) { rows[num_rows++] = (AstCounterRow) {.type = type, .count = count, .ticks = ticks}; }
+    }
+    double per_tick = total_ticks > 0 ? 100.0 / (double) total_ticks : 0.0;
+
+    printf("Node counts: %" PRIu64 " nodes evaluated in %" PRIu64 " ticks\n", total_count, total_ticks);
+    printf("%12s %14s %7s  %5s  %s\n", "nodes", "ticks", "ticks%", "line", "source");
+    for(size_t line = 0; line < num_lines && line < COUNTERS_MAX_LINES && source_lines != nullptr; line++) {
+        uint64_t count = atomic_load(&counters->by_line[line].count);
+        uint64_t ticks = atomic_load(&counters->by_line[line].ticks);
+        if(count > 0) {
+            printf("%12" PRIu64 " %14" PRIu64 " %6.1f%%  %5zu  %.*s\n",
+                count, ticks, per_tick * (double) ticks, line + 1, fmt(source_lines[line]));
+        } else {
+            printf("%12s %14s %7s  %5zu  %.*s\n", "", "", "", line + 1, fmt(source_lines[line]));
+        }
+    }
+
+    uint64_t other_count = atomic_load(&counters->other_lines.count);
+    if(other_count > 0) {
+        printf("%12" PRIu64 " nodes past line %d went into no line\n", other_count, COUNTERS_MAX_LINES);
+    }
+
+    qsort(rows, num_rows, sizeof(AstCounterRow), AstCounterRow_cmp_hottest);
+    printf("\n%12s %14s %7s  %s\n", "nodes", "ticks", "ticks%", "node type");
+    for(size_t i = 0; i < num_rows; i++) {
+        printf("%12" PRIu64 " %14" PRIu64 " %6.1f%%  %.*s\n",
+            rows[i].count, rows[i].ticks, per_tick * (double) rows[i].ticks, fmt(Ast_nameof(rows[i].type)));
+    }
+}
+
+
+/// ----- Allocation profile ----- ///
+
+/// @brief Starts counting every allocation, until AllocProfile_stop
+/// @return the new profile, or nullptr if one is already running
+AllocProfile *AllocProfile_start(void) {
+    AllocProfile *prof = cnew(sizeof(AllocProfile));
+    if(prof == nullptr) { error_oom(); return nullptr; }
+    memset(prof, 0, sizeof(AllocProfile));
+
+    AllocProfile *none = nullptr;
+    if(!atomic_compare_exchange_strong(&ctx().debug.allocs, &none, prof)) {
+        log_message(LL_WARNING, sMSG("An allocation profile is already running."));
+        cfree(prof);
+        return nullptr;
+    }
+    return prof;
+}
+
+/// @brief Stops counting; the counts are kept until AllocProfile_free
+void AllocProfile_stop(void) {
+    AllocProfile *prof = atomic_exchange(&ctx().debug.allocs, nullptr);
+    if(prof == nullptr) { return; }
+
+    /// @note waits out a record already under way on another thread
+    while(atomic_exchange_explicit(&prof->is_locked, true, memory_order_acquire)) { sched_yield(); }
+    atomic_store_explicit(&prof->is_locked, false, memory_order_release);
+}
+
+void AllocProfile_free(AllocProfile *prof) {
+    require_not_null(prof);
+    cfree(prof);
+}
+
+void AllocProfile_record(AllocKind kind, AllocSite site, size_t alloc_size, MetaType type) {
+    AllocProfile *prof = atomic_load_explicit(&ctx().debug.allocs, memory_order_acquire);
+    if(prof == nullptr) { return; }
+
+    size_t hash = ((uintptr_t) site.fn_name >> 3) ^ (site.line * 0x9E3779B97F4A7C15ull) ^ ((size_t) type << 8) ^ kind;
+    while(atomic_exchange_explicit(&prof->is_locked, true, memory_order_acquire)) { sched_yield(); }
+
+    AllocProfileEntry *found = nullptr;
+    for(size_t probe = 0; probe < ALLOC_PROFILE_MAX_SITES && found == nullptr; probe++) {
+        AllocProfileEntry *entry = &prof->entries[(hash + probe) % ALLOC_PROFILE_MAX_SITES];
+        if(entry->count == 0) {
+            *entry = (AllocProfileEntry) {.site = site, .kind = kind, .type = type};
+            prof->num_entries++;
+            found = entry;
+        } else if(entry->site.fn_name == site.fn_name && entry->site.line == site.line
+                && entry->kind == kind && entry->type == type) {
+            found = entry;
+        }
+    }
+
+    if(found != nullptr) {
+        found->count++;
+        found->bytes += alloc_size;
+    } else {
+        prof->num_untracked++;
+        prof->bytes_untracked += alloc_size;
+    }
+    atomic_store_explicit(&prof->is_locked, false, memory_order_release);
+}
+
+static FixStr AllocKind_nameof(AllocKind kind) {
+    static const char *names[] = {
+        [ALLOC_ARENA] = "arena",
+        [ALLOC_HEAP] = "heap",
+        [ALLOC_RAW] = "raw",
+    };
+    return FixStr_from_cstr(names[kind]);
+}
+
+static FixStr AllocProfile_type_name(MetaType type) {
+    if(type == 0) { return s("untyped"); }
+    return type < UBX_EMPTY_UBX_END ? ubx_nameof(type) : bt_nameof(type);
+}
+
+static int AllocProfileEntry_cmp_largest(const void *left, const void *right) {
+    const AllocProfileEntry *a = left, *b = right;
+    if(a->bytes != b->bytes) { return a->bytes < b->bytes ? 1 : -1; }
+    return (a->count < b->count) - (a->count > b->count);
+}
+
+static void AllocProfile_write_arena(FILE *out, const char *name, Arena *a, bool is_last) {
+    size_t reserved = 0;
+    for(size_t i = 0; i < a->num_blocks; i++) { reserved += a->block_sizes[i]; }
+    fprintf(out, "    {\"name\": \"%s\", \"live_bytes\": %zu, \"peak_bytes\": %zu, "
+        "\"reserved_bytes\": %zu, \"blocks\": %zu}%s\n",
+        name, a->live_bytes, a->peak_bytes, reserved, a->num_blocks, is_last ? "" : ",");
+}
+
+/// @brief Writes the arenas' live and peak bytes, then the profile's totals per allocator and
+///     ... per MetaType, and every site, largest first
+/// @note `raw` allocations include the blocks behind the arenas and the heap's objects, so
+///     ... the three allocators' totals overlap. Sorts the profile: write it once stopped
+void AllocProfile_write_json(AllocProfile *prof, FILE *out) {
+    require_not_null(prof);
+    require_not_null(out);
+
+    size_t num_sites = 0;
+    for(size_t i = 0; i < ALLOC_PROFILE_MAX_SITES; i++) {
+        if(prof->entries[i].count > 0) { prof->entries[num_sites++] = prof->entries[i]; }
+    }
+    memset(&prof->entries[num_sites], 0, (ALLOC_PROFILE_MAX_SITES - num_sites) * sizeof(AllocProfileEntry));
+    qsort(prof->entries, num_sites, sizeof(AllocProfileEntry), AllocProfileEntry_cmp_largest);
+
+    size_t kind_count[ALLOC_KIND_ENUM_SIZE] = {0}, kind_bytes[ALLOC_KIND_ENUM_SIZE] = {0};
+    size_t type_count[256] = {0}, type_bytes[256] = {0};
+    for(size_t i = 0; i < num_sites; i++) {
+        AllocProfileEntry *entry = &prof->entries[i];
+        kind_count[entry->kind] += entry->count;
+        kind_bytes[entry->kind] += entry->bytes;
+        type_count[entry->type & 0xFF] += entry->count;
+        type_bytes[entry->type & 0xFF] += entry->bytes;
+    }
+
+    fprintf(out, "{\n  \"arenas\": [\n");
+    AllocProfile_write_arena(out, "compiler", &ctx().arenas.compiler, false);
+    AllocProfile_write_arena(out, "interpreter_global", &ctx().arenas.interpreter_global, false);
+    AllocProfile_write_arena(out, "interpreter_local", &ctx().arenas.interpreter_local, false);
+    AllocProfile_write_arena(out, "gc_backing", &ctx().arenas.gc_backing, true);
+    fprintf(out, "  ],\n");
+
+    #ifdef DEBUG_MEMORY
+        fprintf(out, "  \"raw\": {\"live_allocations\": %zu, \"live_bytes\": %zu, \"peak_bytes\": %zu},\n",
+            ctx_debug_memory().num_live, ctx_debug_memory().live_bytes, ctx_debug_memory().peak_bytes);
+    #endif
+
+    fprintf(out, "  \"allocators\": {");
+    for(size_t kind = 0; kind < ALLOC_KIND_ENUM_SIZE; kind++) {
+        fprintf(out, "%s\"%.*s\": {\"count\": %zu, \"bytes\": %zu}", kind == 0 ? "" : ", ",
+            fmt(AllocKind_nameof(kind)), kind_count[kind], kind_bytes[kind]);
+    }
+    fprintf(out, "},\n  \"types\": [");
+
+    bool is_first = true;
+    for(size_t type = 0; type < 256; type++) {
+        if(type_count[type] == 0) { continue; }
+        fprintf(out, "%s\n    {\"type\": \"%.*s\", \"count\": %zu, \"bytes\": %zu}", is_first ? "" : ",",
+            fmt(AllocProfile_type_name(type)), type_count[type], type_bytes[type]);
+        is_first = false;
+    }
+    fprintf(out, "\n  ],\n  \"sites\": [");
+
+    for(size_t i = 0; i < num_sites; i++) {
+        AllocProfileEntry *entry = &prof->entries[i];
+        fprintf(out, "%s\n    {\"fn\": \"%s\", \"line\": %zu, \"allocator\": \"%.*s\", \"type\": \"%.*s\", "
+            "\"count\": %zu, \"bytes\": %zu}", i == 0 ? "" : ",",
+            entry->site.fn_name == nullptr ? "(unknown)" : entry->site.fn_name, entry->site.line,
+            fmt(AllocKind_nameof(entry->kind)), fmt(AllocProfile_type_name(entry->type)), entry->count, entry->bytes);
+    }
+    fprintf(out, "\n  ],\n  \"untracked\": {\"count\": %zu, \"bytes\": %zu}\n}\n",
+        prof->num_untracked, prof->bytes_untracked);
+}
+
+
+void AllocProfile_test_main(void) {
+    printf("Running Allocation Profile Tests...\n");
+
+    AllocProfile *prof = AllocProfile_start();
+    log_assert(prof != nullptr, sMSG("The allocation profile should start"));
+    log_assert(AllocProfile_start() == nullptr, sMSG("Only one allocation profile should run at once"));
+
+    Arena *arena = ctx_current_arena();
+    size_t live_bytes = arena->live_bytes;
+    size_t arena_line = __LINE__ + 1;
+    for(size_t i = 0; i < 3; i++) { Arena_alloc(20); }
+    log_assert(arena->live_bytes == live_bytes + 3 * 24 && arena->peak_bytes >= arena->live_bytes,
+        sMSG("The arena should count its live bytes, aligned"));
+
+    #ifdef DEBUG_MEMORY
+        size_t num_live = ctx_debug_memory().num_live;
+    #endif
+    size_t raw_line = __LINE__ + 1;
+    void *kept = cnew(100), *freed = cnew(100);
+    cfree(freed);
+    #ifdef DEBUG_MEMORY
+        log_assert(ctx_debug_memory().num_live == num_live + 1, sMSG("Only the freed allocation should be marked free"));
+    #endif
+
+    AllocProfile_stop();
+    Arena_alloc(8);
+    cfree(kept);
+
+    size_t num_found = 0;
+    for(size_t i = 0; i < ALLOC_PROFILE_MAX_SITES; i++) {
+        AllocProfileEntry *entry = &prof->entries[i];
+        if(entry->count == 0 || entry->site.fn_name != __func__) { continue; }
+        if(entry->site.line == arena_line) {
+            log_assert(entry->kind == ALLOC_ARENA && entry->count == 3 && entry->bytes == 3 * 24,
+                sMSG("The arena site should be counted once an allocation"));
+            num_found++;
+        } else if(entry->site.line == raw_line) {
+            log_assert(entry->kind == ALLOC_RAW && entry->count == 2 && entry->bytes == 200,
+                sMSG("The raw site should be counted once an allocation"));
+            num_found++;
+        }
+    }
+    log_assert(num_found == 2, sMSG("Both sites, and nothing after the stop, should be profiled"));
+
+    char json[16 * 1024] = {0};
+    FILE *out = fmemopen(json, sizeof(json) - 1, "w");
+    AllocProfile_write_json(prof, out);
+    fclose(out);
+    log_assert(strstr(json, "\"name\": \"compiler\"") != nullptr && strstr(json, "\"fn\": \"AllocProfile_test_main\"") != nullptr,
+        sMSG("The summary should list the arenas and sites"));
+    printf("%s", json);
+
+    AllocProfile_free(prof);
+    printf("Allocation Profile Tests Completed.\n\n");
+}
+
+
+void Profiler_test_main(void) {
+    printf("Running Profiler Tests...\n");
+
+    CallStack *traces = ctx_local().debug.callstack;
+    size_t top = traces->top;
+    Ast call = { .type = AST_FN_DEF_CALL, .line = 1 };
+    Ast node = { .type = AST_INT, .line = 3, .integer.value = 7 };
+    FixStr source[] = {s("fn main()"), s("    work()"), s("fn work()"), s("    7")};
+
+    Profiler prof;
+    log_assert(Profiler_start(&prof, 1000, 64), sMSG("The profiler should start"));
+    log_assert(!Profiler_start(&(Profiler) {0}, 1000, 64), sMSG("Only one profiler should run at once"));
+
+    /// @note `main` calls `work`, which spins on line 4 until sampled
+    interp_frame_push(s("main"), nullptr);
+    interp_frame_push(s("work"), &call);
+    Tracer_push_node(traces, s("eval"), &node, s(__FILE__), __LINE__);
+    for(volatile size_t spin = 0; atomic_load(&prof.num_samples) < 8; spin++) {}
+    interp_frame_pop();
+    interp_frame_pop();
+    Profiler_stop(&prof);
+    traces->top = top;
+
+    log_assert(Profiler_num_recorded(&prof) >= 8, sMSG("Samples should be recorded"));
+    ProfilerSample *sample = &prof.samples[0];
+    log_assert(sample->num_frames == 3, sMSG("A sample should hold <top> and both calls"));
+    log_assert(FixStr_eq(sample->frames[0].fn_name, s("<top>")) && sample->frames[0].line == 0,
+        sMSG("The root should be <top>, with main called from nowhere"));
+    log_assert(FixStr_eq(sample->frames[1].fn_name, s("main")) && sample->frames[1].line == 2,
+        sMSG("main should be at the line calling work"));
+    log_assert(FixStr_eq(sample->frames[2].fn_name, s("work")) && sample->frames[2].line == 4,
+        sMSG("work should be at its current node's line"));
+
+    char folded[256] = {0};
+    FILE *out = fmemopen(folded, sizeof(folded) - 1, "w");
+    Profiler_write_collapsed(&prof, out);
+    fclose(out);
+    log_assert(strncmp(folded, "<top>:0;main:2;work:4 ", 22) == 0, sMSG("Stacks should be collapsed"));
+
+    Profiler_print_hot_lines(&prof, source, 4, PROFILER_TOP_N);
+    Profiler_free(&prof);
+
+    printf("Profiler Tests Completed.\n\n");
+}
+
+#pragma endregion
+
+#pragma region CliImpl
+
+
+void cli_parse_args(int argc, char *argv[], CliOption *out_opts, size_t num_opts) {
+    /// @note the first entry in out_opts will be the argv data up until the first option
+    /// ... defined by a leading `-` or `--`
+    /// ... this is to allow for positional arguments to be parsed
+    /// ... before the named options
+
+    // Parse positional arguments
+    for (int i = 1; i < argc; i++) {
+        if (argv[i][0] == '-') break;
+        out_opts[0].value = FixStr_from_cstr(argv[i]);
+        out_opts[0].is_set = true;
+    }
+
+    for (int i = 1; i < argc; i++) {
+        for (size_t j = 0; j < num_opts; j++) {
+            if (FixStr_eq(FixStr_from_cstr(argv[i]), out_opts[j].name)) {
+                out_opts[j].is_set = true;
+                if (i + 1 < argc) {
+                    out_opts[j].value = FixStr_from_cstr(argv[i + 1]);
+                }
+            }
+        }
+    }
+}
+
+void cli_print_opts(const CliOption options[], int num_options) {
+    printf("Command-Line Options:\n");
+    printf("----------------------------\n");
+    for (int i = 0; i < num_options; i++) {
+        printf("Option: %-10.*s | Set: %-5s | Value: %.*s | Default: %.*s\n",
+               fmt(options[i].name),
+               options[i].is_set ? "Yes" : "No",
+               fmt(options[i].value),
+               fmt(options[i].or_else));
+    }
+    printf("----------------------------\n");
+}
+
+
+#pragma endregion
+
+#pragma region TestImpl
+
+
+void TestReport_push(TestReport *report, bool result, FixStr message) {
+    if (report->num_results > 32) {
+        log_message(LL_ERROR, sMSG("Warning: TestSuite capacity exceeded."));
+        return;
+    }
+
+    report->results[report->num_results] = result;
+    report->messages[report->num_results] = FixStr_copy(message);
+    report->num_results++;
+}
+
+
+void TestSuite_register(TestSuite *ts, UnitTestFnPtr fnptr) {
+    if (ts->num_tests > 32) {
+        log_message(LL_ERROR, sMSG("Warning: TestSuite capacity exceeded."));
+        return;
+    }
+
+    ts->tests[ts->num_tests] = fnptr;
+    ts->num_tests++;
+}
+
+void TestSuite_run(TestSuite *ts) {
+    Arena_init(&ctx().arenas.compiler, ARENA_1MB);
+    ctx_change_arena(&ctx().arenas.compiler);
+
+    if (ts->num_tests > 32) {
+        log_message(LL_ERROR, sMSG("Warning: TestSuite capacity exceeded."));
+        return;
+    }
+
+    for (size_t i = 0; i < ts->num_tests; ++i) {
+        ts->tests[i](&ts->reports[i]);
+    }
+}
+
+void TestSuite_print(TestSuite *ts) {
+    printf("=== Test Suite Report ===\n");
+
+    for (size_t i = 0; i < ts->num_tests; ++i) {
+        printf("Test #%zu:\n", i + 1);
+        for (size_t j = 0; j < ts->reports[i].num_results; ++j) {
+            printf("  [%s] %.*s\n",
+                ts->reports[i].results[j] ? "PASS" : "FAIL",
+                fmt(ts->reports[i].messages[j])
+            );
+        }
+    }
+
+    printf("=========================\n");
+}
+
+
+void unittest_sample_test_1(TestReport *r) {
+    test_assert(r, 1 + 1 == 2, "Basic arithmetic works");
+    test_assert(r, 2 * 2 == 5, "Deliberate failure example");
+}
+
+void unittest_sample_test_2(TestReport *r) {
+    test_assert(r, strlen("test") == 4, "FixString size is correct");
+}
+
+int unittest_test_main(void) {
+    TestSuite suite = test_suite(
+        unittest_sample_test_1,
+        unittest_sample_test_2
+    );
+
+    TestSuite_run(&suite);
+    TestSuite_print(&suite);
 
     return 0;
 }
@@ -4907,6 +7336,10 @@ int internal_test_main(void) {
     // Box_test_main();
     Heap_test_main();
     Tracer_test_main();
+    Profiler_test_main();
+    AllocProfile_test_main();
+    TaskPool_test_main();
+    InterpContext_test_main();
     unittest_test_main();
     return 0;
 }
@@ -5236,7 +7669,7 @@ bool lex_is_keyword(FixStr str) {
         "mut*", "mut", "pub", "priv", "mod",
         "try", "return", "match", "mod",
         "where", "use", "as", "dyn",
-        "trait", "struct", "macro"
+        "trait", "struct", "macro", "memo", "par"
     };
 
     size_t num = sizeof(kws)/sizeof(kws[0]);
@@ -5557,6 +7990,7 @@ static inline Ast *Ast_fn_def_new(Token *head,
     node->fn.body = body;
     node->fn.is_macro = is_macro;
     node->fn.is_generator = is_generator;
+    node->fn.is_memo = false;
     return node;
 }
 
@@ -5591,6 +8025,15 @@ static inline Ast *Ast_if_new(Token *head,
     return node;
 }
 
+// Try
+static inline Ast *Ast_try_new(Token *head,
+     Ast *body, Ast *fallback) {
+    Ast *node = FixAst_new(AST_TRY, head->line, head->col);
+    node->try_stmt.body = body;
+    node->try_stmt.fallback = fallback;
+    return node;
+}
+
 /// @brief Creates a new AST node for a documentation comment.
 /// @todo
 Ast *Ast_doc_comment_new(Token *token, FixStr comment) {
@@ -5629,6 +8072,15 @@ static inline Ast *Ast_loop_new(Token *head,
     node->loop.body = body;
     node->loop.condition = nullptr;
     node->loop.yields = true;
+    node->loop.parallel = false;
+    return node;
+}
+
+static inline Ast *Ast_par_for_new(Token *head,
+    Ast **binds, size_t num_bindings, Ast *body) {
+    Ast *node = Ast_loop_new(head, binds, num_bindings, body);
+    node->type = AST_FOR;
+    node->loop.parallel = true;
     return node;
 }
 
@@ -6919,11 +9371,18 @@ void parse_error(ParseContext *pctx, Token *token, FixStr message) {
         pctx->parser.current_token, fmt(tt_nameof(token->type)), fmt(token->value)
     );
 
-    log_message(LL_ERROR,
+    // under a recovery point (eg., an embedding host) the caller handles parse errors
+    log_message(ctx_local().debug.recover != nullptr ? LL_WARNING : LL_ERROR,
         FixStr_col_new(ANSI_COL_BRIGHT_YELLOW, s("Parse Error: %.*s\n")), fmt(message)
     );
+    error_push((FixError) {
+        .code = BXE_PARSER,
+        .message = message,
+        .location = s(__FILE__ ":" _STR(__LINE__)),
+        .info = { .user_line = token->line, .user_col = token->col }
+    });
 
-    require_resources_cleanup(pctx);
+    if(ctx_local().debug.recover == nullptr) { require_resources_cleanup(pctx); }
 }
 
 
@@ -6993,7 +9452,8 @@ static inline uint8_t parse_peek_precedence(ParseContext *p) {
 /// @return
 Ast *parse_expression(ParseContext *p, size_t precedence) {
     #define peek_is_expression_end() (peek_eq_chr(',') || peek_eq_chr(':') ||\
-    peek_is(TT_BRA_CLOSE) || peek_is(TT_END) || peek_is(TT_ASSIGN) || peek_is(TT_DISCARD))
+    peek_is(TT_BRA_CLOSE) || peek_is(TT_END) || peek_is(TT_ASSIGN) || peek_is(TT_DISCARD) ||\
+    peek_eq(s("else")))
 
     log_assert(depth_is_bounded(), sMSG("Beyond max depth"));
     log_assert(data_remain(), sMSG("No data remain!"));
@@ -7118,6 +9578,12 @@ Ast *parse_keyword_statement(ParseContext *p, bool in_expr) {
         // return parse_m(p);
     } else if(peek_eq(s("macro"))) {
         return parse_macro_def(p);
+    } else if(peek_eq(s("memo"))) {
+        return parse_memo(p);
+    } else if(peek_eq(s("par"))) {
+        return parse_par(p);
+    } else if(peek_eq(s("try"))) {
+        return parse_try(p);
     } else {
         parse_error(p, peek(), sMSG("Unknown keyword."));
         return nullptr;
@@ -7366,14 +9832,17 @@ Ast *parse_function(ParseContext *p,bool is_loop) {
     FixStr name = consume(TT_IDENTIFIER, sMSG("Expected function name"))->value;
 
     consume_specific(TT_BRA_OPEN, s("("), sMSG("Expected an opening parenthesis."));
-    struct FnParam *params = Arena_alloc(sizeof(struct FnParam *) * ARRAY_SIZE_SMALL);
+    struct FnParam *params = Arena_alloc(sizeof(struct FnParam) * ARRAY_SIZE_SMALL);
     size_t count = 0;
     while(data_remain()) {
         if(peek_eq_chr(')')) break;
         if(peek_eq_chr(',')) consume_expected(TT_SEP);
 
         pctx_trace(peek()->value);
-        params[count++].name = consume(TT_IDENTIFIER, sMSG("Expected parameter name"))->value;
+        params[count].name = consume(TT_IDENTIFIER, sMSG("Expected parameter name"))->value;
+        params[count].type = nullptr;
+        params[count].default_value = nullptr;  /// @todo
+        count++;
     }
     consume_specific(TT_BRA_CLOSE, s(")"), sMSG("Expected a closing parenthesis."));
 
@@ -7386,21 +9855,90 @@ Ast *parse_function(ParseContext *p,bool is_loop) {
     );
 }
 
-
-/// @brief Parses a generic type with constraints.
-//// @todo not yet implemented
+/// @brief
+/// @note Defines a function whose results are cached on its arguments (cf. FixMemoCode)
 /// @example
-///     fn foo<T: Trait1, Trait2>(param: T)
-/// @param p The parsing context.
-/// @return An AST node representing the generic type.
-Ast *parse_generic_type(ParseContext *p) {
+///     memo fn f(x, a, b) = a * x + b
+///
+///     let f = memo fn(x, a, b) -> a * x + b in f(10, m, c)
+/// @param p
+/// @return
+Ast *parse_memo(ParseContext *p) {
     pctx_trace(peek()->value);
-    parse_not_implemented();
 
-    // // Parse base type name
-    // Token *base_type_token = consume(TT_TYPE, sMSG("Expected base type name for generic type."));
+    consume_specific(TT_KEYWORD, s("memo"), sMSG("Keyword `memo` expected."));
+    if(!peek_eq(s("fn"))) {
+        parse_error(p, peek(), sMSG("Expected `fn` after `memo`."));
+        return nullptr;
+    }
 
-    // Ast *generic_type = Ast_generic_type_new(peek(), base_type_token->value);
+    Ast *fn = parse_function(p, false);
+    if(fn != nullptr) { fn->fn.is_memo = true; }
+    return fn;
+}
+
+/// @brief
+/// @note A `for` whose iterations run in parallel and are collected, in order, into an array
+/// @note the body sees its bindings and the enclosing scope, but cannot mutate the latter
+/// @example
+///     const ys = par for(x <- xs) f(x)
+/// @param p
+/// @return
+Ast *parse_par(ParseContext *p) {
+    pctx_trace(peek()->value);
+
+    consume_specific(TT_KEYWORD, s("par"), sMSG("Keyword `par` expected."));
+    consume_specific(TT_KEYWORD, s("for"), sMSG("Expected `for` after `par`."));
+
+    size_t out_num_bindings = 0;
+    Ast **binds = parse_bindings(p, &out_num_bindings);
+    Ast *body = peek_is(TT_INDENT) ? parse_block(p) : parse_expression(p, 0);
+    return Ast_par_for_new(peek(), binds, out_num_bindings, body);
+}
+
+/// @brief
+/// @note An error raised in the body unwinds to the `try`, which evaluates to the `else`
+///     ... branch instead (or null without one)
+/// @example
+///     const fit = try optimize(model, data) else default_fit
+///
+///     try
+///         risky()
+///     else
+///         log("risky() failed")
+/// @param p
+/// @return
+Ast *parse_try(ParseContext *p) {
+    pctx_trace(peek()->value);
+
+    consume_specific(TT_KEYWORD, s("try"), sMSG("Keyword `try` expected."));
+
+    Ast *body = peek_is(TT_INDENT) ? parse_block(p) : parse_expression(p, 0);
+    Ast *fallback = nullptr;
+
+    if(peek_eq(s("else"))) {
+        consume_specific(TT_KEYWORD, s("else"), sMSG("Keyword `else` expected"));
+        fallback = peek_is(TT_INDENT) ? parse_block(p) : parse_expression(p, 0);
+    }
+
+    return Ast_try_new(peek(), body, fallback);
+}
+
+
+/// @brief Parses a generic type with constraints.
+//// @todo not yet implemented
+/// @example
+///     fn foo<T: Trait1, Trait2>(param: T)
+/// @param p The parsing context.
+/// @return An AST node representing the generic type.
+Ast *parse_generic_type(ParseContext *p) {
+    pctx_trace(peek()->value);
+    parse_not_implemented();
+
+    // // Parse base type name
+    // Token *base_type_token = consume(TT_TYPE, sMSG("Expected base type name for generic type."));
+
+    // Ast *generic_type = Ast_generic_type_new(peek(), base_type_token->value);
 
     // // Check for type parameters enclosed in '<' and '>'
     // if (peek_eq_chr('<')) {
@@ -8449,8 +10987,7 @@ void parsing_test_main(void) {
 #ifdef DEBUG_REQUIRE_ASSERTS
     #define require_scope_has(scope, key) assert(FixScope_has(scope, key))
 #else
-    /// @todo swap out all checks
-    #define require_not_null(expr)
+    #define require_scope_has(scope, key) NOOP
 #endif
 
 // #define NATIVE_LOG_CALLS
@@ -8475,10 +11012,14 @@ void parsing_test_main(void) {
     #define native_log_call2(self, one, two)\
         log_message(LL_INFO, s("Native fn: %.*s(%.*s, %.*s)"),\
             fmt(self->name), fmt(Box_to_FixStr(one)), fmt(Box_to_FixStr(two)));
+    #define native_log_call3(self, one, two, three)\
+        log_message(LL_INFO, s("Native fn: %.*s(%.*s, %.*s, %.*s)"),\
+            fmt(self->name), fmt(Box_to_FixStr(one)), fmt(Box_to_FixStr(two)), fmt(Box_to_FixStr(three)));
 #else
     #define native_log_call(self, args)
     #define native_log_call1(self, one)
     #define native_log_call2(self, one, two)
+    #define native_log_call3(self, one, two, three)
 #endif
 
 #define native_return_error_if(test, ...) \
@@ -8560,13 +11101,42 @@ FixStr Boxed_to_FixStr(Boxed *boxed) {
             return FixStruct_to_FixStr(Boxed_as(FixStruct, boxed));
         case BXD_FLX_DICT:
             return FlxDict_to_FixStr(Boxed_as(FlxDict, boxed));
+        case BXD_FLX_VEC_DOUBLE_N:
+            return FlxVecDouble_to_FixStr(Boxed_as(FlxVecDouble, boxed));
+        case BXD_FLX_VEC_INT:
+            return FlxVecInt_to_FixStr(Boxed_as(FlxVecInt, boxed));
+        case BXD_FLX_VEC_BOOL:
+            return FlxVecBool_to_FixStr(Boxed_as(FlxVecBool, boxed));
+        case BXD_FLX_VEC_TAGS:
+            return FlxVecCat_to_FixStr(Boxed_as(FlxVecCat, boxed));
+        case BXD_FLX_DATAFRAME:
+            return FlxDataFrame_to_FixStr(Boxed_as(FlxDataFrame, boxed));
+        case BXD_FLX_MATRIX_DOUBLE:
+            return FlxMatrixF_to_FixStr(Boxed_as(FlxMatrixF, boxed));
+        case BXD_FLX_TENSOR_DOUBLE:
+            return FlxTensorF_to_FixStr(Boxed_as(FlxTensorF, boxed));
+        case BXD_FIX_ARRAY_VIEW:
+            return FixArrayView_to_FixStr(Boxed_as(FixArrayView, boxed));
+        case BXD_FIX_ITER:
+            return FixIter_to_FixStr(Boxed_as(FixIter, boxed));
+        case BXD_FLX_SAMPLE_SINK:
+            return FlxSampleSink_to_FixStr(Boxed_as(FlxSampleSink, boxed));
+        case BXD_FLX_PARTICLES:
+            return FlxParticles_to_FixStr(Boxed_as(FlxParticles, boxed));
+        case BXD_FIX_DISTRIBUTION:
+            return FixDist_to_FixStr(Boxed_as(FixDist, boxed));
+        case BXD_FIX_MODEL_GRAPH:
+            return FixModelGraph_to_FixStr(Boxed_as(FixModelGraph, boxed));
+        case BXD_FLX_GRAPH_DIRECTED_WEIGHTED:
+        case BXD_FLX_GRAPH_DIRECTED_UNWEIGHTED:
+        case BXD_FLX_GRAPH_UNDIRECTED_WEIGHTED:
+        case BXD_FLX_GRAPH_UNDIRECTED_UNWEIGHTED:
+            return FlxGraph_to_FixStr(Boxed_as(FlxGraph, boxed));
         default:
             return FixStr_fmt_new(s("Boxed(%d)"), type);
     }
         // case BXD_FIX_AST:
             // return Ast_to_FixStr(Boxed_as(FixAst *, boxed));
-        // case BXD_FIX_DISTRIBUTION:
-        //     return FixFixDist_to_FixStr(Boxed_as(FixFixDist, boxed));
         // case BXD_FIX_SYSTEM_INFO:
         //     return FixSystemInfo_to_FixStr(Boxed_as(FixSystemInfo, boxed));
         // case BXD_FIX_MODULE:
@@ -8579,8 +11149,6 @@ FixStr Boxed_to_FixStr(Boxed *boxed) {
         //     return FixType_to_FixStr(Boxed_as(FixType, boxed));
         // case BXD_FIX_OBJECT:
         //     return FixObject_to_FixStr(Boxed_as(FixObject, boxed));
-        // case BXD_FIX_ARRAY_VIEW:
-        //     return FixArrayView_to_FixStr(Boxed_as(FixArrayView, boxed));
         // case BXD_FIX_VEC_TAGS:
         //     return FixVecTags_to_FixStr(Boxed_as(FixVecTags, boxed));
         // case BXD_FIX_NUM_128BIT:
@@ -8621,11 +11189,6 @@ FixStr Boxed_to_FixStr(Boxed *boxed) {
         //     return FlxDataFrame_to_FixStr(Boxed_as(FlxDataFrame, boxed));
         // case BXD_FLX_VEC_BOOL:
         //     return FlxVecBool_to_FixStr(Boxed_as(FlxVecBool, boxed));
-        // case BXD_FLX_GRAPH_DIRECTED_WEIGHTED:
-        // case BXD_FLX_GRAPH_DIRECTED_UNWEIGHTED:
-        // case BXD_FLX_GRAPH_UNDIRECTED_WEIGHTED:
-        // case BXD_FLX_GRAPH_UNDIRECTED_UNWEIGHTED:
-        //     return FlxGraph_to_FixStr(Boxed_as(FlxGraph, boxed));
 
 
 }
@@ -8924,6 +11487,7 @@ Box FixArray_weak_unset(FixArray *array, size_t index) {
 
 
 
+
 /// @brief
 /// @example
 ///     const vec1 = [10, 20, 30]
@@ -8967,6 +11531,320 @@ FixArray *FixArray_new(size_t initial_capacity, LifetimeType lifetime) {
 }
 
 
+/// ----- FixArrayView ----- ///
+
+#define FixArray_is_array_type(type) ((type) == BXD_FIX_ARRAY || (type) == BXD_FLX_ARRAY)
+
+/// @brief Reads the element range of an array or view in place, without copying
+/// @return false if `sequence` is neither
+bool Box_as_sequence(Box sequence, Box **out_data, size_t *out_len) {
+    if(!Box_is_Boxed(sequence) || Box_is_error(sequence)) { return false; }
+
+    MetaType type = Box_Boxed_meta(sequence).type;
+    if(FixArray_is_array_type(type)) {
+        FixArray *array = Box_unwrap_FixArray(sequence);
+        *out_data = array->data;
+        *out_len = len_ref(array);
+        return true;
+    }
+    if(type == BXD_FIX_ARRAY_VIEW) {
+        FixArrayView *view = Box_unwrap_typed_ptr(FixArrayView, sequence);
+        size_t end = view->end < len_ref(view->data) ? view->end : len_ref(view->data);
+        *out_data = view->data->data + view->start;
+        *out_len = end > view->start ? end - view->start : 0;
+        return true;
+    }
+    return false;
+}
+
+/// @note bounds are clamped to the array, so the view is always in range (possibly empty)
+FixArrayView *FixArrayView_new(FixArray *array, size_t start, size_t end) {
+    require_not_null(array);
+
+    end = end < len_ref(array) ? end : len_ref(array);
+    start = start < end ? start : end;
+
+    FixArrayView *view = aro_new(BXD_FIX_ARRAY_VIEW);
+    if(view == nullptr) { error_oom(); return nullptr; }
+
+    view->meta.state = LIVING_PINNED;
+    view->data = array;
+    view->start = start;
+    view->end = end;
+    view->meta.size = end - start;
+    return view;
+}
+
+/// @brief A view of [start, end) relative to an array or an existing view;
+///     ... views of views share the root array rather than nesting
+FixArrayView *FixArrayView_of_Box(Box sequence, size_t start, size_t end) {
+    if(!Box_is_Boxed(sequence) || Box_is_error(sequence)) { return nullptr; }
+
+    MetaType type = Box_Boxed_meta(sequence).type;
+    if(FixArray_is_array_type(type)) {
+        return FixArrayView_new(Box_unwrap_FixArray(sequence), start, end);
+    }
+    if(type == BXD_FIX_ARRAY_VIEW) {
+        FixArrayView *view = Box_unwrap_typed_ptr(FixArrayView, sequence);
+        size_t len = len_ref(view);
+        end = end < len ? end : len;
+        start = start < end ? start : end;
+        return FixArrayView_new(view->data, view->start + start, view->start + end);
+    }
+    return nullptr;
+}
+
+FixArray *FixArrayView_to_FixArray_new(FixArrayView *view) {
+    require_not_null(view);
+
+    size_t len = len_ref(view);
+    FixArray *array = FixArray_new_auto(len > 0 ? len : 1);
+    if(array == nullptr) { return nullptr; }
+
+    for(size_t i = 0; i < len; i++) {
+        FixArray_append(array, view->data->data[view->start + i]);
+    }
+    return array;
+}
+
+/// @brief Writes through a view; the first write copies the viewed range so the
+///     ... shared backing array (and any sibling views) are never modified
+Box FixArrayView_set(FixArrayView *view, size_t index, Box element) {
+    require_not_null(view);
+    native_return_error_if(index >= len_ref(view), s("FixArrayView.set(): Index out of bounds."));
+
+    if(view->meta.state == LIVING_PINNED) {
+        FixArray *copy = FixArrayView_to_FixArray_new(view);
+        native_return_error_if(copy == nullptr, s("FixArrayView.set(): Could not copy view."));
+
+        view->data = copy;
+        view->end -= view->start;
+        view->start = 0;
+        view->meta.state = LIVING_ALIVE;
+    }
+
+    view->data->data[view->start + index] = element;
+    return element;
+}
+
+FixStr FixArrayView_to_FixStr(FixArrayView *view) {
+    if(len_ref(view) == 0) {
+        return s("[]");
+    }
+
+    FixStr repr = s("[");
+    for(size_t i = 0; i < len_ref(view); i++) {
+        repr = FixStr_glue_sep_new(repr, Box_to_FixStr(view->data->data[view->start + i]), s(", "));
+    }
+    repr = FixStr_glue_new(repr, s("]"));
+    return repr;
+}
+
+
+/// ----- FixIter ----- ///
+
+static bool FixIter_range_next(FixIter *iter, Box *out) {
+    if(iter->iter_index >= iter->iter_to) { return false; }
+
+    double value = iter->range_from + (double) iter->iter_index * iter->range_step;
+    *out = iter->range_is_int ? Box_wrap_int((int64_t) value) : Box_wrap_float((float) value);
+    iter->iter_index++;
+    return true;
+}
+
+/// @brief Adaptor step shared by take/drop: skips `iter_from` source elements once, then
+///     ... forwards up to `iter_to` more; the source is an array, view or another iterator
+static bool FixIter_adaptor_next(FixIter *iter, Box *out) {
+    if(iter->iter_index >= iter->iter_to) { return false; }
+
+    Box skipped;
+    for(; iter->iter_from > 0; iter->iter_from--) {
+        if(!Box_iter_next(iter->iter_state, iter->iter_cursor++, &skipped)) { return false; }
+    }
+    if(!Box_iter_next(iter->iter_state, iter->iter_cursor++, out)) { return false; }
+
+    iter->iter_index++;
+    return true;
+}
+
+/// @note the stream ends when `iter_fn` returns a `done` state; an error (eg., from a native
+///     ... fn, which returns it rather than unwinding) unwinds from the pull (cf. interp_eval_ast)
+static bool FixIter_fn_next(FixIter *iter, Box *out) {
+    if(iter->iter_index >= iter->iter_to) { return false; }
+
+    Box result = FixFn_call(Box_unwrap_FixFn(iter->iter_fn), *iter->iter_scope, (FixArray) {0});
+    if(Box_is_failed(result)) { interp_graceful_exit(); }
+    if(result.type == UBX_STATE && result.payload == BXS_DONE) { return false; }
+
+    *out = result;
+    iter->iter_index++;
+    return true;
+}
+
+static FixIter *FixIter_new(FixIterNext next, size_t limit) {
+    FixIter *iter = aro_new(BXD_FIX_ITER);
+    if(iter == nullptr) { error_oom(); return nullptr; }
+
+    iter->meta.state = LIVING_ALIVE;
+    iter->next = next;
+    iter->iter_index = 0;
+    iter->iter_from = 0;
+    iter->iter_to = limit;
+    iter->iter_cursor = 0;
+    iter->iter_fn = Box_null();
+    iter->iter_state = Box_null();
+    iter->iter_scope = nullptr;
+    iter->gen_frame = nullptr;
+    iter->range_from = 0.0;
+    iter->range_step = 1.0;
+    iter->range_is_int = true;
+    iter->chain_draw = Box_null();
+    iter->chain_log_weight = 0.0;
+    return iter;
+}
+
+/// @brief The inclusive range from, from + step, ... up to `to`, one element per pull
+FixIter *FixIter_range_new(double from, double to, double step) {
+    require(step != 0.0);
+
+    double span = floor((to - from) / step);
+    size_t count = span < 0.0 ? 0 : (size_t) span + 1;
+
+    FixIter *iter = FixIter_new(FixIter_range_next, count);
+    if(iter == nullptr) { return nullptr; }
+
+    iter->range_from = from;
+    iter->range_step = step;
+    iter->range_is_int = from == floor(from) && step == floor(step);
+    iter->meta.size = count;
+    return iter;
+}
+
+FixIter *FixIter_take_new(Box source, size_t count) {
+    FixIter *iter = FixIter_new(FixIter_adaptor_next, count);
+    if(iter == nullptr) { return nullptr; }
+
+    iter->iter_state = source;
+    return iter;
+}
+
+FixIter *FixIter_drop_new(Box source, size_t count) {
+    FixIter *iter = FixIter_new(FixIter_adaptor_next, SIZE_MAX);
+    if(iter == nullptr) { return nullptr; }
+
+    iter->iter_state = source;
+    iter->iter_from = count;
+    return iter;
+}
+
+/// @brief A stream that calls `fn` (with no arguments) for each element, up to `limit` pulls
+FixIter *FixIter_fn_new(Box fn, struct FixScope *scope, size_t limit) {
+    require_not_null(scope);
+
+    FixIter *iter = FixIter_new(FixIter_fn_next, limit);
+    if(iter == nullptr) { return nullptr; }
+
+    /// @note the caller's scope is usually a native's by-value parameter, so keep a copy
+    iter->iter_scope = Arena_alloc(sizeof(FixScope));
+    if(iter->iter_scope == nullptr) { error_oom(); return nullptr; }
+    *iter->iter_scope = *scope;
+    iter->iter_fn = fn;
+    return iter;
+}
+
+bool FixIter_next(FixIter *iter, Box *out) {
+    require_not_null(iter);
+    require_not_null(iter->next);
+    return iter->next(iter, out);
+}
+
+/// @brief An independent copy of a stream at its current position
+/// @note sources that are themselves streams are copied too, and a generator gets its own
+///     ... frame; elements already produced (and any containers they hold) stay shared
+FixIter *FixIter_clone(FixIter *iter) {
+    require_not_null(iter);
+
+    FixIter *copy = aro_new(BXD_FIX_ITER);
+    if(copy == nullptr) { error_oom(); return nullptr; }
+
+    *copy = *iter;
+    if(Box_is_Boxed_type(iter->iter_state, BXD_FIX_ITER)) {
+        FixIter *source = FixIter_clone(Box_unwrap_FixIter(iter->iter_state));
+        if(source == nullptr) { return nullptr; }
+        copy->iter_state = Box_wrap_BoxedArena(source);
+    }
+    if(iter->gen_frame != nullptr) {
+        copy->gen_frame = FixGenFrame_clone(iter->gen_frame);
+        if(copy->gen_frame == nullptr) { return nullptr; }
+    }
+    return copy;
+}
+
+bool Box_is_iterable(Box source) {
+    Box *items = nullptr;
+    size_t num_items = 0;
+    return Box_as_sequence(source, &items, &num_items) || (Box_is_Boxed_type(source, BXD_FIX_ITER));
+}
+
+/// @brief Element `index` of an array/view, or the next pull of an iterator (which ignores `index`)
+/// @note callers pull indices in order, so both kinds behave as the same forward-only stream
+bool Box_iter_next(Box source, size_t index, Box *out) {
+    Box *items = nullptr;
+    size_t num_items = 0;
+    if(Box_as_sequence(source, &items, &num_items)) {
+        if(index >= num_items) { return false; }
+        *out = items[index];
+        return true;
+    }
+    if(Box_is_Boxed_type(source, BXD_FIX_ITER)) {
+        return FixIter_next(Box_unwrap_FixIter(source), out);
+    }
+    return false;
+}
+
+/// @brief A fresh pass over `source` for a loop or adaptor: an iterator is cloned, so the bound
+///     ... stream keeps its place and can be looped over again; arrays and views are read in place
+/// @note Box_error_empty() when the copy cannot be allocated
+Box Box_iter_pass(Box source) {
+    if(!(Box_is_Boxed_type(source, BXD_FIX_ITER))) { return source; }
+
+    FixIter *copy = FixIter_clone(Box_unwrap_FixIter(source));
+    return copy == nullptr ? Box_error_empty() : Box_wrap_BoxedArena(copy);
+}
+
+/// @note never pulls, since Box_to_FixStr also describes arguments in debug logs
+///     ... (cf. FixIter_peek_to_FixStr)
+FixStr FixIter_to_FixStr(FixIter *iter) {
+    if(iter->next == FixIter_range_next) {
+        return FixStr_fmt_new(s("Iter(range, %zu/%zu)"), iter->iter_index, iter->iter_to);
+    }
+    return FixStr_fmt_new(s("Iter(%zu pulled)"), iter->iter_index);
+}
+
+/// @brief The next `max` elements of the stream, pulled from a copy so the stream keeps its place
+/// @note what a copy can't copy stays shared: peeking at an MCMC chain advances its model
+/// @example
+///     log(take(range(1, 100), 3))     /// [1, 2, 3]
+///     log(range(1, 100))              /// [1, 2, 3, 4, 5, 6, 7, 8, 9, 10, ...]
+FixStr FixIter_peek_to_FixStr(FixIter *iter, size_t max) {
+    require_not_null(iter);
+
+    FixIter *copy = FixIter_clone(iter);
+    if(copy == nullptr) { return FixIter_to_FixStr(iter); }
+
+    FixStr repr = s("[");
+    Box item;
+    size_t count = 0;
+    for(; count < max && FixIter_next(copy, &item); count++) {
+        repr = FixStr_glue_new(repr, count == 0 ? Box_to_FixStr(item) : FixStr_glue_new(s(", "), Box_to_FixStr(item)));
+    }
+    if(count == max && copy->iter_index < copy->iter_to) {
+        repr = FixStr_glue_new(repr, count == 0 ? s("...") : s(", ..."));
+    }
+    return FixStr_glue_new(repr, s("]"));
+}
+
+
 
 /// ----- FlxArray ----- ///
 
@@ -9120,30 +11998,39 @@ FixStr FlxSet_to_FixStr(FlxSet *set) {
 
 FixStr FlxVecDouble_to_FixStr(FlxVecDouble *vec) {
     FixStr repr = s("VecDouble {");
-    for(size_t i = 0; i < dyn_size(vec); i++) {
+    for(size_t i = 0; i < dyn_size(vec) && i < FLXVEC_PRINT_MAX; i++) {
         double value = vec->data[i];
         repr = FixStr_glue_sep_new(repr, FixStr_fmt_new(s("%.6f"), value), s(", "));
     }
+    if(dyn_size(vec) > FLXVEC_PRINT_MAX) {
+        repr = FixStr_glue_sep_new(repr, FixStr_fmt_new(s("... %zu rows"), dyn_size(vec)), s(", "));
+    }
     repr = FixStr_glue_new(repr, s("}"));
     return repr;
 }
 
 FixStr FlxVecBool_to_FixStr(FlxVecBool *vec) {
     FixStr repr = s("VecBool {");
-    for(size_t i = 0; i < dyn_size(vec); i++) {
+    for(size_t i = 0; i < dyn_size(vec) && i < FLXVEC_PRINT_MAX; i++) {
         bool value = vec->data[i];
         repr = FixStr_glue_sep_new(repr, value ? s("true") : s("false"), s(", "));
     }
+    if(dyn_size(vec) > FLXVEC_PRINT_MAX) {
+        repr = FixStr_glue_sep_new(repr, FixStr_fmt_new(s("... %zu rows"), dyn_size(vec)), s(", "));
+    }
     repr = FixStr_glue_new(repr, s("}"));
     return repr;
 }
 
 FixStr FlxVecInt_to_FixStr(FlxVecInt *vec) {
     FixStr repr = s("VecInt {");
-    for(size_t i = 0; i < dyn_size(vec); i++) {
+    for(size_t i = 0; i < dyn_size(vec) && i < FLXVEC_PRINT_MAX; i++) {
         int value = vec->data[i];
         repr = FixStr_glue_sep_new(repr, FixStr_fmt_new(s("%d"), value), s(", "));
     }
+    if(dyn_size(vec) > FLXVEC_PRINT_MAX) {
+        repr = FixStr_glue_sep_new(repr, FixStr_fmt_new(s("... %zu rows"), dyn_size(vec)), s(", "));
+    }
     repr = FixStr_glue_new(repr, s("}"));
     return repr;
 }
@@ -9593,13 +12480,12 @@ Box FixFn_call(FixFn *ffn, FixScope scope, FixArray args) {
     switch(ffn->type) {
         case FN_USER:
             return FixFn_typed_call(FixFnUser, ffn, scope, args);
+        case FN_LOOP:
         case FN_GENERATOR:
-            /// @note calling convention for generators requires
-            ///     the last argument to be an iterator
-            /// this is handled by interpreter when constructing the call
-            // FixIter *_iter = Boxed_unwrap(FixIter, last(args));
-            return Box_error_empty();
-            // return FixFn_typed_call(FixFnGenerator, ffn, scope, args, *_iter);
+            /// @note calling a generator binds its arguments and returns the stream (a FixIter)
+            return FixFn_typed_call(FixFnUser, ffn, scope, args);
+        case FN_MEMO:
+            return FixFn_typed_call(FixFnUser, ffn, scope, args);
         case FN_NATIVE:
             return FixFn_typed_call(FixFnNative, ffn, scope, args);
         case FN_NATIVE_0:
@@ -9677,6 +12563,72 @@ int FixArray_test_main(void) {
     return 0;
 }
 
+int FixArrayView_test_main(void) {
+    FixArray *array = FixArray_new_auto(10);
+    for(int i = 0; i < 10; i++) { FixArray_append(array, Box_wrap_int(i)); }
+    Box boxed = Box_wrap_BoxedArena(array);
+
+    FixArrayView *tail = FixArrayView_of_Box(boxed, 2, SIZE_MAX);
+    log_assert(tail != nullptr && len_ref(tail) == 8, sMSG("FixArrayView should clamp its end to the array"));
+
+    FixArrayView *middle = FixArrayView_of_Box(Box_wrap_BoxedArena(tail), 1, 4);
+    log_assert(middle->data == array && middle->start == 3 && len_ref(middle) == 3, sMSG("A view of a view should share the root array"));
+
+    Box *items = nullptr;
+    size_t num_items = 0;
+    log_assert(Box_as_sequence(Box_wrap_BoxedArena(middle), &items, &num_items), sMSG("Box_as_sequence rejected a view"));
+    log_assert(items == &array->data[3] && num_items == 3, sMSG("Box_as_sequence should read the view in place"));
+
+    FixArrayView_set(middle, 0, Box_wrap_int(99));
+    log_assert(middle->data != array && Box_unwrap_int(middle->data->data[0]) == 99, sMSG("FixArrayView_set should copy on write"));
+    log_assert(Box_unwrap_int(array->data[3]) == 3, sMSG("FixArrayView_set modified the shared array"));
+    log_assert(Box_unwrap_int(tail->data->data[tail->start + 1]) == 3, sMSG("FixArrayView_set modified a sibling view"));
+
+    FixArrayView *empty = FixArrayView_of_Box(boxed, 7, 3);
+    log_assert(empty != nullptr && len_ref(empty) == 0, sMSG("An inverted range should give an empty view"));
+    return 0;
+}
+
+int FixIter_test_main(void) {
+    FixIter *range = FixIter_range_new(1, 10000000, 1);
+    size_t arena_used = ctx_current_arena()->used;
+    Box item;
+    int64_t total = 0;
+    size_t count = 0;
+    while(FixIter_next(range, &item)) { total += Box_unwrap_int(item); count++; }
+    log_assert(count == 10000000 && total == 50000005000000, sMSG("FixIter range should yield 1..10^7 inclusive"));
+    log_assert(ctx_current_arena()->used == arena_used, sMSG("Pulling from a range should not allocate"));
+
+    FixIter *odds = FixIter_range_new(1, 10, 2);
+    log_assert(odds->meta.size == 5, sMSG("range(1, 10, 2) should have 5 elements"));
+
+    Box evens = Box_wrap_BoxedArena(FixIter_range_new(0, 100, 2));
+    Box window = Box_wrap_BoxedArena(FixIter_take_new(Box_wrap_BoxedArena(FixIter_drop_new(evens, 3)), 2));
+    log_assert(Box_iter_next(window, 0, &item) && Box_unwrap_int(item) == 6, sMSG("drop then take should start at 6"));
+    log_assert(Box_iter_next(window, 1, &item) && Box_unwrap_int(item) == 8, sMSG("take should yield a second element"));
+    log_assert(!Box_iter_next(window, 2, &item), sMSG("take(2) should end after two elements"));
+
+    /// take() reads a copy of the stream, so the stream itself keeps its place
+    FixFn take = { .name = s("take") };
+    Box digits = Box_wrap_BoxedArena(FixIter_range_new(0, 9, 1));
+    Box take_args[2] = { digits, Box_wrap_int(2) };
+    Box taken = native_take(&take, (FixScope) {0}, (FixArray) { .meta.size = 2, .meta.capacity = 2, .data = take_args });
+    log_assert(Box_iter_next(taken, 0, &item) && Box_iter_next(taken, 1, &item), sMSG("take() should yield two elements"));
+    log_assert(Box_iter_next(digits, 0, &item) && Box_unwrap_int(item) == 0, sMSG("take() should not consume its stream"));
+
+    FixIter *first = FixIter_take_new(Box_wrap_BoxedArena(FixIter_range_new(1, 100, 1)), 3);
+    log_assert(FixStr_eq(FixIter_peek_to_FixStr(first, FIXITER_PRINT_MAX), s("[1, 2, 3]")), sMSG("A short stream should print whole"));
+    log_assert(FixStr_eq(FixIter_peek_to_FixStr(first, 2), s("[1, 2, ...]")), sMSG("A long stream should print its first elements"));
+    log_assert(FixIter_next(first, &item) && Box_unwrap_int(item) == 1, sMSG("Printing a stream should not consume it"));
+
+    FixArray *array = FixArray_new_auto(3);
+    for(int i = 0; i < 3; i++) { FixArray_append(array, Box_wrap_int(10 + i)); }
+    FixIter *tail = FixIter_drop_new(Box_wrap_BoxedArena(array), 1);
+    log_assert(FixIter_next(tail, &item) && Box_unwrap_int(item) == 11, sMSG("drop over an array should read in place"));
+    log_assert(FixIter_next(tail, &item) && !FixIter_next(tail, &item), sMSG("drop over an array should end with it"));
+    return 0;
+}
+
 int FixDict_test_main(void) {
     FixDict dict;
     FixDict_data_new(&dict, 10);
@@ -9805,806 +12757,7290 @@ int FixFn_test_main(void) {
 
 #pragma endregion
 
-#pragma region BoxHelpersAndErrors
+#pragma region FlxGraphImpl
 
-FixArray *CliArgs_to_FixArray(int argc, char **argv) {
-    FixArray *args = FixArray_new_auto(argc);
-    for (int i = 0; i < argc; i++) {
-        Box arg = Box_wrap_BoxedArena(&FixStr_from_cstr(argv[i]));
-        FixArray_append(args, arg);
+/// @brief A graph of `type` (one of the BXD_FLX_GRAPH_* kinds) with room for the given
+///     ... numbers of nodes and edges
+/// @note capacity is fixed: callers (e.g. FixModelGraph_trace) know the sizes up front
+FlxGraph *FlxGraph_new(MetaType type, size_t node_capacity, size_t edge_capacity) {
+    require(type == BXD_FLX_GRAPH_DIRECTED_WEIGHTED || type == BXD_FLX_GRAPH_DIRECTED_UNWEIGHTED
+        || type == BXD_FLX_GRAPH_UNDIRECTED_WEIGHTED || type == BXD_FLX_GRAPH_UNDIRECTED_UNWEIGHTED);
+
+    FlxGraph *graph = gco_new(BXD_FLX_GRAPH_DIRECTED_UNWEIGHTED);
+    if(graph == nullptr) { error_oom(); return nullptr; }
+
+    graph->meta.type = type;
+    graph->meta.state = LIVING_ALIVE;
+    graph->meta.size = 0;
+    graph->num_nodes = 0;
+    graph->num_edges = 0;
+    graph->node_capacity = node_capacity;
+    graph->edge_capacity = edge_capacity;
+    graph->nodes = nullptr;
+    graph->edges = nullptr;
+
+    if(node_capacity > 0) {
+        graph->nodes = cnew(node_capacity * sizeof(FixGraphNode));
+        if(graph->nodes == nullptr) { error_oom(); return nullptr; }
+        memset(graph->nodes, 0, node_capacity * sizeof(FixGraphNode));
     }
-    return args;
+    if(edge_capacity > 0) {
+        graph->edges = cnew(edge_capacity * sizeof(FixGraphEdge));
+        if(graph->edges == nullptr) { error_oom(); return nullptr; }
+        memset(graph->edges, 0, edge_capacity * sizeof(FixGraphEdge));
+    }
+    return graph;
 }
 
-FixError *error_push(FixError error) {
-    ctx().debug.errors[ctx().debug.num_errors++] = error;
-    return &ctx().debug.errors[ctx().debug.num_errors - 1];
-}
+/// @brief Appends a node holding `value`, returning its index (SIZE_MAX when full)
+size_t FlxGraph_add_node(FlxGraph *graph, Box value) {
+    require_not_null(graph);
+    if(graph->num_nodes >= graph->node_capacity) {
+        log_message(LL_ERROR, sMSG("Graph is full (%zu nodes)"), graph->node_capacity);
+        return SIZE_MAX;
+    }
 
+    size_t index = graph->num_nodes++;
+    graph->nodes[index] = (FixGraphNode) {
+        .hash = Box_hash(value), .value = value, .occupied = true
+    };
+    graph->meta.size = graph->num_nodes;
+    return index;
+}
 
+bool FlxGraph_has_edge(FlxGraph *graph, size_t source, size_t target) {
+    require_not_null(graph);
+    bool undirected = graph->meta.type == BXD_FLX_GRAPH_UNDIRECTED_WEIGHTED
+        || graph->meta.type == BXD_FLX_GRAPH_UNDIRECTED_UNWEIGHTED;
 
-void error_print_lastN(size_t n) {
-    for(size_t i = 0; i < n; i++) {
-        error_print(ctx().debug.errors[ctx().debug.num_errors - i - 1]);
+    for(size_t i = 0; i < graph->num_edges; i++) {
+        size_t from = (size_t) Box_unwrap_int(graph->edges[i].source);
+        size_t to = (size_t) Box_unwrap_int(graph->edges[i].target);
+        if(from == source && to == target) { return true; }
+        if(undirected && from == target && to == source) { return true; }
     }
+    return false;
 }
 
-void error_print(FixError error) {
-    log_message(LL_INFO,  s("Error Code: %d"), error.code);
-    log_message(LL_INFO,  s("Message: %.*s"), fmt(error.message));
-    log_message(LL_INFO,  s("Location: %.*s"), fmt(error.location));
-    if (error.info.user_file.cstr != nullptr) {
-        log_message(LL_INFO,  s("User File: %.*s"), fmt(error.info.user_file));
-        log_message(LL_INFO,  s("User Line: %zu"), error.info.user_line);
-        log_message(LL_INFO,  s("User Column: %zu"), error.info.user_col);
+/// @brief Adds an edge between two existing nodes; a repeated edge is not added twice
+/// @return false if either node is missing or the graph's edges are full
+bool FlxGraph_add_edge(FlxGraph *graph, size_t source, size_t target, Box weight) {
+    require_not_null(graph);
+    if(source >= graph->num_nodes || target >= graph->num_nodes) {
+        log_message(LL_ERROR, sMSG("Graph edge %zu -> %zu is outside its %zu nodes"),
+            source, target, graph->num_nodes);
+        return false;
+    }
+    if(FlxGraph_has_edge(graph, source, target)) { return true; }
+    if(graph->num_edges >= graph->edge_capacity) {
+        log_message(LL_ERROR, sMSG("Graph is full (%zu edges)"), graph->edge_capacity);
+        return false;
     }
+
+    Box from = Box_wrap_int((int32_t) source);
+    Box to = Box_wrap_int((int32_t) target);
+    graph->edges[graph->num_edges++] = (FixGraphEdge) {
+        .hash = Box_hash(from) ^ (Box_hash(to) << 1),
+        .source = from, .target = to, .weight = weight, .occupied = true
+    };
+    return true;
+}
+
+FixStr FlxGraph_to_FixStr(FlxGraph *graph) {
+    return FixStr_fmt_new(s("Graph(%.*s, %zu nodes, %zu edges)"),
+        fmt(bt_nameof(graph->meta.type)), graph->num_nodes, graph->num_edges);
 }
 
 #pragma endregion
 
-#pragma region NativeStdLibMath
+#pragma region FlxDataFrameImpl
+
+/// @note grows a FlxVec* by doubling, for use in functions returning void
+#define flx_vec_grow_ref(vec) \
+    if(len_ref(vec) >= capacity_ref(vec)) { \
+        if((vec)->meta.state == LIVING_PINNED) { \
+            log_message(LL_ERROR, sMSG("Cannot grow a pinned (memory-mapped) column.")); return; } \
+        size_t new_capacity = capacity_ref(vec) ? 2 * capacity_ref(vec) : ARRAY_SIZE_SMALL; \
+        void *new_data = cextend((vec)->data, new_capacity * sizeof((vec)->data[0])); \
+        if(new_data == nullptr) { error_oom(); return; } \
+        (vec)->data = new_data; \
+        (vec)->meta.capacity = new_capacity; \
+        (vec)->meta.alloc_size = new_capacity * sizeof((vec)->data[0]); \
+    }
+
+/// @brief Runs `...` once per selected row index `i`
+/// @note a nullptr selection means every row; fully-set words run as a dense loop
+///     ... and sparse words skip straight to their set bits
+#define flx_foreach_selected(sel, num_rows, ...) \
+    if((sel) == nullptr) { \
+        for(size_t i = 0; i < (num_rows); i++) { __VA_ARGS__; } \
+    } else { \
+        for(size_t w = 0; w < (sel)->meta.capacity; w++) { \
+            uint64_t bits = (sel)->data[w]; \
+            if(bits == ~0ULL) { \
+                for(size_t i = w * 64; i < w * 64 + 64; i++) { __VA_ARGS__; } \
+                continue; \
+            } \
+            while(bits) { \
+                size_t i = w * 64 + (size_t) __builtin_ctzll(bits); \
+                bits &= bits - 1; \
+                __VA_ARGS__; \
+            } \
+        } \
+    }
 
-void native_stdlib_math_test_main(void) {}
+/// @brief Packs `predicate` (over row `i`) into the words of `mask`
+/// @note the inner loop has no branches, so it vectorizes
+#define flx_filter_words(mask, num_rows, predicate) \
+    for(size_t w = 0; w < (mask).meta.capacity; w++) { \
+        size_t base = w * 64; \
+        size_t end = (base + 64 < (num_rows)) ? base + 64 : (num_rows); \
+        uint64_t bits = 0; \
+        for(size_t i = base; i < end; i++) { \
+            bits |= ((uint64_t) (predicate)) << (i - base); \
+        } \
+        (mask).data[w] = bits; \
+    }
 
-double sample(FixDist *dist) {
-    return dist->sample_fn_ptr(dist);
-}
+#define flx_filter_switch(mask, num_rows, op, x, rhs) \
+    switch(op) { \
+        case CMP_LT: flx_filter_words(mask, num_rows, (x)[i] < (rhs)); break; \
+        case CMP_LE: flx_filter_words(mask, num_rows, (x)[i] <= (rhs)); break; \
+        case CMP_GT: flx_filter_words(mask, num_rows, (x)[i] > (rhs)); break; \
+        case CMP_GE: flx_filter_words(mask, num_rows, (x)[i] >= (rhs)); break; \
+        case CMP_EQ: flx_filter_words(mask, num_rows, (x)[i] == (rhs)); break; \
+        case CMP_NE: flx_filter_words(mask, num_rows, (x)[i] != (rhs)); break; \
+    }
 
+#define flx_gather_into(dst, src, rows, num_rows) \
+    for(size_t r = 0; r < (num_rows); r++) { \
+        (dst)->data[r] = (src)->data[(rows)[r]]; \
+    } \
+    (dst)->meta.size = (num_rows);
 
-/**
- * Initializes a probabilistic model with default or specified parameters.
- *
- * @param model   Pointer to the Model structure representing the probabilistic model.
- * @param method  The inference algorithm to use (e.g., MCMC).
- * @return        Pointer to an FixInferResult structure containing posterior samples.
- */
-FixInferResult *FixInferResult_new(const FixInferModel *model, InferMethod method) {
-    FixInferResult *result = Arena_alloc(sizeof(FixInferResult));
-    if (!result) {  error_oom(); return nullptr; }
 
-    result->samples = Arena_alloc(model->num_target_samples * sizeof(double *));
-    result->num_samples = Arena_alloc(model->num_target_samples * sizeof(size_t));
+FlxVecDouble *FlxVecDouble_new(size_t capacity) {
+    FlxVecDouble *vec = gco_new(BXD_FLX_VEC_DOUBLE_N);
+    if(vec == nullptr) { error_oom(); return nullptr; }
 
-    if (!result->samples) {  error_oom(); return nullptr; }
-    if (!result->num_samples) {  error_oom(); return nullptr; }
+    size_t initial_capacity = capacity > 0 ? capacity : ARRAY_SIZE_SMALL;
+    vec->meta.type = BXD_FLX_VEC_DOUBLE_N;
+    vec->meta.state = LIVING_ALIVE;
+    cnew_carray(vec, initial_capacity);
+    return vec;
+}
 
-    for (size_t i = 0; i < model->num_target_samples; i++) {
-        result->samples[i] = Arena_alloc(model->num_params * sizeof(double));
-        if (!result->samples[i]) {
-            error_oom();
-        }
-    }
+FlxVecInt *FlxVecInt_new(size_t capacity) {
+    FlxVecInt *vec = gco_new(BXD_FLX_VEC_INT);
+    if(vec == nullptr) { error_oom(); return nullptr; }
 
-    return result;
+    size_t initial_capacity = capacity > 0 ? capacity : ARRAY_SIZE_SMALL;
+    vec->meta.type = BXD_FLX_VEC_INT;
+    vec->meta.state = LIVING_ALIVE;
+    cnew_carray(vec, initial_capacity);
+    return vec;
 }
 
+FlxVecBool *FlxVecBool_new(size_t capacity) {
+    FlxVecBool *vec = gco_new(BXD_FLX_VEC_BOOL);
+    if(vec == nullptr) { error_oom(); return nullptr; }
 
-/// @brief Performs inference on the given probabilistic model using the specified inference method.
+    size_t initial_capacity = capacity > 0 ? capacity : ARRAY_SIZE_SMALL;
+    vec->meta.type = BXD_FLX_VEC_BOOL;
+    vec->meta.state = LIVING_ALIVE;
+    cnew_carray(vec, initial_capacity);
+    return vec;
+}
 
-FixInferResult *FixInferResult_infer(const FixInferModel *model, InferMethod method);
+FlxVecCat *FlxVecCat_new(size_t capacity, size_t max_categories) {
+    require_positive(max_categories);
 
-/// @brief Initializes a probabilistic model with default or specified parameters.
-FixInferModel *Model_new(FixDist *prior, FixDist *likelihood, size_t num_target_samples);
+    FlxVecCat *cat = gco_new(BXD_FLX_VEC_TAGS);
+    if(cat == nullptr) { error_oom(); return nullptr; }
 
-FixInferModel *Model_set_params(FixInferModel *model, double *params, size_t num_params) {
-    model->params = params;
-    model->num_params = num_params;
-    return model;
+    size_t initial_capacity = capacity > 0 ? capacity : ARRAY_SIZE_SMALL;
+    cat->meta.type = BXD_FLX_VEC_TAGS;
+    cat->meta.state = LIVING_ALIVE;
+    cnew_carray(cat, initial_capacity);
+
+    cat->categories = cnew(max_categories * sizeof(FixStr));
+    if(cat->categories == nullptr) { error_oom(); return nullptr; }
+    cat->num_categories = 0;
+    cat->max_categories = max_categories;
+    return cat;
 }
 
-FixInferModel *Model_set_data(FixInferModel *model, double *data, size_t num_data) {
-    model->data = data;
-    model->num_data = num_data;
-    return model;
+void FlxVecDouble_push(FlxVecDouble *vec, double value) {
+    require_not_null(vec);
+    flx_vec_grow_ref(vec);
+    push_ref(vec, value);
 }
 
+void FlxVecInt_push(FlxVecInt *vec, int value) {
+    require_not_null(vec);
+    flx_vec_grow_ref(vec);
+    push_ref(vec, value);
+}
 
-/**
- * Records an observation within the probabilistic model.
- *
- * @param model
- *      includes pointer to a FixDist struct defining the observation's distribution.
- * @param value The observed value to condition on.
- */
-void Model_observe(FixInferModel *model, double value) {
-    model->data[model->num_data++] = value;
+void FlxVecBool_push(FlxVecBool *vec, bool value) {
+    require_not_null(vec);
+    flx_vec_grow_ref(vec);
+    push_ref(vec, value);
 }
 
-/**
- * Initializes the random number generator with a given seed.
- *
- * @param seed  The seed value for the RNG.
- */
-void initialize_rng(unsigned int seed);
+int FlxVecCat_code_of(FlxVecCat *cat, FixStr category) {
+    require_not_null(cat);
 
-double lib_rand_0to1(void) {
-    return (double) clib_random_improved();
+    for(size_t c = 0; c < cat->num_categories; c++) {
+        if(FixStr_eq(cat->categories[c], category)) {
+            return (int) c;
+        }
+    }
+    return -1;
 }
 
-double lib_rand_normal(double mean, double stddev) {
-    double u1 = lib_rand_0to1();
-    double u2 = lib_rand_0to1();
-    double z = sqrt(-2 * log(u1)) * cos(2 * M_PI * u2);
-    return mean + z * stddev;
-}
+/// @brief Returns the code for `category`, adding it if new (-1 when the table is full)
+int FlxVecCat_intern(FlxVecCat *cat, FixStr category) {
+    require_not_null(cat);
 
-/**
- * Computes the Probability Density Function (PDF) of the Normal distribution.
- *
- * @param x       The value at which to evaluate the PDF.
- * @param mean    The mean (μ) of the Normal distribution.
- * @param stddev  The standard deviation (σ) of the Normal distribution.
- * @return        The PDF value at x for N(mean, stddev).
- */
-double normal_pdf(double x, double mean, double stddev);
-double normal_log_pdf(double x, double mean, double stddev);
+    int code = FlxVecCat_code_of(cat, category);
+    if(code >= 0) {
+        return code;
+    }
+    if(cat->num_categories >= cat->max_categories) {
+        log_message(LL_ERROR, sMSG("FlxVecCat: more than %zu categories."), cat->max_categories);
+        return -1;
+    }
 
-/**
- * Computes the Probability Density Function (PDF) of the Gamma distribution.
- *
- * @param x      The value at which to evaluate the PDF.
- * @param shape  The shape parameter (α) of the Gamma distribution.
- * @param rate   The rate parameter (β) of the Gamma distribution.
- * @return       The PDF value at x for Gamma(shape, rate).
- */
-double gamma_pdf(double x, double shape, double rate);
-double gamma_log_pdf(double x, double shape, double rate);
+    cat->categories[cat->num_categories] = category;
+    return (int) cat->num_categories++;
+}
 
-/**
- * Samples a value from a Normal (Gaussian) distribution.
- *
- * @param mean    The mean (μ) of the distribution.
- * @param stddev  The standard deviation (σ) of the distribution.
- * @return        A random sample from N(mean, stddev).
- */
-double sample_normal(double mean, double stddev);
+void FlxVecCat_push(FlxVecCat *cat, FixStr category) {
+    require_not_null(cat);
 
-/**
- * Samples a value from a Gamma distribution.
- *
- * @param shape  The shape parameter (α) of the Gamma distribution.
- * @param rate   The rate parameter (β) of the Gamma distribution.
- * @return       A random sample from Gamma(shape, rate).
- */
-double sample_gamma(double shape, double rate);
+    int code = FlxVecCat_intern(cat, category);
+    if(code < 0) { return; }
 
+    flx_vec_grow_ref(cat);
+    push_ref(cat, code);
+}
 
-#pragma endregion
+FixStr FlxVecCat_to_FixStr(FlxVecCat *cat) {
+    FixStr repr = s("VecCat {");
+    for(size_t i = 0; i < dyn_size(cat) && i < FLXVEC_PRINT_MAX; i++) {
+        FixStr value = cat->categories[cat->data[i]];
+        repr = FixStr_glue_sep_new(repr, value, s(", "));
+    }
+    if(dyn_size(cat) > FLXVEC_PRINT_MAX) {
+        repr = FixStr_glue_sep_new(repr, FixStr_fmt_new(s("... %zu rows"), dyn_size(cat)), s(", "));
+    }
+    repr = FixStr_glue_new(repr, s("}"));
+    return repr;
+}
 
-#pragma region BoxedNative
 
+/// @brief Zeroes the bits past the last row, so counts and iteration stay exact
+static inline void FixBitmask_clear_tail(FixBitmask *mask) {
+    size_t tail = mask->meta.size & 63;
+    if(tail != 0) {
+        mask->data[mask->meta.capacity - 1] &= (1ULL << tail) - 1;
+    }
+}
 
+FixBitmask FixBitmask_cnew(size_t num_rows, bool all_set) {
+    FixBitmask mask = {0};
+    size_t num_words = FixBitmask_num_words(num_rows);
 
-// #define native_srcof(i) ctx().info.sources[i].source_code
+    mask.meta.size = num_rows;
+    mask.meta.capacity = num_words;
+    mask.meta.alloc_size = num_words * sizeof(uint64_t);
+    mask.data = cnew(num_words > 0 ? mask.meta.alloc_size : sizeof(uint64_t));
+    if(mask.data == nullptr) { error_oom(); return mask; }
 
-#define native_track_src_start() \
-    ctx().info.sources[ctx().info.num_sources].name = s(__func__); \
-    ctx().info.sources[ctx().info.num_sources].source_file = s(__FILE__); \
-    ctx().info.sources[ctx().info.num_sources].start_line_num = __LINE__;
+    uint64_t fill = all_set ? ~0ULL : 0ULL;
+    for(size_t w = 0; w < num_words; w++) {
+        mask.data[w] = fill;
+    }
+    FixBitmask_clear_tail(&mask);
+    return mask;
+}
 
-#define native_track_src_end() \
-    ctx().info.sources[ctx().info.num_sources].end_line_num = __LINE__; \
-    ctx().info.num_sources++;
+void FixBitmask_cfree(FixBitmask *mask) {
+    require_not_null(mask);
+    cfree(mask->data);
+    mask->data = nullptr;
+    mask->meta.size = 0;
+    mask->meta.capacity = 0;
+}
 
-/// @todo consider the *double problem
-///     ... ie maybe have a declare_ for a double arg?
-///         ... since it would require a deref
+void FixBitmask_and(FixBitmask *out, const FixBitmask *other) {
+    require(out->meta.size == other->meta.size);
+    for(size_t w = 0; w < out->meta.capacity; w++) {
+        out->data[w] &= other->data[w];
+    }
+}
 
+void FixBitmask_or(FixBitmask *out, const FixBitmask *other) {
+    require(out->meta.size == other->meta.size);
+    for(size_t w = 0; w < out->meta.capacity; w++) {
+        out->data[w] |= other->data[w];
+    }
+}
 
-#define declare_arity0_to_native(raw_name, return_packer) \
-    Box native_##raw_name(FixFn *self, FixScope parent, Box one, Box two) { \
-        native_log_call0(self);\
-        return return_packer(raw_name()); \
+void FixBitmask_not(FixBitmask *out) {
+    for(size_t w = 0; w < out->meta.capacity; w++) {
+        out->data[w] = ~out->data[w];
     }
+    FixBitmask_clear_tail(out);
+}
 
-#define declare_arity1_to_native(raw_name, btype_1st, return_packer) \
-    Box native_##raw_name(FixFn *self, FixScope parent, Box one) { \
-        native_log_call1(self, one);\
-        native_return_error_if(one.type != btype_1st, sMSG("Expected argument type %s"), ubx_nameof(btype_1st)); \
-        Box_ctypeof(btype_1st) first;\
-        require_safe(clib_memcpy_safe(&first, \
-            sizeof(Box_ctypeof(btype_1st)), &one, sizeof(Box_ctypeof(btype_1st))));\
-        return return_packer(raw_name(first)); \
+size_t FixBitmask_count(const FixBitmask *mask) {
+    size_t count = 0;
+    for(size_t w = 0; w < mask->meta.capacity; w++) {
+        count += (size_t) __builtin_popcountll(mask->data[w]);
     }
+    return count;
+}
 
-#define declare_arity2_to_native(raw_name, btype_1st, btype_2nd, return_packer) \
-    Box native_##raw_name(FixFn *self, FixScope parent, Box one, Box two) { \
-        native_log_call2(self, one, two);\
-        native_return_error_if(one.type != btype_1st, sMSG("Expected argument type %s"), ubx_nameof(btype_1st)); \
-        native_return_error_if(two.type != btype_2nd, sMSG("Expected argument type %s"), ubx_nameof(btype_2nd)); \
-        Box_ctypeof(btype_1st) first;\
-        Box_ctypeof(btype_1st) second;\
-        require_safe(clib_memcpy_safe(&first, sizeof(Box_ctypeof(btype_1st)), \
-                &one, sizeof(Box_ctypeof(btype_1st))));\
-        require_safe(clib_memcpy_safe(&second, sizeof(Box_ctypeof(btype_2nd)), \
-                &two, sizeof(Box_ctypeof(btype_2nd))));\
-        return return_packer(raw_name(first, second));\
+/// @brief Expands a selection into the list of selected row indexes
+static size_t *FixBitmask_rows_cnew(const FixBitmask *sel, size_t *out_count) {
+    size_t count = FixBitmask_count(sel);
+    size_t *rows = cnew((count > 0 ? count : 1) * sizeof(size_t));
+    if(rows == nullptr) { error_oom(); *out_count = 0; return nullptr; }
+
+    size_t k = 0;
+    flx_foreach_selected(sel, sel->meta.size, rows[k++] = i);
+    *out_count = count;
+    return rows;
+}
+
+
+FixBitmask FlxVecDouble_filter(FlxVecDouble *vec, FlxCmpOp op, double rhs) {
+    require_not_null(vec);
+
+    size_t n = len_ref(vec);
+    FixBitmask mask = FixBitmask_cnew(n, false);
+    if(mask.data == nullptr) { return mask; }
+
+    const double *x = vec->data;
+    flx_filter_switch(mask, n, op, x, rhs);
+    return mask;
+}
+
+/// @note compares in double, so a fractional `rhs` isn't truncated (eg., x < 2.5 keeps 2)
+FixBitmask FlxVecInt_filter(FlxVecInt *vec, FlxCmpOp op, double rhs) {
+    require_not_null(vec);
+
+    size_t n = len_ref(vec);
+    FixBitmask mask = FixBitmask_cnew(n, false);
+    if(mask.data == nullptr) { return mask; }
+
+    const int *x = vec->data;
+    flx_filter_switch(mask, n, op, x, rhs);
+    return mask;
+}
+
+FixBitmask FlxVecCat_filter_eq(FlxVecCat *cat, FixStr category) {
+    require_not_null(cat);
+
+    size_t n = len_ref(cat);
+    FixBitmask mask = FixBitmask_cnew(n, false);
+    if(mask.data == nullptr) { return mask; }
+
+    /// @note an unknown category matches nothing
+    int code = FlxVecCat_code_of(cat, category);
+    if(code < 0) { return mask; }
+
+    const int *x = cat->data;
+    flx_filter_words(mask, n, x[i] == code);
+    return mask;
+}
+
+/// @brief Aggregates the selected rows of a column (all rows if `sel` is nullptr)
+/// @note min/max/mean of an empty selection are NAN
+double FlxVecDouble_aggregate(FlxVecDouble *vec, const FixBitmask *sel, FlxAggOp op) {
+    require_not_null(vec);
+
+    size_t n = len_ref(vec);
+    log_assert(sel == nullptr || sel->meta.size == n, sMSG("Selection does not match column length."));
+
+    const double *x = vec->data;
+    size_t count = sel == nullptr ? n : FixBitmask_count(sel);
+
+    switch(op) {
+        case AGG_COUNT:
+            return (double) count;
+        case AGG_SUM: {
+            double acc = 0.0;
+            flx_foreach_selected(sel, n, acc += x[i]);
+            return acc;
+        }
+        case AGG_MEAN: {
+            double acc = 0.0;
+            flx_foreach_selected(sel, n, acc += x[i]);
+            return count > 0 ? acc / (double) count : NAN;
+        }
+        case AGG_MIN: {
+            double acc = INFINITY;
+            flx_foreach_selected(sel, n, acc = x[i] < acc ? x[i] : acc);
+            return count > 0 ? acc : NAN;
+        }
+        case AGG_MAX: {
+            double acc = -INFINITY;
+            flx_foreach_selected(sel, n, acc = x[i] > acc ? x[i] : acc);
+            return count > 0 ? acc : NAN;
+        }
     }
+    return NAN;
+}
 
 
-#define declare_arity2_to_native_numeric(raw_name, return_packer) \
-    Box native_##raw_name(FixFn *self, FixScope parent, Box one, Box two) { \
-        native_log_call2(self, one, two);\
-        double first, second;\
-        native_return_error_if(!Box_try_numeric(one, &first), \
-            sMSG("Expected numeric argument type, got %s"), ubx_nameof(one.type)); \
-        native_return_error_if(!Box_try_numeric(two, &second), \
-            sMSG("Expected numeric argument type, got %s"), ubx_nameof(two.type)); \
-        return return_packer(raw_name(first, second));\
+FlxDataFrame *FlxDataFrame_new(size_t num_columns) {
+    require_positive(num_columns);
+    log_assert(num_columns <= DATAFRAME_MAX_COLUMNS, sMSG("DataFrame beyond column capacity."));
+
+    FlxDataFrame *df = gco_new(BXD_FLX_DATAFRAME);
+    if(df == nullptr) { error_oom(); return nullptr; }
+
+    df->meta.type = BXD_FLX_DATAFRAME;
+    df->meta.size = 0;
+    df->meta.capacity = num_columns;
+    df->num_rows = 0;
+    df->mapping = nullptr;
+    df->mapping_size = 0;
+    df->columns = cnew(num_columns * sizeof(Boxed *));
+    df->names = cnew(num_columns * sizeof(FixStr));
+    if(df->columns == nullptr || df->names == nullptr) { error_oom(); return nullptr; }
+    return df;
+}
+
+bool FlxDataFrame_add_column(FlxDataFrame *df, FixStr name, Boxed *column) {
+    require_not_null(df);
+    require_not_null(column);
+
+    switch(column->meta.type) {
+        case BXD_FLX_VEC_DOUBLE_N:
+        case BXD_FLX_VEC_INT:
+        case BXD_FLX_VEC_BOOL:
+        case BXD_FLX_VEC_TAGS:
+            break;
+        default:
+            log_message(LL_ERROR, sMSG("DataFrame column '%.*s' has unsupported type %.*s."),
+                fmt(name), fmt(bt_nameof(column->meta.type)));
+            return false;
     }
 
+    if(len_ref(df) >= capacity_ref(df)) {
+        log_message(LL_ERROR, sMSG("DataFrame has no room for column '%.*s'."), fmt(name));
+        return false;
+    }
 
-declare_arity1_to_native(sqrtf, UBX_FLOAT, Box_wrap_float);
-declare_arity2_to_native_numeric(lib_rand_normal, Box_wrap_float);
+    if(len_ref(df) > 0 && column->meta.size != df->num_rows) {
+        log_message(LL_ERROR, sMSG("DataFrame column '%.*s' has %zu rows, expected %zu."),
+            fmt(name), column->meta.size, df->num_rows);
+        return false;
+    }
 
-Box native_getsrc(FixFn *self, FixScope parent, Box one) {
-    native_log_call1(self, one); native_track_src_start();
+    df->num_rows = column->meta.size;
+    df->names[len_ref(df)] = name;
+    df->columns[len_ref(df)] = column;
+    incr_len_ref(df);
+    return true;
+}
 
-    FixStr native_fn_name = Box_unwrap_FixStr(one);
+Boxed *FlxDataFrame_column(FlxDataFrame *df, FixStr name) {
+    require_not_null(df);
 
-    static FixDict native_src_dict;
-    static bool is_initialized = false;
+    for(size_t c = 0; c < len_ref(df); c++) {
+        if(FixStr_eq(df->names[c], name)) {
+            return df->columns[c];
+        }
+    }
+    return nullptr;
+}
 
-    if (!is_initialized) {
-        FixDict_data_new(&native_src_dict, ctx().info.num_sources);
-        for (size_t i = 0; i < ctx().info.num_sources; i++) {
-            FixDict_set(&native_src_dict, ctx().info.sources[i].name, Box_wrap_ptr(&ctx().info.sources[i]));
+/// @brief Compares a numeric column against `rhs`, producing a selection
+/// @note categorical columns are filtered with FlxVecCat_filter_eq
+FixBitmask FlxDataFrame_filter(FlxDataFrame *df, FixStr name, FlxCmpOp op, double rhs) {
+    require_not_null(df);
+
+    Boxed *column = FlxDataFrame_column(df, name);
+    if(column == nullptr) {
+        log_message(LL_ERROR, sMSG("DataFrame.filter(): no column '%.*s'."), fmt(name));
+        return FixBitmask_cnew(df->num_rows, false);
+    }
+
+    switch(column->meta.type) {
+        case BXD_FLX_VEC_DOUBLE_N:
+            return FlxVecDouble_filter(Boxed_as(FlxVecDouble, column), op, rhs);
+        case BXD_FLX_VEC_INT:
+            return FlxVecInt_filter(Boxed_as(FlxVecInt, column), op, rhs);
+        case BXD_FLX_VEC_BOOL: {
+            FixBitmask mask = FixBitmask_cnew(df->num_rows, false);
+            if(mask.data == nullptr) { return mask; }
+            const bool *x = Boxed_as(FlxVecBool, column)->data;
+            flx_filter_switch(mask, df->num_rows, op, x, rhs);
+            return mask;
         }
-        is_initialized = true;
+        default:
+            log_message(LL_ERROR, sMSG("DataFrame.filter(): column '%.*s' is not numeric."), fmt(name));
+            return FixBitmask_cnew(df->num_rows, false);
     }
+}
 
-    Box entry = FixDict_get(&native_src_dict, native_fn_name);
-    if (!Box_is_null(entry)) {
-        SourceInfo *src_info = Box_unwrap_typed_ptr(SourceInfo, entry);
-        if (FixStr_is_empty(src_info->source_code)) {
-            src_info->source_code = FixStr_readlines_new(
-                src_info->source_file,
-                src_info->start_line_num,
-                src_info->end_line_num
-            );
+/// @brief Projects the named columns into a new frame sharing the same column data
+FlxDataFrame *FlxDataFrame_select(FlxDataFrame *df, FixStr *names, size_t num_names) {
+    require_not_null(df);
+    require_not_null(names);
+
+    FlxDataFrame *out = FlxDataFrame_new(num_names);
+    if(out == nullptr) { return nullptr; }
+
+    for(size_t c = 0; c < num_names; c++) {
+        Boxed *column = FlxDataFrame_column(df, names[c]);
+        if(column == nullptr) {
+            log_message(LL_ERROR, sMSG("DataFrame.select(): no column '%.*s'."), fmt(names[c]));
+            return nullptr;
         }
-        return Box_wrap_BoxedArena(&src_info->source_code);
+        FlxDataFrame_add_column(out, names[c], column);
     }
+    return out;
+}
 
-    native_error(sMSG("Could not find source for native function: %.*s"), fmt(native_fn_name));
-    Box result = Box_error_empty();
-    native_track_src_end();
-    return result;
+/// @brief Copies the given rows of a column into a new column of the same type
+static Boxed *FlxDataFrame_column_gather(Boxed *column, const size_t *rows, size_t num_rows) {
+    switch(column->meta.type) {
+        case BXD_FLX_VEC_DOUBLE_N: {
+            FlxVecDouble *src = Boxed_as(FlxVecDouble, column);
+            FlxVecDouble *dst = FlxVecDouble_new(num_rows);
+            if(dst == nullptr) { return nullptr; }
+            flx_gather_into(dst, src, rows, num_rows);
+            return (Boxed *) dst;
+        }
+        case BXD_FLX_VEC_INT: {
+            FlxVecInt *src = Boxed_as(FlxVecInt, column);
+            FlxVecInt *dst = FlxVecInt_new(num_rows);
+            if(dst == nullptr) { return nullptr; }
+            flx_gather_into(dst, src, rows, num_rows);
+            return (Boxed *) dst;
+        }
+        case BXD_FLX_VEC_BOOL: {
+            FlxVecBool *src = Boxed_as(FlxVecBool, column);
+            FlxVecBool *dst = FlxVecBool_new(num_rows);
+            if(dst == nullptr) { return nullptr; }
+            flx_gather_into(dst, src, rows, num_rows);
+            return (Boxed *) dst;
+        }
+        case BXD_FLX_VEC_TAGS: {
+            FlxVecCat *src = Boxed_as(FlxVecCat, column);
+            FlxVecCat *dst = FlxVecCat_new(num_rows, src->max_categories);
+            if(dst == nullptr) { return nullptr; }
+            for(size_t c = 0; c < src->num_categories; c++) {
+                dst->categories[c] = src->categories[c];
+            }
+            dst->num_categories = src->num_categories;
+            flx_gather_into(dst, src, rows, num_rows);
+            return (Boxed *) dst;
+        }
+        default:
+            return nullptr;
+    }
 }
 
+/// @brief Materialises the selected rows into a new frame
+FlxDataFrame *FlxDataFrame_compact(FlxDataFrame *df, const FixBitmask *sel) {
+    require_not_null(df);
+    require_not_null(sel);
+    log_assert(sel->meta.size == df->num_rows, sMSG("Selection does not match frame length."));
 
-/// @brief
-/// @typedef log : fn([]str) -> nullptr
-/// @param self
-/// @param parent
-/// @param args
-/// @return
-Box native_log(FixFn *self, FixScope parent, FixArray args) {
-    native_log_call(self, args);
-    native_track_src_start();
+    size_t num_rows = 0;
+    size_t *rows = FixBitmask_rows_cnew(sel, &num_rows);
+    if(rows == nullptr) { return nullptr; }
 
-    for(size_t i = 0; i < len(args); i++) {
-        FixStr_puts(Box_to_FixStr(FixArray_get(args, i)));
-        putchar(' ');
+    FlxDataFrame *out = FlxDataFrame_new(len_ref(df));
+    for(size_t c = 0; out != nullptr && c < len_ref(df); c++) {
+        Boxed *column = FlxDataFrame_column_gather(df->columns[c], rows, num_rows);
+        if(column == nullptr) { out = nullptr; break; }
+        FlxDataFrame_add_column(out, df->names[c], column);
     }
+    /// @note a frame with zero selected rows still has its columns
+    if(out != nullptr) { out->num_rows = num_rows; }
 
-    puts("\n");
-    Box result = Box_null();
+    cfree(rows);
+    return out;
+}
 
-    native_track_src_end();
-    return result;
+
+static inline size_t FlxVecInt_hash_key(int key) {
+    uint64_t h = (uint64_t) (uint32_t) key * 0x9E3779B97F4A7C15ULL;
+    return (size_t) (h >> 32);
 }
 
-/// @brief
-/// @example
-///     range(3) -> [0, 1, 2, 3]
-///     range(1, 3) -> [1, 2, 3]
-///     range(0, 4, 2) -> [0, 2, 4]
-/// @param self
-/// @param parent
-/// @param args
-/// @return FixArray as Box
-Box native_range(FixFn *self, FixScope parent, FixArray args) {
-    FixArray *result = nullptr;
-    double from = 0, to = 0, step = 1;
-    switch(args.meta.size) {
-        case 3:
-            Box_try_numeric(args.data[0], &from);
-            Box_try_numeric(args.data[1], &to);
-            Box_try_numeric(args.data[2], &step);
-            break;
-        case 2:
-            Box_try_numeric(args.data[0], &from);
-            Box_try_numeric(args.data[1], &to);
-            break;
-        case 1:
-            Box_try_numeric(args.data[0], &to);
-            break;
+static inline size_t FlxDataFrame_num_slots(size_t num_keys) {
+    size_t num_slots = ARRAY_SIZE_SMALL;
+    while(num_slots < 2 * num_keys) {
+        num_slots <<= 1;
+    }
+    return num_slots;
+}
+
+/// @brief Assigns dense group ids (in first-seen order) to int keys
+/// @note linear probing over a power-of-two table of group ids
+/// @return the number of groups, whose keys are written to `group_keys`
+static size_t FlxVecInt_group_ids(const FlxVecInt *keys, size_t *group_of, int *group_keys) {
+    size_t n = len_ref(keys);
+    size_t num_slots = FlxDataFrame_num_slots(n);
+    size_t *slots = cnew(num_slots * sizeof(size_t));
+    if(slots == nullptr) { error_oom(); return 0; }
+    for(size_t s = 0; s < num_slots; s++) {
+        slots[s] = SIZE_MAX;
+    }
+
+    size_t num_groups = 0;
+    for(size_t i = 0; i < n; i++) {
+        int key = keys->data[i];
+        size_t slot = FlxVecInt_hash_key(key) & (num_slots - 1);
+        while(slots[slot] != SIZE_MAX && group_keys[slots[slot]] != key) {
+            slot = (slot + 1) & (num_slots - 1);
+        }
+        if(slots[slot] == SIZE_MAX) {
+            slots[slot] = num_groups;
+            group_keys[num_groups++] = key;
+        }
+        group_of[i] = slots[slot];
+    }
+
+    cfree(slots);
+    return num_groups;
+}
+
+/// @brief Groups the selected rows by a categorical or int `key` and aggregates `value`
+/// @return a frame of (key, value) with one row per non-empty group
+FlxDataFrame *FlxDataFrame_group_by(FlxDataFrame *df, FixStr key, FixStr value, FlxAggOp op, const FixBitmask *sel) {
+    require_not_null(df);
+
+    Boxed *key_col = FlxDataFrame_column(df, key);
+    Boxed *value_col = FlxDataFrame_column(df, value);
+    if(key_col == nullptr || value_col == nullptr) {
+        log_message(LL_ERROR, sMSG("DataFrame.group_by(): no column '%.*s' or '%.*s'."), fmt(key), fmt(value));
+        return nullptr;
+    }
+    if(value_col->meta.type != BXD_FLX_VEC_DOUBLE_N) {
+        log_message(LL_ERROR, sMSG("DataFrame.group_by(): value column '%.*s' must be double."), fmt(value));
+        return nullptr;
+    }
+    if(key_col->meta.type != BXD_FLX_VEC_TAGS && key_col->meta.type != BXD_FLX_VEC_INT) {
+        log_message(LL_ERROR, sMSG("DataFrame.group_by(): key column '%.*s' must be categorical or int."), fmt(key));
+        return nullptr;
+    }
+
+    size_t n = df->num_rows;
+    size_t *group_of = cnew((n > 0 ? n : 1) * sizeof(size_t));
+    int *group_keys = nullptr;
+    if(group_of == nullptr) { error_oom(); return nullptr; }
+
+    size_t num_groups = 0;
+    if(key_col->meta.type == BXD_FLX_VEC_TAGS) {
+        FlxVecCat *cat = Boxed_as(FlxVecCat, key_col);
+        for(size_t i = 0; i < n; i++) {
+            group_of[i] = (size_t) cat->data[i];
+        }
+        num_groups = cat->num_categories;
+    } else {
+        group_keys = cnew((n > 0 ? n : 1) * sizeof(int));
+        if(group_keys == nullptr) { error_oom(); cfree(group_of); return nullptr; }
+        num_groups = FlxVecInt_group_ids(Boxed_as(FlxVecInt, key_col), group_of, group_keys);
+    }
+
+    size_t acc_size = (num_groups > 0 ? num_groups : 1);
+    double *acc = cnew(acc_size * sizeof(double));
+    size_t *counts = cnew(acc_size * sizeof(size_t));
+    if(acc == nullptr || counts == nullptr) { error_oom(); return nullptr; }
+
+    double init = op == AGG_MIN ? INFINITY : (op == AGG_MAX ? -INFINITY : 0.0);
+    for(size_t g = 0; g < num_groups; g++) {
+        acc[g] = init;
+        counts[g] = 0;
+    }
+
+    const double *x = Boxed_as(FlxVecDouble, value_col)->data;
+    switch(op) {
+        case AGG_COUNT:
+            flx_foreach_selected(sel, n, counts[group_of[i]]++);
+            break;
+        case AGG_SUM:
+        case AGG_MEAN:
+            flx_foreach_selected(sel, n, acc[group_of[i]] += x[i], counts[group_of[i]]++);
+            break;
+        case AGG_MIN:
+            flx_foreach_selected(sel, n,
+                acc[group_of[i]] = x[i] < acc[group_of[i]] ? x[i] : acc[group_of[i]], counts[group_of[i]]++);
+            break;
+        case AGG_MAX:
+            flx_foreach_selected(sel, n,
+                acc[group_of[i]] = x[i] > acc[group_of[i]] ? x[i] : acc[group_of[i]], counts[group_of[i]]++);
+            break;
+    }
+
+    FlxVecDouble *out_values = FlxVecDouble_new(num_groups);
+    Boxed *out_keys = nullptr;
+    if(key_col->meta.type == BXD_FLX_VEC_TAGS) {
+        FlxVecCat *src = Boxed_as(FlxVecCat, key_col);
+        FlxVecCat *keys = FlxVecCat_new(num_groups, src->max_categories);
+        for(size_t g = 0; keys != nullptr && g < num_groups; g++) {
+            if(counts[g] > 0) { FlxVecCat_push(keys, src->categories[g]); }
+        }
+        out_keys = (Boxed *) keys;
+    } else {
+        FlxVecInt *keys = FlxVecInt_new(num_groups);
+        for(size_t g = 0; keys != nullptr && g < num_groups; g++) {
+            if(counts[g] > 0) { FlxVecInt_push(keys, group_keys[g]); }
+        }
+        out_keys = (Boxed *) keys;
+    }
+
+    for(size_t g = 0; out_values != nullptr && g < num_groups; g++) {
+        if(counts[g] == 0) { continue; }
+        double result = acc[g];
+        if(op == AGG_COUNT) { result = (double) counts[g]; }
+        if(op == AGG_MEAN) { result = acc[g] / (double) counts[g]; }
+        FlxVecDouble_push(out_values, result);
+    }
+
+    cfree(group_of);
+    cfree(acc);
+    cfree(counts);
+    if(group_keys != nullptr) { cfree(group_keys); }
+
+    FlxDataFrame *out = FlxDataFrame_new(2);
+    if(out == nullptr || out_keys == nullptr || out_values == nullptr) { return nullptr; }
+    FlxDataFrame_add_column(out, key, out_keys);
+    FlxDataFrame_add_column(out, value, (Boxed *) out_values);
+    return out;
+}
+
+/// @brief Reads a key column as ints; categorical right-hand keys are recoded into `left`'s codes
+/// @note the returned array is owned by the caller iff *out_owned is set
+static const int *FlxDataFrame_join_keys(Boxed *column, Boxed *left, bool *out_owned) {
+    *out_owned = false;
+    if(column->meta.type == BXD_FLX_VEC_INT) {
+        return Boxed_as(FlxVecInt, column)->data;
+    }
+
+    FlxVecCat *cat = Boxed_as(FlxVecCat, column);
+    if(left == nullptr || left == column) {
+        return cat->data;
+    }
+
+    FlxVecCat *left_cat = Boxed_as(FlxVecCat, left);
+    int *recode = cnew(cat->num_categories * sizeof(int) + sizeof(int));
+    int *keys = cnew((len_ref(cat) > 0 ? len_ref(cat) : 1) * sizeof(int));
+    if(recode == nullptr || keys == nullptr) { error_oom(); return nullptr; }
+
+    for(size_t c = 0; c < cat->num_categories; c++) {
+        recode[c] = FlxVecCat_code_of(left_cat, cat->categories[c]);
+    }
+    for(size_t i = 0; i < len_ref(cat); i++) {
+        keys[i] = recode[cat->data[i]];
+    }
+
+    cfree(recode);
+    *out_owned = true;
+    return keys;
+}
+
+/// @brief Inner equi-join on a shared int or categorical `key` column
+/// @note hashes the right frame (row chains per key), then probes in left row order,
+///     ... so output rows follow the left frame; the right key column is dropped, and a
+///     ... right column whose name the left frame already has is suffixed `_right`
+FlxDataFrame *FlxDataFrame_join(FlxDataFrame *left, FlxDataFrame *right, FixStr key) {
+    require_not_null(left);
+    require_not_null(right);
+
+    Boxed *left_key = FlxDataFrame_column(left, key);
+    Boxed *right_key = FlxDataFrame_column(right, key);
+    if(left_key == nullptr || right_key == nullptr) {
+        log_message(LL_ERROR, sMSG("DataFrame.join(): both frames need a '%.*s' column."), fmt(key));
+        return nullptr;
+    }
+    if(left_key->meta.type != right_key->meta.type
+        || (left_key->meta.type != BXD_FLX_VEC_INT && left_key->meta.type != BXD_FLX_VEC_TAGS)) {
+        log_message(LL_ERROR, sMSG("DataFrame.join(): key '%.*s' must be int or categorical on both sides."), fmt(key));
+        return nullptr;
+    }
+
+    bool left_owned = false, right_owned = false;
+    const int *lk = FlxDataFrame_join_keys(left_key, nullptr, &left_owned);
+    const int *rk = FlxDataFrame_join_keys(right_key, left_key, &right_owned);
+    if(lk == nullptr || rk == nullptr) { return nullptr; }
+
+    size_t num_left = left->num_rows;
+    size_t num_right = right->num_rows;
+    size_t num_slots = FlxDataFrame_num_slots(num_right);
+    size_t *heads = cnew(num_slots * sizeof(size_t));
+    size_t *next = cnew((num_right > 0 ? num_right : 1) * sizeof(size_t));
+    if(heads == nullptr || next == nullptr) { error_oom(); return nullptr; }
+    for(size_t s = 0; s < num_slots; s++) {
+        heads[s] = SIZE_MAX;
+    }
+
+    /// @note insert in reverse so each chain lists right rows in ascending order
+    for(size_t r = num_right; r-- > 0;) {
+        if(rk[r] < 0) { continue; }
+        size_t slot = FlxVecInt_hash_key(rk[r]) & (num_slots - 1);
+        next[r] = heads[slot];
+        heads[slot] = r;
+    }
+
+    size_t num_pairs = 0;
+    size_t pairs_capacity = num_left > 0 ? num_left : ARRAY_SIZE_SMALL;
+    size_t *left_rows = cnew(pairs_capacity * sizeof(size_t));
+    size_t *right_rows = cnew(pairs_capacity * sizeof(size_t));
+    if(left_rows == nullptr || right_rows == nullptr) { error_oom(); return nullptr; }
+
+    for(size_t l = 0; l < num_left; l++) {
+        size_t slot = FlxVecInt_hash_key(lk[l]) & (num_slots - 1);
+        for(size_t r = heads[slot]; r != SIZE_MAX; r = next[r]) {
+            if(rk[r] != lk[l]) { continue; }
+            if(num_pairs >= pairs_capacity) {
+                pairs_capacity *= 2;
+                left_rows = cextend(left_rows, pairs_capacity * sizeof(size_t));
+                right_rows = cextend(right_rows, pairs_capacity * sizeof(size_t));
+                if(left_rows == nullptr || right_rows == nullptr) { error_oom(); return nullptr; }
+            }
+            left_rows[num_pairs] = l;
+            right_rows[num_pairs] = r;
+            num_pairs++;
+        }
+    }
+
+    FlxDataFrame *out = FlxDataFrame_new(len_ref(left) + len_ref(right) - 1);
+    for(size_t c = 0; out != nullptr && c < len_ref(left); c++) {
+        Boxed *column = FlxDataFrame_column_gather(left->columns[c], left_rows, num_pairs);
+        if(column == nullptr) { out = nullptr; break; }
+        FlxDataFrame_add_column(out, left->names[c], column);
+    }
+    for(size_t c = 0; out != nullptr && c < len_ref(right); c++) {
+        if(right->columns[c] == right_key) { continue; }
+        Boxed *column = FlxDataFrame_column_gather(right->columns[c], right_rows, num_pairs);
+        if(column == nullptr) { out = nullptr; break; }
+        FixStr name = right->names[c];
+        if(FlxDataFrame_column(left, name) != nullptr) { name = FixStr_fmt_new(s("%.*s_right"), fmt(name)); }
+        FlxDataFrame_add_column(out, name, column);
+    }
+    if(out != nullptr) { out->num_rows = num_pairs; }
+
+    cfree(heads);
+    cfree(next);
+    cfree(left_rows);
+    cfree(right_rows);
+    if(left_owned) { cfree((void *) lk); }
+    if(right_owned) { cfree((void *) rk); }
+    return out;
+}
+
+FixStr FlxDataFrame_to_FixStr(FlxDataFrame *df) {
+    FixStr repr = FixStr_fmt_new(s("DataFrame(%zu rows) {"), df->num_rows);
+    for(size_t c = 0; c < len_ref(df); c++) {
+        FixStr column = FixStr_fmt_new(s("%.*s: %.*s"), fmt(df->names[c]), fmt(bt_nameof(df->columns[c]->meta.type)));
+        repr = FixStr_glue_sep_new(repr, column, s(", "));
+    }
+    repr = FixStr_glue_new(repr, s("}"));
+    return repr;
+}
+
+
+int FlxDataFrame_test_main(void) {
+    FlxVecDouble *y = FlxVecDouble_new(0);
+    FlxVecInt *id = FlxVecInt_new(0);
+    FlxVecCat *group = FlxVecCat_new(0, 4);
+
+    /// @note 130 rows, so selections span a full word and a partial tail word
+    for(int i = 0; i < 130; i++) {
+        FlxVecDouble_push(y, (double) i);
+        FlxVecInt_push(id, i % 10);
+        FlxVecCat_push(group, i % 2 == 0 ? s("even") : s("odd"));
+    }
+    log_assert(len_ref(y) == 130, sMSG("FlxVecDouble_push did not grow the column"));
+    log_assert(group->num_categories == 2, sMSG("FlxVecCat_push did not intern categories"));
+
+    FlxDataFrame *df = FlxDataFrame_new(3);
+    log_assert(FlxDataFrame_add_column(df, s("y"), (Boxed *) y), sMSG("Failed to add column y"));
+    log_assert(FlxDataFrame_add_column(df, s("id"), (Boxed *) id), sMSG("Failed to add column id"));
+    log_assert(FlxDataFrame_add_column(df, s("group"), (Boxed *) group), sMSG("Failed to add column group"));
+    log_assert(df->num_rows == 130, sMSG("DataFrame row count incorrect"));
+
+    FixBitmask below = FlxDataFrame_filter(df, s("id"), CMP_LT, 2.5);
+    log_assert(FixBitmask_count(&below) == 39, sMSG("An int column should compare against a fractional threshold"));
+    FixBitmask_cfree(&below);
+
+    FixBitmask big = FlxDataFrame_filter(df, s("y"), CMP_GE, 100.0);
+    log_assert(FixBitmask_count(&big) == 30, sMSG("FlxDataFrame_filter selected the wrong rows"));
+
+    FixBitmask even = FlxVecCat_filter_eq(group, s("even"));
+    FixBitmask_and(&big, &even);
+    log_assert(FixBitmask_count(&big) == 15, sMSG("FixBitmask_and selected the wrong rows"));
+    log_assert(FlxVecDouble_aggregate(y, &big, AGG_SUM) == 1710.0, sMSG("Selected sum incorrect"));
+    log_assert(FlxVecDouble_aggregate(y, nullptr, AGG_MAX) == 129.0, sMSG("Unselected max incorrect"));
+
+    FlxDataFrame *compact = FlxDataFrame_compact(df, &big);
+    log_assert(compact->num_rows == 15, sMSG("FlxDataFrame_compact row count incorrect"));
+    log_assert(Boxed_as(FlxVecDouble, FlxDataFrame_column(compact, s("y")))->data[0] == 100.0,
+        sMSG("FlxDataFrame_compact gathered the wrong rows"));
+
+    FlxDataFrame *by_group = FlxDataFrame_group_by(df, s("group"), s("y"), AGG_MEAN, nullptr);
+    FlxVecDouble *means = Boxed_as(FlxVecDouble, FlxDataFrame_column(by_group, s("y")));
+    log_assert(by_group->num_rows == 2, sMSG("FlxDataFrame_group_by group count incorrect"));
+    log_assert(means->data[0] == 64.0 && means->data[1] == 65.0, sMSG("FlxDataFrame_group_by means incorrect"));
+
+    FlxDataFrame *by_id = FlxDataFrame_group_by(df, s("id"), s("y"), AGG_COUNT, nullptr);
+    log_assert(by_id->num_rows == 10, sMSG("FlxDataFrame_group_by int keys incorrect"));
+
+    FlxVecInt *lookup_id = FlxVecInt_new(0);
+    FlxVecDouble *weight = FlxVecDouble_new(0);
+    FlxVecDouble *lookup_y = FlxVecDouble_new(0);
+    FlxVecInt_push(lookup_id, 3);  FlxVecDouble_push(weight, 0.5);  FlxVecDouble_push(lookup_y, -1.0);
+    FlxVecInt_push(lookup_id, 7);  FlxVecDouble_push(weight, 2.0);  FlxVecDouble_push(lookup_y, -2.0);
+    FlxDataFrame *lookup = FlxDataFrame_new(3);
+    FlxDataFrame_add_column(lookup, s("id"), (Boxed *) lookup_id);
+    FlxDataFrame_add_column(lookup, s("weight"), (Boxed *) weight);
+    FlxDataFrame_add_column(lookup, s("y"), (Boxed *) lookup_y);
+
+    FlxDataFrame *joined = FlxDataFrame_join(df, lookup, s("id"));
+    log_assert(joined->num_rows == 26, sMSG("FlxDataFrame_join row count incorrect"));
+    log_assert(len_ref(joined) == 5, sMSG("FlxDataFrame_join column count incorrect"));
+    log_assert(Boxed_as(FlxVecDouble, FlxDataFrame_column(joined, s("y")))->data[0] == 3.0
+        && Boxed_as(FlxVecDouble, FlxDataFrame_column(joined, s("y_right")))->data[0] == -1.0,
+        sMSG("FlxDataFrame_join should keep both sides' columns of the same name"));
+
+    FixStr names[] = {s("y")};
+    FlxDataFrame *projected = FlxDataFrame_select(df, names, 1);
+    log_assert(projected->columns[0] == (Boxed *) y, sMSG("FlxDataFrame_select copied a column"));
+
+    FixBitmask_cfree(&big);
+    FixBitmask_cfree(&even);
+    return 0;
+}
+
+#pragma endregion
+
+#pragma region FlxDataFrameIOImpl
+
+#define SWAR_ONES 0x0101010101010101ULL
+#define SWAR_LOW7 0x7F7F7F7F7F7F7F7FULL
+#define SWAR_HIGH 0x8080808080808080ULL
+
+/// @brief Sets the high bit of every byte of `word` equal to the byte broadcast in `pattern`
+/// @note exact (no false positives from borrows), so the result can be popcount'd
+static inline uint64_t swar_match_bytes(uint64_t word, uint64_t pattern) {
+    uint64_t v = word ^ pattern;
+    return ~(((v & SWAR_LOW7) + SWAR_LOW7) | v) & SWAR_HIGH;
+}
+
+/// @brief Counts occurrences of `c` in [p, end), eight bytes at a time
+static size_t csv_count_byte(const char *p, const char *end, char c) {
+    uint64_t pattern = SWAR_ONES * (uint8_t) c;
+    size_t count = 0;
+
+    for(; p + 8 <= end; p += 8) {
+        uint64_t word;
+        memcpy(&word, p, sizeof(word));
+        count += (size_t) __builtin_popcountll(swar_match_bytes(word, pattern));
+    }
+    for(; p < end; p++) {
+        count += (*p == c);
+    }
+    return count;
+}
+
+/// @brief Finds the first delimiter or newline in [p, end), eight bytes at a time
+/// @note assumes a little-endian target, so the lowest set bit is the first match
+static const char *csv_find_field_end(const char *p, const char *end, char delimiter) {
+    uint64_t delim_pattern = SWAR_ONES * (uint8_t) delimiter;
+    uint64_t nl_pattern = SWAR_ONES * (uint8_t) '\n';
+
+    for(; p + 8 <= end; p += 8) {
+        uint64_t word;
+        memcpy(&word, p, sizeof(word));
+        uint64_t hits = swar_match_bytes(word, delim_pattern) | swar_match_bytes(word, nl_pattern);
+        if(hits != 0) {
+            return p + (__builtin_ctzll(hits) >> 3);
+        }
+    }
+    for(; p < end; p++) {
+        if(*p == delimiter || *p == '\n') { return p; }
+    }
+    return end;
+}
+
+static bool csv_parse_int(FixStr field, int *out) {
+    size_t i = 0;
+    bool negative = false;
+    if(i < field.size && (field.cstr[i] == '-' || field.cstr[i] == '+')) {
+        negative = field.cstr[i] == '-';
+        i++;
+    }
+    if(i == field.size) { return false; }
+
+    int64_t value = 0;
+    for(; i < field.size; i++) {
+        char c = field.cstr[i];
+        if(c < '0' || c > '9') { return false; }
+        value = value * 10 + (c - '0');
+        if(value > (int64_t) INT_MAX + 1) { return false; }
+    }
+
+    value = negative ? -value : value;
+    if(value > INT_MAX || value < INT_MIN) { return false; }
+    *out = (int) value;
+    return true;
+}
+
+static bool csv_parse_double(FixStr field, double *out) {
+    char buffer[64];
+    if(field.size == 0 || field.size >= sizeof(buffer)) { return false; }
+
+    memcpy(buffer, field.cstr, field.size);
+    buffer[field.size] = '\0';
+
+    char *parsed_end = nullptr;
+    double value = strtod(buffer, &parsed_end);
+    if(parsed_end != buffer + field.size) { return false; }
+    *out = value;
+    return true;
+}
+
+static bool csv_parse_bool(FixStr field, bool *out) {
+    if(FixStr_eq(field, s("true"))) { *out = true; return true; }
+    if(FixStr_eq(field, s("false"))) { *out = false; return true; }
+    return false;
+}
+
+static MetaType csv_infer_type(FixStr field) {
+    int as_int;
+    double as_double;
+    bool as_bool;
+    if(csv_parse_int(field, &as_int)) { return BXD_FLX_VEC_INT; }
+    if(csv_parse_double(field, &as_double)) { return BXD_FLX_VEC_DOUBLE_N; }
+    if(csv_parse_bool(field, &as_bool)) { return BXD_FLX_VEC_BOOL; }
+    return BXD_FLX_VEC_TAGS;
+}
+
+/// @brief Splits one line into at most `max_fields` fields, returning the field count
+static size_t csv_split_line(const char *p, const char *end, char delimiter, FixStr *fields, size_t max_fields) {
+    size_t num_fields = 0;
+    while(num_fields < max_fields) {
+        const char *field_end = csv_find_field_end(p, end, delimiter);
+        FixStr field = {.cstr = p, .size = (size_t) (field_end - p)};
+        if(field.size > 0 && field.cstr[field.size - 1] == '\r') { field.size--; }
+        fields[num_fields++] = field;
+
+        if(field_end >= end || *field_end != delimiter) { break; }
+        p = field_end + 1;
+    }
+    return num_fields;
+}
+
+/// @brief Infers each column's type from up to CSV_INFER_ROWS rows from `p`
+/// @note empty fields are skipped (an all-empty column is double); int and double merge to
+///     ... double, and otherwise a column keeps its first type
+static void csv_infer_types(const char *p, const char *end, char delimiter, size_t num_columns, MetaType *out_types) {
+    bool seen[DATAFRAME_MAX_COLUMNS] = {0};
+    FixStr fields[DATAFRAME_MAX_COLUMNS];
+    for(size_t c = 0; c < num_columns; c++) {
+        out_types[c] = BXD_FLX_VEC_DOUBLE_N;
+    }
+
+    for(size_t r = 0; r < CSV_INFER_ROWS && p < end; r++) {
+        const char *line_end = memchr(p, '\n', (size_t) (end - p));
+        line_end = line_end ? line_end : end;
+
+        size_t num_fields = csv_split_line(p, line_end, delimiter, fields, num_columns);
+        for(size_t c = 0; c < num_fields; c++) {
+            if(fields[c].size == 0) { continue; }
+            MetaType type = csv_infer_type(fields[c]);
+            if(!seen[c]) {
+                out_types[c] = type;
+                seen[c] = true;
+            } else if(out_types[c] == BXD_FLX_VEC_INT && type == BXD_FLX_VEC_DOUBLE_N) {
+                out_types[c] = BXD_FLX_VEC_DOUBLE_N;
+            }
+        }
+        p = line_end + 1;
+    }
+}
+
+static void *FlxCsvChunk_count_worker(void *arg) {
+    FlxCsvChunk *chunk = (FlxCsvChunk *) arg;
+    chunk->num_rows = csv_count_byte(chunk->start, chunk->end, '\n');
+    if(chunk->end > chunk->start && chunk->end[-1] != '\n') {
+        chunk->num_rows++;
+    }
+    return nullptr;
+}
+
+/// @note runs on a worker thread: writes only into its own rows and local tables, never allocates
+static void FlxCsvChunk_store(FlxCsvChunk *chunk, size_t column, size_t row, FixStr field) {
+    Boxed *boxed = chunk->df->columns[column];
+
+    switch(boxed->meta.type) {
+        case BXD_FLX_VEC_DOUBLE_N: {
+            double value = NAN;
+            if(!csv_parse_double(field, &value)) { value = NAN; chunk->num_errors += field.size > 0; }
+            Boxed_as(FlxVecDouble, boxed)->data[row] = value;
+            break;
+        }
+        case BXD_FLX_VEC_INT: {
+            int value = 0;
+            double as_double;
+            if(!csv_parse_int(field, &value)) {
+                /// @note a fraction, NaN or missing value: the column is parsed again as double
+                if(field.size == 0 || csv_parse_double(field, &as_double)) { chunk->widen[column] = true; }
+                else { chunk->num_errors++; }
+                value = 0;
+            }
+            Boxed_as(FlxVecInt, boxed)->data[row] = value;
+            break;
+        }
+        case BXD_FLX_VEC_BOOL: {
+            bool value = false;
+            if(!csv_parse_bool(field, &value)) { value = false; chunk->num_errors++; }
+            Boxed_as(FlxVecBool, boxed)->data[row] = value;
+            break;
+        }
+        case BXD_FLX_VEC_TAGS: {
+            FixStr *local = chunk->local_categories + column * CSV_MAX_CATEGORIES;
+            size_t *num_local = &chunk->num_local_categories[column];
+
+            int code = -1;
+            for(size_t c = 0; c < *num_local; c++) {
+                if(FixStr_eq(local[c], field)) { code = (int) c; break; }
+            }
+            if(code < 0) {
+                if(*num_local >= CSV_MAX_CATEGORIES) { chunk->overflowed = true; code = 0; }
+                else { local[*num_local] = field; code = (int) (*num_local)++; }
+            }
+            Boxed_as(FlxVecCat, boxed)->data[row] = code;
+            break;
+        }
+        default:
+            break;
+    }
+}
+
+static void *FlxCsvChunk_parse_worker(void *arg) {
+    FlxCsvChunk *chunk = (FlxCsvChunk *) arg;
+    size_t num_columns = len_ref(chunk->df);
+    FixStr fields[DATAFRAME_MAX_COLUMNS];
+
+    const char *p = chunk->start;
+    for(size_t r = 0; r < chunk->num_rows; r++) {
+        const char *line_end = memchr(p, '\n', (size_t) (chunk->end - p));
+        line_end = line_end ? line_end : chunk->end;
+
+        size_t num_fields = csv_split_line(p, line_end, chunk->delimiter, fields, num_columns);
+        for(size_t c = 0; c < num_columns; c++) {
+            /// @note missing trailing fields are stored as empty (NAN, 0, false, "")
+            FixStr field = c < num_fields ? fields[c] : FixStr_empty();
+            FlxCsvChunk_store(chunk, c, chunk->row_offset + r, field);
+        }
+
+        p = line_end + 1;
+    }
+    return nullptr;
+}
+
+static void FlxCsv_run_chunks(FlxCsvChunk *chunks, size_t num_chunks, void *(*worker)(void *)) {
+    TaskPool_run(chunks, sizeof(FlxCsvChunk), num_chunks, worker);
+}
+
+/// @brief Replaces each int column a chunk flagged with a double column, ready to parse again
+/// @return whether any column was widened
+static bool FlxCsv_widen_columns(FlxDataFrame *df, FlxCsvChunk *chunks, size_t num_chunks) {
+    bool widened = false;
+    for(size_t c = 0; c < len_ref(df); c++) {
+        bool widen = false;
+        for(size_t k = 0; k < num_chunks; k++) {
+            widen = widen || chunks[k].widen[c];
+        }
+        if(!widen) { continue; }
+
+        FlxVecDouble *column = FlxVecDouble_new(df->num_rows);
+        if(column == nullptr) { return false; }
+        column->meta.size = df->num_rows;
+        df->columns[c] = (Boxed *) column;
+        widened = true;
+    }
+    if(!widened) { return false; }
+
+    for(size_t k = 0; k < num_chunks; k++) {
+        chunks[k].num_errors = 0;
+        chunks[k].overflowed = false;
+        memset(chunks[k].widen, 0, sizeof(chunks[k].widen));
+        memset(chunks[k].num_local_categories, 0, len_ref(df) * sizeof(size_t));
+    }
+    return true;
+}
+
+/// @brief Renumbers each chunk's local category codes into the column's shared table
+/// @note category text is copied out of the mapping, which is released after loading
+static bool FlxCsv_merge_categories(FlxDataFrame *df, FlxCsvChunk *chunks, size_t num_chunks) {
+    int remap[CSV_MAX_CATEGORIES];
+
+    for(size_t c = 0; c < len_ref(df); c++) {
+        if(df->columns[c]->meta.type != BXD_FLX_VEC_TAGS) { continue; }
+        FlxVecCat *cat = Boxed_as(FlxVecCat, df->columns[c]);
+
+        for(size_t k = 0; k < num_chunks; k++) {
+            FixStr *local = chunks[k].local_categories + c * CSV_MAX_CATEGORIES;
+            for(size_t l = 0; l < chunks[k].num_local_categories[c]; l++) {
+                int code = FlxVecCat_code_of(cat, local[l]);
+                if(code < 0) { code = FlxVecCat_intern(cat, FixStr_copy(local[l])); }
+                if(code < 0) { return false; }
+                remap[l] = code;
+            }
+
+            size_t row_end = chunks[k].row_offset + chunks[k].num_rows;
+            for(size_t r = chunks[k].row_offset; r < row_end; r++) {
+                cat->data[r] = remap[cat->data[r]];
+            }
+        }
+    }
+    return true;
+}
+
+/// @brief Loads a delimited text file with a header row into a dataframe
+/// @note quoted fields are not supported; a categorical column holds at most CSV_MAX_CATEGORIES values
+FlxDataFrame *FlxDataFrame_read_csv(const char *filename, char delimiter) {
+    require_not_null(filename);
+
+    int fd = open(filename, O_RDONLY);
+    if(fd < 0) {
+        log_message(LL_ERROR, sMSG("read_csv(): cannot open '%s'."), filename);
+        return nullptr;
+    }
+
+    struct stat st;
+    if(fstat(fd, &st) != 0 || st.st_size == 0) {
+        log_message(LL_ERROR, sMSG("read_csv(): '%s' is empty or unreadable."), filename);
+        close(fd);
+        return nullptr;
+    }
+
+    size_t size = (size_t) st.st_size;
+    const char *data = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if(data == MAP_FAILED) {
+        log_message(LL_ERROR, sMSG("read_csv(): cannot map '%s'."), filename);
+        return nullptr;
+    }
+    madvise((void *) data, size, MADV_SEQUENTIAL);
+
+    const char *end = data + size;
+    const char *header_end = memchr(data, '\n', size);
+    header_end = header_end ? header_end : end;
+    const char *body = header_end < end ? header_end + 1 : end;
+
+    FixStr names[DATAFRAME_MAX_COLUMNS];
+    size_t num_columns = csv_split_line(data, header_end, delimiter, names, DATAFRAME_MAX_COLUMNS);
+
+    MetaType types[DATAFRAME_MAX_COLUMNS];
+    csv_infer_types(body, end, delimiter, num_columns, types);
+
+    size_t num_chunks = (size_t) (end - body) < CSV_PARALLEL_MIN_BYTES ? 1 : TaskPool_num_workers();
+    FlxCsvChunk chunks[CPU_CORES_MAX] = {0};
+
+    const char *chunk_start = body;
+    for(size_t k = 0; k < num_chunks; k++) {
+        const char *chunk_end = end;
+        if(k + 1 < num_chunks) {
+            chunk_end = body + (size_t) (end - body) * (k + 1) / num_chunks;
+            chunk_end = chunk_end < chunk_start ? chunk_start : chunk_end;
+            const char *nl = memchr(chunk_end, '\n', (size_t) (end - chunk_end));
+            chunk_end = nl ? nl + 1 : end;
+        }
+        chunks[k].start = chunk_start;
+        chunks[k].end = chunk_end;
+        chunks[k].delimiter = delimiter;
+        chunk_start = chunk_end;
+    }
+
+    FlxCsv_run_chunks(chunks, num_chunks, FlxCsvChunk_count_worker);
+
+    size_t num_rows = 0;
+    for(size_t k = 0; k < num_chunks; k++) {
+        chunks[k].row_offset = num_rows;
+        num_rows += chunks[k].num_rows;
+    }
+
+    FlxDataFrame *df = FlxDataFrame_new(num_columns);
+    for(size_t c = 0; df != nullptr && c < num_columns; c++) {
+        Boxed *column = nullptr;
+        switch(types[c]) {
+            case BXD_FLX_VEC_INT: column = (Boxed *) FlxVecInt_new(num_rows); break;
+            case BXD_FLX_VEC_BOOL: column = (Boxed *) FlxVecBool_new(num_rows); break;
+            case BXD_FLX_VEC_TAGS: column = (Boxed *) FlxVecCat_new(num_rows, CSV_MAX_CATEGORIES); break;
+            default: column = (Boxed *) FlxVecDouble_new(num_rows); break;
+        }
+        if(column == nullptr) { df = nullptr; break; }
+        column->meta.size = num_rows;
+        FlxDataFrame_add_column(df, FixStr_copy(names[c]), column);
+    }
+
+    for(size_t k = 0; df != nullptr && k < num_chunks; k++) {
+        chunks[k].df = df;
+        chunks[k].local_categories = cnew(num_columns * CSV_MAX_CATEGORIES * sizeof(FixStr));
+        chunks[k].num_local_categories = cnew(num_columns * sizeof(size_t));
+        if(chunks[k].local_categories == nullptr || chunks[k].num_local_categories == nullptr) {
+            error_oom();
+            df = nullptr;
+            break;
+        }
+        require_safe(clib_memset_zero_safe(chunks[k].num_local_categories,
+            num_columns * sizeof(size_t), num_columns * sizeof(size_t)));
+    }
+
+    size_t num_errors = 0;
+    bool overflowed = false;
+    if(df != nullptr) {
+        FlxCsv_run_chunks(chunks, num_chunks, FlxCsvChunk_parse_worker);
+        if(FlxCsv_widen_columns(df, chunks, num_chunks)) {
+            FlxCsv_run_chunks(chunks, num_chunks, FlxCsvChunk_parse_worker);
+        }
+        for(size_t k = 0; k < num_chunks; k++) {
+            num_errors += chunks[k].num_errors;
+            overflowed = overflowed || chunks[k].overflowed;
+        }
+        overflowed = overflowed || !FlxCsv_merge_categories(df, chunks, num_chunks);
+    }
+
+    for(size_t k = 0; k < num_chunks; k++) {
+        if(chunks[k].local_categories) { cfree(chunks[k].local_categories); }
+        if(chunks[k].num_local_categories) { cfree(chunks[k].num_local_categories); }
+    }
+    munmap((void *) data, size);
+
+    if(overflowed) {
+        log_message(LL_ERROR, sMSG("read_csv(): '%s' has a column with more than %d categories."),
+            filename, CSV_MAX_CATEGORIES);
+        return nullptr;
+    }
+    if(num_errors > 0) {
+        log_message(LL_WARNING, sMSG("read_csv(): %zu fields in '%s' did not match their column type."),
+            num_errors, filename);
+    }
+    return df;
+}
+
+
+static size_t FlxDataFrame_elem_size(MetaType type) {
+    switch(type) {
+        case BXD_FLX_VEC_DOUBLE_N: return sizeof(double);
+        case BXD_FLX_VEC_INT: return sizeof(int);
+        case BXD_FLX_VEC_BOOL: return sizeof(bool);
+        case BXD_FLX_VEC_TAGS: return sizeof(int);
+        default: return 0;
+    }
+}
+
+/// @brief Pads the file to COLUMNAR_ALIGN, writes `bytes` and returns their offset
+static uint64_t columnar_write_aligned(FILE *file, const void *bytes, size_t size) {
+    static const char zeros[COLUMNAR_ALIGN] = {0};
+
+    long position = ftell(file);
+    size_t padding = (COLUMNAR_ALIGN - ((size_t) position % COLUMNAR_ALIGN)) % COLUMNAR_ALIGN;
+    fwrite(zeros, 1, padding, file);
+
+    uint64_t offset = (uint64_t) position + padding;
+    if(size > 0) { fwrite(bytes, 1, size, file); }
+    return offset;
+}
+
+bool FlxDataFrame_write_columnar(FlxDataFrame *df, const char *filename) {
+    require_not_null(df);
+    require_not_null(filename);
+
+    FILE *file = fopen(filename, "wb");
+    if(file == nullptr) {
+        log_message(LL_ERROR, sMSG("write_columnar(): cannot open '%s'."), filename);
+        return false;
+    }
+
+    FlxColumnarHeader header = {.num_rows = df->num_rows, .num_columns = len_ref(df)};
+    memcpy(header.magic, COLUMNAR_MAGIC, sizeof(header.magic));
+    FlxColumnarColumn table[DATAFRAME_MAX_COLUMNS] = {0};
+
+    /// @note the column table is written twice: reserved now, filled in once offsets are known
+    fwrite(&header, sizeof(header), 1, file);
+    fwrite(table, sizeof(FlxColumnarColumn), len_ref(df), file);
+
+    for(size_t c = 0; c < len_ref(df); c++) {
+        Boxed *column = df->columns[c];
+        FlxColumnarColumn *entry = &table[c];
+
+        entry->type = column->meta.type;
+        entry->elem_size = FlxDataFrame_elem_size(column->meta.type);
+        entry->name_size = df->names[c].size;
+        entry->name_offset = columnar_write_aligned(file, df->names[c].cstr, df->names[c].size);
+
+        /// @note every column type keeps its rows in a leading `data` array, cf. FlxVecDouble
+        const void *rows = Boxed_as(FlxVecDouble, column)->data;
+        entry->data_offset = columnar_write_aligned(file, rows, df->num_rows * entry->elem_size);
+
+        if(column->meta.type == BXD_FLX_VEC_TAGS) {
+            FlxVecCat *cat = Boxed_as(FlxVecCat, column);
+            uint64_t spans[2 * CSV_MAX_CATEGORIES];
+            size_t num_categories = cat->num_categories < CSV_MAX_CATEGORIES ? cat->num_categories : CSV_MAX_CATEGORIES;
+            for(size_t k = 0; k < num_categories; k++) {
+                spans[2 * k] = columnar_write_aligned(file, cat->categories[k].cstr, cat->categories[k].size);
+                spans[2 * k + 1] = cat->categories[k].size;
+            }
+            entry->num_categories = num_categories;
+            entry->categories_offset = columnar_write_aligned(file, spans, 2 * num_categories * sizeof(uint64_t));
+        }
+    }
+
+    fseek(file, (long) sizeof(header), SEEK_SET);
+    fwrite(table, sizeof(FlxColumnarColumn), len_ref(df), file);
+    bool ok = ferror(file) == 0;
+    fclose(file);
+
+    if(!ok) {
+        log_message(LL_ERROR, sMSG("write_columnar(): failed writing '%s'."), filename);
+    }
+    return ok;
+}
+
+/// @brief Wraps mapped rows as a pinned column, without copying them
+static Boxed *FlxDataFrame_mapped_column(MetaType type, void *rows, size_t num_rows) {
+    Boxed *column = nullptr;
+    switch(type) {
+        case BXD_FLX_VEC_DOUBLE_N: {
+            FlxVecDouble *vec = gco_new(BXD_FLX_VEC_DOUBLE_N);
+            if(vec) { vec->data = rows; }
+            column = (Boxed *) vec;
+            break;
+        }
+        case BXD_FLX_VEC_INT: {
+            FlxVecInt *vec = gco_new(BXD_FLX_VEC_INT);
+            if(vec) { vec->data = rows; }
+            column = (Boxed *) vec;
+            break;
+        }
+        case BXD_FLX_VEC_BOOL: {
+            FlxVecBool *vec = gco_new(BXD_FLX_VEC_BOOL);
+            if(vec) { vec->data = rows; }
+            column = (Boxed *) vec;
+            break;
+        }
+        case BXD_FLX_VEC_TAGS: {
+            FlxVecCat *vec = gco_new(BXD_FLX_VEC_TAGS);
+            if(vec) { vec->data = rows; }
+            column = (Boxed *) vec;
+            break;
+        }
+        default:
+            return nullptr;
+    }
+    if(column == nullptr) { error_oom(); return nullptr; }
+
+    column->meta.type = type;
+    column->meta.size = num_rows;
+    column->meta.capacity = num_rows;
+    column->meta.alloc_size = num_rows * FlxDataFrame_elem_size(type);
+    column->meta.state = LIVING_PINNED;
+    return column;
+}
+
+/// @brief Maps a file written by FlxDataFrame_write_columnar; columns point into the mapping
+/// @note the columns are pinned (read-only, cannot grow); release with FlxDataFrame_unmap
+FlxDataFrame *FlxDataFrame_map_columnar(const char *filename) {
+    require_not_null(filename);
+
+    int fd = open(filename, O_RDONLY);
+    if(fd < 0) {
+        log_message(LL_ERROR, sMSG("map_columnar(): cannot open '%s'."), filename);
+        return nullptr;
+    }
+
+    struct stat st;
+    if(fstat(fd, &st) != 0 || (size_t) st.st_size < sizeof(FlxColumnarHeader)) {
+        log_message(LL_ERROR, sMSG("map_columnar(): '%s' is too small."), filename);
+        close(fd);
+        return nullptr;
+    }
+
+    size_t size = (size_t) st.st_size;
+    char *data = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if(data == MAP_FAILED) {
+        log_message(LL_ERROR, sMSG("map_columnar(): cannot map '%s'."), filename);
+        return nullptr;
+    }
+
+    #define columnar_fail(...) \
+        { log_message(LL_ERROR, __VA_ARGS__); munmap(data, size); return nullptr; }
+    #define columnar_in_bounds(offset, length) \
+        ((offset) <= size && (length) <= size - (offset))
+
+    const FlxColumnarHeader *header = (const FlxColumnarHeader *) data;
+    if(memcmp(header->magic, COLUMNAR_MAGIC, sizeof(header->magic)) != 0) {
+        columnar_fail(sMSG("map_columnar(): '%s' is not a columnar file."), filename);
+    }
+    if(header->num_columns == 0 || header->num_columns > DATAFRAME_MAX_COLUMNS
+        || !columnar_in_bounds(sizeof(*header), header->num_columns * sizeof(FlxColumnarColumn))) {
+        columnar_fail(sMSG("map_columnar(): '%s' has a corrupt column table."), filename);
+    }
+
+    const FlxColumnarColumn *table = (const FlxColumnarColumn *) (data + sizeof(*header));
+    size_t num_rows = header->num_rows;
+
+    FlxDataFrame *df = FlxDataFrame_new(header->num_columns);
+    if(df == nullptr) { munmap(data, size); return nullptr; }
+
+    for(size_t c = 0; c < header->num_columns; c++) {
+        const FlxColumnarColumn *entry = &table[c];
+        MetaType type = (MetaType) entry->type;
+
+        if(FlxDataFrame_elem_size(type) == 0 || entry->elem_size != FlxDataFrame_elem_size(type)
+            || num_rows > size / entry->elem_size
+            || !columnar_in_bounds(entry->data_offset, num_rows * entry->elem_size)
+            || !columnar_in_bounds(entry->name_offset, entry->name_size)) {
+            columnar_fail(sMSG("map_columnar(): '%s' column %zu is corrupt."), filename, c);
+        }
+
+        Boxed *column = FlxDataFrame_mapped_column(type, data + entry->data_offset, num_rows);
+        if(column == nullptr) { munmap(data, size); return nullptr; }
+
+        if(type == BXD_FLX_VEC_TAGS) {
+            FlxVecCat *cat = Boxed_as(FlxVecCat, column);
+            size_t num_categories = entry->num_categories;
+            if(num_categories > CSV_MAX_CATEGORIES
+                || !columnar_in_bounds(entry->categories_offset, 2 * num_categories * sizeof(uint64_t))) {
+                columnar_fail(sMSG("map_columnar(): '%s' column %zu has corrupt categories."), filename, c);
+            }
+
+            const uint64_t *spans = (const uint64_t *) (data + entry->categories_offset);
+            cat->categories = cnew((num_categories > 0 ? num_categories : 1) * sizeof(FixStr));
+            if(cat->categories == nullptr) { error_oom(); munmap(data, size); return nullptr; }
+            for(size_t k = 0; k < num_categories; k++) {
+                if(!columnar_in_bounds(spans[2 * k], spans[2 * k + 1])) {
+                    columnar_fail(sMSG("map_columnar(): '%s' column %zu has corrupt categories."), filename, c);
+                }
+                cat->categories[k] = (FixStr) {.cstr = data + spans[2 * k], .size = spans[2 * k + 1]};
+            }
+            cat->num_categories = num_categories;
+            cat->max_categories = num_categories;
+
+            for(size_t r = 0; r < num_rows; r++) {
+                if(cat->data[r] < 0 || (size_t) cat->data[r] >= num_categories) {
+                    columnar_fail(sMSG("map_columnar(): '%s' column %zu has an invalid code."), filename, c);
+                }
+            }
+        }
+
+        FixStr name = {.cstr = data + entry->name_offset, .size = entry->name_size};
+        FlxDataFrame_add_column(df, name, column);
+    }
+
+    #undef columnar_fail
+    #undef columnar_in_bounds
+
+    df->num_rows = num_rows;
+    df->mapping = data;
+    df->mapping_size = size;
+    return df;
+}
+
+void FlxDataFrame_unmap(FlxDataFrame *df) {
+    require_not_null(df);
+    if(df->mapping == nullptr) { return; }
+
+    munmap(df->mapping, df->mapping_size);
+    df->mapping = nullptr;
+    df->mapping_size = 0;
+    df->meta.size = 0;
+    df->num_rows = 0;
+}
+
+
+int FlxDataFrame_io_test_main(void) {
+    const char *csv_path = "/tmp/doubt_io_test.csv";
+    const char *bin_path = "/tmp/doubt_io_test.dcf";
+
+    /// @note large enough to be split into parallel chunks
+    FILE *file = fopen(csv_path, "wb");
+    log_assert(file != nullptr, sMSG("Failed to create test csv"));
+    fprintf(file, "x,y,group,flag,v,w\r\n");
+    for(int i = 0; i < 100000; i++) {
+        fprintf(file, "%d,%.1f,%s,%s,%s,", i, i * 0.5, i % 3 == 0 ? "a" : (i % 3 == 1 ? "bb" : "ccc"),
+            i % 2 == 0 ? "true" : "false", i == 3 ? "2.5" : "1");
+        /// @note w reads as ints for far more rows than are sampled to infer its type
+        if(i < 99000) { fprintf(file, "%d\n", i); } else { fprintf(file, "%d.5\n", i); }
+    }
+    fclose(file);
+
+    FlxDataFrame *df = FlxDataFrame_read_csv(csv_path, ',');
+    log_assert(df != nullptr, sMSG("FlxDataFrame_read_csv failed"));
+    log_assert(df->num_rows == 100000, sMSG("FlxDataFrame_read_csv row count incorrect"));
+    log_assert(len_ref(df) == 6, sMSG("FlxDataFrame_read_csv column count incorrect"));
+    log_assert(FixStr_eq(df->names[5], s("w")), sMSG("FlxDataFrame_read_csv did not strip \\r from the header"));
+
+    Boxed *x = FlxDataFrame_column(df, s("x"));
+    Boxed *y = FlxDataFrame_column(df, s("y"));
+    FlxVecCat *group = Boxed_as(FlxVecCat, FlxDataFrame_column(df, s("group")));
+    log_assert(x->meta.type == BXD_FLX_VEC_INT, sMSG("Column x should be inferred as int"));
+    log_assert(y->meta.type == BXD_FLX_VEC_DOUBLE_N, sMSG("Column y should be inferred as double"));
+    log_assert(group->meta.type == BXD_FLX_VEC_TAGS, sMSG("Column group should be categorical"));
+    log_assert(FlxDataFrame_column(df, s("flag"))->meta.type == BXD_FLX_VEC_BOOL, sMSG("Column flag should be bool"));
+
+    log_assert(Boxed_as(FlxVecInt, x)->data[99999] == 99999, sMSG("Last row parsed incorrectly"));
+
+    Boxed *v = FlxDataFrame_column(df, s("v")), *w = FlxDataFrame_column(df, s("w"));
+    log_assert(v->meta.type == BXD_FLX_VEC_DOUBLE_N && Boxed_as(FlxVecDouble, v)->data[3] == 2.5,
+        sMSG("A fraction among the sampled rows should make the column double"));
+    log_assert(w->meta.type == BXD_FLX_VEC_DOUBLE_N && Boxed_as(FlxVecDouble, w)->data[99999] == 99999.5
+        && Boxed_as(FlxVecDouble, w)->data[5] == 5.0, sMSG("A later fraction should widen the column, not truncate it"));
+    log_assert(FlxVecDouble_aggregate(Boxed_as(FlxVecDouble, y), nullptr, AGG_SUM) == 2499975000.0,
+        sMSG("Parallel chunks lost or duplicated rows"));
+    log_assert(group->num_categories == 3, sMSG("Chunk categories were not merged"));
+    log_assert(FixStr_eq(group->categories[group->data[4]], s("bb")), sMSG("Category codes remapped incorrectly"));
+
+    log_assert(FlxDataFrame_write_columnar(df, bin_path), sMSG("FlxDataFrame_write_columnar failed"));
+    FlxDataFrame *mapped = FlxDataFrame_map_columnar(bin_path);
+    log_assert(mapped != nullptr, sMSG("FlxDataFrame_map_columnar failed"));
+    log_assert(mapped->num_rows == 100000, sMSG("Mapped row count incorrect"));
+
+    FlxVecDouble *mapped_y = Boxed_as(FlxVecDouble, FlxDataFrame_column(mapped, s("y")));
+    FlxVecCat *mapped_group = Boxed_as(FlxVecCat, FlxDataFrame_column(mapped, s("group")));
+    log_assert(mapped_y->meta.state == LIVING_PINNED, sMSG("Mapped columns should be pinned"));
+    log_assert(mapped_y->data[10] == 5.0, sMSG("Mapped column data incorrect"));
+    log_assert(FixStr_eq(mapped_group->categories[mapped_group->data[5]], s("ccc")), sMSG("Mapped categories incorrect"));
+
+    FlxDataFrame_unmap(mapped);
+
+    /// the same file from doubt code: columns reach observe() unboxed, and the kernels are natives
+    FixStr source = FixStr_fmt_new(s(
+        "fn fit() :=\n    let\n        df = read_csv(\"%s\")\n        small = filter(df, \"x\", #LT, 10)\n    in\n"
+        "        observe(normal(0, 1), small.y)\n\n"
+        "fn mean_y() :=\n    aggregate(read_csv(\"%s\").y, #MEAN)\n\n"
+        "fn as_frames() :=\n    let\n        df = read_csv(\"%s\")\n        means = group_by(df, \"group\", \"y\", #MEAN)\n    in\n"
+        "        [select(df, \"x\", \"y\"), filter(df, \"group\", #EQ, \"a\"), join(filter(df, \"x\", #LT, 10), means, \"group\"), means]\n"),
+        csv_path, csv_path, csv_path);
+    DoubtInstance *instance = DoubtInstance_new();
+    log_assert(instance != nullptr && DoubtInstance_load(instance, source), sMSG("A dataframe program should load"));
+
+    Box result;
+    double first_ys[10];
+    for(int i = 0; i < 10; i++) { first_ys[i] = i * 0.5; }
+    FixDist *standard = FixDist_new(DIST_NORMAL, (double[]) { 0.0, 1.0 }, 2);
+    log_assert(DoubtInstance_call(instance, s("fit"), (FixArray) {0}, &result)
+        && fabs(Box_unwrap_float(result) - FixDist_log_pdf_sum(standard, first_ys, 10)) < 1e-3,
+        sMSG("observe(dist, df.col) should score the filtered column"));
+    log_assert(DoubtInstance_call(instance, s("mean_y"), (FixArray) {0}, &result) && Box_unwrap_float(result) == 24999.75f,
+        sMSG("aggregate() should average a column"));
+
+    log_assert(DoubtInstance_call(instance, s("as_frames"), (FixArray) {0}, &result), sMSG("The dataframe natives should run"));
+    FixArray *frames = Box_unwrap_FixArray(result);
+    FlxDataFrame *selected = Box_unwrap_typed_ptr(FlxDataFrame, frames->data[0]);
+    FlxDataFrame *group_a = Box_unwrap_typed_ptr(FlxDataFrame, frames->data[1]);
+    FlxDataFrame *joined = Box_unwrap_typed_ptr(FlxDataFrame, frames->data[2]);
+    FlxDataFrame *means = Box_unwrap_typed_ptr(FlxDataFrame, frames->data[3]);
+    log_assert(len_ref(selected) == 2 && selected->num_rows == 100000, sMSG("select() should keep the named columns"));
+    log_assert(group_a->num_rows == 33334, sMSG("filter() should compare a categorical column with a string"));
+    log_assert(joined->num_rows == 10 && len_ref(joined) == 7, sMSG("join() should add the right frame's value column"));
+    log_assert(means->num_rows == 3, sMSG("group_by() should give one row per group"));
+    DoubtInstance_free(instance);
+
+    remove(csv_path);
+    remove(bin_path);
+    return 0;
+}
+
+#pragma endregion
+
+#pragma region FlxMatrixImpl
+
+#define linalg_min(a, b) ((a) < (b) ? (a) : (b))
+
+FlxMatrixF *FlxMatrixF_new(size_t rows, size_t columns) {
+    require_positive(rows);
+    require_positive(columns);
+
+    FlxMatrixF *m = gco_new(BXD_FLX_MATRIX_DOUBLE);
+    if(m == nullptr) { error_oom(); return nullptr; }
+
+    m->meta.type = BXD_FLX_MATRIX_DOUBLE;
+    m->meta.state = LIVING_ALIVE;
+    m->rows = rows;
+    m->columns = columns;
+    cnew_carray(m, rows * columns);
+    m->meta.size = rows * columns;
+    return m;
+}
+
+FlxMatrixF *FlxMatrixF_copy(const FlxMatrixF *m) {
+    require_not_null(m);
+
+    FlxMatrixF *out = FlxMatrixF_new(m->rows, m->columns);
+    if(out == nullptr) { return nullptr; }
+    memcpy(out->data, m->data, m->rows * m->columns * sizeof(double));
+    return out;
+}
+
+/// @brief Dot product with four independent accumulators, so the loop pipelines and vectorizes
+static inline double linalg_dot(const double *x, const double *y, size_t n) {
+    double acc0 = 0.0, acc1 = 0.0, acc2 = 0.0, acc3 = 0.0;
+    size_t i = 0;
+    for(; i + 4 <= n; i += 4) {
+        acc0 += x[i] * y[i];
+        acc1 += x[i + 1] * y[i + 1];
+        acc2 += x[i + 2] * y[i + 2];
+        acc3 += x[i + 3] * y[i + 3];
+    }
+    for(; i < n; i++) {
+        acc0 += x[i] * y[i];
+    }
+    return (acc0 + acc1) + (acc2 + acc3);
+}
+
+/// @brief Runs `worker` over `tasks` on the compute pool (inline when there is one)
+static void FlxLinalg_run_tasks(FlxLinalgTask *tasks, size_t num_tasks, void *(*worker)(void *)) {
+    TaskPool_run(tasks, sizeof(FlxLinalgTask), num_tasks, worker);
+}
+
+/// @brief Splits `rows` into per-thread ranges (multiples of `align`), returning the task count
+static size_t FlxLinalg_split_rows(FlxLinalgTask *tasks, size_t rows, double flops, size_t align) {
+    size_t num_tasks = flops < LINALG_PARALLEL_MIN_FLOPS ? 1 : TaskPool_num_workers();
+    size_t step = (rows + num_tasks - 1) / num_tasks;
+    step = ((step + align - 1) / align) * align;
+
+    size_t t = 0;
+    for(size_t start = 0; start < rows && t < num_tasks; start += step, t++) {
+        tasks[t].row_start = start;
+        tasks[t].row_end = linalg_min(start + step, rows);
+    }
+    return t > 0 ? t : 1;
+}
+
+
+/// @brief Packs an MCxKC block of A into MR-row panels (zero-padded), column by column
+static void gemm_pack_a(const FlxMatrixF *a, size_t ic, size_t pc, size_t mc, size_t kc, double *packed) {
+    for(size_t ir = 0; ir < mc; ir += GEMM_MR) {
+        for(size_t p = 0; p < kc; p++) {
+            for(size_t i = 0; i < GEMM_MR; i++) {
+                *packed++ = ir + i < mc ? FlxMatrixF_at(a, ic + ir + i, pc + p) : 0.0;
+            }
+        }
+    }
+}
+
+/// @brief Packs a KCxNC panel of B into NR-column panels (zero-padded), row by row
+static void gemm_pack_b(const FlxMatrixF *b, size_t pc, size_t jc, size_t kc, size_t nc, double *packed) {
+    for(size_t jr = 0; jr < nc; jr += GEMM_NR) {
+        for(size_t p = 0; p < kc; p++) {
+            const double *row = &FlxMatrixF_at(b, pc + p, jc + jr);
+            for(size_t j = 0; j < GEMM_NR; j++) {
+                *packed++ = jr + j < nc ? row[j] : 0.0;
+            }
+        }
+    }
+}
+
+/// @brief C[mr x nr] += Apanel * Bpanel over kc, accumulating in an MRxNR register tile
+static void gemm_micro_kernel(size_t kc, const double *a, const double *b, double *c, size_t ldc, size_t mr, size_t nr) {
+    double acc[GEMM_MR][GEMM_NR] = {{0}};
+
+    for(size_t p = 0; p < kc; p++) {
+        const double *b_row = b + p * GEMM_NR;
+        for(size_t i = 0; i < GEMM_MR; i++) {
+            double a_ip = a[p * GEMM_MR + i];
+            for(size_t j = 0; j < GEMM_NR; j++) {
+                acc[i][j] += a_ip * b_row[j];
+            }
+        }
+    }
+
+    for(size_t i = 0; i < mr; i++) {
+        for(size_t j = 0; j < nr; j++) {
+            c[i * ldc + j] += acc[i][j];
+        }
+    }
+}
+
+static void *FlxMatrixF_gemm_worker(void *arg) {
+    FlxLinalgTask *task = (FlxLinalgTask *) arg;
+    const FlxMatrixF *a = task->a;
+    const FlxMatrixF *b = task->b;
+    FlxMatrixF *c = task->c;
+    size_t k = a->columns;
+    size_t n = b->columns;
+
+    for(size_t jc = 0; jc < n; jc += GEMM_NC) {
+        size_t nc = linalg_min(GEMM_NC, n - jc);
+
+        for(size_t pc = 0; pc < k; pc += GEMM_KC) {
+            size_t kc = linalg_min(GEMM_KC, k - pc);
+            gemm_pack_b(b, pc, jc, kc, nc, task->packed_b);
+
+            for(size_t ic = task->row_start; ic < task->row_end; ic += GEMM_MC) {
+                size_t mc = linalg_min(GEMM_MC, task->row_end - ic);
+                gemm_pack_a(a, ic, pc, mc, kc, task->packed_a);
+
+                for(size_t jr = 0; jr < nc; jr += GEMM_NR) {
+                    for(size_t ir = 0; ir < mc; ir += GEMM_MR) {
+                        gemm_micro_kernel(kc, task->packed_a + ir * kc, task->packed_b + jr * kc,
+                            &FlxMatrixF_at(c, ic + ir, jc + jr), n,
+                            linalg_min(GEMM_MR, mc - ir), linalg_min(GEMM_NR, nc - jr));
+                    }
+                }
+            }
+        }
+    }
+    return nullptr;
+}
+
+/// @brief C += A * B, cache-blocked and split by rows of C across compute threads
+void FlxMatrixF_gemm(const FlxMatrixF *a, const FlxMatrixF *b, FlxMatrixF *c) {
+    require_not_null(a);
+    require_not_null(b);
+    require_not_null(c);
+    log_assert(a->columns == b->rows && c->rows == a->rows && c->columns == b->columns,
+        sMSG("FlxMatrixF_gemm(): dimension mismatch."));
+
+    FlxLinalgTask tasks[CPU_CORES_MAX] = {0};
+    double flops = 2.0 * (double) a->rows * (double) a->columns * (double) b->columns;
+    size_t num_tasks = FlxLinalg_split_rows(tasks, a->rows, flops, GEMM_MR);
+
+    /// @note scratch is allocated here, since workers must not touch the allocators
+    size_t kc = linalg_min(GEMM_KC, a->columns);
+    size_t nc = linalg_min(GEMM_NC, b->columns);
+    size_t packed_a_size = GEMM_MC * kc;
+    size_t packed_b_size = ((nc + GEMM_NR - 1) / GEMM_NR) * GEMM_NR * kc;
+
+    for(size_t t = 0; t < num_tasks; t++) {
+        tasks[t].a = a;
+        tasks[t].b = b;
+        tasks[t].c = c;
+        tasks[t].packed_a = cnew(packed_a_size * sizeof(double));
+        tasks[t].packed_b = cnew(packed_b_size * sizeof(double));
+        if(tasks[t].packed_a == nullptr || tasks[t].packed_b == nullptr) { error_oom(); return; }
+    }
+
+    FlxLinalg_run_tasks(tasks, num_tasks, FlxMatrixF_gemm_worker);
+
+    for(size_t t = 0; t < num_tasks; t++) {
+        cfree(tasks[t].packed_a);
+        cfree(tasks[t].packed_b);
+    }
+}
+
+FlxMatrixF *FlxMatrixF_matmul_new(const FlxMatrixF *a, const FlxMatrixF *b) {
+    require_not_null(a);
+    require_not_null(b);
+
+    if(a->columns != b->rows) {
+        log_message(LL_ERROR, sMSG("matmul(): cannot multiply %zux%zu by %zux%zu."),
+            a->rows, a->columns, b->rows, b->columns);
+        return nullptr;
+    }
+
+    FlxMatrixF *c = FlxMatrixF_new(a->rows, b->columns);
+    if(c == nullptr) { return nullptr; }
+    FlxMatrixF_gemm(a, b, c);
+    return c;
+}
+
+static void *FlxMatrixF_gemv_worker(void *arg) {
+    FlxLinalgTask *task = (FlxLinalgTask *) arg;
+    const FlxMatrixF *a = task->a;
+
+    for(size_t r = task->row_start; r < task->row_end; r++) {
+        task->y[r] = linalg_dot(&FlxMatrixF_at(a, r, 0), task->x, a->columns);
+    }
+    return nullptr;
+}
+
+/// @brief y = A * x; rows of A are contiguous, so each output is one streaming dot product
+void FlxMatrixF_gemv(const FlxMatrixF *a, const double *x, double *y) {
+    require_not_null(a);
+    require_not_null(x);
+    require_not_null(y);
+
+    FlxLinalgTask tasks[CPU_CORES_MAX] = {0};
+    double flops = 2.0 * (double) a->rows * (double) a->columns;
+    size_t num_tasks = FlxLinalg_split_rows(tasks, a->rows, flops, 1);
+
+    for(size_t t = 0; t < num_tasks; t++) {
+        tasks[t].a = a;
+        tasks[t].x = x;
+        tasks[t].y = y;
+    }
+    FlxLinalg_run_tasks(tasks, num_tasks, FlxMatrixF_gemv_worker);
+}
+
+/// @brief In-place Cholesky factorisation A = L L^T, leaving L in the lower triangle
+/// @note Cholesky-Crout order: every update is a dot product of two contiguous row prefixes
+/// @return false if A is not (numerically) symmetric positive definite
+bool FlxMatrixF_cholesky(FlxMatrixF *a) {
+    require_not_null(a);
+    log_assert(a->rows == a->columns, sMSG("FlxMatrixF_cholesky(): matrix is not square."));
+
+    size_t n = a->rows;
+    for(size_t j = 0; j < n; j++) {
+        double *row_j = &FlxMatrixF_at(a, j, 0);
+        double d = row_j[j] - linalg_dot(row_j, row_j, j);
+        if(!(d > 0.0)) {
+            return false;
+        }
+
+        double l_jj = sqrt(d);
+        row_j[j] = l_jj;
+        for(size_t i = j + 1; i < n; i++) {
+            double *row_i = &FlxMatrixF_at(a, i, 0);
+            row_i[j] = (row_i[j] - linalg_dot(row_i, row_j, j)) / l_jj;
+        }
+    }
+
+    for(size_t i = 0; i < n; i++) {
+        for(size_t j = i + 1; j < n; j++) {
+            FlxMatrixF_at(a, i, j) = 0.0;
+        }
+    }
+    return true;
+}
+
+/// @brief Solves L x = b by forward substitution (x may alias b)
+void FlxMatrixF_solve_lower(const FlxMatrixF *l, const double *b, double *x) {
+    require_not_null(l);
+
+    for(size_t i = 0; i < l->rows; i++) {
+        const double *row = &FlxMatrixF_at(l, i, 0);
+        x[i] = (b[i] - linalg_dot(row, x, i)) / row[i];
+    }
+}
+
+/// @brief Solves L^T x = b by back substitution (x may alias b)
+/// @note column-oriented, so it still walks rows of L contiguously
+void FlxMatrixF_solve_lower_transpose(const FlxMatrixF *l, const double *b, double *x) {
+    require_not_null(l);
+
+    size_t n = l->rows;
+    if(x != b) {
+        memcpy(x, b, n * sizeof(double));
+    }
+    for(size_t i = n; i-- > 0;) {
+        const double *row = &FlxMatrixF_at(l, i, 0);
+        x[i] /= row[i];
+        for(size_t k = 0; k < i; k++) {
+            x[k] -= row[k] * x[i];
+        }
+    }
+}
+
+double FlxMatrixF_cholesky_logdet(const FlxMatrixF *l) {
+    require_not_null(l);
+
+    double logdet = 0.0;
+    for(size_t i = 0; i < l->rows; i++) {
+        logdet += log(FlxMatrixF_at(l, i, i));
+    }
+    return 2.0 * logdet;
+}
+
+/// @brief log|A| of a symmetric positive definite matrix, via Cholesky of a copy
+/// @note the copy is a scratch buffer freed here, not a collected matrix
+bool FlxMatrixF_logdet(const FlxMatrixF *a, double *out_logdet) {
+    require_not_null(a);
+
+    FlxMatrixF l = *a;
+    l.data = cnew(a->rows * a->columns * sizeof(double));
+    if(l.data == nullptr) { error_oom(); return false; }
+    memcpy(l.data, a->data, a->rows * a->columns * sizeof(double));
+
+    bool ok = FlxMatrixF_cholesky(&l);
+    if(ok) { *out_logdet = FlxMatrixF_cholesky_logdet(&l); }
+    cfree(l.data);
+    return ok;
+}
+
+/// @brief log N(x | mean, L L^T) given the Cholesky factor L of the covariance
+double FlxMatrixF_mvn_log_pdf(const double *x, const double *mean, const FlxMatrixF *chol) {
+    require_not_null(chol);
+
+    size_t n = chol->rows;
+    double *z = cnew(n * sizeof(double));
+    if(z == nullptr) { error_oom(); return NAN; }
+
+    for(size_t i = 0; i < n; i++) {
+        z[i] = x[i] - mean[i];
+    }
+    FlxMatrixF_solve_lower(chol, z, z);
+    double mahalanobis = linalg_dot(z, z, n);
+    cfree(z);
+
+    return -0.5 * ((double) n * log(2.0 * M_PI) + FlxMatrixF_cholesky_logdet(chol) + mahalanobis);
+}
+
+FixStr FlxMatrixF_to_FixStr(FlxMatrixF *m) {
+    FixStr repr = FixStr_fmt_new(s("MatrixF(%zux%zu) ["), m->rows, m->columns);
+    for(size_t r = 0; r < m->rows; r++) {
+        FixStr row = s("[");
+        for(size_t c = 0; c < m->columns; c++) {
+            row = FixStr_glue_sep_new(row, FixStr_fmt_new(s("%.6f"), FlxMatrixF_at(m, r, c)), s(", "));
+        }
+        repr = FixStr_glue_sep_new(repr, FixStr_glue_new(row, s("]")), s(", "));
+    }
+    repr = FixStr_glue_new(repr, s("]"));
+    return repr;
+}
+
+
+int FlxMatrixF_test_main(void) {
+    /// @note sizes straddle the MR/NR/MC tiles and cross the threading threshold
+    size_t m = 133, k = 70, n = 129;
+    FlxMatrixF *a = FlxMatrixF_new(m, k);
+    FlxMatrixF *b = FlxMatrixF_new(k, n);
+    for(size_t i = 0; i < m * k; i++) { a->data[i] = (double) ((i * 7) % 11) - 5.0; }
+    for(size_t i = 0; i < k * n; i++) { b->data[i] = (double) ((i * 5) % 13) - 6.0; }
+
+    FlxMatrixF *c = FlxMatrixF_matmul_new(a, b);
+    double max_error = 0.0;
+    for(size_t i = 0; i < m; i++) {
+        for(size_t j = 0; j < n; j++) {
+            double expected = 0.0;
+            for(size_t p = 0; p < k; p++) { expected += FlxMatrixF_at(a, i, p) * FlxMatrixF_at(b, p, j); }
+            double error = fabs(expected - FlxMatrixF_at(c, i, j));
+            max_error = error > max_error ? error : max_error;
+        }
+    }
+    log_assert(max_error == 0.0, sMSG("FlxMatrixF_gemm disagrees with the naive product"));
+
+    double x[70], y[133];
+    for(size_t i = 0; i < k; i++) { x[i] = (double) i; }
+    FlxMatrixF_gemv(a, x, y);
+    log_assert(y[5] == linalg_dot(&FlxMatrixF_at(a, 5, 0), x, k), sMSG("FlxMatrixF_gemv row 5 incorrect"));
+
+    /// @note [[4, 2], [2, 3]] = L L^T with L = [[2, 0], [1, sqrt(2)]]
+    FlxMatrixF *spd = FlxMatrixF_new(2, 2);
+    spd->data[0] = 4.0; spd->data[1] = 2.0; spd->data[2] = 2.0; spd->data[3] = 3.0;
+    double logdet = 0.0;
+    log_assert(FlxMatrixF_logdet(spd, &logdet) && fabs(logdet - log(8.0)) < 1e-12, sMSG("FlxMatrixF_logdet incorrect"));
+    log_assert(spd->data[0] == 4.0, sMSG("FlxMatrixF_logdet should leave its argument alone"));
+
+    FlxMatrixF *l = FlxMatrixF_copy(spd);
+    log_assert(FlxMatrixF_cholesky(l), sMSG("FlxMatrixF_cholesky rejected an SPD matrix"));
+    log_assert(fabs(FlxMatrixF_at(l, 1, 1) - sqrt(2.0)) < 1e-12, sMSG("FlxMatrixF_cholesky factor incorrect"));
+
+    double rhs[2] = {10.0, 8.0}, solution[2];
+    FlxMatrixF_solve_lower(l, rhs, solution);
+    FlxMatrixF_solve_lower_transpose(l, solution, solution);
+    log_assert(fabs(solution[0] - 1.75) < 1e-12 && fabs(solution[1] - 1.5) < 1e-12, sMSG("Cholesky solve incorrect"));
+
+    double zero[2] = {0.0, 0.0};
+    double expected_log_pdf = -log(2.0 * M_PI) - 0.5 * log(8.0);
+    log_assert(fabs(FlxMatrixF_mvn_log_pdf(zero, zero, l) - expected_log_pdf) < 1e-12, sMSG("FlxMatrixF_mvn_log_pdf incorrect"));
+
+    FlxMatrixF *not_spd = FlxMatrixF_new(2, 2);
+    not_spd->data[0] = 1.0; not_spd->data[1] = 2.0; not_spd->data[2] = 2.0; not_spd->data[3] = 1.0;
+    log_assert(!FlxMatrixF_cholesky(not_spd), sMSG("FlxMatrixF_cholesky accepted an indefinite matrix"));
+
+    /// the natives free their copies of vector arguments when they fail
+    FlxVecDouble *short_vec = FlxVecDouble_new(1);
+    short_vec->data[0] = 1.0;
+    short_vec->meta.size = 1;
+    FlxVecDouble *pair = FlxVecDouble_new(2);
+    pair->data[0] = 1.0; pair->data[1] = 2.0;
+    pair->meta.size = 2;
+
+    FixFn linalg = { .name = s("linalg") };
+    Box spd_box = Box_wrap_BoxedHeap(spd), not_spd_box = Box_wrap_BoxedHeap(not_spd);
+    Box short_box = Box_wrap_BoxedHeap(short_vec), pair_box = Box_wrap_BoxedHeap(pair);
+    log_assert(Box_is_error(native_matmul(&linalg, (FixScope) {0}, spd_box, short_box)),
+        sMSG("A vector of the wrong length should be an error"));
+
+    /// @note counted from after the first error, which sets up storage of its own; solve()
+    ///     ... and mvnormal_log_pdf() also copy the matrix, which is left to the collector
+    #ifdef DEBUG_MEMORY
+        size_t num_live = ctx_debug_memory().num_live;
+        FlxMatrixF_copy(spd);
+        size_t per_copy = ctx_debug_memory().num_live - num_live;
+        num_live = ctx_debug_memory().num_live;
+    #endif
+    log_assert(Box_is_error(native_matmul(&linalg, (FixScope) {0}, spd_box, short_box))
+        && Box_is_error(native_solve(&linalg, (FixScope) {0}, not_spd_box, pair_box))
+        && Box_is_error(native_mvnormal_log_pdf(&linalg, (FixScope) {0}, pair_box, short_box, not_spd_box))
+        && Box_is_error(native_mvnormal_log_pdf(&linalg, (FixScope) {0}, pair_box, pair_box, not_spd_box)),
+        sMSG("Mismatched or indefinite arguments should be errors"));
+    #ifdef DEBUG_MEMORY
+        log_assert(ctx_debug_memory().num_live == num_live + 3 * per_copy, sMSG("A failing native should free its copies"));
+    #endif
+    return 0;
+}
+
+#pragma endregion
+
+#pragma region FlxTensorImpl
+
+#define tensor_op_assign(x, y) (y)
+#define tensor_op_add(x, y) ((x) + (y))
+#define tensor_op_sub(x, y) ((x) - (y))
+#define tensor_op_mul(x, y) ((x) * (y))
+#define tensor_op_div(x, y) ((x) / (y))
+
+/// @brief Innermost run of an elementwise pass, split so the unit-stride and scalar-broadcast
+///     ... cases are plain counted loops the compiler can vectorize
+#define tensor_inner_loop(op_fn) \
+    if(sd == 1 && sa == 1 && sb == 1) { \
+        for(size_t i = 0; i < n; i++) { d[i] = op_fn(pa[i], pb[i]); } \
+    } else if(sd == 1 && sa == 1 && sb == 0) { \
+        const double y = pb[0]; \
+        for(size_t i = 0; i < n; i++) { d[i] = op_fn(pa[i], y); } \
+    } else { \
+        for(ptrdiff_t i = 0; i < (ptrdiff_t) n; i++) { d[i * sd] = op_fn(pa[i * sa], pb[i * sb]); } \
+    }
+
+/// @brief Allocates an unpopulated header with row-major strides for `shape`
+static FlxTensorF *FlxTensorF_header_new(size_t ndim, const size_t *shape) {
+    if(ndim == 0 || ndim > TENSOR_MAX_DIMS) {
+        log_message(LL_ERROR, sMSG("Tensor rank %zu outside 1..%d."), ndim, TENSOR_MAX_DIMS);
+        return nullptr;
+    }
+
+    FlxTensorF *t = gco_new(BXD_FLX_TENSOR_DOUBLE);
+    if(t == nullptr) { error_oom(); return nullptr; }
+
+    t->meta.type = BXD_FLX_TENSOR_DOUBLE;
+    t->meta.state = LIVING_ALIVE;
+    t->data = nullptr;
+    t->offset = 0;
+    t->ndim = ndim;
+    t->base = nullptr;
+
+    size_t size = 1;
+    for(size_t k = ndim; k-- > 0;) {
+        t->shape[k] = shape[k];
+        t->strides[k] = (ptrdiff_t) size;
+        size *= shape[k];
+    }
+    t->meta.size = size;
+    return t;
+}
+
+/// @brief A view header sharing `t`'s data; the caller adjusts shape/strides/offset
+static FlxTensorF *FlxTensorF_view_new(const FlxTensorF *t) {
+    FlxTensorF *view = FlxTensorF_header_new(t->ndim, t->shape);
+    if(view == nullptr) { return nullptr; }
+
+    view->data = t->data;
+    view->offset = t->offset;
+    memcpy(view->strides, t->strides, t->ndim * sizeof(ptrdiff_t));
+    /// @note a pinned tensor without a base borrows from a non-tensor owner (eg., a matrix)
+    view->base = t->base || t->meta.state == LIVING_PINNED ? t->base : (FlxTensorF *) t;
+    view->meta.state = LIVING_PINNED;
+    return view;
+}
+
+FlxTensorF *FlxTensorF_new(size_t ndim, const size_t *shape) {
+    require_not_null(shape);
+
+    FlxTensorF *t = FlxTensorF_header_new(ndim, shape);
+    if(t == nullptr) { return nullptr; }
+
+    size_t size = t->meta.size > 0 ? t->meta.size : 1;
+    cnew_carray(t, size);
+    t->meta.size = size;
+    for(size_t k = 0; k < ndim; k++) {
+        if(shape[k] == 0) { t->meta.size = 0; }
+    }
+    return t;
+}
+
+/// @brief Wraps an existing contiguous buffer (eg., a matrix or vector's data) without copying
+FlxTensorF *FlxTensorF_from_data(double *data, size_t ndim, const size_t *shape, FlxTensorF *base) {
+    require_not_null(data);
+    require_not_null(shape);
+
+    FlxTensorF *t = FlxTensorF_header_new(ndim, shape);
+    if(t == nullptr) { return nullptr; }
+
+    t->data = data;
+    t->base = base;
+    t->meta.state = LIVING_PINNED;
+    return t;
+}
+
+bool FlxTensorF_is_contiguous(const FlxTensorF *t) {
+    require_not_null(t);
+
+    ptrdiff_t expected = 1;
+    for(size_t k = t->ndim; k-- > 0;) {
+        if(t->shape[k] != 1 && t->strides[k] != expected) { return false; }
+        expected *= (ptrdiff_t) t->shape[k];
+    }
+    return true;
+}
+
+/// @brief Fills `out_view` with a stack view over a tensor, matrix or double vector (no allocation)
+bool FlxTensorF_view_of_Box(Box box, FlxTensorF *out_view) {
+    require_not_null(out_view);
+
+    if(Box_is_Boxed_type(box, BXD_FLX_TENSOR_DOUBLE)) {
+        FlxTensorF *t = Box_unwrap_typed_ptr(FlxTensorF, box);
+        *out_view = *t;
+        out_view->base = t->base ? t->base : t;
+        out_view->meta.state = LIVING_PINNED;
+        return true;
+    }
+
+    memset(out_view, 0, sizeof(FlxTensorF));
+    out_view->meta.type = BXD_FLX_TENSOR_DOUBLE;
+    out_view->meta.state = LIVING_PINNED;
+    if(Box_is_Boxed_type(box, BXD_FLX_MATRIX_DOUBLE)) {
+        FlxMatrixF *m = Box_unwrap_typed_ptr(FlxMatrixF, box);
+        out_view->data = m->data;
+        out_view->ndim = 2;
+        out_view->shape[0] = m->rows;
+        out_view->shape[1] = m->columns;
+        out_view->strides[0] = (ptrdiff_t) m->columns;
+        out_view->strides[1] = 1;
+        out_view->meta.size = m->rows * m->columns;
+        return true;
+    }
+    if(Box_is_Boxed_type(box, BXD_FLX_VEC_DOUBLE_N)) {
+        FlxVecDouble *vec = Box_unwrap_typed_ptr(FlxVecDouble, box);
+        out_view->data = vec->data;
+        out_view->ndim = 1;
+        out_view->shape[0] = len_ref(vec);
+        out_view->strides[0] = 1;
+        out_view->meta.size = len_ref(vec);
+        return true;
+    }
+    return false;
+}
+
+/// @brief Selects [start, stop) along `axis` every `step` elements as a view
+/// @note a negative step walks the same half-open range backwards, from stop - 1 down to start
+FlxTensorF *FlxTensorF_slice(const FlxTensorF *t, size_t axis, size_t start, size_t stop, ptrdiff_t step) {
+    require_not_null(t);
+
+    if(axis >= t->ndim || step == 0) {
+        log_message(LL_ERROR, sMSG("Invalid slice: axis %zu of rank %zu, step %td."), axis, t->ndim, step);
+        return nullptr;
+    }
+
+    stop = stop > t->shape[axis] ? t->shape[axis] : stop;
+    start = start > stop ? stop : start;
+    size_t stride = (size_t) (step > 0 ? step : -step);
+    size_t length = (stop - start + stride - 1) / stride;
+
+    FlxTensorF *view = FlxTensorF_view_new(t);
+    if(view == nullptr) { return nullptr; }
+
+    if(length > 0) {
+        size_t first = step > 0 ? start : stop - 1;
+        view->offset = (size_t) ((ptrdiff_t) view->offset + (ptrdiff_t) first * t->strides[axis]);
+    }
+    view->shape[axis] = length;
+    view->strides[axis] = t->strides[axis] * step;
+    view->meta.size = t->shape[axis] > 0 ? t->meta.size / t->shape[axis] * length : 0;
+    return view;
+}
+
+FlxTensorF *FlxTensorF_permute(const FlxTensorF *t, const size_t *axes) {
+    require_not_null(t);
+    require_not_null(axes);
+
+    bool seen[TENSOR_MAX_DIMS] = {0};
+    for(size_t k = 0; k < t->ndim; k++) {
+        if(axes[k] >= t->ndim || seen[axes[k]]) {
+            log_message(LL_ERROR, sMSG("Invalid permutation of rank %zu tensor."), t->ndim);
+            return nullptr;
+        }
+        seen[axes[k]] = true;
+    }
+
+    FlxTensorF *view = FlxTensorF_view_new(t);
+    if(view == nullptr) { return nullptr; }
+
+    for(size_t k = 0; k < t->ndim; k++) {
+        view->shape[k] = t->shape[axes[k]];
+        view->strides[k] = t->strides[axes[k]];
+    }
+    return view;
+}
+
+/// @brief Reverses the axes (a matrix transpose for rank 2)
+FlxTensorF *FlxTensorF_transpose(const FlxTensorF *t) {
+    require_not_null(t);
+
+    size_t axes[TENSOR_MAX_DIMS];
+    for(size_t k = 0; k < t->ndim; k++) { axes[k] = t->ndim - 1 - k; }
+    return FlxTensorF_permute(t, axes);
+}
+
+bool FlxTensorF_broadcast_shape(const FlxTensorF *a, const FlxTensorF *b, size_t *out_ndim, size_t *out_shape) {
+    require_not_null(a);
+    require_not_null(b);
+
+    size_t ndim = a->ndim > b->ndim ? a->ndim : b->ndim;
+    for(size_t k = 0; k < ndim; k++) {
+        size_t extent_a = k < ndim - a->ndim ? 1 : a->shape[k - (ndim - a->ndim)];
+        size_t extent_b = k < ndim - b->ndim ? 1 : b->shape[k - (ndim - b->ndim)];
+        if(extent_a != extent_b && extent_a != 1 && extent_b != 1) { return false; }
+        out_shape[k] = extent_a == 1 ? extent_b : extent_a;
+    }
+    *out_ndim = ndim;
+    return true;
+}
+
+/// @brief Aligns `t` to the trailing axes of `shape`, with stride 0 on every broadcast axis
+static bool FlxTensorF_broadcast_strides(const FlxTensorF *t, size_t ndim, const size_t *shape, ptrdiff_t *out_strides) {
+    if(t->ndim > ndim) { return false; }
+
+    size_t lead = ndim - t->ndim;
+    for(size_t k = 0; k < ndim; k++) {
+        if(k < lead) { out_strides[k] = 0; continue; }
+
+        size_t extent = t->shape[k - lead];
+        if(extent == shape[k]) { out_strides[k] = t->strides[k - lead]; }
+        else if(extent == 1) { out_strides[k] = 0; }
+        else { return false; }
+    }
+    return true;
+}
+
+/// @brief dst = a `op` b over one iteration space, in a single pass
+/// @note unit axes are dropped and adjacent axes merged whenever every operand's strides chain,
+///     ... so contiguous (or scalar-broadcast) operands run as one flat vectorizable loop
+static void FlxTensor_elementwise(FlxElemOp op, size_t ndim, const size_t *shape_in,
+    double *dst, const double *a, const double *b, ptrdiff_t (*strides_in)[TENSOR_MAX_DIMS]
+) {
+    size_t total = 1;
+    for(size_t k = 0; k < ndim; k++) { total *= shape_in[k]; }
+    if(total == 0) { return; }
+
+    size_t shape[TENSOR_MAX_DIMS];
+    ptrdiff_t strides[3][TENSOR_MAX_DIMS];
+    size_t kept = 0;
+    for(size_t k = 0; k < ndim; k++) {
+        if(shape_in[k] == 1) { continue; }
+        shape[kept] = shape_in[k];
+        for(size_t o = 0; o < 3; o++) { strides[o][kept] = strides_in[o][k]; }
+        kept++;
+    }
+    if(kept == 0) {
+        shape[0] = 1;
+        for(size_t o = 0; o < 3; o++) { strides[o][0] = 0; }
+        kept = 1;
+    }
+
+    size_t merged = 0;
+    for(size_t k = 1; k < kept; k++) {
+        bool chains = true;
+        for(size_t o = 0; o < 3; o++) {
+            if(strides[o][merged] != strides[o][k] * (ptrdiff_t) shape[k]) { chains = false; }
+        }
+        if(!chains) { merged++; }
+        shape[merged] = chains ? shape[merged] * shape[k] : shape[k];
+        for(size_t o = 0; o < 3; o++) { strides[o][merged] = strides[o][k]; }
+    }
+    ndim = merged + 1;
+
+    size_t n = shape[ndim - 1];
+    ptrdiff_t sd = strides[0][ndim - 1], sa = strides[1][ndim - 1], sb = strides[2][ndim - 1];
+    size_t index[TENSOR_MAX_DIMS] = {0};
+    ptrdiff_t offset_d = 0, offset_a = 0, offset_b = 0;
+
+    for(size_t row = 0; row < total / n; row++) {
+        double *d = dst + offset_d;
+        const double *pa = a + offset_a;
+        const double *pb = b + offset_b;
+
+        switch(op) {
+            case ELEM_ASSIGN: tensor_inner_loop(tensor_op_assign); break;
+            case ELEM_ADD: tensor_inner_loop(tensor_op_add); break;
+            case ELEM_SUB: tensor_inner_loop(tensor_op_sub); break;
+            case ELEM_MUL: tensor_inner_loop(tensor_op_mul); break;
+            case ELEM_DIV: tensor_inner_loop(tensor_op_div); break;
+        }
+
+        for(size_t k = ndim - 1; k-- > 0;) {
+            index[k]++;
+            offset_d += strides[0][k];
+            offset_a += strides[1][k];
+            offset_b += strides[2][k];
+            if(index[k] < shape[k]) { break; }
+
+            offset_d -= strides[0][k] * (ptrdiff_t) shape[k];
+            offset_a -= strides[1][k] * (ptrdiff_t) shape[k];
+            offset_b -= strides[2][k] * (ptrdiff_t) shape[k];
+            index[k] = 0;
+        }
+    }
+}
+
+FlxTensorF *FlxTensorF_copy(const FlxTensorF *t) {
+    require_not_null(t);
+
+    FlxTensorF *out = FlxTensorF_new(t->ndim, t->shape);
+    if(out == nullptr) { return nullptr; }
+
+    ptrdiff_t strides[3][TENSOR_MAX_DIMS];
+    memcpy(strides[0], out->strides, t->ndim * sizeof(ptrdiff_t));
+    memcpy(strides[1], out->strides, t->ndim * sizeof(ptrdiff_t));
+    memcpy(strides[2], t->strides, t->ndim * sizeof(ptrdiff_t));
+    FlxTensor_elementwise(ELEM_ASSIGN, t->ndim, t->shape, out->data, out->data, t->data + t->offset, strides);
+    return out;
+}
+
+/// @brief In place: dst = dst `op` src, with src broadcast to dst's shape
+/// @note a src that views dst's data with a different layout (eg., x += x^T) is copied first
+bool FlxTensorF_apply(FlxTensorF *dst, FlxElemOp op, const FlxTensorF *src) {
+    require_not_null(dst);
+    require_not_null(src);
+
+    ptrdiff_t strides[3][TENSOR_MAX_DIMS];
+    if(!FlxTensorF_broadcast_strides(src, dst->ndim, dst->shape, strides[2])) {
+        log_message(LL_ERROR, sMSG("Cannot broadcast rank %zu tensor onto rank %zu tensor."), src->ndim, dst->ndim);
+        return false;
+    }
+
+    const FlxTensorF *source = src;
+    bool same_layout = src->offset == dst->offset && src->ndim == dst->ndim
+        && memcmp(src->strides, dst->strides, src->ndim * sizeof(ptrdiff_t)) == 0;
+    if(src->data == dst->data && !same_layout) {
+        source = FlxTensorF_copy(src);
+        if(source == nullptr) { return false; }
+        FlxTensorF_broadcast_strides(source, dst->ndim, dst->shape, strides[2]);
+    }
+
+    memcpy(strides[0], dst->strides, dst->ndim * sizeof(ptrdiff_t));
+    memcpy(strides[1], dst->strides, dst->ndim * sizeof(ptrdiff_t));
+    double *d = dst->data + dst->offset;
+    FlxTensor_elementwise(op, dst->ndim, dst->shape, d, d, source->data + source->offset, strides);
+    return true;
+}
+
+void FlxTensorF_apply_scalar(FlxTensorF *dst, FlxElemOp op, double value) {
+    require_not_null(dst);
+
+    ptrdiff_t strides[3][TENSOR_MAX_DIMS] = {0};
+    memcpy(strides[0], dst->strides, dst->ndim * sizeof(ptrdiff_t));
+    memcpy(strides[1], dst->strides, dst->ndim * sizeof(ptrdiff_t));
+    double *d = dst->data + dst->offset;
+    FlxTensor_elementwise(op, dst->ndim, dst->shape, d, d, &value, strides);
+}
+
+/// @brief A new tensor of the broadcast shape holding a `op` b, computed in one fused pass
+FlxTensorF *FlxTensorF_binary_new(const FlxTensorF *a, FlxElemOp op, const FlxTensorF *b) {
+    require_not_null(a);
+    require_not_null(b);
+
+    size_t ndim = 0, shape[TENSOR_MAX_DIMS];
+    if(!FlxTensorF_broadcast_shape(a, b, &ndim, shape)) {
+        log_message(LL_ERROR, sMSG("Tensor shapes are not broadcast-compatible."));
+        return nullptr;
+    }
+
+    FlxTensorF *out = FlxTensorF_new(ndim, shape);
+    if(out == nullptr) { return nullptr; }
+
+    ptrdiff_t strides[3][TENSOR_MAX_DIMS];
+    memcpy(strides[0], out->strides, ndim * sizeof(ptrdiff_t));
+    FlxTensorF_broadcast_strides(a, ndim, shape, strides[1]);
+    FlxTensorF_broadcast_strides(b, ndim, shape, strides[2]);
+    FlxTensor_elementwise(op, ndim, shape, out->data, a->data + a->offset, b->data + b->offset, strides);
+    return out;
+}
+
+/// @brief Maps a mutation or binary operator ("=", "+=", "-", ...) onto its kernel op
+bool FlxElemOp_from_FixStr(FixStr op, FlxElemOp *out_op) {
+    if(op.size == 0 || op.size > 2 || (op.size == 2 && op.cstr[1] != '=')) { return false; }
+
+    switch(op.cstr[0]) {
+        case '=': if(op.size != 1) { return false; } *out_op = ELEM_ASSIGN; return true;
+        case '+': *out_op = ELEM_ADD; return true;
+        case '-': *out_op = ELEM_SUB; return true;
+        case '*': *out_op = ELEM_MUL; return true;
+        case '/': *out_op = ELEM_DIV; return true;
+        default: return false;
+    }
+}
+
+FixStr FlxTensorF_to_FixStr(FlxTensorF *t) {
+    FixStr shape = FixStr_fmt_new(s("%zu"), t->shape[0]);
+    for(size_t k = 1; k < t->ndim; k++) {
+        shape = FixStr_glue_sep_new(shape, s("x"), FixStr_fmt_new(s("%zu"), t->shape[k]));
+    }
+
+    /// @note elements are listed flat in logical (row-major) order, truncated for large tensors
+    FixStr repr = FixStr_fmt_new(s("TensorF(%.*s) ["), fmt(shape));
+    size_t index[TENSOR_MAX_DIMS] = {0};
+    size_t shown = t->meta.size < 16 ? t->meta.size : 16;
+    for(size_t i = 0; i < shown; i++) {
+        ptrdiff_t at = (ptrdiff_t) t->offset;
+        for(size_t k = 0; k < t->ndim; k++) { at += (ptrdiff_t) index[k] * t->strides[k]; }
+
+        FixStr item = FixStr_fmt_new(s("%.6f"), t->data[at]);
+        repr = i == 0 ? FixStr_glue_new(repr, item) : FixStr_glue_sep_new(repr, s(", "), item);
+
+        for(size_t k = t->ndim; k-- > 0;) {
+            if(++index[k] < t->shape[k]) { break; }
+            index[k] = 0;
+        }
+    }
+    if(shown < t->meta.size) { repr = FixStr_glue_new(repr, s(", ...")); }
+    return FixStr_glue_new(repr, s("]"));
+}
+
+int FlxTensorF_test_main(void) {
+    size_t shape[3] = {2, 3, 4};
+    FlxTensorF *t = FlxTensorF_new(3, shape);
+    for(size_t i = 0; i < 24; i++) { t->data[i] = (double) i; }
+    log_assert(FlxTensorF_is_contiguous(t), sMSG("Fresh tensor should be contiguous"));
+
+    FlxTensorF *tt = FlxTensorF_transpose(t);
+    log_assert(tt->data == t->data && tt->shape[0] == 4 && tt->shape[2] == 2, sMSG("Transpose should be a view"));
+    log_assert(!FlxTensorF_is_contiguous(tt), sMSG("Transposed view should not be contiguous"));
+
+    FlxTensorF *tc = FlxTensorF_copy(tt);
+    log_assert(tc->data[1] == 12.0 && tc->data[2] == 4.0, sMSG("FlxTensorF_copy of transpose incorrect"));
+
+    /// @note t[:, 1:3, ::-2] -> shape (2, 2, 2), element (0, 0, 0) = t[0, 1, 3] = 7
+    FlxTensorF *s1 = FlxTensorF_slice(t, 1, 1, 3, 1);
+    FlxTensorF *s2 = FlxTensorF_slice(s1, 2, 0, 4, -2);
+    log_assert(s2->meta.size == 8 && s2->data[s2->offset] == 7.0, sMSG("Strided slice view incorrect"));
+
+    /// @note broadcasting a row vector (4,) over (2, 3, 4)
+    size_t row_shape[1] = {4};
+    FlxTensorF *row = FlxTensorF_new(1, row_shape);
+    for(size_t i = 0; i < 4; i++) { row->data[i] = 100.0 * (double) i; }
+    FlxTensorF *sum = FlxTensorF_binary_new(t, ELEM_ADD, row);
+    log_assert(sum != nullptr && sum->data[23] == 323.0 && sum->data[4] == 4.0, sMSG("Broadcast add incorrect"));
+
+    /// @note in-place update through a non-contiguous view only touches the viewed elements
+    FlxTensorF_apply_scalar(s2, ELEM_MUL, -1.0);
+    log_assert(t->data[7] == -7.0 && t->data[5] == -5.0 && t->data[6] == 6.0, sMSG("In-place strided update incorrect"));
+
+    size_t square_shape[2] = {3, 3};
+    FlxTensorF *sq = FlxTensorF_new(2, square_shape);
+    for(size_t i = 0; i < 9; i++) { sq->data[i] = (double) i; }
+    log_assert(FlxTensorF_apply(sq, ELEM_ADD, FlxTensorF_transpose(sq)), sMSG("Aliased apply failed"));
+    log_assert(sq->data[1] == 4.0 && sq->data[3] == 4.0 && sq->data[8] == 16.0, sMSG("x += x^T should read the original x"));
+
+    size_t bad_shape[1] = {3}, out_ndim = 0, out_shape[TENSOR_MAX_DIMS];
+    log_assert(!FlxTensorF_broadcast_shape(t, FlxTensorF_new(1, bad_shape), &out_ndim, out_shape), sMSG("Incompatible broadcast accepted"));
+    return 0;
+}
+
+#pragma endregion
+
+#pragma region BoxHelpersAndErrors
+
+FixArray *CliArgs_to_FixArray(int argc, char **argv) {
+    FixArray *args = FixArray_new_auto(argc);
+    for (int i = 0; i < argc; i++) {
+        Box arg = Box_wrap_BoxedArena(&FixStr_from_cstr(argv[i]));
+        FixArray_append(args, arg);
+    }
+    return args;
+}
+
+/// @note keeps the last ARRAY_SIZE_SMALL errors of the current thread
+FixError *error_push(FixError error) {
+    FixError *slot = &ctx_local().debug.errors[ctx_local().debug.num_errors++ % ARRAY_SIZE_SMALL];
+    *slot = error;
+    return slot;
+}
+
+
+
+void error_print_lastN(size_t n) {
+    size_t num_errors = ctx_local().debug.num_errors;
+    n = n < num_errors ? n : num_errors;
+    n = n < ARRAY_SIZE_SMALL ? n : ARRAY_SIZE_SMALL;
+    for(size_t i = 0; i < n; i++) {
+        error_print(ctx_local().debug.errors[(num_errors - i - 1) % ARRAY_SIZE_SMALL]);
+    }
+}
+
+void error_print(FixError error) {
+    log_message(LL_INFO,  s("Error Code: %d"), error.code);
+    log_message(LL_INFO,  s("Message: %.*s"), fmt(error.message));
+    log_message(LL_INFO,  s("Location: %.*s"), fmt(error.location));
+    if (error.info.user_file.cstr != nullptr) {
+        log_message(LL_INFO,  s("User File: %.*s"), fmt(error.info.user_file));
+        log_message(LL_INFO,  s("User Line: %zu"), error.info.user_line);
+        log_message(LL_INFO,  s("User Column: %zu"), error.info.user_col);
+    }
+}
+
+#pragma endregion
+
+#pragma region NativeStdLibMath
+
+void native_stdlib_math_test_main(void) {}
+
+double sample(FixDist *dist) {
+    return dist->sample_fn_ptr(dist);
+}
+
+
+/// ----- FlxSampleSink ----- ///
+
+static int FixCentroid_cmp(const void *a, const void *b) {
+    double left = ((const FixCentroid *) a)->mean;
+    double right = ((const FixCentroid *) b)->mean;
+    return (left > right) - (left < right);
+}
+
+/// @brief Folds the buffered draws into the centroids (the merging t-digest, Dunning 2019)
+/// @note a centroid may absorb neighbours while its weight stays within 4 N q (1 - q) / delta,
+///     ... so the tails keep small centroids and extreme quantiles stay accurate
+static void FixTDigest_compress(FixTDigest *td) {
+    if(td->num_buffered == 0) { return; }
+
+    FixCentroid merged[TDIGEST_MAX_CENTROIDS + TDIGEST_BUFFER_SIZE];
+    size_t num_merged = td->num_centroids;
+    memcpy(merged, td->centroids, td->num_centroids * sizeof(FixCentroid));
+    for(size_t i = 0; i < td->num_buffered; i++) {
+        merged[num_merged++] = (FixCentroid) {.mean = td->buffer[i], .weight = 1.0};
+    }
+    qsort(merged, num_merged, sizeof(FixCentroid), FixCentroid_cmp);
+
+    double total = td->total_weight + (double) td->num_buffered;
+    double weight_before = 0.0;
+    size_t out = 0;
+    td->centroids[0] = merged[0];
+
+    for(size_t i = 1; i < num_merged; i++) {
+        FixCentroid *current = &td->centroids[out];
+        double proposed = current->weight + merged[i].weight;
+        double q = (weight_before + proposed / 2.0) / total;
+        double limit = 4.0 * total * q * (1.0 - q) / TDIGEST_COMPRESSION;
+
+        if(proposed <= limit || out + 1 == TDIGEST_MAX_CENTROIDS) {
+            current->mean += (merged[i].mean - current->mean) * merged[i].weight / proposed;
+            current->weight = proposed;
+        } else {
+            weight_before += current->weight;
+            td->centroids[++out] = merged[i];
+        }
+    }
+
+    td->num_centroids = out + 1;
+    td->num_buffered = 0;
+    td->total_weight = total;
+}
+
+static void FixTDigest_add(FixTDigest *td, double x) {
+    if(td->total_weight == 0.0 && td->num_buffered == 0) {
+        td->min = x;
+        td->max = x;
+    }
+    td->min = x < td->min ? x : td->min;
+    td->max = x > td->max ? x : td->max;
+
+    td->buffer[td->num_buffered++] = x;
+    if(td->num_buffered == TDIGEST_BUFFER_SIZE) {
+        FixTDigest_compress(td);
+    }
+}
+
+/// @brief Interpolates between centroid centres, and towards min/max in the tails
+static double FixTDigest_quantile(FixTDigest *td, double q) {
+    FixTDigest_compress(td);
+    if(td->num_centroids == 0) { return NAN; }
+    if(q <= 0.0) { return td->min; }
+    if(q >= 1.0) { return td->max; }
+
+    double target = q * td->total_weight;
+    double previous_centre = 0.0;
+    double previous_mean = td->min;
+    double cumulative = 0.0;
+
+    for(size_t i = 0; i < td->num_centroids; i++) {
+        FixCentroid *c = &td->centroids[i];
+        double centre = cumulative + c->weight / 2.0;
+        if(target < centre) {
+            double span = centre - previous_centre;
+            double t = span > 0.0 ? (target - previous_centre) / span : 0.0;
+            return previous_mean + t * (c->mean - previous_mean);
+        }
+        previous_centre = centre;
+        previous_mean = c->mean;
+        cumulative += c->weight;
+    }
+
+    double span = td->total_weight - previous_centre;
+    double t = span > 0.0 ? (target - previous_centre) / span : 1.0;
+    return previous_mean + t * (td->max - previous_mean);
+}
+
+static void FixSampleStats_add(FixSampleStats *st, double x) {
+    if(st->count == 0) { st->shift = x; }
+
+    st->count++;
+    double delta = x - st->mean;
+    st->mean += delta / (double) st->count;
+    st->m2 += delta * (x - st->mean);
+
+    /// @note products at lag k pair this draw with the one k draws back, still in the ring
+    double y = x - st->shift;
+    size_t t = st->count - 1;
+    size_t max_lag = t < SAMPLE_MAX_LAG ? t : SAMPLE_MAX_LAG;
+    st->lag_products[0] += y * y;
+    for(size_t k = 1; k <= max_lag; k++) {
+        st->lag_products[k] += y * st->recent[(t - k) % SAMPLE_MAX_LAG];
+    }
+
+    if(t < SAMPLE_MAX_LAG) { st->head[t] = y; }
+    st->recent[t % SAMPLE_MAX_LAG] = y;
+    st->sum += y;
+
+    FixTDigest_add(&st->digest, x);
+}
+
+FlxSampleSink *FlxSampleSink_new(size_t num_params, const char *spill_path) {
+    require_positive(num_params);
+
+    FlxSampleSink *sink = gco_new(BXD_FLX_SAMPLE_SINK);
+    if(sink == nullptr) { error_oom(); return nullptr; }
+
+    sink->meta.type = BXD_FLX_SAMPLE_SINK;
+    sink->meta.state = LIVING_ALIVE;
+    cnew_carray(sink, num_params);
+    sink->meta.size = num_params;
+    sink->num_params = num_params;
+    sink->num_draws = 0;
+    sink->spill = nullptr;
+
+    if(spill_path != nullptr) {
+        sink->spill = fopen(spill_path, "wb");
+        if(sink->spill == nullptr) {
+            log_message(LL_ERROR, sMSG("FlxSampleSink: cannot open spill file '%s'."), spill_path);
+            cfree(sink->data);
+            Heap_cfree(sink);
+            return nullptr;
+        }
+        setvbuf(sink->spill, nullptr, _IOFBF, SAMPLE_SPILL_BUFFER);
+
+        uint64_t header_params = num_params;
+        fwrite(SAMPLE_SPILL_MAGIC, 1, sizeof(SAMPLE_SPILL_MAGIC) - 1, sink->spill);
+        fwrite(&header_params, sizeof(header_params), 1, sink->spill);
+    }
+    return sink;
+}
+
+bool FlxSampleSink_push(FlxSampleSink *sink, const double *draw) {
+    require_not_null(sink);
+    require_not_null(draw);
+
+    for(size_t p = 0; p < sink->num_params; p++) {
+        FixSampleStats_add(&sink->data[p], draw[p]);
+    }
+    sink->num_draws++;
+
+    if(sink->spill != nullptr) {
+        return fwrite(draw, sizeof(double), sink->num_params, sink->spill) == sink->num_params;
+    }
+    return true;
+}
+
+/// @brief Pushes a draw given as a number, or an array/view of numbers (eg., `[m, c, sigma]`)
+bool FlxSampleSink_push_Box(FlxSampleSink *sink, Box draw) {
+    require_not_null(sink);
+
+    double values[ARRAY_SIZE_SMALL];
+    Box *items = nullptr;
+    size_t num_items = 0;
+
+    if(!Box_as_sequence(draw, &items, &num_items)) {
+        items = &draw;
+        num_items = 1;
+    }
+
+    if(num_items != sink->num_params || num_items > ARRAY_SIZE_SMALL) {
+        log_message(LL_ERROR, sMSG("FlxSampleSink: expected draws of %zu values, got %zu."), sink->num_params, num_items);
+        return false;
+    }
+
+    for(size_t p = 0; p < num_items; p++) {
+        if(!Box_try_numeric(items[p], &values[p])) {
+            log_message(LL_ERROR, sMSG("FlxSampleSink: draws must be numeric."));
+            return false;
+        }
+    }
+    return FlxSampleSink_push(sink, values);
+}
+
+bool FlxSampleSink_close(FlxSampleSink *sink) {
+    require_not_null(sink);
+    if(sink->spill == nullptr) { return true; }
+
+    bool ok = ferror(sink->spill) == 0;
+    ok = (fclose(sink->spill) == 0) && ok;
+    sink->spill = nullptr;
+    return ok;
+}
+
+double FlxSampleSink_mean(FlxSampleSink *sink, size_t param) {
+    require_not_null(sink);
+    require(param < sink->num_params);
+    return sink->data[param].count > 0 ? sink->data[param].mean : NAN;
+}
+
+double FlxSampleSink_variance(FlxSampleSink *sink, size_t param) {
+    require_not_null(sink);
+    require(param < sink->num_params);
+    FixSampleStats *st = &sink->data[param];
+    return st->count > 1 ? st->m2 / (double) (st->count - 1) : NAN;
+}
+
+double FlxSampleSink_quantile(FlxSampleSink *sink, size_t param, double q) {
+    require_not_null(sink);
+    require(param < sink->num_params);
+    return FixTDigest_quantile(&sink->data[param].digest, q);
+}
+
+/// @brief The lag-k sample autocorrelation, exact for k <= SAMPLE_MAX_LAG
+/// @note with y = x - shift, the autocovariance is
+///     ... (S_k - m (A_k + B_k) + (n - k) m^2) / n, where S_k is the lag-k product sum, m the
+///     ... mean of y, A_k the sum of all but the first k values and B_k all but the last k
+double FlxSampleSink_autocorrelation(FlxSampleSink *sink, size_t param, size_t lag) {
+    require_not_null(sink);
+    require(param < sink->num_params);
+
+    FixSampleStats *st = &sink->data[param];
+    size_t n = st->count;
+    if(lag > SAMPLE_MAX_LAG || lag >= n || st->m2 <= 0.0) { return NAN; }
+    if(lag == 0) { return 1.0; }
+
+    double first = 0.0;
+    double last = 0.0;
+    for(size_t i = 0; i < lag; i++) {
+        first += st->head[i];
+        last += st->recent[(n - 1 - i) % SAMPLE_MAX_LAG];
+    }
+
+    double m = st->sum / (double) n;
+    double rest = (double) (n - lag);
+    double covariance = (st->lag_products[lag] - m * ((st->sum - first) + (st->sum - last)) + rest * m * m) / (double) n;
+    return covariance / (st->m2 / (double) n);
+}
+
+/// @brief n / (1 + 2 sum rho_k), summing autocorrelation pairs while they stay positive (Geyer)
+double FlxSampleSink_effective_size(FlxSampleSink *sink, size_t param) {
+    require_not_null(sink);
+    require(param < sink->num_params);
+
+    size_t n = sink->data[param].count;
+    if(n < 2 || sink->data[param].m2 <= 0.0) { return (double) n; }
+
+    double rho_sum = 0.0;
+    for(size_t k = 1; k + 1 <= SAMPLE_MAX_LAG && k + 1 < n; k += 2) {
+        double pair = FlxSampleSink_autocorrelation(sink, param, k) + FlxSampleSink_autocorrelation(sink, param, k + 1);
+        if(!(pair > 0.0)) { break; }
+        rho_sum += pair;
+    }
+
+    double ess = (double) n / (1.0 + 2.0 * rho_sum);
+    return ess < (double) n ? ess : (double) n;
+}
+
+/// @brief Loads a spill file as a (draws x params) matrix
+FlxMatrixF *FlxSampleSink_read_spill(const char *path) {
+    require_not_null(path);
+
+    FILE *file = fopen(path, "rb");
+    if(file == nullptr) {
+        log_message(LL_ERROR, sMSG("FlxSampleSink: cannot open spill file '%s'."), path);
+        return nullptr;
+    }
+
+    char magic[sizeof(SAMPLE_SPILL_MAGIC) - 1];
+    uint64_t num_params = 0;
+    bool ok = fread(magic, 1, sizeof(magic), file) == sizeof(magic)
+        && memcmp(magic, SAMPLE_SPILL_MAGIC, sizeof(magic)) == 0
+        && fread(&num_params, sizeof(num_params), 1, file) == 1
+        && num_params > 0;
+
+    long data_start = ftell(file);
+    fseek(file, 0, SEEK_END);
+    size_t num_draws = ok ? (size_t) (ftell(file) - data_start) / (num_params * sizeof(double)) : 0;
+    fseek(file, data_start, SEEK_SET);
+
+    FlxMatrixF *draws = (ok && num_draws > 0) ? FlxMatrixF_new(num_draws, num_params) : nullptr;
+    if(draws != nullptr) {
+        ok = fread(draws->data, sizeof(double), num_draws * num_params, file) == num_draws * num_params;
+    }
+    fclose(file);
+
+    if(!ok || draws == nullptr) {
+        log_message(LL_ERROR, sMSG("FlxSampleSink: '%s' is not a readable spill file."), path);
+        return nullptr;
+    }
+    return draws;
+}
+
+FixStr FlxSampleSink_to_FixStr(FlxSampleSink *sink) {
+    FixStr repr = FixStr_fmt_new(s("SampleSink(%zu draws)\n  param        mean          sd          5%%         50%%         95%%         ess"),
+        sink->num_draws);
+
+    for(size_t p = 0; p < sink->num_params; p++) {
+        FixStr row = FixStr_fmt_new(s("  %5zu %11.4g %11.4g %11.4g %11.4g %11.4g %11.1f"), p,
+            FlxSampleSink_mean(sink, p), sqrt(FlxSampleSink_variance(sink, p)),
+            FlxSampleSink_quantile(sink, p, 0.05), FlxSampleSink_quantile(sink, p, 0.5),
+            FlxSampleSink_quantile(sink, p, 0.95), FlxSampleSink_effective_size(sink, p));
+        repr = FixStr_glue_sep_new(repr, s("\n"), row);
+    }
+    return repr;
+}
+
+
+/// ----- FlxParticles ----- ///
+
+/// @brief A particle range of an SMC kernel or scan, run on one compute thread
+typedef struct FlxSmcTask {
+    FlxParticles *particles;
+    size_t start;
+    size_t end;
+    FlxParticleKernel kernel;
+    void *user;
+    double max;          /// max log weight: of the chunk, then of all particles
+    double total;        /// sum of exp(lw - max) over the chunk
+    double sum_squares;
+    double offset;       /// exclusive prefix of the chunk totals
+    double scale;        /// 1 / grand total
+    double u;
+    bool ended;          /// a model stream of the chunk ran out
+    bool failed;         /// ... or raised `error`
+    FixError error;
+} FlxSmcTask;
+
+/// @brief Runs `worker` over `tasks` on the compute pool (inline when there is one)
+static void FlxSmc_run_tasks(FlxSmcTask *tasks, size_t num_tasks, void *(*worker)(void *)) {
+    TaskPool_run(tasks, sizeof(FlxSmcTask), num_tasks, worker);
+}
+
+/// @brief Splits the particles into contiguous per-thread chunks (one below `min_particles`),
+///     ... returning the task count
+static size_t FlxSmc_split(FlxSmcTask *tasks, FlxParticles *particles, size_t min_particles) {
+    size_t n = particles->num_particles;
+    size_t num_tasks = n < min_particles ? 1 : TaskPool_num_workers();
+    size_t step = (n + num_tasks - 1) / num_tasks;
+
+    for(size_t t = 0; t < num_tasks; t++) {
+        tasks[t] = (FlxSmcTask) {
+            .particles = particles,
+            .start = t * step < n ? t * step : n,
+            .end = (t + 1) * step < n ? (t + 1) * step : n,
+        };
+    }
+    return num_tasks;
+}
+
+FlxParticles *FlxParticles_new(size_t num_particles, size_t num_params) {
+    require_positive(num_particles);
+
+    FlxParticles *particles = gco_new(BXD_FLX_PARTICLES);
+    if(particles == nullptr) { error_oom(); return nullptr; }
+
+    particles->meta.type = BXD_FLX_PARTICLES;
+    particles->meta.state = LIVING_ALIVE;
+    particles->meta.size = num_particles;
+    particles->num_particles = num_particles;
+    particles->num_params = 0;
+    particles->data = nullptr;
+    particles->scratch = nullptr;
+    particles->streams = nullptr;
+    particles->values = nullptr;
+    particles->cursor = num_particles;
+    particles->ess = (double) num_particles;
+    particles->log_evidence = 0.0;
+    particles->log_total = log((double) num_particles);
+    particles->num_steps = 0;
+    particles->num_resamples = 0;
+
+    /// @note the per-particle arrays share one block: weights, prefix sums, then ancestors
+    size_t block_size = num_particles * (2 * sizeof(double) + sizeof(size_t));
+    particles->log_weights = cnew(block_size);
+    if(particles->log_weights == nullptr) { error_oom(); return nullptr; }
+    memset(particles->log_weights, 0, block_size);
+    particles->cumulative = particles->log_weights + num_particles;
+    particles->ancestors = (size_t *) (particles->cumulative + num_particles);
+
+    if(num_params > 0 && !FlxParticles_reserve(particles, num_params)) { return nullptr; }
+    return particles;
+}
+
+/// @brief Allocates the value columns (and their gather target) for `num_params` parameters
+bool FlxParticles_reserve(FlxParticles *particles, size_t num_params) {
+    require_not_null(particles);
+    require_positive(num_params);
+    require(particles->data == nullptr);
+
+    size_t column_size = particles->num_particles * num_params * sizeof(double);
+    particles->data = cnew(2 * column_size);
+    if(particles->data == nullptr) { error_oom(); return false; }
+    memset(particles->data, 0, 2 * column_size);
+
+    particles->scratch = particles->data + particles->num_particles * num_params;
+    particles->num_params = num_params;
+    return true;
+}
+
+/// @brief Allocates each particle's model stream and latest value, for interpreted models
+static bool FlxParticles_reserve_streams(FlxParticles *particles) {
+    size_t n = particles->num_particles;
+    particles->streams = cnew(3 * n * sizeof(Box));
+    if(particles->streams == nullptr) { error_oom(); return false; }
+
+    for(size_t i = 0; i < 3 * n; i++) { particles->streams[i] = Box_null(); }
+    particles->values = particles->streams + n;
+    return true;
+}
+
+static void *FlxParticles_propagate_worker(void *arg) {
+    FlxSmcTask *task = (FlxSmcTask *) arg;
+    task->kernel(task->particles, task->start, task->end, task->user);
+    return nullptr;
+}
+
+/// @brief Advances every particle with a native kernel, chunks spread across compute threads
+void FlxParticles_propagate(FlxParticles *particles, FlxParticleKernel kernel, void *user) {
+    require_not_null(particles);
+    require_not_null(kernel);
+
+    FlxSmcTask tasks[CPU_CORES_MAX] = {0};
+    size_t num_tasks = FlxSmc_split(tasks, particles, SMC_PARALLEL_MIN_PARTICLES);
+    for(size_t t = 0; t < num_tasks; t++) {
+        tasks[t].kernel = kernel;
+        tasks[t].user = user;
+    }
+    FlxSmc_run_tasks(tasks, num_tasks, FlxParticles_propagate_worker);
+    particles->num_steps++;
+}
+
+static void *FlxParticles_max_worker(void *arg) {
+    FlxSmcTask *task = (FlxSmcTask *) arg;
+    const double *lw = task->particles->log_weights;
+
+    double max = -INFINITY;
+    for(size_t i = task->start; i < task->end; i++) {
+        if(lw[i] > max) { max = lw[i]; }
+    }
+    task->max = max;
+    return nullptr;
+}
+
+/// @note phase one of the prefix sum: each chunk scans its own weights from zero
+static void *FlxParticles_scan_worker(void *arg) {
+    FlxSmcTask *task = (FlxSmcTask *) arg;
+    const double *lw = task->particles->log_weights;
+    double *cumulative = task->particles->cumulative;
+
+    double total = 0.0, sum_squares = 0.0;
+    for(size_t i = task->start; i < task->end; i++) {
+        double w = exp(lw[i] - task->max);
+        total += w;
+        sum_squares += w * w;
+        cumulative[i] = total;
+    }
+    task->total = total;
+    task->sum_squares = sum_squares;
+    return nullptr;
+}
+
+/// @note phase two: shift each chunk by the totals before it and normalise
+static void *FlxParticles_offset_worker(void *arg) {
+    FlxSmcTask *task = (FlxSmcTask *) arg;
+    double *cumulative = task->particles->cumulative;
+
+    for(size_t i = task->start; i < task->end; i++) {
+        cumulative[i] = (cumulative[i] + task->offset) * task->scale;
+    }
+    return nullptr;
+}
+
+/// @brief Scans the weights into normalised prefix sums, returning the effective sample size
+/// @note a two-phase parallel scan: chunk-local sums, a serial scan over the (per-worker) chunk
+///     ... totals, then a parallel offset; also accumulates the log marginal likelihood
+double FlxParticles_normalise(FlxParticles *particles) {
+    require_not_null(particles);
+
+    FlxSmcTask tasks[CPU_CORES_MAX] = {0};
+    size_t num_tasks = FlxSmc_split(tasks, particles, SMC_PARALLEL_MIN_PARTICLES);
+
+    FlxSmc_run_tasks(tasks, num_tasks, FlxParticles_max_worker);
+    double max = -INFINITY;
+    for(size_t t = 0; t < num_tasks; t++) {
+        if(tasks[t].max > max) { max = tasks[t].max; }
+    }
+    if(max == -INFINITY) {
+        log_message(LL_ERROR, sMSG("FlxParticles: every particle has zero weight."));
+        return 0.0;
+    }
+
+    for(size_t t = 0; t < num_tasks; t++) { tasks[t].max = max; }
+    FlxSmc_run_tasks(tasks, num_tasks, FlxParticles_scan_worker);
+
+    double total = 0.0, sum_squares = 0.0;
+    for(size_t t = 0; t < num_tasks; t++) {
+        tasks[t].offset = total;
+        total += tasks[t].total;
+        sum_squares += tasks[t].sum_squares;
+    }
+    for(size_t t = 0; t < num_tasks; t++) { tasks[t].scale = 1.0 / total; }
+    FlxSmc_run_tasks(tasks, num_tasks, FlxParticles_offset_worker);
+    particles->cumulative[particles->num_particles - 1] = 1.0;
+
+    double log_total = max + log(total);
+    particles->log_evidence += log_total - particles->log_total;
+    particles->log_total = log_total;
+    particles->ess = (total * total) / sum_squares;
+    return particles->ess;
+}
+
+/// @note the chunk's first point is found by binary search, the rest by a merge-style walk
+static void *FlxParticles_systematic_worker(void *arg) {
+    FlxSmcTask *task = (FlxSmcTask *) arg;
+    size_t n = task->particles->num_particles;
+    const double *cumulative = task->particles->cumulative;
+    size_t *ancestors = task->particles->ancestors;
+
+    if(task->start >= task->end) { return nullptr; }
+
+    double point = (task->u + (double) task->start) / (double) n;
+    size_t lo = 0, hi = n - 1;
+    while(lo < hi) {
+        size_t mid = lo + (hi - lo) / 2;
+        if(cumulative[mid] > point) { hi = mid; } else { lo = mid + 1; }
+    }
+
+    size_t j = lo;
+    for(size_t i = task->start; i < task->end; i++) {
+        point = (task->u + (double) i) / (double) n;
+        while(j < n - 1 && cumulative[j] <= point) { j++; }
+        ancestors[i] = j;
+    }
+    return nullptr;
+}
+
+/// @brief Systematic resampling: ancestors of the points (u + i) / N, for u in [0, 1)
+/// @note requires FlxParticles_normalise; ancestors come out sorted
+void FlxParticles_systematic(FlxParticles *particles, double u) {
+    require_not_null(particles);
+    require(u >= 0.0 && u < 1.0);
+
+    FlxSmcTask tasks[CPU_CORES_MAX] = {0};
+    size_t num_tasks = FlxSmc_split(tasks, particles, SMC_PARALLEL_MIN_PARTICLES);
+    for(size_t t = 0; t < num_tasks; t++) { tasks[t].u = u; }
+    FlxSmc_run_tasks(tasks, num_tasks, FlxParticles_systematic_worker);
+}
+
+static void *FlxParticles_gather_worker(void *arg) {
+    FlxSmcTask *task = (FlxSmcTask *) arg;
+    FlxParticles *particles = task->particles;
+    size_t n = particles->num_particles;
+
+    for(size_t p = 0; p < particles->num_params; p++) {
+        const double *from = particles->data + p * n;
+        double *to = particles->scratch + p * n;
+        for(size_t i = task->start; i < task->end; i++) {
+            to[i] = from[particles->ancestors[i]];
+        }
+    }
+    for(size_t i = task->start; i < task->end; i++) {
+        particles->log_weights[i] = 0.0;
+    }
+    return nullptr;
+}
+
+/// @brief Replaces each particle by its ancestor, leaving the particles equally weighted
+/// @note requires FlxParticles_systematic; value columns are gathered in parallel, while
+///     ... interpreted model streams are copied serially (copying allocates)
+void FlxParticles_resample(FlxParticles *particles) {
+    require_not_null(particles);
+
+    size_t n = particles->num_particles;
+    if(particles->streams != nullptr) {
+        Box *next = particles->values + n;
+        for(size_t i = 0; i < n; i++) {
+            size_t a = particles->ancestors[i];
+            bool first_child = i == 0 || particles->ancestors[i - 1] != a;
+            next[i] = particles->streams[a];
+            if(!first_child && (Box_is_Boxed_type(next[i], BXD_FIX_ITER))) {
+                FixIter *copy = FixIter_clone(Box_unwrap_FixIter(next[i]));
+                next[i] = copy == nullptr ? Box_null() : Box_wrap_BoxedArena(copy);
+            }
+        }
+        memcpy(particles->streams, next, n * sizeof(Box));
+
+        for(size_t i = 0; i < n; i++) { next[i] = particles->values[particles->ancestors[i]]; }
+        memcpy(particles->values, next, n * sizeof(Box));
+    }
+
+    FlxSmcTask tasks[CPU_CORES_MAX] = {0};
+    size_t num_tasks = FlxSmc_split(tasks, particles, SMC_PARALLEL_MIN_PARTICLES);
+    FlxSmc_run_tasks(tasks, num_tasks, FlxParticles_gather_worker);
+
+    double *swap = particles->data;
+    particles->data = particles->scratch;
+    particles->scratch = swap;
+    particles->log_total = log((double) n);
+    particles->num_resamples++;
+}
+
+/// @brief The numbers a particle's value carries: itself, or the elements of an array or view
+static size_t FlxParticles_value_items(Box *value, Box **items) {
+    size_t num_items = 1;
+    double number;
+    *items = value;
+    if(!Box_try_numeric(*value, &number)) { Box_as_sequence(*value, items, &num_items); }
+    return num_items;
+}
+
+/// @brief Runs the model streams of a chunk of particles once each, weighting each particle
+///     ... by what its run observed
+/// @note observe() weights the running thread's InterpContext, read after each run; an
+///     ... error stops the chunk and is raised again on the calling thread (cf. FlxParticles_pull)
+static void *FlxParticles_pull_worker(void *arg) {
+    FlxSmcTask *task = (FlxSmcTask *) arg;
+    FlxParticles *particles = task->particles;
+
+    InterpRecover point;
+    interp_try(&point) {
+        for(size_t i = task->start; i < task->end; i++) {
+            ctx_local().inference.log_weight = 0.0;
+            ctx_local().inference.num_observed = 0;
+
+            Box value;
+            Box stream = particles->streams[i];
+            if(!(Box_is_Boxed_type(stream, BXD_FIX_ITER)) || !FixIter_next(Box_unwrap_FixIter(stream), &value)) {
+                task->ended = true;
+                break;
+            }
+            particles->log_weights[i] += ctx_local().inference.log_weight;
+            particles->values[i] = value;
+        }
+        interp_try_end(&point);
+        return nullptr;
+    }
+
+    size_t num_errors = ctx_local().debug.num_errors;
+    task->failed = true;
+    if(num_errors > 0) { task->error = ctx_local().debug.errors[(num_errors - 1) % ARRAY_SIZE_SMALL]; }
+    return nullptr;
+}
+
+/// @brief Copies the latest values of a chunk of particles into their parameter columns
+static void *FlxParticles_store_worker(void *arg) {
+    FlxSmcTask *task = (FlxSmcTask *) arg;
+    FlxParticles *particles = task->particles;
+    size_t n = particles->num_particles;
+
+    for(size_t i = task->start; i < task->end; i++) {
+        Box *items;
+        size_t num_items = FlxParticles_value_items(&particles->values[i], &items);
+        for(size_t p = 0; p < particles->num_params; p++) {
+            double x = NAN;
+            if(p < num_items) { Box_try_numeric(items[p], &x); }
+            particles->data[p * n + i] = x;
+        }
+    }
+    return nullptr;
+}
+
+/// @brief Runs each particle's model stream once, chunks spread across compute threads
+/// @note a model error in any chunk unwinds from here, as if the pulls had run serially
+static bool FlxParticles_pull(FlxParticles *particles) {
+    ctx().inference.step++;
+
+    FlxSmcTask tasks[CPU_CORES_MAX] = {0};
+    size_t num_tasks = FlxSmc_split(tasks, particles, SMC_PARALLEL_MIN_PULLS);
+    FlxSmc_run_tasks(tasks, num_tasks, FlxParticles_pull_worker);
+
+    bool ended = false;
+    for(size_t t = 0; t < num_tasks; t++) {
+        if(tasks[t].failed) {
+            size_t num_errors = ctx_local().debug.num_errors;
+            bool logged = num_errors > 0 &&
+                ctx_local().debug.errors[(num_errors - 1) % ARRAY_SIZE_SMALL].message.cstr == tasks[t].error.message.cstr;
+            if(!logged && tasks[t].error.message.cstr != nullptr) { error_push(tasks[t].error); }
+            interp_graceful_exit();
+        }
+        ended |= tasks[t].ended;
+    }
+    if(ended) { return false; }
+
+    if(particles->data == nullptr) {
+        Box *items;
+        size_t num_items = FlxParticles_value_items(&particles->values[0], &items);
+        if(!FlxParticles_reserve(particles, num_items > 0 ? num_items : 1)) { return false; }
+    }
+    FlxSmc_run_tasks(tasks, num_tasks, FlxParticles_store_worker);
+
+    particles->num_steps++;
+    return true;
+}
+
+/// @brief Posterior draws of a time-series model: each pull hands out one of the N equally
+///     ... weighted (resampled) particles of the current step, stepping all particles when spent
+/// @note particles are resampled lazily, at the next step, once the ESS falls below the threshold
+static bool FixIter_smc_next(FixIter *iter, Box *out) {
+    if(iter->iter_index >= iter->iter_to) { return false; }
+
+    FlxParticles *particles = Box_unwrap_typed_ptr(FlxParticles, iter->iter_state);
+    size_t n = particles->num_particles;
+
+    if(particles->cursor >= n) {
+        if(particles->num_steps > 0 && particles->ess < SMC_RESAMPLE_THRESHOLD * (double) n) {
+            FlxParticles_resample(particles);
+        }
+        if(!FlxParticles_pull(particles)) { return false; }
+        if(FlxParticles_normalise(particles) <= 0.0) { return false; }
+        FlxParticles_systematic(particles, InterpContext_random());
+        particles->cursor = 0;
+    }
+
+    *out = particles->values[particles->ancestors[particles->cursor++]];
+    iter->iter_index++;
+    return true;
+}
+
+/// @brief A stream of SMC draws, running `num_particles` independent copies of `model`
+FixIter *FixIter_smc_new(FixIter *model, size_t num_particles) {
+    require_not_null(model);
+    require_positive(num_particles);
+
+    FlxParticles *particles = FlxParticles_new(num_particles, 0);
+    if(particles == nullptr || !FlxParticles_reserve_streams(particles)) { return nullptr; }
+
+    particles->streams[0] = Box_wrap_BoxedArena(model);
+    for(size_t i = 1; i < num_particles; i++) {
+        FixIter *copy = FixIter_clone(model);
+        if(copy == nullptr) { return nullptr; }
+        particles->streams[i] = Box_wrap_BoxedArena(copy);
+    }
+
+    FixIter *iter = FixIter_new(FixIter_smc_next, SIZE_MAX);
+    if(iter == nullptr) { return nullptr; }
+    iter->iter_state = Box_wrap_BoxedHeap(particles);
+    return iter;
+}
+
+FixStr FlxParticles_to_FixStr(FlxParticles *particles) {
+    return FixStr_fmt_new(s("Particles(%zu x %zu params, step %zu, ess %.1f, log Z %.4g, %zu resamples)"),
+        particles->num_particles, particles->num_params, particles->num_steps,
+        particles->ess, particles->log_evidence, particles->num_resamples);
+}
+
+
+/**
+ * Initializes a probabilistic model with default or specified parameters.
+ *
+ * @param model   Pointer to the Model structure representing the probabilistic model.
+ * @param method  The inference algorithm to use (e.g., MCMC).
+ * @return        Pointer to an FixInferResult whose sink summarises the posterior draws.
+ * @note          memory is constant in model->num_target_samples: draws are streamed into the sink
+ */
+FixInferResult *FixInferResult_new(const FixInferModel *model, InferMethod method) {
+    FixInferResult *result = Arena_alloc(sizeof(FixInferResult));
+    if (!result) {  error_oom(); return nullptr; }
+
+    result->sink = FlxSampleSink_new(model->num_params, nullptr);
+    if (!result->sink) { return nullptr; }
+
+    result->location = Arena_alloc(2 * model->num_params * sizeof(double));
+    if (!result->location) {  error_oom(); return nullptr; }
+    memset(result->location, 0, 2 * model->num_params * sizeof(double));
+    result->scale = method == INFERENCE_VI ? result->location + model->num_params : nullptr;
+    result->objective = -INFINITY;
+    result->iterations = 0;
+    result->converged = false;
+
+    return result;
+}
+
+int FlxSampleSink_test_main(void) {
+    enum { NUM_DRAWS = 20000 };
+    static double xs[NUM_DRAWS];
+
+    /// AR(1) draws, x[t] = 0.5 x[t-1] + u, from a fixed xorshift stream
+    uint64_t state = 88172645463325252ull;
+    double previous = 0.0;
+    for(size_t t = 0; t < NUM_DRAWS; t++) {
+        state ^= state << 13; state ^= state >> 7; state ^= state << 17;
+        double u = (double) (state >> 11) / 9007199254740992.0 - 0.5;
+        xs[t] = 10.0 + 0.5 * previous + u;
+        previous = xs[t] - 10.0;
+    }
+
+    /// @note a unique file, so concurrent test runs never share a spill
+    char path[] = "/tmp/doubt_sample_sink_XXXXXX";
+    int spill_fd = mkstemp(path);
+    log_assert(spill_fd >= 0, sMSG("Could not create a spill file"));
+    close(spill_fd);
+
+    FlxSampleSink *sink = FlxSampleSink_new(2, path);
+    log_assert(sink != nullptr, sMSG("FlxSampleSink_new failed"));
+
+    size_t arena_used = ctx_current_arena()->used;
+    for(size_t t = 0; t < NUM_DRAWS; t++) {
+        double draw[2] = { xs[t], (double) t };
+        FlxSampleSink_push(sink, draw);
+    }
+    log_assert(ctx_current_arena()->used == arena_used, sMSG("Pushing draws should not allocate"));
+    log_assert(FlxSampleSink_close(sink), sMSG("Closing the spill file failed"));
+
+    double mean = 0.0;
+    for(size_t t = 0; t < NUM_DRAWS; t++) { mean += xs[t]; }
+    mean /= NUM_DRAWS;
+    double c0 = 0.0, c1 = 0.0, c5 = 0.0;
+    for(size_t t = 0; t < NUM_DRAWS; t++) {
+        c0 += (xs[t] - mean) * (xs[t] - mean);
+        if(t >= 1) { c1 += (xs[t] - mean) * (xs[t - 1] - mean); }
+        if(t >= 5) { c5 += (xs[t] - mean) * (xs[t - 5] - mean); }
+    }
+
+    log_assert(fabs(FlxSampleSink_mean(sink, 0) - mean) < 1e-9, sMSG("Welford mean should match"));
+    log_assert(fabs(FlxSampleSink_variance(sink, 0) - c0 / (NUM_DRAWS - 1)) < 1e-9, sMSG("Welford variance should match"));
+    log_assert(fabs(FlxSampleSink_autocorrelation(sink, 0, 1) - c1 / c0) < 1e-9, sMSG("Lag-1 autocorrelation should be exact"));
+    log_assert(fabs(FlxSampleSink_autocorrelation(sink, 0, 5) - c5 / c0) < 1e-9, sMSG("Lag-5 autocorrelation should be exact"));
+    log_assert(fabs(FlxSampleSink_autocorrelation(sink, 0, 1) - 0.5) < 0.05, sMSG("AR(1) lag-1 autocorrelation should be near 0.5"));
+    log_assert(FlxSampleSink_effective_size(sink, 0) < 0.5 * NUM_DRAWS, sMSG("Correlated draws should have a smaller effective size"));
+
+    double median = FlxSampleSink_quantile(sink, 1, 0.5);
+    double tail = FlxSampleSink_quantile(sink, 1, 0.99);
+    log_assert(fabs(median - 0.5 * NUM_DRAWS) < 0.01 * NUM_DRAWS, sMSG("t-digest median should be within 1%%"));
+    log_assert(fabs(tail - 0.99 * NUM_DRAWS) < 0.002 * NUM_DRAWS, sMSG("t-digest tails should be tighter"));
+    log_assert(FlxSampleSink_quantile(sink, 1, 1.0) == NUM_DRAWS - 1, sMSG("q = 1 should be the maximum"));
+
+    FlxMatrixF *spilled = FlxSampleSink_read_spill(path);
+    log_assert(spilled != nullptr && spilled->rows == NUM_DRAWS && spilled->columns == 2, sMSG("Spill should hold every draw"));
+    log_assert(spilled->data[2 * 1234] == xs[1234] && spilled->data[2 * 1234 + 1] == 1234.0, sMSG("Spilled rows should round-trip"));
+    unlink(path);
+    return 0;
+}
+
+/// @note test kernel: particle i takes value i; odd particles are ruled out by their weight
+static void FlxParticles_test_kernel(FlxParticles *particles, size_t start, size_t end, void *user) {
+    for(size_t i = start; i < end; i++) {
+        particles->data[i] = (double) i;
+        particles->log_weights[i] += (i % 2 == 0) ? 0.0 : -INFINITY;
+    }
+}
+
+int FlxParticles_test_main(void) {
+    /// serial: weights 1, 3, 0, 4 scan to 1/8, 4/8, 4/8, 1
+    FlxParticles *small = FlxParticles_new(4, 1);
+    log_assert(small != nullptr, sMSG("FlxParticles_new failed"));
+    double weights[4] = { 1.0, 3.0, 0.0, 4.0 };
+    for(size_t i = 0; i < 4; i++) {
+        small->data[i] = 10.0 * (double) i;
+        small->log_weights[i] = log(weights[i]);
+    }
+
+    double ess = FlxParticles_normalise(small);
+    log_assert(fabs(ess - 64.0 / 26.0) < 1e-12, sMSG("ESS should be (sum w)^2 / sum w^2"));
+    log_assert(fabs(small->cumulative[0] - 0.125) < 1e-12 && fabs(small->cumulative[1] - 0.5) < 1e-12
+        && fabs(small->cumulative[2] - 0.5) < 1e-12 && small->cumulative[3] == 1.0, sMSG("Prefix sums should be normalised"));
+    log_assert(fabs(small->log_evidence - log(8.0 / 4.0)) < 1e-12, sMSG("log Z should be the log mean weight"));
+
+    /// points 0.125, 0.375, 0.625, 0.875 land on particles 1, 1, 3, 3
+    FlxParticles_systematic(small, 0.5);
+    log_assert(small->ancestors[0] == 1 && small->ancestors[1] == 1 && small->ancestors[2] == 3 && small->ancestors[3] == 3,
+        sMSG("Systematic ancestors should follow the weights"));
+
+    FlxParticles_resample(small);
+    log_assert(small->data[0] == 10.0 && small->data[2] == 30.0 && small->log_weights[1] == 0.0,
+        sMSG("Resampling should gather values and reset weights"));
+
+    /// parallel: enough particles to split the kernel, scan and gather across threads
+    enum { NUM_PARTICLES = 2 * SMC_PARALLEL_MIN_PARTICLES + 3 };
+    FlxParticles *particles = FlxParticles_new(NUM_PARTICLES, 1);
+    log_assert(particles != nullptr, sMSG("FlxParticles_new failed"));
+
+    FlxParticles_propagate(particles, FlxParticles_test_kernel, nullptr);
+    ess = FlxParticles_normalise(particles);
+    log_assert(fabs(ess - (NUM_PARTICLES + 1) / 2) < 1e-6, sMSG("Half the particles should be effective"));
+    log_assert(fabs(particles->cumulative[NUM_PARTICLES / 2] - (double) (NUM_PARTICLES / 4 + 1) / ((NUM_PARTICLES + 1) / 2)) < 1e-9,
+        sMSG("Chunk offsets should carry across threads"));
+
+    FlxParticles_systematic(particles, 0.25);
+    bool sorted_and_even = true;
+    for(size_t i = 0; i < NUM_PARTICLES; i++) {
+        sorted_and_even &= particles->ancestors[i] % 2 == 0;
+        sorted_and_even &= i == 0 || particles->ancestors[i] >= particles->ancestors[i - 1];
+    }
+    log_assert(sorted_and_even, sMSG("Ancestors should be sorted and never zero-weight"));
+
+    FlxParticles_resample(particles);
+    bool gathered = true;
+    for(size_t i = 0; i < NUM_PARTICLES; i++) {
+        gathered &= particles->data[i] == (double) particles->ancestors[i];
+    }
+    log_assert(gathered && particles->num_resamples == 1, sMSG("Resampled values should be the ancestors'"));
+
+    /// interpreted: each particle runs its own copy of the model stream, one step per round
+    FixIter *smc = FixIter_smc_new(FixIter_range_new(1, 3, 1), 4);
+    log_assert(smc != nullptr, sMSG("FixIter_smc_new failed"));
+    Box draw;
+    for(int64_t step = 1; step <= 3; step++) {
+        for(size_t i = 0; i < 4; i++) {
+            log_assert(FixIter_next(smc, &draw) && Box_unwrap_int(draw) == step, sMSG("Each round should step every particle"));
+        }
+    }
+    log_assert(!FixIter_next(smc, &draw), sMSG("The draws should end with the model stream"));
+
+    /// ... and enough particles to pull their streams in chunks across threads
+    log_assert(TaskPool_start(4), sMSG("The pool should start"));
+    enum { NUM_PULLED = 2 * SMC_PARALLEL_MIN_PULLS + 3 };
+    smc = FixIter_smc_new(FixIter_range_new(1, 2, 1), NUM_PULLED);
+    log_assert(smc != nullptr, sMSG("FixIter_smc_new failed"));
+    for(int64_t step = 1; step <= 2; step++) {
+        bool stepped = true;
+        for(size_t i = 0; i < NUM_PULLED; i++) {
+            stepped &= FixIter_next(smc, &draw) && Box_unwrap_int(draw) == step;
+        }
+        log_assert(stepped, sMSG("Each round should step every particle, whichever thread pulled it"));
+    }
+    FlxParticles *pulled = Box_unwrap_typed_ptr(FlxParticles, smc->iter_state);
+    log_assert(pulled->num_params == 1 && pulled->data[NUM_PULLED - 1] == 2.0, sMSG("Pulled values should fill the columns"));
+    log_assert(!FixIter_next(smc, &draw), sMSG("The draws should end with the model stream"));
+    return 0;
+}
+
+
+int FixInfer_test_main(void) {
+    enum { NUM_DATA = 3 * INFER_PARALLEL_MIN_DATA };
+    static double data[NUM_DATA];
+
+    /// N(3, 2) data from a fixed xorshift stream (Box-Muller)
+    uint64_t state = 88172645463325252ull;
+    double mean = 0.0, m2 = 0.0;
+    for(size_t i = 0; i < NUM_DATA; i++) {
+        double u[2];
+        for(size_t k = 0; k < 2; k++) {
+            state ^= state << 13; state ^= state >> 7; state ^= state << 17;
+            u[k] = ((double) (state >> 11) + 0.5) / 9007199254740992.0;
+        }
+        data[i] = 3.0 + 2.0 * sqrt(-2.0 * log(u[0])) * cos(2.0 * M_PI * u[1]);
+        double delta = data[i] - mean;
+        mean += delta / (double) (i + 1);
+        m2 += delta * (data[i] - mean);
+    }
+    double sd = sqrt(m2 / NUM_DATA);
+
+    double location_prior_params[2] = { 0.0, 10.0 };
+    double scale_prior_params[2] = { 2.0, 0.5 };
+    FixDist location_prior = { .type = DIST_NORMAL, .num_params = 2, .params = location_prior_params,
+        .log_pdf_fn_ptr = FixDist_normal_log_pdf };
+    FixDist scale_prior = { .type = DIST_GAMMA, .num_params = 2, .params = scale_prior_params,
+        .log_pdf_fn_ptr = FixDist_gamma_log_pdf };
+    FixDist likelihood = { .type = DIST_NORMAL, .num_params = 2, .log_pdf_fn_ptr = FixDist_normal_log_pdf };
+    FixDist *priors[2] = { &location_prior, &scale_prior };
+
+    FixInferModel model = {
+        .priors = priors, .likelihood = &likelihood, .params = nullptr, .num_params = 2,
+        .data = data, .num_data = NUM_DATA, .num_target_samples = 1000
+    };
+
+    /// the parallel log joint agrees with a serial sum
+    double zeta[2] = { 1.0, log(1.5) };
+    double theta[2] = { 1.0, 1.5 };
+    likelihood.params = theta;
+    double serial = FixDist_normal_log_pdf(&location_prior, 1.0) + FixDist_gamma_log_pdf(&scale_prior, 1.5) + log(1.5);
+    for(size_t i = 0; i < NUM_DATA; i++) { serial += FixDist_normal_log_pdf(&likelihood, data[i]); }
+    likelihood.params = nullptr;
+    log_assert(fabs(FixInferModel_log_joint(&model, zeta, data, NUM_DATA) - serial) < 1e-6 * fabs(serial),
+        sMSG("Threaded log joint should match the serial sum"));
+
+    /// with this much data the mode is (nearly) the maximum likelihood estimate
+    FixInferResult *map = FixInferResult_infer(&model, INFERENCE_MAP);
+    log_assert(map != nullptr && map->converged, sMSG("L-BFGS should converge"));
+    log_assert(fabs(map->location[0] - mean) < 1e-3 && fabs(map->location[1] - sd) < 1e-2,
+        sMSG("MAP should find the sample mean and sd"));
+
+    FixInferResult *vi = FixInferResult_infer(&model, INFERENCE_VI);
+    log_assert(vi != nullptr, sMSG("ADVI failed"));
+    log_assert(fabs(vi->location[0] - mean) < 0.05 && fabs(vi->location[1] - sd) < 0.05,
+        sMSG("ADVI should centre on the posterior"));
+    log_assert(vi->scale[0] < 0.1 && vi->scale[1] < 0.1, sMSG("ADVI should concentrate with this much data"));
+    log_assert(vi->sink->num_draws == 1000 && fabs(FlxSampleSink_mean(vi->sink, 0) - mean) < 0.05,
+        sMSG("Draws from q should be summarised in the sink"));
+
+    /// batched kernels (threaded at this size) agree with per-element log_pdf calls
+    double gamma_sum = 0.0, normal_sum = 0.0;
+    for(size_t i = 0; i < NUM_DATA; i++) {
+        normal_sum += FixDist_normal_log_pdf(&location_prior, data[i]);
+        gamma_sum += FixDist_gamma_log_pdf(&scale_prior, fabs(data[i]) + 0.1);
+        data[i] = fabs(data[i]) + 0.1;
+    }
+    log_assert(fabs(FixDist_log_pdf_sum(&scale_prior, data, NUM_DATA) - gamma_sum) < 1e-9 * fabs(gamma_sum),
+        sMSG("Batched gamma log_pdf should match"));
+    data[7] = -1.0;
+    log_assert(FixDist_log_pdf_sum(&scale_prior, data, NUM_DATA) == -INFINITY, sMSG("Gamma data outside the support has zero density"));
+
+    /// observe(dist, xs) scores a vector at once into the run's log weight
+    location_prior.meta.type = BXD_FIX_DISTRIBUTION;
+    FixArray *ys = FixArray_new_auto(3);
+    FlxVecDouble *column = FlxVecDouble_new(3);
+    for(int k = 0; k < 3; k++) {
+        FixArray_append(ys, Box_wrap_int(k));
+        column->data[k] = (double) k;
+    }
+    column->meta.size = 3;
+    double expected = 0.0;
+    for(int k = 0; k < 3; k++) { expected += FixDist_normal_log_pdf(&location_prior, (double) k); }
+
+    FixFn observe = { .name = s("observe") };
+    ctx_local().inference.log_weight = 0.0;
+    ctx_local().inference.num_observed = 0;
+    Box observe_args[2] = { Box_wrap_BoxedArena(&location_prior), Box_wrap_BoxedArena(ys) };
+    native_observe(&observe, (FixScope) {0}, (FixArray) { .meta.size = 2, .meta.capacity = 2, .data = observe_args });
+    observe_args[1] = Box_wrap_BoxedHeap(column);
+    native_observe(&observe, (FixScope) {0}, (FixArray) { .meta.size = 2, .meta.capacity = 2, .data = observe_args });
+    log_assert(fabs(ctx_local().inference.log_weight - 2.0 * expected) < 1e-9 && ctx_local().inference.num_observed == 6,
+        sMSG("observe() should accumulate the batched log-density"));
+    Box unobserved = native_observe(&observe, (FixScope) {0}, (FixArray) { .meta.size = 1, .meta.capacity = 1, .data = observe_args });
+    log_assert(Box_is_error(unobserved) && ctx_local().inference.num_observed == 6,
+        sMSG("A distribution without data should be an error, not an observation"));
+    ctx_local().inference.log_weight = 0.0;
+    ctx_local().inference.num_observed = 0;
+    return 0;
+}
+
+
+int FixDist_test_main(void) {
+    FixFn normal = { .name = s("normal") };
+    Box normal_args[2] = { Box_wrap_int(3), Box_wrap_float(2.0f) };
+    Box value = native_normal(&normal, (FixScope) {0}, (FixArray) { .meta.size = 2, .meta.capacity = 2, .data = normal_args });
+    log_assert(Box_is_Boxed_type(value, BXD_FIX_DISTRIBUTION), sMSG("normal() should build a distribution value"));
+
+    FixDist *dist = Box_unwrap_typed_ptr(FixDist, value);
+    log_assert(dist->params == dist->param_data && dist->params[0] == 3.0 && dist->params[1] == 2.0,
+        sMSG("Parameters should be stored inline"));
+    log_assert(FixStr_eq(FixDist_to_FixStr(dist), s("normal(3, 2)")), sMSG("Distributions should print their parameters"));
+
+    FixFn log_pdf = { .name = s("log_pdf") };
+    Box score = native_log_pdf(&log_pdf, (FixScope) {0}, value, Box_wrap_int(3));
+    log_assert(fabs(Box_unwrap_float(score) - (-log(2.0) - 0.5 * log(2.0 * M_PI))) < 1e-6, sMSG("log_pdf() should score without sampling"));
+
+    FixFn sample = { .name = s("sample") };
+    log_assert(native_sample(&sample, (FixScope) {0}, value).type == UBX_FLOAT, sMSG("sample() should draw a number"));
+
+    /// sample moments of the samplers (gamma with shape < 1 takes the boosted path)
+    struct { FixDistType type; double params[2]; double mean; double var; } cases[] = {
+        { DIST_NORMAL, { 3.0, 2.0 }, 3.0, 4.0 },
+        { DIST_GAMMA, { 2.0, 0.5 }, 4.0, 8.0 },
+        { DIST_GAMMA, { 0.5, 1.0 }, 0.5, 0.5 },
+        { DIST_BETA, { 2.0, 5.0 }, 2.0 / 7.0, 10.0 / (49.0 * 8.0) },
+        { DIST_EXPONENTIAL, { 2.0 }, 0.5, 0.25 },
+        { DIST_UNIFORM, { -1.0, 3.0 }, 1.0, 16.0 / 12.0 },
+    };
+    enum { NUM_DRAWS = 40000 };
+    for(size_t c = 0; c < sizeof(cases) / sizeof(cases[0]); c++) {
+        size_t num_params = cases[c].type == DIST_EXPONENTIAL ? 1 : 2;
+        FixDist *d = FixDist_new(cases[c].type, cases[c].params, num_params);
+        double mean = 0.0, m2 = 0.0;
+        for(size_t i = 0; i < NUM_DRAWS; i++) {
+            double x = d->sample_fn_ptr(d);
+            double delta = x - mean;
+            mean += delta / (double) (i + 1);
+            m2 += delta * (x - mean);
+        }
+        double sd = sqrt(cases[c].var);
+        log_assert(fabs(mean - cases[c].mean) < 5.0 * sd / sqrt(NUM_DRAWS), sMSG("Sample mean should match"));
+        log_assert(fabs(m2 / NUM_DRAWS - cases[c].var) < 0.1 * cases[c].var, sMSG("Sample variance should match"));
+        log_assert(fabs(d->pdf_fn_ptr(d, cases[c].mean) - exp(d->log_pdf_fn_ptr(d, cases[c].mean))) < 1e-12,
+            sMSG("pdf and log_pdf should agree"));
+    }
+
+    double bad[2] = { 0.0, -1.0 };
+    log_assert(!FixDist_params_valid(DIST_NORMAL, bad, 2) && !FixDist_params_valid(DIST_GAMMA, bad, 2),
+        sMSG("Invalid parameters should be rejected"));
+    return 0;
+}
+
+
+/// ----- FixInfer: ADVI and MAP ----- ///
+
+typedef enum { SUPPORT_REAL, SUPPORT_POSITIVE, SUPPORT_UNIT } FixSupport;
+
+/// @brief A range of data whose log-likelihood is summed on one compute thread
+typedef struct FixInferTask {
+    const FixDist *likelihood;
+    const double *data;
+    size_t start;
+    size_t end;
+    double sum;
+} FixInferTask;
+
+/// @brief Runs `worker` over `tasks` on the compute pool (inline when there is one)
+static void FixInfer_run_tasks(FixInferTask *tasks, size_t num_tasks, void *(*worker)(void *)) {
+    TaskPool_run(tasks, sizeof(FixInferTask), num_tasks, worker);
+}
+
+/// @brief sum_i log p(xs[i]) on one thread, in closed form for the built-in normal and gamma
+/// @note the closed forms hoist log(sd), lgamma(shape) etc. out of the loop and keep
+///     ... independent accumulators, so the loop body is a few multiply-adds
+static double FixDist_log_pdf_kernel(const FixDist *dist, const double *xs, size_t n) {
+    if(n == 0) { return 0.0; }
+
+    if(dist->type == DIST_NORMAL && dist->log_pdf_fn_ptr == FixDist_normal_log_pdf) {
+        double mean = dist->params[0];
+        double precision = 1.0 / dist->params[1];
+        double acc0 = 0.0, acc1 = 0.0;
+        size_t i = 0;
+        for(; i + 1 < n; i += 2) {
+            double z0 = (xs[i] - mean) * precision;
+            double z1 = (xs[i + 1] - mean) * precision;
+            acc0 += z0 * z0;
+            acc1 += z1 * z1;
+        }
+        for(; i < n; i++) {
+            double z = (xs[i] - mean) * precision;
+            acc0 += z * z;
+        }
+        return -0.5 * (acc0 + acc1) - (double) n * (log(dist->params[1]) + 0.5 * log(2.0 * M_PI));
+    }
+
+    if(dist->type == DIST_GAMMA && dist->log_pdf_fn_ptr == FixDist_gamma_log_pdf) {
+        double shape = dist->params[0], rate = dist->params[1];
+        double sum_log = 0.0, sum = 0.0;
+        for(size_t i = 0; i < n; i++) {
+            if(xs[i] <= 0.0) { return -INFINITY; }
+            sum_log += log(xs[i]);
+            sum += xs[i];
+        }
+        return (double) n * (shape * log(rate) - lgamma(shape)) + (shape - 1.0) * sum_log - rate * sum;
+    }
+
+    FixDist *generic = (FixDist *) dist;
+    double sum = 0.0;
+    for(size_t i = 0; i < n; i++) {
+        sum += generic->log_pdf_fn_ptr(generic, xs[i]);
+    }
+    return sum;
+}
+
+static void *FixInfer_log_likelihood_worker(void *arg) {
+    FixInferTask *task = (FixInferTask *) arg;
+    task->sum = FixDist_log_pdf_kernel(task->likelihood, task->data + task->start, task->end - task->start);
+    return nullptr;
+}
+
+/// @brief The log-likelihood of `data` under `likelihood`, summed per thread then combined
+double FixDist_log_pdf_sum(const FixDist *likelihood, const double *data, size_t num_data) {
+    require_not_null(likelihood);
+    require_not_null(likelihood->log_pdf_fn_ptr);
+
+    FixInferTask tasks[CPU_CORES_MAX] = {0};
+    size_t num_tasks = num_data < INFER_PARALLEL_MIN_DATA ? 1 : TaskPool_num_workers();
+    size_t step = (num_data + num_tasks - 1) / num_tasks;
+
+    for(size_t t = 0; t < num_tasks; t++) {
+        tasks[t].likelihood = likelihood;
+        tasks[t].data = data;
+        tasks[t].start = t * step < num_data ? t * step : num_data;
+        tasks[t].end = (t + 1) * step < num_data ? (t + 1) * step : num_data;
+    }
+    FixInfer_run_tasks(tasks, num_tasks, FixInfer_log_likelihood_worker);
+
+    double sum = 0.0;
+    for(size_t t = 0; t < num_tasks; t++) { sum += tasks[t].sum; }
+    return sum;
+}
+
+static FixSupport FixDist_support(const FixDist *dist) {
+    if(dist == nullptr) { return SUPPORT_REAL; }
+    switch(dist->type) {
+        case DIST_GAMMA:
+        case DIST_EXPONENTIAL:
+        case DIST_INV_GAMMA:
+        case DIST_LOG_NORMAL:
+        case DIST_WEIBULL:
+        case DIST_RAYLEIGH:
+        case DIST_WALD:
+        case DIST_MAXWELL:
+            return SUPPORT_POSITIVE;
+        case DIST_BETA:
+            return SUPPORT_UNIT;
+        default:
+            return SUPPORT_REAL;
+    }
+}
+
+/// @brief Maps an unconstrained value into the support, adding log |d theta / d zeta|
+static double FixSupport_constrain(FixSupport support, double zeta, double *log_jacobian) {
+    switch(support) {
+        case SUPPORT_POSITIVE:
+            *log_jacobian += zeta;
+            return exp(zeta);
+        case SUPPORT_UNIT: {
+            double theta = 1.0 / (1.0 + exp(-zeta));
+            *log_jacobian += log(theta) + log1p(-theta);
+            return theta;
+        }
+        default:
+            return zeta;
+    }
+}
+
+static double FixSupport_unconstrain(FixSupport support, double theta) {
+    switch(support) {
+        case SUPPORT_POSITIVE: return log(theta);
+        case SUPPORT_UNIT: return log(theta) - log1p(-theta);
+        default: return theta;
+    }
+}
+
+static void FixInferModel_constrain(const FixInferModel *model, const double *zeta, double *theta) {
+    double log_jacobian = 0.0;
+    for(size_t j = 0; j < model->num_params; j++) {
+        FixDist *prior = model->priors != nullptr ? model->priors[j] : nullptr;
+        theta[j] = FixSupport_constrain(FixDist_support(prior), zeta[j], &log_jacobian);
+    }
+}
+
+/// @brief log p(theta) + log |J| + (num_data / batch_len) log p(batch | theta), at theta(zeta)
+/// @note pass the whole dataset as the batch for the exact log joint
+double FixInferModel_log_joint(const FixInferModel *model, const double *zeta, const double *batch, size_t batch_len) {
+    require_not_null(model);
+    require_not_null(model->likelihood);
+    require(model->likelihood->num_params == model->num_params);
+
+    double theta[model->num_params];
+    double log_joint = 0.0;
+    for(size_t j = 0; j < model->num_params; j++) {
+        FixDist *prior = model->priors != nullptr ? model->priors[j] : nullptr;
+        theta[j] = FixSupport_constrain(FixDist_support(prior), zeta[j], &log_joint);
+        if(prior != nullptr) { log_joint += prior->log_pdf_fn_ptr(prior, theta[j]); }
+    }
+    if(batch_len == 0) { return log_joint; }
+
+    /// @note a copy reading this call's theta, so the caller's likelihood is never written
+    FixDist likelihood = *model->likelihood;
+    likelihood.params = theta;
+    double scale = (double) model->num_data / (double) batch_len;
+    return log_joint + scale * FixDist_log_pdf_sum(&likelihood, batch, batch_len);
+}
+
+/// @brief The log joint at zeta, with its gradient (by central differences) in `out_grad`
+double FixInferModel_gradient(const FixInferModel *model, const double *zeta,
+    const double *batch, size_t batch_len, double *out_grad) {
+    require_not_null(model);
+    require_not_null(out_grad);
+
+    double point[model->num_params];
+    memcpy(point, zeta, model->num_params * sizeof(double));
+
+    for(size_t j = 0; j < model->num_params; j++) {
+        double h = INFER_GRADIENT_STEP * fmax(1.0, fabs(zeta[j]));
+        point[j] = zeta[j] + h;
+        double above = FixInferModel_log_joint(model, point, batch, batch_len);
+        point[j] = zeta[j] - h;
+        double below = FixInferModel_log_joint(model, point, batch, batch_len);
+        point[j] = zeta[j];
+        out_grad[j] = (above - below) / (2.0 * h);
+    }
+    return FixInferModel_log_joint(model, zeta, batch, batch_len);
+}
+
+/// @brief Unconstrained starting point: the model's params when set, otherwise zero
+static void FixInferModel_initial(const FixInferModel *model, double *zeta) {
+    for(size_t j = 0; j < model->num_params; j++) {
+        FixDist *prior = model->priors != nullptr ? model->priors[j] : nullptr;
+        zeta[j] = model->params != nullptr ? FixSupport_unconstrain(FixDist_support(prior), model->params[j]) : 0.0;
+    }
+}
+
+/// @brief Mean-field ADVI (Kucukelbir et al. 2017): q(zeta) = prod N(mu_j, exp(omega_j)^2)
+/// @note one reparameterised draw per step on a minibatch of VI_MINIBATCH_SIZE data, taken
+///     ... in order from a shuffled copy (so each pass is without replacement), with the
+///     ... adaptive step size eta i^(-1/2) / (1 + sqrt(s)); stops once the mean ELBO of
+///     ... successive windows changes by less than VI_TOLERANCE (relative)
+FixInferResult *FixInferResult_vi(const FixInferModel *model) {
+    require_not_null(model);
+    require_positive(model->num_params);
+    require_positive(model->num_data);
+
+    FixInferResult *result = FixInferResult_new(model, INFERENCE_VI);
+    if(result == nullptr) { return nullptr; }
+
+    size_t n = model->num_data;
+    size_t P = model->num_params;
+    size_t batch_len = n < VI_MINIBATCH_SIZE ? n : VI_MINIBATCH_SIZE;
+
+    double *shuffled = cnew(n * sizeof(double));
+    if(shuffled == nullptr) { error_oom(); return nullptr; }
+    memcpy(shuffled, model->data, n * sizeof(double));
+    for(size_t i = n - 1; i > 0; i--) {
+        size_t k = (size_t) (InterpContext_random() * (double) (i + 1));
+        double swap = shuffled[i]; shuffled[i] = shuffled[k]; shuffled[k] = swap;
+    }
+
+    double mu[P], omega[P], zeta[P], eps[P], grad[P], s_mu[P], s_omega[P];
+    FixInferModel_initial(model, mu);
+    for(size_t j = 0; j < P; j++) { omega[j] = 0.0; s_mu[j] = 0.0; s_omega[j] = 0.0; }
+
+    double window = 0.0, previous_window = NAN;
+    size_t offset = 0, iteration = 0;
+    for(iteration = 1; iteration <= VI_MAX_ITERATIONS; iteration++) {
+        if(offset + batch_len > n) { offset = 0; }
+
+        for(size_t j = 0; j < P; j++) {
+            eps[j] = lib_rand_normal(0.0, 1.0);
+            zeta[j] = mu[j] + exp(omega[j]) * eps[j];
+        }
+        double log_joint = FixInferModel_gradient(model, zeta, shuffled + offset, batch_len, grad);
+        offset += batch_len;
+
+        double entropy = 0.0;
+        double rate = VI_STEP_SIZE / sqrt((double) iteration);
+        for(size_t j = 0; j < P; j++) {
+            double g_mu = grad[j];
+            double g_omega = grad[j] * eps[j] * exp(omega[j]) + 1.0;
+
+            /// @note the first step seeds the running squared gradients (alpha = 0.1 after)
+            double alpha = iteration == 1 ? 1.0 : 0.1;
+            s_mu[j] = alpha * g_mu * g_mu + (1.0 - alpha) * s_mu[j];
+            s_omega[j] = alpha * g_omega * g_omega + (1.0 - alpha) * s_omega[j];
+            mu[j] += rate * g_mu / (1.0 + sqrt(s_mu[j]));
+            omega[j] += rate * g_omega / (1.0 + sqrt(s_omega[j]));
+            entropy += omega[j];
+        }
+
+        window += log_joint + entropy;
+        if(iteration % VI_ELBO_WINDOW == 0) {
+            double mean = window / VI_ELBO_WINDOW;
+            result->converged = fabs(mean - previous_window) < VI_TOLERANCE * fabs(mean);
+            result->objective = mean;
+            previous_window = mean;
+            window = 0.0;
+            if(result->converged) { break; }
+        }
+    }
+    cfree(shuffled);
+    result->iterations = iteration < VI_MAX_ITERATIONS ? iteration : VI_MAX_ITERATIONS;
+
+    FixInferModel_constrain(model, mu, result->location);
+    for(size_t j = 0; j < P; j++) { result->scale[j] = exp(omega[j]); }
+
+    double theta[P];
+    for(size_t k = 0; k < model->num_target_samples; k++) {
+        for(size_t j = 0; j < P; j++) { zeta[j] = mu[j] + result->scale[j] * lib_rand_normal(0.0, 1.0); }
+        FixInferModel_constrain(model, zeta, theta);
+        FlxSampleSink_push(result->sink, theta);
+    }
+    return result;
+}
+
+/// @brief The posterior mode, by L-BFGS on the unconstrained negative log joint
+/// @note MAP_HISTORY curvature pairs, two-loop recursion and a backtracking (Armijo) line
+///     ... search; every objective uses the whole dataset, so each is a parallel sum
+FixInferResult *FixInferResult_map(const FixInferModel *model) {
+    require_not_null(model);
+    require_positive(model->num_params);
+
+    FixInferResult *result = FixInferResult_new(model, INFERENCE_MAP);
+    if(result == nullptr) { return nullptr; }
+
+    size_t P = model->num_params;
+    const double *data = model->data;
+    size_t n = model->num_data;
+
+    double x[P], g[P], d[P], x_next[P], g_next[P], alpha[MAP_HISTORY], rho[MAP_HISTORY];
+    double history_s[MAP_HISTORY][P], history_y[MAP_HISTORY][P];
+    size_t num_pairs = 0, newest = 0;
+
+    FixInferModel_initial(model, x);
+    double f = -FixInferModel_gradient(model, x, data, n, g);
+    for(size_t j = 0; j < P; j++) { g[j] = -g[j]; }
+
+    size_t iteration;
+    for(iteration = 1; iteration <= MAP_MAX_ITERATIONS; iteration++) {
+        /// direction: d = -H g, by the two-loop recursion over the newest pairs first
+        for(size_t j = 0; j < P; j++) { d[j] = -g[j]; }
+        for(size_t k = 0; k < num_pairs; k++) {
+            size_t h = (newest + MAP_HISTORY - k) % MAP_HISTORY;
+            alpha[h] = 0.0;
+            for(size_t j = 0; j < P; j++) { alpha[h] += history_s[h][j] * d[j]; }
+            alpha[h] *= rho[h];
+            for(size_t j = 0; j < P; j++) { d[j] -= alpha[h] * history_y[h][j]; }
+        }
+        if(num_pairs > 0) {
+            double sy = 0.0, yy = 0.0;
+            for(size_t j = 0; j < P; j++) {
+                sy += history_s[newest][j] * history_y[newest][j];
+                yy += history_y[newest][j] * history_y[newest][j];
+            }
+            for(size_t j = 0; j < P; j++) { d[j] *= sy / yy; }
+        }
+        for(size_t k = num_pairs; k > 0; k--) {
+            size_t h = (newest + MAP_HISTORY - (k - 1)) % MAP_HISTORY;
+            double beta = 0.0;
+            for(size_t j = 0; j < P; j++) { beta += history_y[h][j] * d[j]; }
+            beta *= rho[h];
+            for(size_t j = 0; j < P; j++) { d[j] += (alpha[h] - beta) * history_s[h][j]; }
+        }
+
+        double slope = 0.0;
+        for(size_t j = 0; j < P; j++) { slope += g[j] * d[j]; }
+        if(slope >= 0.0) {
+            /// @note not a descent direction: drop the history and follow the gradient
+            num_pairs = 0;
+            slope = 0.0;
+            for(size_t j = 0; j < P; j++) { d[j] = -g[j]; slope -= g[j] * g[j]; }
+        }
+
+        double step = num_pairs == 0 ? 1.0 / fmax(1.0, sqrt(-slope)) : 1.0;
+        double f_next = INFINITY;
+        for(size_t tries = 0; tries < 50; tries++) {
+            for(size_t j = 0; j < P; j++) { x_next[j] = x[j] + step * d[j]; }
+            f_next = -FixInferModel_log_joint(model, x_next, data, n);
+            if(isfinite(f_next) && f_next <= f + 1e-4 * step * slope) { break; }
+            step *= 0.5;
+        }
+        if(!isfinite(f_next) || f_next > f) { break; }
+
+        FixInferModel_gradient(model, x_next, data, n, g_next);
+        size_t next = num_pairs == 0 ? 0 : (newest + 1) % MAP_HISTORY;
+        double sy = 0.0;
+        for(size_t j = 0; j < P; j++) {
+            g_next[j] = -g_next[j];
+            history_s[next][j] = x_next[j] - x[j];
+            history_y[next][j] = g_next[j] - g[j];
+            sy += history_s[next][j] * history_y[next][j];
+        }
+        if(sy > 1e-12) {
+            rho[next] = 1.0 / sy;
+            newest = next;
+            num_pairs = num_pairs < MAP_HISTORY ? num_pairs + 1 : MAP_HISTORY;
+        }
+
+        bool done = fabs(f - f_next) <= MAP_TOLERANCE * fmax(1.0, fabs(f));
+        memcpy(x, x_next, P * sizeof(double));
+        memcpy(g, g_next, P * sizeof(double));
+        f = f_next;
+        if(done) { result->converged = true; break; }
+    }
+
+    result->iterations = iteration < MAP_MAX_ITERATIONS ? iteration : MAP_MAX_ITERATIONS;
+    result->objective = -f;
+    FixInferModel_constrain(model, x, result->location);
+    FlxSampleSink_push(result->sink, result->location);
+    return result;
+}
+
+/// @brief Performs inference on the given probabilistic model using the specified inference method.
+/// @note MCMC over a FixInferModel is not implemented: sample with infer(model, #MCMC) instead
+FixInferResult *FixInferResult_infer(const FixInferModel *model, InferMethod method) {
+    switch(method) {
+        case INFERENCE_VI:
+            return FixInferResult_vi(model);
+        case INFERENCE_MAP:
+            return FixInferResult_map(model);
+        default:
+            log_message(LL_ERROR, sMSG("FixInferResult_infer: unsupported inference method %d."), method);
+            return nullptr;
+    }
+}
+
+/// @brief Initializes a probabilistic model with default or specified parameters.
+FixInferModel *Model_new(FixDist *prior, FixDist *likelihood, size_t num_target_samples);
+
+FixInferModel *Model_set_params(FixInferModel *model, double *params, size_t num_params) {
+    model->params = params;
+    model->num_params = num_params;
+    return model;
+}
+
+FixInferModel *Model_set_data(FixInferModel *model, double *data, size_t num_data) {
+    model->data = data;
+    model->num_data = num_data;
+    return model;
+}
+
+
+/**
+ * Records an observation within the probabilistic model.
+ *
+ * @param model
+ *      includes pointer to a FixDist struct defining the observation's distribution.
+ * @param value The observed value to condition on.
+ */
+void Model_observe(FixInferModel *model, double value) {
+    model->data[model->num_data++] = value;
+}
+
+/**
+ * Initializes the random number generator with a given seed.
+ *
+ * @param seed  The seed value for the RNG.
+ * @note only the calling thread's stream (cf. InterpContext_seed)
+ */
+void initialize_rng(unsigned int seed) {
+    InterpContext_seed(seed);
+}
+
+double lib_rand_0to1(void) {
+    return InterpContext_random();
+}
+
+double lib_rand_normal(double mean, double stddev) {
+    double u1 = lib_rand_0to1();
+    double u2 = lib_rand_0to1();
+    double z = sqrt(-2 * log(u1)) * cos(2 * M_PI * u2);
+    return mean + z * stddev;
+}
+
+/**
+ * Computes the Probability Density Function (PDF) of the Normal distribution.
+ *
+ * @param x       The value at which to evaluate the PDF.
+ * @param mean    The mean (μ) of the Normal distribution.
+ * @param stddev  The standard deviation (σ) of the Normal distribution.
+ * @return        The PDF value at x for N(mean, stddev).
+ */
+double normal_pdf(double x, double mean, double stddev);
+double normal_log_pdf(double x, double mean, double stddev);
+
+/**
+ * Computes the Probability Density Function (PDF) of the Gamma distribution.
+ *
+ * @param x      The value at which to evaluate the PDF.
+ * @param shape  The shape parameter (α) of the Gamma distribution.
+ * @param rate   The rate parameter (β) of the Gamma distribution.
+ * @return       The PDF value at x for Gamma(shape, rate).
+ */
+double gamma_pdf(double x, double shape, double rate);
+double gamma_log_pdf(double x, double shape, double rate);
+
+/**
+ * Samples a value from a Normal (Gaussian) distribution.
+ *
+ * @param mean    The mean (μ) of the distribution.
+ * @param stddev  The standard deviation (σ) of the distribution.
+ * @return        A random sample from N(mean, stddev).
+ */
+double sample_normal(double mean, double stddev);
+
+/**
+ * Samples a value from a Gamma distribution.
+ *
+ * @param shape  The shape parameter (α) of the Gamma distribution.
+ * @param rate   The rate parameter (β) of the Gamma distribution.
+ * @return       A random sample from Gamma(shape, rate).
+ */
+double sample_gamma(double shape, double rate);
+
+double normal_log_pdf(double x, double mean, double stddev) {
+    double z = (x - mean) / stddev;
+    return -0.5 * z * z - log(stddev) - 0.5 * log(2.0 * M_PI);
+}
+
+double normal_pdf(double x, double mean, double stddev) {
+    return exp(normal_log_pdf(x, mean, stddev));
+}
+
+double gamma_log_pdf(double x, double shape, double rate) {
+    if(x <= 0.0) { return -INFINITY; }
+    return shape * log(rate) - lgamma(shape) + (shape - 1.0) * log(x) - rate * x;
+}
+
+double gamma_pdf(double x, double shape, double rate) {
+    return exp(gamma_log_pdf(x, shape, rate));
+}
+
+/// @brief log_pdf_fn_ptr of a FixDist with params (mean, stddev)
+double FixDist_normal_log_pdf(FixDist *dist, double x) {
+    return normal_log_pdf(x, dist->params[0], dist->params[1]);
+}
+
+/// @brief log_pdf_fn_ptr of a FixDist with params (shape, rate)
+double FixDist_gamma_log_pdf(FixDist *dist, double x) {
+    return gamma_log_pdf(x, dist->params[0], dist->params[1]);
+}
+
+double sample_normal(double mean, double stddev) {
+    return lib_rand_normal(mean, stddev);
+}
+
+/// @note Marsaglia & Tsang (2000); a shape below one is boosted by one and scaled by u^(1/shape)
+double sample_gamma(double shape, double rate) {
+    if(shape < 1.0) {
+        double u = lib_rand_0to1();
+        return sample_gamma(shape + 1.0, rate) * pow(1.0 - u, 1.0 / shape);
+    }
+
+    double d = shape - 1.0 / 3.0;
+    double c = 1.0 / sqrt(9.0 * d);
+    while(true) {
+        double z = lib_rand_normal(0.0, 1.0);
+        double v = 1.0 + c * z;
+        if(v <= 0.0) { continue; }
+        v = v * v * v;
+        double u = lib_rand_0to1();
+        if(log(1.0 - u) < 0.5 * z * z + d - d * v + d * log(v)) {
+            return d * v / rate;
+        }
+    }
+}
+
+static double FixDist_normal_sample(FixDist *dist) { return sample_normal(dist->params[0], dist->params[1]); }
+static double FixDist_normal_pdf(FixDist *dist, double x) { return normal_pdf(x, dist->params[0], dist->params[1]); }
+
+static double FixDist_gamma_sample(FixDist *dist) { return sample_gamma(dist->params[0], dist->params[1]); }
+static double FixDist_gamma_pdf(FixDist *dist, double x) { return gamma_pdf(x, dist->params[0], dist->params[1]); }
+
+static double FixDist_exponential_sample(FixDist *dist) { return -log(1.0 - lib_rand_0to1()) / dist->params[0]; }
+static double FixDist_exponential_log_pdf(FixDist *dist, double x) {
+    return x < 0.0 ? -INFINITY : log(dist->params[0]) - dist->params[0] * x;
+}
+static double FixDist_exponential_pdf(FixDist *dist, double x) { return exp(FixDist_exponential_log_pdf(dist, x)); }
+
+static double FixDist_uniform_sample(FixDist *dist) {
+    return dist->params[0] + (dist->params[1] - dist->params[0]) * lib_rand_0to1();
+}
+static double FixDist_uniform_log_pdf(FixDist *dist, double x) {
+    return (x < dist->params[0] || x > dist->params[1]) ? -INFINITY : -log(dist->params[1] - dist->params[0]);
+}
+static double FixDist_uniform_pdf(FixDist *dist, double x) { return exp(FixDist_uniform_log_pdf(dist, x)); }
+
+static double FixDist_beta_sample(FixDist *dist) {
+    double x = sample_gamma(dist->params[0], 1.0);
+    double y = sample_gamma(dist->params[1], 1.0);
+    return x / (x + y);
+}
+static double FixDist_beta_log_pdf(FixDist *dist, double x) {
+    double a = dist->params[0], b = dist->params[1];
+    if(x <= 0.0 || x >= 1.0) { return -INFINITY; }
+    return (a - 1.0) * log(x) + (b - 1.0) * log1p(-x) - (lgamma(a) + lgamma(b) - lgamma(a + b));
+}
+static double FixDist_beta_pdf(FixDist *dist, double x) { return exp(FixDist_beta_log_pdf(dist, x)); }
+
+/// @note s() is a compound literal, which is not a constant initializer
+#define FixDist_param_name(txt) { .cstr = (txt), .size = sizeof(txt) - 1 }
+static FixStr FixDist_normal_names[] = { FixDist_param_name("mean"), FixDist_param_name("sd") };
+static FixStr FixDist_rate_shape_names[] = { FixDist_param_name("shape"), FixDist_param_name("rate") };
+static FixStr FixDist_rate_names[] = { FixDist_param_name("rate") };
+static FixStr FixDist_bounds_names[] = { FixDist_param_name("low"), FixDist_param_name("high") };
+static FixStr FixDist_beta_names[] = { FixDist_param_name("alpha"), FixDist_param_name("beta") };
+#undef FixDist_param_name
+
+/// @brief The built-in distributions: parameter layout, kernels and the printed name
+static const struct FixDistSpec {
+    FixDistType type;
+    const char *name;
+    size_t num_params;
+    FixStr *param_names;
+    double (*sample_fn_ptr)(FixDist *dist);
+    double (*pdf_fn_ptr)(FixDist *dist, double x);
+    double (*log_pdf_fn_ptr)(FixDist *dist, double x);
+} FixDist_specs[] = {
+    { DIST_NORMAL, "normal", 2, FixDist_normal_names,
+        FixDist_normal_sample, FixDist_normal_pdf, FixDist_normal_log_pdf },
+    { DIST_GAMMA, "gamma", 2, FixDist_rate_shape_names,
+        FixDist_gamma_sample, FixDist_gamma_pdf, FixDist_gamma_log_pdf },
+    { DIST_EXPONENTIAL, "exponential", 1, FixDist_rate_names,
+        FixDist_exponential_sample, FixDist_exponential_pdf, FixDist_exponential_log_pdf },
+    { DIST_UNIFORM, "uniform", 2, FixDist_bounds_names,
+        FixDist_uniform_sample, FixDist_uniform_pdf, FixDist_uniform_log_pdf },
+    { DIST_BETA, "beta", 2, FixDist_beta_names,
+        FixDist_beta_sample, FixDist_beta_pdf, FixDist_beta_log_pdf },
+};
+
+static const struct FixDistSpec *FixDist_spec(FixDistType type) {
+    for(size_t i = 0; i < sizeof(FixDist_specs) / sizeof(FixDist_specs[0]); i++) {
+        if(FixDist_specs[i].type == type) { return &FixDist_specs[i]; }
+    }
+    return nullptr;
+}
+
+/// @brief Whether `params` are a valid parameterisation (eg., a positive sd) of a built-in `type`
+bool FixDist_params_valid(FixDistType type, const double *params, size_t num_params) {
+    const struct FixDistSpec *spec = FixDist_spec(type);
+    if(spec == nullptr || num_params != spec->num_params) { return false; }
+    for(size_t i = 0; i < num_params; i++) {
+        if(!isfinite(params[i])) { return false; }
+    }
+
+    switch(type) {
+        case DIST_NORMAL: return params[1] > 0.0;
+        case DIST_GAMMA:
+        case DIST_BETA: return params[0] > 0.0 && params[1] > 0.0;
+        case DIST_EXPONENTIAL: return params[0] > 0.0;
+        case DIST_UNIFORM: return params[0] < params[1];
+        default: return true;
+    }
+}
+
+/// @brief A built-in distribution value, with its parameters stored inline
+/// @note one arena allocation: sampling and scoring call the kernels directly, so neither
+///     ... re-enters the interpreter
+FixDist *FixDist_new(FixDistType type, const double *params, size_t num_params) {
+    require(FixDist_params_valid(type, params, num_params));
+    const struct FixDistSpec *spec = FixDist_spec(type);
+
+    FixDist *dist = aro_new(BXD_FIX_DISTRIBUTION);
+    if(dist == nullptr) { error_oom(); return nullptr; }
+
+    dist->meta.type = BXD_FIX_DISTRIBUTION;
+    dist->meta.state = LIVING_ALIVE;
+    dist->type = type;
+    dist->param_names = spec->param_names;
+    dist->param_descriptions = nullptr;
+    dist->num_params = num_params;
+    memcpy(dist->param_data, params, num_params * sizeof(double));
+    dist->params = dist->param_data;
+    dist->sample_fn_ptr = spec->sample_fn_ptr;
+    dist->pdf_fn_ptr = spec->pdf_fn_ptr;
+    dist->log_pdf_fn_ptr = spec->log_pdf_fn_ptr;
+    return dist;
+}
+
+FixStr FixDist_to_FixStr(FixDist *dist) {
+    const struct FixDistSpec *spec = FixDist_spec(dist->type);
+    FixStr repr = FixStr_fmt_new(s("%s("), spec != nullptr ? spec->name : "distribution");
+    for(size_t i = 0; i < dist->num_params; i++) {
+        repr = FixStr_glue_new(repr, i == 0 ? FixStr_fmt_new(s("%g"), dist->params[i]) : FixStr_fmt_new(s(", %g"), dist->params[i]));
+    }
+    return FixStr_glue_new(repr, s(")"));
+}
+
+
+#pragma endregion
+
+#pragma region BoxedNative
+
+
+
+// #define native_srcof(i) ctx().info.sources[i].source_code
+
+#define native_track_src_start() \
+    ctx().info.sources[ctx().info.num_sources].name = s(__func__); \
+    ctx().info.sources[ctx().info.num_sources].source_file = s(__FILE__); \
+    ctx().info.sources[ctx().info.num_sources].start_line_num = __LINE__;
+
+#define native_track_src_end() \
+    ctx().info.sources[ctx().info.num_sources].end_line_num = __LINE__; \
+    ctx().info.num_sources++;
+
+/// @todo consider the *double problem
+///     ... ie maybe have a declare_ for a double arg?
+///         ... since it would require a deref
+
+
+#define declare_arity0_to_native(raw_name, return_packer) \
+    Box native_##raw_name(FixFn *self, FixScope parent, Box one, Box two) { \
+        native_log_call0(self);\
+        return return_packer(raw_name()); \
+    }
+
+#define declare_arity1_to_native(raw_name, btype_1st, return_packer) \
+    Box native_##raw_name(FixFn *self, FixScope parent, Box one) { \
+        native_log_call1(self, one);\
+        native_return_error_if(one.type != btype_1st, sMSG("Expected argument type %s"), ubx_nameof(btype_1st)); \
+        Box_ctypeof(btype_1st) first;\
+        require_safe(clib_memcpy_safe(&first, \
+            sizeof(Box_ctypeof(btype_1st)), &one, sizeof(Box_ctypeof(btype_1st))));\
+        return return_packer(raw_name(first)); \
+    }
+
+#define declare_arity2_to_native(raw_name, btype_1st, btype_2nd, return_packer) \
+    Box native_##raw_name(FixFn *self, FixScope parent, Box one, Box two) { \
+        native_log_call2(self, one, two);\
+        native_return_error_if(one.type != btype_1st, sMSG("Expected argument type %s"), ubx_nameof(btype_1st)); \
+        native_return_error_if(two.type != btype_2nd, sMSG("Expected argument type %s"), ubx_nameof(btype_2nd)); \
+        Box_ctypeof(btype_1st) first;\
+        Box_ctypeof(btype_1st) second;\
+        require_safe(clib_memcpy_safe(&first, sizeof(Box_ctypeof(btype_1st)), \
+                &one, sizeof(Box_ctypeof(btype_1st))));\
+        require_safe(clib_memcpy_safe(&second, sizeof(Box_ctypeof(btype_2nd)), \
+                &two, sizeof(Box_ctypeof(btype_2nd))));\
+        return return_packer(raw_name(first, second));\
+    }
+
+
+#define declare_arity2_to_native_numeric(raw_name, return_packer) \
+    Box native_##raw_name(FixFn *self, FixScope parent, Box one, Box two) { \
+        native_log_call2(self, one, two);\
+        double first, second;\
+        native_return_error_if(!Box_try_numeric(one, &first), \
+            sMSG("Expected numeric argument type, got %s"), ubx_nameof(one.type)); \
+        native_return_error_if(!Box_try_numeric(two, &second), \
+            sMSG("Expected numeric argument type, got %s"), ubx_nameof(two.type)); \
+        return return_packer(raw_name(first, second));\
+    }
+
+
+declare_arity1_to_native(sqrtf, UBX_FLOAT, Box_wrap_float);
+declare_arity2_to_native_numeric(lib_rand_normal, Box_wrap_float);
+
+Box native_getsrc(FixFn *self, FixScope parent, Box one) {
+    native_log_call1(self, one); native_track_src_start();
+
+    FixStr native_fn_name = Box_unwrap_FixStr(one);
+
+    static FixDict native_src_dict;
+    static bool is_initialized = false;
+
+    if (!is_initialized) {
+        FixDict_data_new(&native_src_dict, ctx().info.num_sources);
+        for (size_t i = 0; i < ctx().info.num_sources; i++) {
+            FixDict_set(&native_src_dict, ctx().info.sources[i].name, Box_wrap_ptr(&ctx().info.sources[i]));
+        }
+        is_initialized = true;
+    }
+
+    Box entry = FixDict_get(&native_src_dict, native_fn_name);
+    if (!Box_is_null(entry)) {
+        SourceInfo *src_info = Box_unwrap_typed_ptr(SourceInfo, entry);
+        if (FixStr_is_empty(src_info->source_code)) {
+            src_info->source_code = FixStr_readlines_new(
+                src_info->source_file,
+                src_info->start_line_num,
+                src_info->end_line_num
+            );
+        }
+        return Box_wrap_BoxedArena(&src_info->source_code);
+    }
+
+    native_error(sMSG("Could not find source for native function: %.*s"), fmt(native_fn_name));
+    Box result = Box_error_empty();
+    native_track_src_end();
+    return result;
+}
+
+
+/// @brief
+/// @typedef log : fn([]str) -> nullptr
+/// @param self
+/// @param parent
+/// @param args
+/// @return
+Box native_log(FixFn *self, FixScope parent, FixArray args) {
+    native_log_call(self, args);
+    native_track_src_start();
+
+    /// @note streams are lazy, so what's printed of one is its next few elements
+    for(size_t i = 0; i < len(args); i++) {
+        Box arg = FixArray_get(args, i);
+        FixStr_puts(Box_is_Boxed_type(arg, BXD_FIX_ITER) ?
+            FixIter_peek_to_FixStr(Box_unwrap_FixIter(arg), FIXITER_PRINT_MAX) : Box_to_FixStr(arg));
+        putchar(' ');
+    }
+
+    puts("\n");
+    Box result = Box_null();
+
+    native_track_src_end();
+    return result;
+}
+
+/// @brief The summed log-density of `data` under `dist`: one number, or a whole vector at once
+/// @note double columns (vec_double, matrix) are read in place; boxed arrays and views are
+///     ... unboxed OBSERVE_CHUNK elements at a time into a stack buffer
+static bool native_observe_Box(const FixDist *dist, Box data, double *out_log_density, size_t *out_count) {
+    double x;
+    if(Box_try_numeric(data, &x)) {
+        *out_log_density = FixDist_log_pdf_sum(dist, &x, 1);
+        *out_count = 1;
+        return true;
+    }
+    if(Box_is_Boxed_type(data, BXD_FLX_VEC_DOUBLE_N)) {
+        FlxVecDouble *column = Box_unwrap_typed_ptr(FlxVecDouble, data);
+        *out_log_density = FixDist_log_pdf_sum(dist, column->data, len_ref(column));
+        *out_count = len_ref(column);
+        return true;
+    }
+    if(Box_is_Boxed_type(data, BXD_FLX_MATRIX_DOUBLE)) {
+        FlxMatrixF *m = Box_unwrap_typed_ptr(FlxMatrixF, data);
+        *out_log_density = FixDist_log_pdf_sum(dist, m->data, m->rows * m->columns);
+        *out_count = m->rows * m->columns;
+        return true;
+    }
+
+    Box *items;
+    size_t num_items;
+    if(!Box_as_sequence(data, &items, &num_items)) { return false; }
+
+    double buffer[OBSERVE_CHUNK];
+    double log_density = 0.0;
+    for(size_t start = 0; start < num_items; start += OBSERVE_CHUNK) {
+        size_t n = num_items - start < OBSERVE_CHUNK ? num_items - start : OBSERVE_CHUNK;
+        for(size_t i = 0; i < n; i++) {
+            if(!Box_try_numeric(items[start + i], &buffer[i])) { return false; }
+        }
+        log_density += FixDist_log_pdf_sum(dist, buffer, n);
+    }
+    *out_log_density = log_density;
+    *out_count = num_items;
+    return true;
+}
+
+/// @brief observe(dist, data) -- conditions the current model run on `data` drawn from `dist`;
+///     ... observe(log_density, ...) adds log-density terms directly
+/// @note the log-density goes to ctx().inference, which samplers reset before running the
+///     ... model body and read after; data may be one number or a whole vector, which is
+///     ... scored by one batched log_pdf kernel (cf. FixDist_log_pdf_sum) rather than per element
+/// @note a distribution alone observes nothing, so it is an error rather than a zero weight
+/// @example
+///     observe(normal(m * x + c, sigma), ys)
+///     observe(-0.5 * ((y - m) / sigma) ** 2)
+/// @return the accumulated log weight of this run
+Box native_observe(FixFn *self, FixScope parent, FixArray args) {
+    native_log_call(self, args);
+
+    native_return_error_if(len(args) == 1 && Box_is_Boxed_type(args.data[0], BXD_FIX_DISTRIBUTION),
+        sMSG("observe(): expected a distribution and the data it observes, eg., observe(normal(mu, 1), y)"));
+
+    if(len(args) == 2 && Box_is_Boxed_type(args.data[0], BXD_FIX_DISTRIBUTION)) {
+        FixDist *dist = Box_unwrap_typed_ptr(FixDist, args.data[0]);
+        native_return_error_if(dist->log_pdf_fn_ptr == nullptr, sMSG("observe(): distribution has no log_pdf"));
+
+        double log_density;
+        size_t count;
+        native_return_error_if(!native_observe_Box(dist, args.data[1], &log_density, &count),
+            sMSG("observe(): expected a number or a vector of numbers, got %.*s"), fmt(ubx_nameof(args.data[1].type)));
+        ctx_local().inference.log_weight += log_density;
+        ctx_local().inference.num_observed += count;
+        return Box_wrap_float((float) ctx_local().inference.log_weight);
+    }
+
+    for(size_t i = 0; i < len(args); i++) {
+        double term;
+        native_return_error_if(!Box_try_numeric(args.data[i], &term),
+            sMSG("observe(): expected a distribution and data, or a log-density, got %.*s"),
+            fmt(ubx_nameof(args.data[i].type)));
+        ctx_local().inference.log_weight += term;
+        ctx_local().inference.num_observed++;
+    }
+    return Box_wrap_float((float) ctx_local().inference.log_weight);
+}
+
+/// @brief log_pdf(dist, x) -- the log-density of x, or the summed log-density of a vector of x
+Box native_log_pdf(FixFn *self, FixScope parent, Box distObject, Box data) {
+    native_log_call2(self, distObject, data);
+
+    native_return_error_if(!(Box_is_Boxed_type(distObject, BXD_FIX_DISTRIBUTION)),
+        sMSG("log_pdf(): expected a distribution, got %.*s"), fmt(ubx_nameof(distObject.type)));
+
+    FixDist *dist = Box_unwrap_typed_ptr(FixDist, distObject);
+    double log_density;
+    size_t count;
+    native_return_error_if(!native_observe_Box(dist, data, &log_density, &count),
+        sMSG("log_pdf(): expected a number or a vector of numbers, got %.*s"), fmt(ubx_nameof(data.type)));
+    return Box_wrap_float((float) log_density);
+}
+
+/// @brief Builds a distribution value from numeric args, checking its parameterisation
+static Box native_dist_new(FixFn *self, FixDistType type, FixArray args) {
+    double params[DIST_MAX_INLINE_PARAMS];
+    native_return_error_if(len(args) > DIST_MAX_INLINE_PARAMS,
+        sMSG("%.*s(): too many parameters (%zu)"), fmt(self->name), len(args));
+
+    for(size_t i = 0; i < len(args); i++) {
+        native_return_error_if(!Box_try_numeric(args.data[i], &params[i]),
+            sMSG("%.*s(): expected numeric parameters, got %.*s"), fmt(self->name), fmt(ubx_nameof(args.data[i].type)));
+    }
+    native_return_error_if(!FixDist_params_valid(type, params, len(args)),
+        sMSG("%.*s(): invalid parameters"), fmt(self->name));
+
+    FixDist *dist = FixDist_new(type, params, len(args));
+    native_return_error_if(dist == nullptr, sMSG("%.*s(): could not allocate"), fmt(self->name));
+    return Box_wrap_BoxedArena(dist);
+}
+
+/// @brief normal(mean, sd) -- a distribution value, to sample(), observe() or log_pdf()
+Box native_normal(FixFn *self, FixScope parent, FixArray args) {
+    native_log_call(self, args);
+    return native_dist_new(self, DIST_NORMAL, args);
+}
+
+/// @brief gamma(shape, rate)
+Box native_gamma(FixFn *self, FixScope parent, FixArray args) {
+    native_log_call(self, args);
+    return native_dist_new(self, DIST_GAMMA, args);
+}
+
+/// @brief exponential(rate)
+Box native_exponential(FixFn *self, FixScope parent, FixArray args) {
+    native_log_call(self, args);
+    return native_dist_new(self, DIST_EXPONENTIAL, args);
+}
+
+/// @brief uniform(low, high)
+Box native_uniform(FixFn *self, FixScope parent, FixArray args) {
+    native_log_call(self, args);
+    return native_dist_new(self, DIST_UNIFORM, args);
+}
+
+/// @brief beta(alpha, beta)
+Box native_beta(FixFn *self, FixScope parent, FixArray args) {
+    native_log_call(self, args);
+    return native_dist_new(self, DIST_BETA, args);
+}
+
+/// @brief
+/// @example
+///     range(3) -> [0, 1, 2, 3]
+///     range(1, 3) -> [1, 2, 3]
+///     range(0, 4, 2) -> [0, 2, 4]
+/// @param self
+/// @param parent
+/// @param args
+/// @return FixArray as Box
+/// @brief range(to), range(from, to), range(from, to, step) -- an inclusive lazy stream
+/// @note elements are computed per pull, so range(1, 10_000_000) costs a single FixIter
+Box native_range(FixFn *self, FixScope parent, FixArray args) {
+    double from = 0, to = 0, step = 1;
+    switch(args.meta.size) {
+        case 3:
+            Box_try_numeric(args.data[0], &from);
+            Box_try_numeric(args.data[1], &to);
+            Box_try_numeric(args.data[2], &step);
+            break;
+        case 2:
+            Box_try_numeric(args.data[0], &from);
+            Box_try_numeric(args.data[1], &to);
+            break;
+        case 1:
+            Box_try_numeric(args.data[0], &to);
+            break;
+        default:
+            native_return_error_if(true,
+                sMSG("Incorrect number of args (%zu): `range(start, end, step)`"), len(args));
+    }
+
+    native_return_error_if(step == 0, sMSG("Cannot create a range with step 0"));
+    native_return_error_if(step < 0 && from < to, sMSG("Cannot create a range with negative step and positive start"));
+
+    FixIter *iter = FixIter_range_new(from, to, step);
+    native_return_error_if(iter == nullptr, sMSG("Could not allocate range"));
+    return Box_wrap_BoxedArena(iter);
+}
+
+/// @brief The traced, initialised graph of a `loop fn` model without yields, or nullptr
+static FixModelGraph *native_infer_graph(Box loopFn) {
+    if(!(Box_is_Boxed_type(loopFn, BXD_FIX_ITER))) { return nullptr; }
+
+    FixGenFrame *frame = Box_unwrap_FixIter(loopFn)->gen_frame;
+    if(frame == nullptr || frame->code->has_yield) { return nullptr; }
+
+    FixModelGraph *model = FixModelGraph_trace(frame->code->body, &frame->locals);
+    return model != nullptr && FixModelGraph_init(model) ? model : nullptr;
+}
+
+/// @brief The stream of posterior draws of a model under an inference strategy
+/// @note calling a `loop fn` model already gives a stream (one run of its body per pull),
+///     ... so the result stays lazy: `.take(n)` runs the model n times, as it is pulled;
+///     ... a plain function is called once per pull instead
+/// @note #SMC runs SMC_DEFAULT_PARTICLES copies of the model stream, one step per round,
+///     ... weighting each by its observe() calls and resampling them (cf. FlxParticles)
+/// @note #MCMC first traces a `loop fn` body without yields into a FixModelGraph: each
+///     ... draw is then one Metropolis-Hastings sweep, and a proposal for one latent
+///     ... re-evaluates only the terms downstream of it. Bodies that cannot be traced
+///     ... (and #HMC, until it has a gradient kernel) run whole-body Metropolis instead:
+///     ... each pull reruns the model and accepts the run on its observe() weight
+/// @note #VI (ADVI) and #MAP (L-BFGS) trace the model the same way, into a FixInferModel
+///     ... (cf. FixModelGraph_fit), and fit it once: #VI gives a stream of draws from the
+///     ... fitted approximation, #MAP the body's result at the mode
+/// @example
+///     log(infer(model(), #MCMC).take(3))
+///     log(infer(random_walk(), #SMC).take(1000))
+///     log(infer(model(), #MAP))
+/// @param self
+/// @param parent
+/// @param loopFn
+/// @param strategyTag
+/// @return
+Box native_infer(FixFn *self, FixScope parent, Box loopFn, Box strategyTag) {
+    native_log_call2(self, loopFn, strategyTag);
+
+    bool is_smc = Box_tag_eq(strategyTag, s("#SMC"));
+    bool is_mcmc = Box_tag_eq(strategyTag, s("#MCMC"));
+    bool is_vi = Box_tag_eq(strategyTag, s("#VI"));
+    bool is_map = Box_tag_eq(strategyTag, s("#MAP"));
+    native_return_error_if(!is_smc && !is_mcmc && !is_vi && !is_map && !Box_tag_eq(strategyTag, s("#HMC")),
+        sMSG("Unknown inference strategy: %.*s"), fmt(Box_to_FixStr(strategyTag)));
+
+    if(is_vi || is_map) {
+        FixModelGraph *model = native_infer_graph(loopFn);
+        native_return_error_if(model == nullptr || FixModelGraph_fit(model, is_vi ? INFERENCE_VI : INFERENCE_MAP) == nullptr,
+            sMSG("infer(): %s needs a `loop fn` model with one observe() of data, whose distribution takes each latent, "
+                 "e.g. observe(normal(mu, sigma), ys)"), is_vi ? "#VI" : "#MAP");
+        if(is_map) {
+            Box mode = FixModelGraph_fit_result(model, false);
+            native_return_error_if(Box_is_error(mode), sMSG("infer(): could not evaluate the model at its mode"));
+            return mode;
+        }
+
+        FixIter *draws = FixIter_vi_new(model);
+        native_return_error_if(draws == nullptr, sMSG("infer(): could not create the draw stream"));
+        return Box_wrap_BoxedArena(draws);
+    }
+
+    if(is_mcmc) {
+        FixModelGraph *model = native_infer_graph(loopFn);
+        if(model != nullptr) {
+            FixIter *chain = FixIter_mcmc_new(model);
+            native_return_error_if(chain == nullptr, sMSG("infer(): could not create the draw stream"));
+            return Box_wrap_BoxedArena(chain);
+        }
+    }
+
+    FixIter *draws;
+    if(Box_is_Boxed_type(loopFn, BXD_FIX_ITER)) {
+        draws = FixIter_drop_new(loopFn, 0);
+    } else {
+        native_return_error_if(loopFn.type != UBX_PTR_ARENA,
+            sMSG("infer(): expected a model stream or function, got %.*s"), fmt(ubx_nameof(loopFn.type)));
+        draws = FixIter_fn_new(loopFn, &parent, SIZE_MAX);
+    }
+
+    if(draws != nullptr) {
+        draws = is_smc ? FixIter_smc_new(draws, SMC_DEFAULT_PARTICLES) : FixIter_metropolis_new(draws);
+    }
+
+    native_return_error_if(draws == nullptr, sMSG("infer(): could not create the draw stream"));
+    return Box_wrap_BoxedArena(draws);
+}
+
+/// @brief sample(dist) -- one draw from a distribution value, or from an object with a
+///     ... `sample` method; a plain number is a point mass and is returned as is
+/// @example
+///     let
+///         m = sample(normal(0, 2))
+///     in
+///         observe(normal(f(10, m, c), sigma), y);
+///
+Box native_sample(FixFn *self, FixScope parent, Box distObject) {
+    native_log_call1(self, distObject);
+
+    if(Box_is_Boxed_type(distObject, BXD_FIX_DISTRIBUTION)) {
+        FixDist *dist = Box_unwrap_typed_ptr(FixDist, distObject);
+        return Box_wrap_float((float) dist->sample_fn_ptr(dist));
+    }
+
+    double point;
+    if(Box_try_numeric(distObject, &point)) {
+        return distObject;
+    }
+
+    native_return_error_if(!(Box_is_Boxed_type(distObject, BXD_FLX_OBJECT)),
+        sMSG("sample(): expected a distribution, got %.*s"), fmt(ubx_nameof(distObject.type)));
+
+    Box fn = FlxObject_getattr_checked(
+        Box_unwrap_FixObject(distObject), s("sample"), UBX_PTR_ARENA
+    );
+
+    native_return_error_if(Box_is_error(fn),
+        sMSG("Expected object to have a `sample` method"));
+
+    return FixFn_call(Box_unwrap_FixFn(fn), parent, (FixArray) {
+        .meta.capacity = 1,
+        .meta.size = 1,
+        .data = &distObject
+    });
+}
+
+/// @brief Reads a non-negative int argument of the view natives
+static bool native_count_from_Box(Box arg, size_t *out_count) {
+    if(arg.type != UBX_INT || Box_unwrap_int(arg) < 0) { return false; }
+    *out_count = (size_t) Box_unwrap_int(arg);
+    return true;
+}
+
+/// @brief take(xs, n) -- the first n elements: a view of an array or view (no copy),
+///     ... or a lazy stream over an iterator
+/// @note the stream reads a copy of the iterator (cf. Box_iter_pass), which keeps its place
+/// @note also accepts take(n, xs)
+Box native_take(FixFn *self, FixScope parent, FixArray args) {
+    native_log_call(self, args);
+
+    size_t count = 0;
+    if(len(args) == 2) {
+        bool count_first = args.data[0].type == UBX_INT;
+        Box sequence = count_first ? args.data[1] : args.data[0];
+        if(Box_is_iterable(sequence)) {
+            native_return_error_if(!native_count_from_Box(count_first ? args.data[0] : args.data[1], &count),
+                sMSG("take(): expected a non-negative count"));
+
+            if(Box_is_Boxed_type(sequence, BXD_FIX_ITER)) {
+                Box pass = Box_iter_pass(sequence);
+                FixIter *iter = Box_is_error(pass) ? nullptr : FixIter_take_new(pass, count);
+                native_return_error_if(iter == nullptr, sMSG("take(): could not create stream"));
+                return Box_wrap_BoxedArena(iter);
+            }
+            FixArrayView *view = FixArrayView_of_Box(sequence, 0, count);
+            native_return_error_if(view == nullptr, sMSG("take(): could not create view"));
+            return Box_wrap_BoxedArena(view);
+        }
+    }
+
+    return Box_wrap_FixError(native_error(
+        sMSG("Incorrect args (%zu): `take(xs, n)` expects an array, view or stream and a count"), len(args)));
+}
+
+/// @brief drop(xs, n) -- all but the first n elements, as a view (no copy) or a lazy stream
+Box native_drop(FixFn *self, FixScope parent, Box sequence, Box count) {
+    native_log_call2(self, sequence, count);
+
+    size_t n = 0;
+    native_return_error_if(!native_count_from_Box(count, &n), sMSG("drop(): expected a non-negative count"));
+    if(Box_is_Boxed_type(sequence, BXD_FIX_ITER)) {
+        Box pass = Box_iter_pass(sequence);
+        FixIter *iter = Box_is_error(pass) ? nullptr : FixIter_drop_new(pass, n);
+        native_return_error_if(iter == nullptr, sMSG("drop(): could not create stream"));
+        return Box_wrap_BoxedArena(iter);
+    }
+    FixArrayView *view = FixArrayView_of_Box(sequence, n, SIZE_MAX);
+    native_return_error_if(view == nullptr,
+        sMSG("drop(): expected array or view, got %.*s"), fmt(ubx_nameof(sequence.type)));
+    return Box_wrap_BoxedArena(view);
+}
+
+/// @brief Shared by window/chunk: views [i * stride, i * stride + size) over `sequence`
+static Box native_views_of(Box sequence, size_t size, size_t stride, size_t num_views) {
+    FixArray *views = FixArray_new_auto(num_views > 0 ? num_views : 1);
+    native_return_error_if(views == nullptr, sMSG("Could not allocate views"));
+
+    for(size_t i = 0; i < num_views; i++) {
+        FixArrayView *view = FixArrayView_of_Box(sequence, i * stride, i * stride + size);
+        native_return_error_if(view == nullptr, sMSG("Could not allocate view"));
+        FixArray_append(views, Box_wrap_BoxedArena(view));
+    }
+    return Box_wrap_BoxedArena(views);
+}
+
+/// @brief window(xs, k) -- every length-k sliding window, each a view onto xs
+Box native_window(FixFn *self, FixScope parent, Box sequence, Box size) {
+    native_log_call2(self, sequence, size);
+
+    Box *items = nullptr;
+    size_t num_items = 0, k = 0;
+    native_return_error_if(!Box_as_sequence(sequence, &items, &num_items),
+        sMSG("window(): expected array or view, got %.*s"), fmt(ubx_nameof(sequence.type)));
+    native_return_error_if(!native_count_from_Box(size, &k) || k == 0, sMSG("window(): expected a positive size"));
+
+    return native_views_of(sequence, k, 1, num_items >= k ? num_items - k + 1 : 0);
+}
+
+/// @brief chunk(xs, k) -- consecutive length-k views onto xs (the last may be shorter)
+Box native_chunk(FixFn *self, FixScope parent, Box sequence, Box size) {
+    native_log_call2(self, sequence, size);
+
+    Box *items = nullptr;
+    size_t num_items = 0, k = 0;
+    native_return_error_if(!Box_as_sequence(sequence, &items, &num_items),
+        sMSG("chunk(): expected array or view, got %.*s"), fmt(ubx_nameof(sequence.type)));
+    native_return_error_if(!native_count_from_Box(size, &k) || k == 0, sMSG("chunk(): expected a positive size"));
+
+    return native_views_of(sequence, k, k, (num_items + k - 1) / k);
+}
+
+
+/// ----- Parallel map and reduce ----- ///
+
+/// @brief Elements per chunk below which a parallel job is not split further
+#define PAR_MIN_CHUNK 8
+
+/// @brief One `par for`, par_map or par_reduce: elements `[0, num_items)` of the sources,
+///     ... evaluated in chunks on the compute pool
+/// @note the caller's scope is shared read-only: each element gets a fresh child scope, so
+///     ... workers only ever write to their own scopes, arenas and result slots
+typedef struct FixParJob {
+    FixScope *scope;
+    FixFn *fn;              /// par_map/par_reduce: applied to the element(s)
+    Ast *body;              /// `par for`: evaluated with `bindings` defined per element
+    Ast **bindings;
+    Box **items;            /// per binding; nullptr for a binding defined once in `scope`
+    size_t num_sources;
+    size_t num_items;
+    Box *results;
+} FixParJob;
+
+typedef struct FixParChunk {
+    FixParJob *job;
+    size_t start;
+    size_t end;
+    Box result;             /// par_reduce: the fold of the chunk; else the first error
+    FixError error;         /// why the chunk failed, from the log of the thread it ran on
+} FixParChunk;
+
+/// @brief The elements of a finite iterable: arrays and views in place, streams pulled once
+static Box *FixPar_items(Box source, size_t *out_len) {
+    Box *items = nullptr;
+    if(Box_as_sequence(source, &items, out_len)) { return items; }
+
+    size_t capacity = ARRAY_SIZE_SMALL, n = 0;
+    items = Arena_alloc(capacity * sizeof(Box));
+
+    Box item;
+    while(items != nullptr && Box_iter_next(source, n, &item)) {
+        if(n == capacity) {
+            Box *grown = Arena_alloc(2 * capacity * sizeof(Box));
+            if(grown != nullptr) { memcpy(grown, items, n * sizeof(Box)); }
+            items = grown;
+            capacity *= 2;
+            if(items == nullptr) { break; }
+        }
+        items[n++] = item;
+    }
+
+    if(items == nullptr) { error_oom(); return nullptr; }
+    *out_len = n;
+    return items;
+}
+
+/// @brief Calls the job's fn on `args` in a fresh child of the shared scope
+/// @note each call is an evaluation of its own: its traces are dropped once it returns, and
+///     ... an error it raises unwinds no further than here, whichever thread it runs on
+static Box FixPar_call(FixParJob *job, Box *args, size_t num_args) {
+    CallStack *traces = ctx_local().debug.callstack;
+    size_t depth = traces == nullptr ? 0 : traces->top;
+
+    FixScope call_scope = FixScope_empty(sMSG("$Scope"));
+    FixScope_data_new(&call_scope, job->scope);
+
+    InterpRecover point;
+    interp_try(&point) {
+        Box result = FixFn_call(job->fn, call_scope, (FixArray) {
+            .meta.capacity = num_args,
+            .meta.size = num_args,
+            .data = args
+        });
+        interp_try_end(&point);
+
+        if(traces != nullptr) { traces->top = depth; }
+        return result;
+    }
+    return Box_exit();
+}
+
+/// @brief Element `i` of a map: the fn applied to it, or the body with it bound
+static Box FixPar_apply(FixParJob *job, size_t i) {
+    if(job->fn != nullptr) {
+        return FixPar_call(job, &job->items[0][i], 1);
+    }
+
+    CallStack *traces = ctx_local().debug.callstack;
+    size_t depth = traces == nullptr ? 0 : traces->top;
+
+    FixScope iter_scope = FixScope_empty(sMSG("$Scope"));
+    FixScope_data_new(&iter_scope, job->scope);
+    for(size_t b = 0; b < job->num_sources; b++) {
+        if(job->items[b] == nullptr) { continue; }
+        FixScope_define_local(&iter_scope, job->bindings[b]->binding.identifier, job->items[b][i]);
+    }
+
+    InterpRecover point;
+    interp_try(&point) {
+        Box result = interp_eval_ast(job->body, &iter_scope);
+        interp_try_end(&point);
+
+        if(traces != nullptr) { traces->top = depth; }
+        return result;
+    }
+    return Box_exit();
+}
+
+/// @brief Records that `chunk` failed with `result`, keeping the error that caused it
+static void FixPar_fail(FixParChunk *chunk, Box result) {
+    size_t num_errors = ctx_local().debug.num_errors;
+    chunk->result = result;
+    if(num_errors > 0) {
+        chunk->error = ctx_local().debug.errors[(num_errors - 1) % ARRAY_SIZE_SMALL];
+    }
+}
+
+/// @brief The failure of `chunk`, its error moved into the caller's log if it ran elsewhere
+static Box FixPar_raise(FixParChunk *chunk) {
+    size_t num_errors = ctx_local().debug.num_errors;
+    bool logged = num_errors > 0 &&
+        ctx_local().debug.errors[(num_errors - 1) % ARRAY_SIZE_SMALL].message.cstr == chunk->error.message.cstr;
+    if(!logged && chunk->error.message.cstr != nullptr) { error_push(chunk->error); }
+    return chunk->result;
+}
+
+static void *FixPar_map_chunk(void *arg) {
+    FixParChunk *chunk = (FixParChunk *) arg;
+    FixParJob *job = chunk->job;
+
+    for(size_t i = chunk->start; i < chunk->end; i++) {
+        Box result = FixPar_apply(job, i);
+        if(Box_is_failed(result)) { FixPar_fail(chunk, result); return nullptr; }
+        job->results[i] = result;
+    }
+    return nullptr;
+}
+
+static void *FixPar_reduce_chunk(void *arg) {
+    FixParChunk *chunk = (FixParChunk *) arg;
+    FixParJob *job = chunk->job;
+
+    chunk->result = job->items[0][chunk->start];
+    for(size_t i = chunk->start + 1; i < chunk->end; i++) {
+        Box args[2] = { chunk->result, job->items[0][i] };
+        Box result = FixPar_call(job, args, 2);
+        if(Box_is_failed(result)) { FixPar_fail(chunk, result); return nullptr; }
+        chunk->result = result;
+    }
+    return nullptr;
+}
+
+/// @brief Runs `worker` over the job's elements in contiguous chunks
+/// @note the chunking depends only on the number of elements, never on the number of
+///     ... workers, so a reduce combines the same partial results on every machine
+/// @return the number of chunks run
+static size_t FixPar_run(FixParJob *job, FixParChunk *chunks, void *(*worker)(void *)) {
+    size_t num_chunks = (job->num_items + PAR_MIN_CHUNK - 1) / PAR_MIN_CHUNK;
+    if(num_chunks > CPU_CORES_MAX) { num_chunks = CPU_CORES_MAX; }
+    if(num_chunks == 0) { return 0; }
+
+    for(size_t c = 0; c < num_chunks; c++) {
+        chunks[c] = (FixParChunk) {
+            .job = job,
+            .start = c * job->num_items / num_chunks,
+            .end = (c + 1) * job->num_items / num_chunks,
+            .result = Box_null()
+        };
+    }
+    TaskPool_run(chunks, sizeof(FixParChunk), num_chunks, worker);
+    return num_chunks;
+}
+
+/// @brief Maps the job's elements into a new array, in element order
+static Box FixPar_map(FixParJob *job) {
+    FixArray *results = FixArray_new_auto(job->num_items > 0 ? job->num_items : 1);
+    native_return_error_if(results == nullptr, sMSG("Could not allocate parallel results"));
+    job->results = results->data;
+
+    FixParChunk chunks[CPU_CORES_MAX];
+    size_t num_chunks = FixPar_run(job, chunks, FixPar_map_chunk);
+    for(size_t c = 0; c < num_chunks; c++) {
+        if(Box_is_failed(chunks[c].result)) { return FixPar_raise(&chunks[c]); }
+    }
+
+    results->meta.size = job->num_items;
+    return Box_wrap_BoxedArena(results);
+}
+
+/// @brief par_map(f, xs) -- [f(x) for x in xs], with the calls spread over the compute pool
+/// @note `f` must not mutate shared state; xs may be an array, view or finite stream
+/// @example
+///     const ys = par_map(fn(x) -> x * x, range(0, 1000))
+Box native_par_map(FixFn *self, FixScope parent, Box fn, Box sequence) {
+    native_log_call2(self, fn, sequence);
+
+    native_return_error_if(fn.type != UBX_PTR_ARENA,
+        sMSG("par_map(): expected a function, got %.*s"), fmt(ubx_nameof(fn.type)));
+    native_return_error_if(!Box_is_iterable(sequence),
+        sMSG("par_map(): expected array, view or stream, got %.*s"), fmt(ubx_nameof(sequence.type)));
+
+    size_t num_items = 0;
+    Box *items = FixPar_items(sequence, &num_items);
+    native_return_error_if(items == nullptr, sMSG("par_map(): could not read the sequence"));
+
+    FixParJob job = {
+        .scope = &parent,
+        .fn = Box_unwrap_FixFn(fn),
+        .items = &items,
+        .num_sources = 1,
+        .num_items = num_items
+    };
+    return FixPar_map(&job);
+}
+
+/// @brief par_reduce(f, xs, init) -- f(...f(f(init, x0), x1)..., xn) for an associative f
+/// @note chunks are folded in parallel, then their results are folded into `init` in order
+/// @example
+///     const total = par_reduce(fn(a, b) -> a + b, xs, 0)
+Box native_par_reduce(FixFn *self, FixScope parent, Box fn, Box sequence, Box init) {
+    native_log_call3(self, fn, sequence, init);
+
+    native_return_error_if(fn.type != UBX_PTR_ARENA,
+        sMSG("par_reduce(): expected a function, got %.*s"), fmt(ubx_nameof(fn.type)));
+    native_return_error_if(!Box_is_iterable(sequence),
+        sMSG("par_reduce(): expected array, view or stream, got %.*s"), fmt(ubx_nameof(sequence.type)));
+
+    size_t num_items = 0;
+    Box *items = FixPar_items(sequence, &num_items);
+    native_return_error_if(items == nullptr, sMSG("par_reduce(): could not read the sequence"));
+
+    FixParJob job = {
+        .scope = &parent,
+        .fn = Box_unwrap_FixFn(fn),
+        .items = &items,
+        .num_sources = 1,
+        .num_items = num_items
+    };
+
+    FixParChunk chunks[CPU_CORES_MAX];
+    size_t num_chunks = FixPar_run(&job, chunks, FixPar_reduce_chunk);
+
+    Box result = init;
+    for(size_t c = 0; c < num_chunks; c++) {
+        if(Box_is_failed(chunks[c].result)) { return FixPar_raise(&chunks[c]); }
+        Box args[2] = { result, chunks[c].result };
+        result = FixPar_call(&job, args, 2);
+        if(Box_is_failed(result)) { return result; }
+    }
+    return result;
+}
+
+
+Box native_input(FixFn *self, FixScope parent, FixArray args) {
+    native_log_call(self, args);
+
+    require_not_null(self);
+    require_not_null(parent.data.data);
+    require_not_null(args.data);
+
+    native_return_error_if(args.meta.size != 1, sMSG("Expected 1 argument, got %zu"), len(args));
+    native_return_error_if(args.data[0].type != UBX_PTR_ARENA, sMSG("Expected string argument type, got %s"), ubx_nameof(args.data[0].type));
+
+    FixStr prompt = Box_unwrap_FixStr(args.data[0]);
+    FixStr_puts(prompt);
+
+    return Box_wrap_BoxedHeap(FixStr_flexible_new(FixStr_readline_new(1024)));
+}
+
+/// @brief Copies a string argument into a nul-terminated buffer for the OS file APIs
+static bool native_path_from_Box(Box arg, char *path, size_t path_size) {
+    if(arg.type != UBX_PTR_ARENA) { return false; }
+
+    FixStr path_str = Box_unwrap_FixStr(arg);
+    if(path_str.size >= path_size) { return false; }
+    snprintf(path, path_size, "%.*s", fmt(path_str));
+    return true;
+}
+
+Box native_read_csv(FixFn *self, FixScope parent, Box path) {
+    native_log_call1(self, path);
+
+    char filename[1024];
+    native_return_error_if(!native_path_from_Box(path, filename, sizeof(filename)),
+        sMSG("Expected string path argument, got %s"), ubx_nameof(path.type));
+
+    FlxDataFrame *df = FlxDataFrame_read_csv(filename, ',');
+    native_return_error_if(df == nullptr, sMSG("Could not load csv '%s'"), filename);
+    return Box_wrap_BoxedHeap(df);
+}
+
+Box native_save_columns(FixFn *self, FixScope parent, Box frame, Box path) {
+    native_log_call2(self, frame, path);
+
+    native_return_error_if(!(Box_is_Boxed_type(frame, BXD_FLX_DATAFRAME)),
+        sMSG("Expected dataframe argument, got %s"), ubx_nameof(frame.type));
+
+    char filename[1024];
+    native_return_error_if(!native_path_from_Box(path, filename, sizeof(filename)),
+        sMSG("Expected string path argument, got %s"), ubx_nameof(path.type));
+
+    FlxDataFrame *df = Box_unwrap_typed_ptr(FlxDataFrame, frame);
+    return Box_wrap_bool(FlxDataFrame_write_columnar(df, filename));
+}
+
+Box native_load_columns(FixFn *self, FixScope parent, Box path) {
+    native_log_call1(self, path);
+
+    char filename[1024];
+    native_return_error_if(!native_path_from_Box(path, filename, sizeof(filename)),
+        sMSG("Expected string path argument, got %s"), ubx_nameof(path.type));
+
+    FlxDataFrame *df = FlxDataFrame_map_columnar(filename);
+    native_return_error_if(df == nullptr, sMSG("Could not map columnar file '%s'"), filename);
+    return Box_wrap_BoxedHeap(df);
+}
+
+/// @brief Reads a string argument of the dataframe natives, eg., a column name
+static bool native_name_from_Box(Box arg, FixStr *out_name) {
+    if(arg.type != UBX_PTR_ARENA) { return false; }
+    *out_name = Box_unwrap_FixStr(arg);
+    return true;
+}
+
+/// @brief Reads a comparison tag of filter(): #LT, #LE, #GT, #GE, #EQ or #NE
+static bool native_cmp_from_Box(Box tag, FlxCmpOp *out_op) {
+    static const struct { FixStr tag; FlxCmpOp op; } ops[] = {
+        { s("#LT"), CMP_LT }, { s("#LE"), CMP_LE }, { s("#GT"), CMP_GT },
+        { s("#GE"), CMP_GE }, { s("#EQ"), CMP_EQ }, { s("#NE"), CMP_NE }
+    };
+    for(size_t i = 0; i < sizeof(ops) / sizeof(ops[0]); i++) {
+        if(Box_tag_eq(tag, ops[i].tag)) { *out_op = ops[i].op; return true; }
+    }
+    return false;
+}
+
+/// @brief Reads an aggregate tag of group_by() and aggregate(): #COUNT, #SUM, #MEAN, #MIN or #MAX
+static bool native_agg_from_Box(Box tag, FlxAggOp *out_op) {
+    static const struct { FixStr tag; FlxAggOp op; } ops[] = {
+        { s("#COUNT"), AGG_COUNT }, { s("#SUM"), AGG_SUM }, { s("#MEAN"), AGG_MEAN },
+        { s("#MIN"), AGG_MIN }, { s("#MAX"), AGG_MAX }
+    };
+    for(size_t i = 0; i < sizeof(ops) / sizeof(ops[0]); i++) {
+        if(Box_tag_eq(tag, ops[i].tag)) { *out_op = ops[i].op; return true; }
+    }
+    return false;
+}
+
+/// @brief column(df, name) -- a dataframe column, unboxed, as df.name does
+/// @note a double column goes to observe() as is, scored by one batched kernel
+/// @example
+///     observe(normal(mu, 1), column(df, "y"))
+///     observe(normal(mu, 1), df.y)
+Box native_column(FixFn *self, FixScope parent, Box frame, Box name) {
+    native_log_call2(self, frame, name);
+
+    FixStr column_name;
+    native_return_error_if(!(Box_is_Boxed_type(frame, BXD_FLX_DATAFRAME)),
+        sMSG("column(): expected a dataframe, got %.*s"), fmt(ubx_nameof(frame.type)));
+    native_return_error_if(!native_name_from_Box(name, &column_name),
+        sMSG("column(): expected a column name, got %.*s"), fmt(ubx_nameof(name.type)));
+
+    Boxed *column = FlxDataFrame_column(Box_unwrap_typed_ptr(FlxDataFrame, frame), column_name);
+    native_return_error_if(column == nullptr, sMSG("column(): no column '%.*s'"), fmt(column_name));
+    return Box_wrap_BoxedHeap(column);
+}
+
+/// @brief filter(df, name, #OP, value) -- the rows whose column `name` compares to `value`
+/// @note a numeric column compares with #LT, #LE, #GT, #GE, #EQ or #NE; a categorical
+///     ... column with #EQ or #NE against a string. The selection is one bitmask pass,
+///     ... then the kept rows are copied into a new frame (cf. FlxDataFrame_compact)
+/// @example
+///     filter(df, "y", #GE, 100)
+///     filter(df, "group", #EQ, "a")
+Box native_filter(FixFn *self, FixScope parent, FixArray args) {
+    native_log_call(self, args);
+
+    FixStr name;
+    FlxCmpOp op;
+    native_return_error_if(len(args) != 4, sMSG("Incorrect number of args (%zu): `filter(df, name, #OP, value)`"), len(args));
+    native_return_error_if(!(Box_is_Boxed_type(args.data[0], BXD_FLX_DATAFRAME)),
+        sMSG("filter(): expected a dataframe, got %.*s"), fmt(ubx_nameof(args.data[0].type)));
+    native_return_error_if(!native_name_from_Box(args.data[1], &name),
+        sMSG("filter(): expected a column name, got %.*s"), fmt(ubx_nameof(args.data[1].type)));
+    native_return_error_if(!native_cmp_from_Box(args.data[2], &op),
+        sMSG("filter(): expected one of #LT, #LE, #GT, #GE, #EQ, #NE, got %.*s"), fmt(Box_to_FixStr(args.data[2])));
+
+    FlxDataFrame *df = Box_unwrap_typed_ptr(FlxDataFrame, args.data[0]);
+    Boxed *column = FlxDataFrame_column(df, name);
+    native_return_error_if(column == nullptr, sMSG("filter(): no column '%.*s'"), fmt(name));
+
+    FixBitmask mask;
+    double rhs;
+    FixStr category;
+    if(column->meta.type == BXD_FLX_VEC_TAGS) {
+        native_return_error_if((op != CMP_EQ && op != CMP_NE) || !native_name_from_Box(args.data[3], &category),
+            sMSG("filter(): a categorical column compares with #EQ or #NE against a string"));
+        mask = FlxVecCat_filter_eq(Boxed_as(FlxVecCat, column), category);
+        if(op == CMP_NE && mask.data != nullptr) { FixBitmask_not(&mask); }
+    } else {
+        native_return_error_if(!Box_try_numeric(args.data[3], &rhs),
+            sMSG("filter(): expected a number to compare '%.*s' with, got %.*s"), fmt(name), fmt(ubx_nameof(args.data[3].type)));
+        mask = FlxDataFrame_filter(df, name, op, rhs);
+    }
+    native_return_error_if(mask.data == nullptr && df->num_rows > 0, sMSG("filter(): could not allocate the selection"));
+
+    FlxDataFrame *out = FlxDataFrame_compact(df, &mask);
+    FixBitmask_cfree(&mask);
+    native_return_error_if(out == nullptr, sMSG("filter(): could not create the frame"));
+    return Box_wrap_BoxedHeap(out);
+}
+
+/// @brief select(df, name, ...) -- the named columns, shared with `df` rather than copied
+Box native_select(FixFn *self, FixScope parent, FixArray args) {
+    native_log_call(self, args);
+
+    native_return_error_if(len(args) < 2 || !(Box_is_Boxed_type(args.data[0], BXD_FLX_DATAFRAME)),
+        sMSG("Incorrect args (%zu): `select(df, name, ...)` expects a dataframe and column names"), len(args));
+
+    size_t num_names = len(args) - 1;
+    native_return_error_if(num_names > DATAFRAME_MAX_COLUMNS, sMSG("select(): too many columns (%zu)"), num_names);
+    FixStr names[DATAFRAME_MAX_COLUMNS];
+    FlxDataFrame *df = Box_unwrap_typed_ptr(FlxDataFrame, args.data[0]);
+    for(size_t c = 0; c < num_names; c++) {
+        native_return_error_if(!native_name_from_Box(args.data[c + 1], &names[c]),
+            sMSG("select(): expected a column name, got %.*s"), fmt(ubx_nameof(args.data[c + 1].type)));
+        native_return_error_if(FlxDataFrame_column(df, names[c]) == nullptr, sMSG("select(): no column '%.*s'"), fmt(names[c]));
+    }
+
+    FlxDataFrame *out = FlxDataFrame_select(df, names, num_names);
+    native_return_error_if(out == nullptr, sMSG("select(): could not create the frame"));
+    return Box_wrap_BoxedHeap(out);
+}
+
+/// @brief group_by(df, key, value, #AGG) -- one row per `key`, aggregating the double column `value`
+/// @example
+///     group_by(df, "group", "y", #MEAN)
+Box native_group_by(FixFn *self, FixScope parent, FixArray args) {
+    native_log_call(self, args);
+
+    FixStr key, value;
+    FlxAggOp op;
+    native_return_error_if(len(args) != 4, sMSG("Incorrect number of args (%zu): `group_by(df, key, value, #AGG)`"), len(args));
+    native_return_error_if(!(Box_is_Boxed_type(args.data[0], BXD_FLX_DATAFRAME)),
+        sMSG("group_by(): expected a dataframe, got %.*s"), fmt(ubx_nameof(args.data[0].type)));
+    native_return_error_if(!native_name_from_Box(args.data[1], &key) || !native_name_from_Box(args.data[2], &value),
+        sMSG("group_by(): expected key and value column names"));
+    native_return_error_if(!native_agg_from_Box(args.data[3], &op),
+        sMSG("group_by(): expected one of #COUNT, #SUM, #MEAN, #MIN, #MAX, got %.*s"), fmt(Box_to_FixStr(args.data[3])));
+
+    FlxDataFrame *out = FlxDataFrame_group_by(Box_unwrap_typed_ptr(FlxDataFrame, args.data[0]), key, value, op, nullptr);
+    native_return_error_if(out == nullptr,
+        sMSG("group_by(): could not group '%.*s' by '%.*s' (key must be categorical or int, value double)"), fmt(value), fmt(key));
+    return Box_wrap_BoxedHeap(out);
+}
+
+/// @brief join(left, right, key) -- the inner join of two frames on a shared int or categorical column
+Box native_join(FixFn *self, FixScope parent, Box left, Box right, Box key) {
+    native_log_call3(self, left, right, key);
+
+    FixStr key_name;
+    native_return_error_if(!(Box_is_Boxed_type(left, BXD_FLX_DATAFRAME)) || !(Box_is_Boxed_type(right, BXD_FLX_DATAFRAME)),
+        sMSG("join(): expected two dataframes"));
+    native_return_error_if(!native_name_from_Box(key, &key_name),
+        sMSG("join(): expected a key column name, got %.*s"), fmt(ubx_nameof(key.type)));
+
+    FlxDataFrame *out = FlxDataFrame_join(Box_unwrap_typed_ptr(FlxDataFrame, left), Box_unwrap_typed_ptr(FlxDataFrame, right), key_name);
+    native_return_error_if(out == nullptr, sMSG("join(): could not join on '%.*s'"), fmt(key_name));
+    return Box_wrap_BoxedHeap(out);
+}
+
+/// @brief aggregate(column, #AGG) -- one pass over a double column: #COUNT, #SUM, #MEAN, #MIN or #MAX
+/// @example
+///     aggregate(df.y, #MEAN)
+Box native_aggregate(FixFn *self, FixScope parent, Box column, Box op) {
+    native_log_call2(self, column, op);
+
+    FlxAggOp agg;
+    native_return_error_if(!(Box_is_Boxed_type(column, BXD_FLX_VEC_DOUBLE_N)),
+        sMSG("aggregate(): expected a double column, got %.*s"), fmt(ubx_nameof(column.type)));
+    native_return_error_if(!native_agg_from_Box(op, &agg),
+        sMSG("aggregate(): expected one of #COUNT, #SUM, #MEAN, #MIN, #MAX, got %.*s"), fmt(Box_to_FixStr(op)));
+
+    return Box_wrap_float((float) FlxVecDouble_aggregate(Box_unwrap_typed_ptr(FlxVecDouble, column), nullptr, agg));
+}
+
+/// @brief Pulls `n` draws from a stream into a sample sink, and optionally spills them to `path`
+/// @note the sink keeps running summaries only, so its memory does not grow with `n`;
+///     ... the first draw fixes the number of parameters
+/// @example
+///     log(summarize(infer(model(), #MCMC), 10000))
+///     summarize(infer(model(), #MCMC), 1000000000, "draws.bin")
+Box native_summarize(FixFn *self, FixScope parent, FixArray args) {
+    native_log_call(self, args);
+
+    native_return_error_if(len(args) < 2 || len(args) > 3,
+        sMSG("Incorrect number of args (%zu): `summarize(draws, n, path?)`"), len(args));
+
+    Box draws = args.data[0];
+    size_t n = 0;
+    native_return_error_if(!Box_is_iterable(draws),
+        sMSG("summarize(): expected a stream of draws, got %.*s"), fmt(ubx_nameof(draws.type)));
+    native_return_error_if(!native_count_from_Box(args.data[1], &n) || n == 0,
+        sMSG("summarize(): expected a positive count"));
+
+    char filename[1024];
+    bool spill = len(args) == 3;
+    native_return_error_if(spill && !native_path_from_Box(args.data[2], filename, sizeof(filename)),
+        sMSG("Expected string path argument, got %.*s"), fmt(ubx_nameof(args.data[2].type)));
+
+    Box draw;
+    native_return_error_if(!Box_iter_next(draws, 0, &draw), sMSG("summarize(): the stream has no draws"));
+
+    Box *items = nullptr;
+    size_t num_params = 1;
+    Box_as_sequence(draw, &items, &num_params);
+    native_return_error_if(num_params == 0 || num_params > ARRAY_SIZE_SMALL,
+        sMSG("summarize(): draws must have 1 to %d values"), ARRAY_SIZE_SMALL);
+
+    FlxSampleSink *sink = FlxSampleSink_new(num_params, spill ? filename : nullptr);
+    native_return_error_if(sink == nullptr, sMSG("summarize(): could not create the sample sink"));
+
+    for(size_t i = 0; i < n; i++) {
+        if(i > 0 && !Box_iter_next(draws, i, &draw)) { break; }
+        if(!FlxSampleSink_push_Box(sink, draw)) {
+            FlxSampleSink_close(sink);
+            native_return_error_if(true, sMSG("summarize(): could not record draw %zu"), i);
+        }
+    }
+
+    native_return_error_if(!FlxSampleSink_close(sink), sMSG("summarize(): could not write '%s'"), filename);
+    return Box_wrap_BoxedHeap(sink);
+}
+
+/// @brief Reads a FlxVecDouble, or an array or view of numbers, into a new double buffer
+static double *native_doubles_from_Box_cnew(Box arg, size_t *out_len) {
+    *out_len = 0;
+    if(Box_is_Boxed_type(arg, BXD_FLX_VEC_DOUBLE_N)) {
+        FlxVecDouble *vec = Box_unwrap_typed_ptr(FlxVecDouble, arg);
+        double *out = cnew((len_ref(vec) > 0 ? len_ref(vec) : 1) * sizeof(double));
+        if(out == nullptr) { error_oom(); return nullptr; }
+        memcpy(out, vec->data, len_ref(vec) * sizeof(double));
+        *out_len = len_ref(vec);
+        return out;
+    }
+
+    Box *items = nullptr;
+    size_t num_items = 0;
+    if(!Box_as_sequence(arg, &items, &num_items)) { return nullptr; }
+    double *out = cnew((num_items > 0 ? num_items : 1) * sizeof(double));
+    if(out == nullptr) { error_oom(); return nullptr; }
+
+    for(size_t i = 0; i < num_items; i++) {
+        if(!Box_try_numeric(items[i], &out[i])) { cfree(out); return nullptr; }
+    }
+    *out_len = num_items;
+    return out;
+}
+
+static Box native_Box_from_doubles(const double *values, size_t n) {
+    FlxVecDouble *vec = FlxVecDouble_new(n);
+    if(vec == nullptr) { return Box_error_empty(); }
+    memcpy(vec->data, values, n * sizeof(double));
+    vec->meta.size = n;
+    return Box_wrap_BoxedHeap(vec);
+}
+
+Box native_matrix(FixFn *self, FixScope parent, Box rows) {
+    native_log_call1(self, rows);
+
+    native_return_error_if(!(Box_is_Boxed_type(rows, BXD_FIX_ARRAY)),
+        sMSG("Expected an array of rows, got %s"), ubx_nameof(rows.type));
+    FixArray *array = Box_unwrap_FixArray(rows);
+    native_return_error_if(len_ref(array) == 0, sMSG("Expected at least one row"));
+
+    FlxMatrixF *m = nullptr;
+    for(size_t r = 0; r < len_ref(array); r++) {
+        size_t num_columns = 0;
+        double *row = native_doubles_from_Box_cnew(array->data[r], &num_columns);
+        native_return_error_if(row == nullptr || num_columns == 0, sMSG("Row %zu is not an array of numbers"), r);
+
+        if(m == nullptr) { m = FlxMatrixF_new(len_ref(array), num_columns); }
+        if(m == nullptr) {
+            cfree(row);
+            return Box_wrap_FixError(native_error(sMSG("Could not allocate matrix")));
+        }
+        if(num_columns != m->columns) {
+            cfree(row);
+            return Box_wrap_FixError(native_error(sMSG("Row %zu has %zu columns, expected %zu"), r, num_columns, m->columns));
+        }
+
+        memcpy(&FlxMatrixF_at(m, r, 0), row, num_columns * sizeof(double));
+        cfree(row);
+    }
+    return Box_wrap_BoxedHeap(m);
+}
+
+/// @note matrix x matrix is a GEMM; matrix x vector (array or FlxVecDouble) is a GEMV
+Box native_matmul(FixFn *self, FixScope parent, Box left, Box right) {
+    native_log_call2(self, left, right);
+
+    native_return_error_if(!(Box_is_Boxed_type(left, BXD_FLX_MATRIX_DOUBLE)),
+        sMSG("Expected matrix argument, got %s"), ubx_nameof(left.type));
+    FlxMatrixF *a = Box_unwrap_typed_ptr(FlxMatrixF, left);
+
+    if(Box_is_Boxed_type(right, BXD_FLX_MATRIX_DOUBLE)) {
+        FlxMatrixF *c = FlxMatrixF_matmul_new(a, Box_unwrap_typed_ptr(FlxMatrixF, right));
+        native_return_error_if(c == nullptr, sMSG("matmul(): incompatible matrix shapes"));
+        return Box_wrap_BoxedHeap(c);
+    }
+
+    size_t n = 0;
+    double *x = native_doubles_from_Box_cnew(right, &n);
+    native_return_error_if(x == nullptr, sMSG("Expected matrix or vector argument, got %s"), ubx_nameof(right.type));
+    if(n != a->columns) {
+        cfree(x);
+        return Box_wrap_FixError(native_error(sMSG("matmul(): vector has %zu entries, expected %zu"), n, a->columns));
+    }
+
+    double *y = cnew(a->rows * sizeof(double));
+    if(y == nullptr) {
+        cfree(x);
+        return Box_wrap_FixError(native_error(sMSG("Could not allocate result")));
+    }
+    FlxMatrixF_gemv(a, x, y);
+
+    Box result = native_Box_from_doubles(y, a->rows);
+    cfree(x);
+    cfree(y);
+    return result;
+}
+
+Box native_cholesky(FixFn *self, FixScope parent, Box matrix) {
+    native_log_call1(self, matrix);
+
+    native_return_error_if(!(Box_is_Boxed_type(matrix, BXD_FLX_MATRIX_DOUBLE)),
+        sMSG("Expected matrix argument, got %s"), ubx_nameof(matrix.type));
+    FlxMatrixF *l = FlxMatrixF_copy(Box_unwrap_typed_ptr(FlxMatrixF, matrix));
+    native_return_error_if(l == nullptr || l->rows != l->columns, sMSG("cholesky(): expected a square matrix"));
+    native_return_error_if(!FlxMatrixF_cholesky(l), sMSG("cholesky(): matrix is not positive definite"));
+    return Box_wrap_BoxedHeap(l);
+}
+
+Box native_logdet(FixFn *self, FixScope parent, Box matrix) {
+    native_log_call1(self, matrix);
+
+    native_return_error_if(!(Box_is_Boxed_type(matrix, BXD_FLX_MATRIX_DOUBLE)),
+        sMSG("Expected matrix argument, got %s"), ubx_nameof(matrix.type));
+    FlxMatrixF *a = Box_unwrap_typed_ptr(FlxMatrixF, matrix);
+    native_return_error_if(a->rows != a->columns, sMSG("logdet(): expected a square matrix"));
+
+    double logdet = 0.0;
+    native_return_error_if(!FlxMatrixF_logdet(a, &logdet), sMSG("logdet(): matrix is not positive definite"));
+    return Box_wrap_float((float) logdet);
+}
+
+/// @brief Solves A x = b for symmetric positive definite A
+Box native_solve(FixFn *self, FixScope parent, Box matrix, Box rhs) {
+    native_log_call2(self, matrix, rhs);
+
+    native_return_error_if(!(Box_is_Boxed_type(matrix, BXD_FLX_MATRIX_DOUBLE)),
+        sMSG("Expected matrix argument, got %s"), ubx_nameof(matrix.type));
+    FlxMatrixF *l = FlxMatrixF_copy(Box_unwrap_typed_ptr(FlxMatrixF, matrix));
+    native_return_error_if(l == nullptr || l->rows != l->columns, sMSG("solve(): expected a square matrix"));
+
+    size_t n = 0;
+    double *b = native_doubles_from_Box_cnew(rhs, &n);
+    if(b == nullptr || n != l->rows) {
+        cfree(b);
+        return Box_wrap_FixError(native_error(sMSG("solve(): expected a vector of %zu numbers"), l->rows));
+    }
+    if(!FlxMatrixF_cholesky(l)) {
+        cfree(b);
+        return Box_wrap_FixError(native_error(sMSG("solve(): matrix is not positive definite")));
+    }
+
+    FlxMatrixF_solve_lower(l, b, b);
+    FlxMatrixF_solve_lower_transpose(l, b, b);
+    Box result = native_Box_from_doubles(b, n);
+    cfree(b);
+    return result;
+}
+
+Box native_mvnormal_log_pdf(FixFn *self, FixScope parent, Box x, Box mean, Box cov) {
+    native_log_call3(self, x, mean, cov);
+
+    native_return_error_if(!(Box_is_Boxed_type(cov, BXD_FLX_MATRIX_DOUBLE)),
+        sMSG("Expected covariance matrix argument, got %s"), ubx_nameof(cov.type));
+    FlxMatrixF *l = FlxMatrixF_copy(Box_unwrap_typed_ptr(FlxMatrixF, cov));
+    native_return_error_if(l == nullptr || l->rows != l->columns, sMSG("mvnormal_log_pdf(): expected a square covariance"));
+
+    size_t num_x = 0, num_mean = 0;
+    double *xs = native_doubles_from_Box_cnew(x, &num_x);
+    double *mus = native_doubles_from_Box_cnew(mean, &num_mean);
+    if(xs == nullptr || mus == nullptr || num_x != l->rows || num_mean != l->rows) {
+        cfree(xs);
+        cfree(mus);
+        return Box_wrap_FixError(native_error(sMSG("mvnormal_log_pdf(): expected vectors of %zu numbers"), l->rows));
+    }
+    if(!FlxMatrixF_cholesky(l)) {
+        cfree(xs);
+        cfree(mus);
+        return Box_wrap_FixError(native_error(sMSG("mvnormal_log_pdf(): covariance is not positive definite")));
+    }
+
+    double log_pdf = FlxMatrixF_mvn_log_pdf(xs, mus, l);
+    cfree(xs);
+    cfree(mus);
+    return Box_wrap_float((float) log_pdf);
+}
+
+/// @note a matrix becomes a zero-copy rank-2 view; arrays and double vectors are copied into rank 1
+Box native_tensor(FixFn *self, FixScope parent, Box data) {
+    native_log_call1(self, data);
+
+    if(Box_is_Boxed_type(data, BXD_FLX_TENSOR_DOUBLE)) { return data; }
+    if(Box_is_Boxed_type(data, BXD_FLX_MATRIX_DOUBLE)) {
+        FlxMatrixF *m = Box_unwrap_typed_ptr(FlxMatrixF, data);
+        size_t shape[2] = {m->rows, m->columns};
+        FlxTensorF *t = FlxTensorF_from_data(m->data, 2, shape, nullptr);
+        native_return_error_if(t == nullptr, sMSG("Could not allocate tensor"));
+        return Box_wrap_BoxedHeap(t);
+    }
+
+    size_t n = 0;
+    double *values = native_doubles_from_Box_cnew(data, &n);
+    native_return_error_if(values == nullptr || n == 0,
+        sMSG("Expected matrix, vector or array of numbers, got %.*s"), fmt(ubx_nameof(data.type)));
+
+    FlxTensorF *t = FlxTensorF_new(1, &n);
+    if(t == nullptr) {
+        cfree(values);
+        return Box_wrap_FixError(native_error(sMSG("Could not allocate tensor")));
+    }
+    memcpy(t->data, values, n * sizeof(double));
+    cfree(values);
+    return Box_wrap_BoxedHeap(t);
+}
+
+Box native_transpose(FixFn *self, FixScope parent, Box data) {
+    native_log_call1(self, data);
+
+    FlxTensorF view;
+    native_return_error_if(!FlxTensorF_view_of_Box(data, &view),
+        sMSG("Expected tensor or matrix argument, got %.*s"), fmt(ubx_nameof(data.type)));
+    FlxTensorF *t = FlxTensorF_transpose(&view);
+    native_return_error_if(t == nullptr, sMSG("Could not allocate tensor"));
+    return Box_wrap_BoxedHeap(t);
+}
+
+/// @brief slice(xs, start, stop) -- a zero-copy view of [start, stop) of an array or view,
+///     ... or of rows [start, stop) along the first axis of a tensor or matrix
+Box native_slice(FixFn *self, FixScope parent, Box data, Box start, Box stop) {
+    native_log_call3(self, data, start, stop);
+
+    native_return_error_if(start.type != UBX_INT || stop.type != UBX_INT || Box_unwrap_int(start) < 0 || Box_unwrap_int(stop) < 0,
+        sMSG("slice(): expected non-negative integer bounds"));
+
+    FixArrayView *array_view = FixArrayView_of_Box(data, (size_t) Box_unwrap_int(start), (size_t) Box_unwrap_int(stop));
+    if(array_view != nullptr) { return Box_wrap_BoxedArena(array_view); }
+
+    FlxTensorF view;
+    native_return_error_if(!FlxTensorF_view_of_Box(data, &view),
+        sMSG("Expected array, tensor or matrix argument, got %.*s"), fmt(ubx_nameof(data.type)));
+
+    FlxTensorF *t = FlxTensorF_slice(&view, 0, (size_t) Box_unwrap_int(start), (size_t) Box_unwrap_int(stop), 1);
+    native_return_error_if(t == nullptr, sMSG("Could not allocate tensor"));
+    return Box_wrap_BoxedHeap(t);
+}
+
+Box native_len(FixFn *self, FixScope parent, Box arg) {
+    native_log_call1(self, arg);
+
+    if(Box_is_Boxed(arg)) {
+        return Box_wrap_int(Box_Boxed_meta(arg).size);
+    }
+
+    native_error(sMSG("Expected array or string argument type, got %s"), ubx_nameof(arg.type));
+    return Box_null();
+}
+
+Box native_sum(FixFn *self, FixScope parent, FixArray args) {
+    native_log_call(self, args);
+
+    double sum = 0;
+    for(size_t i = 0; i < len(args); i++) {
+        native_return_error_if(args.data[i].type != UBX_FLOAT, sMSG("Expected float argument type, got %s"), ubx_nameof(args.data[i].type));
+        sum += Box_unwrap_float(args.data[i]);
+    }
+
+    return Box_wrap_float(sum);
+}
+
+Box native_sum_FlxVecInt(FixFn *self, FixScope parent, Box vec) {
+    native_log_call1(self, vec);
+    FlxVecInt *a = Box_unwrap_typed_ptr(FlxVecInt, vec);
+
+    native_return_error_if(a == nullptr, sMSG("Expected non-nullptr FlxVecInt argument"));
+    native_return_error_if(Box_is_Boxed(vec), sMSG("Expected collection argument type, got %s"), ubx_nameof(vec.type));
+    native_return_error_if(Box_is_Boxed_type(vec, BXD_FLX_VEC_INT), sMSG("Expected FlxVecInt argument type, got %s"), bt_nameof(a->meta.type));
+    // native_return_error_if(len_ref(a) == 0, sMSG("Cannot sum an empty array"));
+
+    int sum = 0;
+    for(size_t i = 0; i < len_ref(a); i++) {
+        sum += at_ref(a, i);
+    }
+
+    return Box_wrap_int(sum);
+}
+
+Box native_sum_FlxVecDouble(FixFn *self, FixScope parent, Box vec) {
+    native_log_call1(self, vec);
+    FlxVecDouble *a = Box_unwrap_typed_ptr(FlxVecDouble, vec);
+
+    native_return_error_if(Box_is_Boxed(vec), sMSG("Expected collection argument type, got %s"), ubx_nameof(vec.type));
+    native_return_error_if(a == nullptr, sMSG("Expected non-nullptr FlxVecFloat argument"));
+    native_return_error_if(Box_is_Boxed_type(vec, BXD_FLX_VEC_DOUBLE_N), sMSG("Expected FlxVecFloat argument type, got %s"), bt_nameof(a->meta.type));
+    native_return_error_if(len_ref(a) == 0, sMSG("Cannot sum an empty array"));
+
+    double sum = 0;
+    for(size_t i = 0; i < len_ref(a); i++) {
+        sum += at_ref(a, i);
+    }
+
+    return Box_wrap_float(sum);
+}
+
+Box native_max(FixFn *self, FixScope parent, FixArray args) {
+    native_log_call(self, args);
+
+    double max = -INFINITY;
+    for(size_t i = 0; i < len(args); i++) {
+        native_return_error_if(args.data[i].type != UBX_FLOAT, sMSG("Expected float argument type, got %s"), ubx_nameof(args.data[i].type));
+        max = fmax(max, Box_unwrap_float(args.data[i]));
+    }
+
+    return Box_wrap_float(max);
+}
+
+// Box native_min(FixFn *self, FixScope parent, FixArray args);
+// Box native_abs(FixFn *self, FixScope parent, FixArray args);
+// Box native_pow(FixFn *self, FixScope parent, FixArray args);
+// Box native_sqrt(FixFn *self, FixScope parent, FixArray args);
+// Box native_floor(FixFn *self, FixScope parent, FixArray args);
+// Box native_ceil(FixFn *self, FixScope parent, FixArray args);
+// Box native_round(FixFn *self, FixScope parent, FixArray args);
+Box native_log10(FixFn *self, FixScope parent, FixArray args);
+Box native_logB(FixFn *self, FixScope parent, FixArray args);
+Box native_logE(FixFn *self, FixScope parent, FixArray args);
+Box native_exp(FixFn *self, FixScope parent, FixArray args);
+Box native_sin(FixFn *self, FixScope parent, FixArray args);
+Box native_cos(FixFn *self, FixScope parent, FixArray args);
+Box native_tan(FixFn *self, FixScope parent, FixArray args);
+Box native_asin(FixFn *self, FixScope parent, FixArray args);
+Box native_acos(FixFn *self, FixScope parent, FixArray args);
+Box native_atan(FixFn *self, FixScope parent, FixArray args);
+Box native_atan2(FixFn *self, FixScope parent, FixArray args);
+Box native_sinh(FixFn *self, FixScope parent, FixArray args);
+Box native_cosh(FixFn *self, FixScope parent, FixArray args);
+Box native_tanh(FixFn *self, FixScope parent, FixArray args);
+Box native_asinh(FixFn *self, FixScope parent, FixArray args);
+Box native_acosh(FixFn *self, FixScope parent, FixArray args);
+Box native_atanh(FixFn *self, FixScope parent, FixArray args);
+Box native_rand(FixFn *self, FixScope parent, FixArray args);
+Box native_random_int(FixFn *self, FixScope parent, FixArray args);
+Box native_random_range(FixFn *self, FixScope parent, FixArray args);
+Box native_random_choice(FixFn *self, FixScope parent, FixArray args);
+Box native_random_shuffle(FixFn *self, FixScope parent, FixArray args);
+Box native_random_sample(FixFn *self, FixScope parent, FixArray args);
+Box native_random_seed(FixFn *self, FixScope parent, FixArray args);
+Box native_random_normal(FixFn *self, FixScope parent, FixArray args);
+Box native_random_int_normal(FixFn *self, FixScope parent, FixArray args);
+Box native_random_gamma(FixFn *self, FixScope parent, FixArray args);
+Box native_random_beta(FixFn *self, FixScope parent, FixArray args);
+Box native_random_poisson(FixFn *self, FixScope parent, FixArray args);
+Box native_random_binomial(FixFn *self, FixScope parent, FixArray args);
+Box native_random_bernoulli(FixFn *self, FixScope parent, FixArray args);
+Box native_random_exponential(FixFn *self, FixScope parent, FixArray args);
+Box native_random_uniform(FixFn *self, FixScope parent, FixArray args);
+Box native_random_beta_binomial(FixFn *self, FixScope parent, FixArray args);
+Box native_random_dirichlet(FixFn *self, FixScope parent, FixArray args);
+Box native_random_gamma_poisson(FixFn *self, FixScope parent, FixArray args);
+Box native_random_inv_gamma(FixFn *self, FixScope parent, FixArray args);
+Box native_random_laplace(FixFn *self, FixScope parent, FixArray args);
+Box native_random_log_normal(FixFn *self, FixScope parent, FixArray args);
+Box native_random_neg_binomial(FixFn *self, FixScope parent, FixArray args);
+Box native_random_pareto(FixFn *self, FixScope parent, FixArray args);
+Box native_random_triangular(FixFn *self, FixScope parent, FixArray args);
+Box native_random_uniform_int(FixFn *self, FixScope parent, FixArray args);
+Box native_random_weibull(FixFn *self, FixScope parent, FixArray args);
+Box native_random_boltzmann(FixFn *self, FixScope parent, FixArray args);
+Box native_random_gev(FixFn *self, FixScope parent, FixArray args);
+Box native_random_gumbel(FixFn *self, FixScope parent, FixArray args);
+Box native_random_rayleigh(FixFn *self, FixScope parent, FixArray args);
+Box native_random_wald(FixFn *self, FixScope parent, FixArray args);
+Box native_random_maxwell(FixFn *self, FixScope parent, FixArray args);
+Box native_random_power_law(FixFn *self, FixScope parent, FixArray args);
+
+
+
+
+
+
+void native_add_prelude(FixScope scope) {
+    static FixFn prelude[] = {
+        FixFnFromNative(FN_NATIVE, s("log"), native_log),
+        FixFnFromNative(FN_NATIVE, s("observe"), native_observe),
+        FixFnFromNative(FN_NATIVE, s("range"), native_range),
+        FixFnFromNative(FN_NATIVE_1, s("sqrt"), native_sqrtf),
+        FixFnFromNative(FN_NATIVE_2, s("infer"), native_infer),
+        FixFnFromNative(FN_NATIVE_1, s("sample"), native_sample),
+        FixFnFromNative(FN_NATIVE, s("take"), native_take),
+        FixFnFromNative(FN_NATIVE, s("normal"), native_normal),
+        FixFnFromNative(FN_NATIVE, s("gamma"), native_gamma),
+        FixFnFromNative(FN_NATIVE, s("exponential"), native_exponential),
+        FixFnFromNative(FN_NATIVE, s("uniform"), native_uniform),
+        FixFnFromNative(FN_NATIVE, s("beta"), native_beta),
+        FixFnFromNative(FN_NATIVE_2, s("log_pdf"), native_log_pdf),
+        FixFnFromNative(FN_NATIVE_1, s("read_csv"), native_read_csv),
+        FixFnFromNative(FN_NATIVE_2, s("save_columns"), native_save_columns),
+        FixFnFromNative(FN_NATIVE_1, s("load_columns"), native_load_columns),
+        FixFnFromNative(FN_NATIVE_2, s("column"), native_column),
+        FixFnFromNative(FN_NATIVE, s("filter"), native_filter),
+        FixFnFromNative(FN_NATIVE, s("select"), native_select),
+        FixFnFromNative(FN_NATIVE, s("group_by"), native_group_by),
+        FixFnFromNative(FN_NATIVE_3, s("join"), native_join),
+        FixFnFromNative(FN_NATIVE_2, s("aggregate"), native_aggregate),
+        FixFnFromNative(FN_NATIVE_1, s("matrix"), native_matrix),
+        FixFnFromNative(FN_NATIVE_2, s("matmul"), native_matmul),
+        FixFnFromNative(FN_NATIVE_1, s("cholesky"), native_cholesky),
+        FixFnFromNative(FN_NATIVE_1, s("logdet"), native_logdet),
+        FixFnFromNative(FN_NATIVE_2, s("solve"), native_solve),
+        FixFnFromNative(FN_NATIVE_3, s("mvnormal_log_pdf"), native_mvnormal_log_pdf),
+        FixFnFromNative(FN_NATIVE_1, s("tensor"), native_tensor),
+        FixFnFromNative(FN_NATIVE_1, s("transpose"), native_transpose),
+        FixFnFromNative(FN_NATIVE_3, s("slice"), native_slice),
+        FixFnFromNative(FN_NATIVE, s("summarize"), native_summarize),
+        FixFnFromNative(FN_NATIVE_2, s("drop"), native_drop),
+        FixFnFromNative(FN_NATIVE_2, s("window"), native_window),
+        FixFnFromNative(FN_NATIVE_2, s("chunk"), native_chunk),
+        FixFnFromNative(FN_NATIVE_2, s("par_map"), native_par_map),
+        FixFnFromNative(FN_NATIVE_3, s("par_reduce"), native_par_reduce)
+    };
+
+    size_t n = sizeof(prelude) / sizeof(FixFn);
+    for(size_t i = 0; i < n; i++) {
+        FixScope_define_local(&scope, prelude[i].name, Box_wrap_BoxedArena(&prelude[i]));
+    }
+}
+
+
+#pragma endregion
+
+//#endregion
+///---------- ---------- ---------- IMPL: INTERPRETER ---------- ---------- ------ ///
+//#region Implementation_Interpreter
+
+
+#pragma region InterpErrorImpl
+
+/// @note values from interp_eval_ast need no check: a failed evaluation never returns there,
+///     ... it unwinds (cf. interp_graceful_exit). This is for results produced any other way.
+#define interp_return_if_error(value) \
+    if (Box_is_failed(value)) {\
+        return Box_exit();\
+    }
+
+#pragma endregion
+
+#pragma region BoxedPrecacheImpl
+
+void interp_init(void) {
+
+    #ifdef INTERP_PRECACHE_INTERNED_STRINGS
+        /// @todo consider this interning approach, and this size
+        /// ... empirically how many vars / prog? how useful is it to intern?
+        /// @todo presumably this should be a vector of strings, not a FixDict
+        FixDict_data_new(&interp_precache().str_precache, ARRAY_SIZE_MEDIUM);
+    #endif
+}
+
+/// @todo implement this
+
+/// @brief
+/// @param str
+/// @param out
+/// @return
+bool interp_precache_getstr(FixStr str, FixKvPair *out) {
+    return true;
+}
+
+void interp_precache_setstr(FixStr str) {
+    return;
+}
+
+void interp_precache_test_main(void) {
+    #ifndef INTERP_PRECACHE_INTERNED_STRINGS
+        log_message(LL_INFO, sMSG("Skipping interned strings test"));
+        return;
+    #endif
+
+    // Initialize the interpreter pre-cache
+    interp_init();
+    log_assert(FixStr_is_empty(interp_precache().str_precache[0]), sMSG("Interned strings should be empty"));
+
+    // Test setting and getting a string
+    FixStr test_str = s("test_string");
+    interp_precache_setstr(test_str);
+
+    FixKvPair entry;
+    bool found = interp_precache_getstr(test_str, &entry);
+    log_assert(found, sMSG("Failed to find interned string"));
+    log_assert(Box_is_null(entry.value), sMSG("Interned string value should be nullptr"));
+
+    // Test retrieving a non-existent string
+    FixStr non_existent = s("non_existent");
+    found = interp_precache_getstr(non_existent, &entry);
+    log_assert(!found, sMSG("Non-existent string should not be found"));
+}
+
+#pragma endregion
+
+#pragma region InterpEvalImpl
+
+/// @note records the node itself: it's only formatted if the traceback is printed
+#define interp_trace() \
+    Tracer_push_node(ctx_local().debug.callstack, s(__func__), node, s(__FILE__), __LINE__)
+
+#define interp_print_traces() Tracer_print_stack(ctx_local().debug.callstack, 16);
+
+
+ ///@todo
+#define interp_require_type(node_type)\
+    if (node->type != node_type) {\
+        assert(false);\
+        return Box_exit();\
+    }
+
+
+static inline __attribute__((always_inline))
+Box interp_eval_FixAst(Ast *node, FixScope *scope) {
+    switch(node->type) {
+        case AST_DISCARD:
+            return Box_null();
+        case AST_IF:
+            return interp_eval_if(node, scope);
+        case AST_TRY:
+            return interp_eval_try(node, scope);
+        case AST_DICT:
+            return interp_eval_dict(node, scope);
+        case AST_VEC:
+            return interp_eval_vec(node, scope);
+        case AST_FN_DEF_CALL:
+            return interp_eval_call_fn(node, scope);
+        case AST_METHOD_CALL:
+            return interp_eval_method_call(node, scope);
+        case AST_MEMBER_ACCESS:
+            return interp_eval_member_access(node, scope);
+        case AST_TAG: case AST_INT: case AST_FLOAT: case AST_DOUBLE: case AST_STR:
+            return interp_eval_literal(node, scope);
+        case AST_ID:
+            return interp_eval_identifier(node, scope);
+        case AST_MOD:
+            return interp_eval_module(node, scope);
+        case AST_BLOCK:
+            return interp_eval_block(node, scope);
+        case AST_FN_DEF:
+            return interp_eval_fn_def(node, scope);
+        case AST_LOOP:
+            return interp_eval_loop(node, scope);
+        case AST_FOR:
+            return interp_eval_for(node, scope);
+        case AST_EXPRESSION:
+            return interp_eval_expression(node, scope);
+        case AST_FN_DEF_ANON:
+            return interp_eval_fn_anon(node, scope);
+        case AST_CONST_DEF:
+            return interp_eval_const_def(node, scope);
+        case AST_LEF_DEF:
+            return interp_eval_let_def(node, scope);
+        case AST_BOP:
+            return interp_eval_binary_op(node, scope);
+        case AST_UOP:
+            return interp_eval_unary_op(node, scope);
+        case AST_USE:
+            return interp_eval_use(node, scope);
+        case AST_STRUCT_DEF:
+            return interp_eval_struct_def(node, scope);
+        case AST_OBJECT_LITERAL:
+            return interp_eval_object_literal(node, scope);
+        case AST_MATCH:
+            return interp_eval_match(node, scope);
+        case AST_RETURN:
+            return interp_eval_return(node, scope);
+        case AST_MUTATION:
+            return interp_eval_mutation(node, scope);
+        case AST_YIELD:
+            /// @note yields are resumed by FixGen_resume, which never evaluates them here
+            interp_error(sMSG("`yield` is only allowed as a statement in a `loop fn` body."));
+            return Box_exit();
+        default:
+            if((node->type > 0) && (node->type < AST_ENUM_SIZE)) {
+                interp_error(sMSG("Unknown AST node type (%.*s)"), fmt(Ast_nameof(node->type)));
+            } else {
+                interp_error(sMSG("Unknown AST node type (%d)"), node->type);
+            }
+            return Box_exit();
+    }
+}
+
+
+/// @brief interp_eval_FixAst, counted and timed into the running AstCounters
+/// @note a node's self ticks are its own less its children's. An error unwinding through it
+///     ... goes uncounted, and its children's ticks may then be put on an ancestor
+static __attribute__((noinline))
+Box interp_eval_counted(AstCounters *counters, Ast *node, FixScope *scope) {
+    uint64_t outer_children = ctx_local().debug.child_ticks;
+    ctx_local().debug.child_ticks = 0;
+    uint64_t start = Tracer_ticks();
+
+    Box result = interp_eval_FixAst(node, scope);
+
+    uint64_t elapsed = Tracer_ticks() - start;
+    uint64_t children = ctx_local().debug.child_ticks;
+    AstCounters_record(counters, node, children < elapsed ? elapsed - children : 0);
+    ctx_local().debug.child_ticks = outer_children + elapsed;
+    return result;
+}
+
+Box interp_eval_ast(Ast *node, FixScope *scope) {
+    require_not_null(node); require_not_null(scope);
+    require_positive(node->type);
+
+    AstCounters *counters = atomic_load_explicit(&ctx().debug.counters, memory_order_relaxed);
+    Box result = counters == nullptr
+        ? interp_eval_FixAst(node, scope)
+        : interp_eval_counted(counters, node, scope);
+
+    //|| Box_is_halt(result)
+    if(Box_is_failed(result)) {
+        interp_graceful_exit();
+    }
+
+    return result;
+}
+
+
+/// @brief Unwinds to the innermost `try` or embedding call, or, with none, ends the process
+/// @note the evaluations unwound through leave their allocations to their arena and heap
+void interp_graceful_exit(void) {
+    InterpRecover *point = ctx_local().debug.recover;
+    if(point != nullptr) {
+        CallStack *traces = ctx_local().debug.callstack;
+        if(traces != nullptr) { traces->top = point->trace_depth; }
+        ctx_local().debug.num_frames = point->frame_depth;
+        ctx_current_arena() = point->arena;
+        ctx_current_heap() = point->heap;
+        ctx_local().debug.recover = point->prev;
+        longjmp(point->target, 1);
+    }
+
+    /// @note print the stack trace
+    log_message(LL_RECOVERABLE, sMSG("Interpreter Error"));
+    interp_print_traces();
+    error_print_all();
+    abort();
+}
+
+
+
+// Implementation of interp_run_from_source
+Box interp_run_from_source(ParseContext *p, FixStr source, int argc, char **argv) {
+    lex_source(p, source, s("    "));
+    FixStr_puts(data_to_ansi_new(p->lexer));
+
+    #ifdef INTERP_SHOW_PARSING
+        lex_print_all(p->lexer);
+    #endif
+
+    parse(p);
+    require_not_null(p->parser.data);
+
+    #ifdef INTERP_SHOW_PARSING
+        Ast_print(p->parser.data);
+    #endif
+
+    log_assert(p->parser.data->type == AST_BLOCK, sMSG("Top-level node must be a block"));
+
+    /// @todo revise the FixScope new'ing to ensure data are initialized
+    FixScope globals = FixScope_empty(s("Global scope"));
+    FixScope_data_new(&globals, nullptr);
+    native_add_prelude(globals);
+
+    interp_eval_ast(p->parser.data, &globals);
+
+    /// @note we find and run the main function
+    // FixArray *main_args = CliArgs_to_FixArray(argc, argv);
+    FixArray main_args = {0}; //CliArgs_to_FixArray(argc, argv);
+    Box main_fn;
+    if(FixScope_lookup(&globals, s("main"), &main_fn)) {
+        interp_frame_push(s("main"), nullptr);
+        Box result = FixFn_call(Box_unwrap_FixFn(main_fn), globals, main_args);
+        interp_frame_pop();
+        return result;
+    } else {
+        FixScope_debug_print(globals);
+        interp_error(sMSG("No main function found"));
+        return Box_exit();
+    }
+}
+
+/// @brief Binds the arguments (or their defaults) and evaluates a user function's body
+static Box FixFn_interp_body(FixFn *fn, Ast *body, FixScope function_scope, FixArray args) {
+    require_not_null(body);
+
+    size_t i = 0;
+    FixDict_iter_items(fn->signature, arg) {
+        Box value = at(args, i++);
+        if(Box_is_null(value)) {
+            value = arg->value;
+        }
+        FixScope_define_local(&function_scope, arg->key, value);
+    }
+
+    return interp_eval_ast(body, &function_scope);
+}
+
+Box FixFn_interp_user_fn(FixFn *fn, FixScope function_scope, FixArray args) {
+    require_not_null(fn);
+    log_assert(fn->type == FN_USER, sMSG("Function must be user-defined!"));
+    return FixFn_interp_body(fn, (Ast *) fn->code, function_scope, args);
+}
+
+
+/// ----- Memo functions ----- ///
+
+static void FixMemoCode_clear(FixMemoCode *memo) {
+    memo->num_entries = 0;
+    memo->head = SIZE_MAX;
+    memo->tail = SIZE_MAX;
+    for(size_t b = 0; b < MEMO_CAPACITY; b++) { memo->buckets[b] = SIZE_MAX; }
+}
+
+FixMemoCode *FixMemoCode_new(Ast *body) {
+    require_not_null(body);
+
+    FixMemoCode *memo = Arena_alloc(sizeof(FixMemoCode));
+    if(memo == nullptr) { error_oom(); return nullptr; }
+
+    memo->body = body;
+    memo->step = ctx().inference.step;
+    memo->num_hits = 0;
+    memo->num_misses = 0;
+    pthread_mutex_init(&memo->lock, nullptr);
+    FixMemoCode_clear(memo);
+    return memo;
+}
+
+/// @brief The cache key of a call, or false if it cannot be cached
+static bool FixMemo_key(FixArray args, size_t *out_hash) {
+    if(len(args) > MEMO_MAX_ARGS) { return false; }
+
+    size_t hash = len(args);
+    for(size_t i = 0; i < len(args); i++) {
+        if(args.data[i].type > UBX_TAG) { return false; }
+        hash = (hash * 31) ^ Box_hash(args.data[i]);
+    }
+    *out_hash = hash;
+    return true;
+}
+
+static void FixMemo_unlink(FixMemoCode *memo, size_t index) {
+    FixMemoEntry *entry = &memo->entries[index];
+    if(entry->prev != SIZE_MAX) { memo->entries[entry->prev].next = entry->next; } else { memo->head = entry->next; }
+    if(entry->next != SIZE_MAX) { memo->entries[entry->next].prev = entry->prev; } else { memo->tail = entry->prev; }
+}
+
+static void FixMemo_push_front(FixMemoCode *memo, size_t index) {
+    FixMemoEntry *entry = &memo->entries[index];
+    entry->prev = SIZE_MAX;
+    entry->next = memo->head;
+    if(memo->head != SIZE_MAX) { memo->entries[memo->head].prev = index; }
+    memo->head = index;
+    if(memo->tail == SIZE_MAX) { memo->tail = index; }
+}
+
+static size_t FixMemo_find(FixMemoCode *memo, size_t hash, FixArray args) {
+    for(size_t e = memo->buckets[hash % MEMO_CAPACITY]; e != SIZE_MAX; e = memo->entries[e].chain) {
+        FixMemoEntry *entry = &memo->entries[e];
+        if(entry->hash != hash || entry->num_args != len(args)) { continue; }
+
+        bool same = true;
+        for(size_t i = 0; same && i < entry->num_args; i++) { same = Box_eq(entry->args[i], args.data[i]); }
+        if(same) { return e; }
+    }
+    return SIZE_MAX;
+}
+
+/// @brief A slot for a new entry: a free one, else the least recently used (evicted)
+static size_t FixMemo_slot(FixMemoCode *memo) {
+    if(memo->num_entries < MEMO_CAPACITY) { return memo->num_entries++; }
+
+    size_t victim = memo->tail;
+    FixMemo_unlink(memo, victim);
+
+    size_t *link = &memo->buckets[memo->entries[victim].hash % MEMO_CAPACITY];
+    while(*link != victim) { link = &memo->entries[*link].chain; }
+    *link = memo->entries[victim].chain;
+    return victim;
+}
+
+/// @brief Calling a `memo fn`: a cached result for the same arguments, else the body's
+/// @example
+///      memo fn f(x, a, b) = a * x + b
+Box FixFn_interp_memo_fn(FixFn *fn, FixScope function_scope, FixArray args) {
+    require_not_null(fn);
+    log_assert(fn->type == FN_MEMO, sMSG("Function must be a memo function!"));
+
+    FixMemoCode *memo = (FixMemoCode *) fn->code;
+    require_not_null(memo);
+
+    size_t hash;
+    if(!FixMemo_key(args, &hash)) {
+        return FixFn_interp_body(fn, memo->body, function_scope, args);
+    }
+
+    pthread_mutex_lock(&memo->lock);
+    if(memo->step != ctx().inference.step) {
+        FixMemoCode_clear(memo);
+        memo->step = ctx().inference.step;
+    }
+
+    size_t found = FixMemo_find(memo, hash, args);
+    if(found != SIZE_MAX) {
+        memo->num_hits++;
+        if(found != memo->head) {
+            FixMemo_unlink(memo, found);
+            FixMemo_push_front(memo, found);
+        }
+        Box cached = memo->entries[found].result;
+        pthread_mutex_unlock(&memo->lock);
+        return cached;
+    }
+    memo->num_misses++;
+    pthread_mutex_unlock(&memo->lock);
+
+    Box result = FixFn_interp_body(fn, memo->body, function_scope, args);
+    if(Box_is_failed(result)) { return result; }
+
+    /// @note a concurrent call may have cached the same key meanwhile: the older entry
+    ///     ... shadows this one until it is evicted
+    pthread_mutex_lock(&memo->lock);
+    size_t slot = FixMemo_slot(memo);
+    FixMemoEntry *entry = &memo->entries[slot];
+    entry->hash = hash;
+    entry->num_args = len(args);
+    memcpy(entry->args, args.data, len(args) * sizeof(Box));
+    entry->result = result;
+    entry->chain = memo->buckets[hash % MEMO_CAPACITY];
+    memo->buckets[hash % MEMO_CAPACITY] = slot;
+    FixMemo_push_front(memo, slot);
+    pthread_mutex_unlock(&memo->lock);
+    return result;
+}
+
+/// @brief The setup shared by tests that call interpreted functions directly: a callstack
+///     ... for the calls to trace into, and a root scope defining `normal`
+typedef struct InterpTestFixture {
+    CallStack traces;
+    CallStack *prev_callstack;
+    FixFn normal;
+    FixScope root;
+} InterpTestFixture;
+
+/// @note the fixture must stay put while entered: its root scope points at its `normal`
+static void InterpTestFixture_enter(InterpTestFixture *fixture) {
+    fixture->traces = (CallStack) {0};
+    fixture->prev_callstack = ctx_local().debug.callstack;
+    ctx_local().debug.callstack = &fixture->traces;
+
+    fixture->normal = (FixFn) FixFnFromNative(FN_NATIVE, s("normal"), native_normal);
+    fixture->root = FixScope_empty(s("Root"));
+    FixDict_data_new(&fixture->root.data, ARRAY_SIZE_SMALL);
+    FixScope_define_local(&fixture->root, fixture->normal.name, Box_wrap_BoxedArena(&fixture->normal));
+}
+
+static void InterpTestFixture_leave(InterpTestFixture *fixture) {
+    ctx_local().debug.callstack = fixture->prev_callstack;
+}
+
+static Box FixMemo_test_call(FixFn *fn, FixScope *root, Box value) {
+    ctx_local().debug.callstack->top = 0;
+    FixScope call_scope = FixScope_empty(sMSG("$Scope"));
+    FixScope_data_new(&call_scope, root);
+    Box call_args[1] = { value };
+    return FixFn_call(fn, call_scope, (FixArray) { .meta.size = 1, .meta.capacity = 1, .data = call_args });
+}
+
+int FixMemo_test_main(void) {
+    InterpTestFixture fixture;
+    InterpTestFixture_enter(&fixture);
+    FixScope root = fixture.root;
+
+    /// memo fn twice(x) = x * 2
+    Ast x = { .type = AST_ID, .id.name = s("x") };
+    Ast two = { .type = AST_INT, .integer.value = 2 };
+    Ast body = { .type = AST_BOP, .bop.op = s("*"), .bop.left = &x, .bop.right = &two };
+
+    FixDict signature;
+    FixDict_data_new(&signature, ARRAY_SIZE_SMALL);
+    FixDict_set(&signature, s("x"), Box_null());
+    FixMemoCode *memo = FixMemoCode_new(&body);
+    FixFn *twice = FixFn_new(FN_MEMO, s("twice"), signature, root, (void *) FixFn_interp_memo_fn, memo);
+
+
+    log_assert(Box_unwrap_int(FixMemo_test_call(twice, &root, Box_wrap_int(3))) == 6, sMSG("A memo fn should evaluate its body"));
+    log_assert(Box_unwrap_int(FixMemo_test_call(twice, &root, Box_wrap_int(3))) == 6, sMSG("A repeated call should return the cached result"));
+    log_assert(memo->num_misses == 1 && memo->num_hits == 1, sMSG("The repeated call should hit the cache"));
+
+    /// filling past capacity evicts the least recently used entry; 3 was just used
+    for(int i = 100; i < 100 + MEMO_CAPACITY; i++) {
+        FixMemo_test_call(twice, &root, Box_wrap_int(i));
+        if(i == 110) { FixMemo_test_call(twice, &root, Box_wrap_int(3)); }
+    }
+    log_assert(memo->num_entries == MEMO_CAPACITY, sMSG("The cache should stay bounded"));
+    size_t misses = memo->num_misses;
+    FixMemo_test_call(twice, &root, Box_wrap_int(3));
+    log_assert(memo->num_misses == misses, sMSG("A recently used entry should survive eviction"));
+    FixMemo_test_call(twice, &root, Box_wrap_int(100));
+    log_assert(memo->num_misses == misses + 1, sMSG("The least recently used entry should be evicted"));
+
+    ctx().inference.step++;
+    FixMemo_test_call(twice, &root, Box_wrap_int(3));
+    log_assert(memo->num_misses == misses + 2 && memo->num_entries == 1, sMSG("A new inference step should empty the cache"));
+
+    InterpTestFixture_leave(&fixture);
+    return 0;
+}
+
+
+
+/// ----- Generators ----- ///
+
+typedef enum FixGenStep {
+    GEN_STEP_DONE,
+    GEN_STEP_YIELD,
+    GEN_STEP_ERROR,
+} FixGenStep;
+
+/// @brief Sizes the resume stack of a `loop fn` body and notes whether it yields
+/// @note only statement-level nodes are resumable: a `yield` nested in an expression
+///     ... (eg., an argument) is reported by interp_eval_FixAst when it is reached
+static size_t FixGen_compile(Ast *node, bool *has_yield) {
+    if(node == nullptr) { return 0; }
+
+    size_t inner = 0;
+    switch(node->type) {
+        case AST_YIELD:
+            *has_yield = true;
+            return 1;
+        case AST_EXPRESSION:
+            return FixGen_compile(node->exp_stmt.expression, has_yield);
+        case AST_BLOCK:
+            for(size_t i = 0; i < node->block.num_statements; i++) {
+                size_t depth = FixGen_compile(node->block.statements[i], has_yield);
+                inner = depth > inner ? depth : inner;
+            }
+            return inner + 1;
+        case AST_LEF_DEF:
+            return FixGen_compile(node->let_stmt.body, has_yield) + 1;
+        case AST_IF:
+            inner = FixGen_compile(node->if_stmt.body, has_yield);
+            size_t else_depth = FixGen_compile(node->if_stmt.else_body, has_yield);
+            return (else_depth > inner ? else_depth : inner) + 1;
+        case AST_LOOP:
+        case AST_FOR:
+            return FixGen_compile(node->loop.body, has_yield) + 1;
+        default:
+            return 0;
+    }
+}
+
+static FixGenStep FixGen_resume(FixGenFrame *frame, Ast *node, size_t depth, Box *out);
+
+/// @brief Runs (or resumes) a `loop`/`for` one pass at a time: bindings are evaluated on
+///     ... entry, and each pass pulls the next element of every bound stream into the frame
+static FixGenStep FixGen_resume_loop(FixGenFrame *frame, Ast *node, size_t depth, Box *out) {
+    struct FixGenResume *slot = &frame->resume[depth];
+    FixScope *locals = &frame->locals;
+    Ast **bindings = node->loop.bindings;
+    size_t num_bindings = node->loop.num_bindings;
+
+    if(!slot->active) {
+        slot->active = true;
+        slot->in_body = false;
+        slot->has_sequence = false;
+        slot->pc = 0;
+        slot->sources = num_bindings > 0 ? FixArray_new_auto(num_bindings) : nullptr;
+
+        for(size_t i = 0; i < num_bindings; i++) {
+            if(bindings[i]->type != AST_BINDING) {
+                interp_error(sMSG("Expected binding in loop."));
+                return GEN_STEP_ERROR;
+            }
+
+            Box source = interp_eval_ast(bindings[i]->binding.expression, locals);
+            if(Box_is_error(source)) { return GEN_STEP_ERROR; }
+            source = Box_iter_pass(source);
+            if(Box_is_error(source)) {
+                interp_error(sMSG("Could not start a pass over a loop's stream"));
+                return GEN_STEP_ERROR;
+            }
+            FixArray_append(slot->sources, source);
+
+            if(Box_is_iterable(source)) {
+                slot->has_sequence = true;
+            } else {
+                FixScope_define_local(locals, bindings[i]->binding.identifier, source);
+            }
+        }
+    }
+
+    Box result = Box_null();
+    while(true) {
+        if(!slot->in_body) {
+            if(node->loop.condition) {
+                Box cond_val = interp_eval_ast(node->loop.condition, locals);
+                if(Box_is_error(cond_val)) { return GEN_STEP_ERROR; }
+                if(!Box_is_truthy(cond_val)) { break; }
+            } else if(slot->has_sequence) {
+                bool exhausted = false;
+                for(size_t i = 0; i < num_bindings && !exhausted; i++) {
+                    Box item;
+                    if(!Box_is_iterable(slot->sources->data[i])) { continue; }
+                    if(!Box_iter_next(slot->sources->data[i], slot->pc, &item)) {
+                        exhausted = true;
+                    } else {
+                        FixScope_define_local(locals, bindings[i]->binding.identifier, item);
+                    }
+                }
+                if(exhausted) { break; }
+            } else if(num_bindings > 0 && slot->pc > 0) {
+                /// @note with nothing iterable bound the body runs once (cf. interp_eval_bound_iterations)
+                break;
+            }
+            slot->in_body = true;
+        }
+
+        FixGenStep step = FixGen_resume(frame, node->loop.body, depth + 1, &result);
+        if(step != GEN_STEP_DONE) { return step; }
+
+        slot->in_body = false;
+        slot->pc++;
+    }
+
+    slot->active = false;
+    *out = result;
+    return GEN_STEP_DONE;
+}
+
+/// @brief Runs `node` in the generator's frame until it completes or reaches a `yield`
+/// @note on GEN_STEP_YIELD the value is in `frame->yielded` and every slot on the path keeps
+///     ... its position, so the next call with the same node continues after the yield
+static FixGenStep FixGen_resume(FixGenFrame *frame, Ast *node, size_t depth, Box *out) {
+    *out = Box_null();
+    if(node == nullptr) { return GEN_STEP_DONE; }
+
+    FixScope *locals = &frame->locals;
+    struct FixGenResume *slot = &frame->resume[depth];
+    FixGenStep step;
+
+    switch(node->type) {
+        case AST_EXPRESSION:
+            return FixGen_resume(frame, node->exp_stmt.expression, depth, out);
+        case AST_YIELD:
+            if(slot->active) {
+                slot->active = false;
+                return GEN_STEP_DONE;
+            }
+            frame->yielded = interp_eval_ast(node->yield_stmt.value, locals);
+            if(Box_is_error(frame->yielded)) { return GEN_STEP_ERROR; }
+            slot->active = true;
+            return GEN_STEP_YIELD;
+        case AST_BLOCK:
+            /// @note blocks share the frame rather than opening a scope per pass
+            if(!slot->active) {
+                slot->active = true;
+                slot->pc = 0;
+            }
+            for(; slot->pc < node->block.num_statements; slot->pc++) {
+                step = FixGen_resume(frame, node->block.statements[slot->pc], depth + 1, out);
+                if(step != GEN_STEP_DONE) { return step; }
+            }
+            slot->active = false;
+            return GEN_STEP_DONE;
+        case AST_LEF_DEF:
+            if(!slot->active) {
+                for(size_t i = 0; i < node->let_stmt.num_bindings; i++) {
+                    Ast *binding = node->let_stmt.bindings[i];
+                    if(binding->type != AST_BINDING) {
+                        interp_error(sMSG("Expected binding in let statement."));
+                        return GEN_STEP_ERROR;
+                    }
+                    Box value = interp_eval_ast(binding->binding.expression, locals);
+                    if(Box_is_error(value)) { return GEN_STEP_ERROR; }
+                    FixScope_define_local(locals, binding->binding.identifier, value);
+                }
+                slot->active = true;
+            }
+            step = FixGen_resume(frame, node->let_stmt.body, depth + 1, out);
+            if(step != GEN_STEP_YIELD) { slot->active = false; }
+            return step;
+        case AST_IF:
+            if(!slot->active) {
+                Box cond_val = interp_eval_ast(node->if_stmt.condition, locals);
+                if(Box_is_error(cond_val)) { return GEN_STEP_ERROR; }
+                slot->branch = Box_is_truthy(cond_val);
+                slot->active = true;
+            }
+            step = FixGen_resume(frame, slot->branch ? node->if_stmt.body : node->if_stmt.else_body, depth + 1, out);
+            if(step != GEN_STEP_YIELD) { slot->active = false; }
+            return step;
+        case AST_LOOP:
+        case AST_FOR:
+            return FixGen_resume_loop(frame, node, depth, out);
         default:
-            native_return_error_if(true,
-                sMSG("Incorrect number of args (%zu): `range(start, end, step)`"), len(args));
-    }
-
-    size_t _len = 1 + (size_t) fabs(ceil((to - from)/step));
-
-    native_return_error_if(_len == 0, sMSG("Cannot create an empty range"));
-    native_return_error_if(_len > UINT64_MAX, sMSG("Cannot create a range of this size: %zu"), _len);
-    native_return_error_if(step == 0, sMSG("Cannot create a range with step 0"));
-    native_return_error_if(step < 0 && from < to, sMSG("Cannot create a range with negative step and positive start"));
-    native_return_error_if(_len > ARRAY_SIZE_SMALL, sMSG("TODO: Move to FlxArray. Range too large: %zu"), _len);
-
-    result = FixArray_new_auto(_len);
-    for(size_t i = from; i <= to; i++) {
-        FixArray_append(result, Box_wrap_int(i));
+            *out = interp_eval_ast(node, locals);
+            return Box_is_error((*out)) ? GEN_STEP_ERROR : GEN_STEP_DONE;
     }
-    return Box_wrap_BoxedArena(result);
 }
 
-/// @brief
-/// @example
-///     log(infer(model(), #MCMC).take(3))
-/// @param self
-/// @param parent
-/// @param loopFn
-/// @param strategyTag
-/// @return
-Box native_infer(FixFn *self, FixScope parent, Box loopFn, Box strategyTag) {
-    native_log_call2(self, loopFn, strategyTag);
+/// @brief One pull of a generator stream
+/// @note a body with yields ends the stream when it completes; a body without any
+///     ... (eg., a model) is one draw per pull, so the stream is unbounded
+static bool FixIter_generator_next(FixIter *iter, Box *out) {
+    FixGenFrame *frame = iter->gen_frame;
+    if(frame->finished || iter->iter_index >= iter->iter_to) { return false; }
 
-    // native_return_error_if(loopFn.type != UBX_PTR_ARENA, sMSG("Expected function argument type, got %s"), ubx_nameof(loopFn.type));
-    // native_return_error_if(strategyTag.type != UBX_INT, sMSG("Expected int argument type, got %s"), ubx_nameof(strategyTag.type));
+    Box result;
+    FixGenStep step = FixGen_resume(frame, frame->code->body, 0, &result);
 
-    if(Box_tag_eq(strategyTag, s("#MCMC"))) {
-        printf("MCMC\n");
-        return Box_wrap_int(2);
-    } else if(Box_tag_eq(strategyTag, s("#HMC"))) {
-        printf("HMC\n");
-        return Box_wrap_int(1);
+    if(step == GEN_STEP_YIELD) {
+        *out = frame->yielded;
+    } else if(step == GEN_STEP_DONE && !frame->code->has_yield) {
+        *out = result;
     } else {
-        native_error(sMSG("Unknown inference strategy: %.*s"), fmt(Box_to_FixStr(strategyTag)));
-        return Box_null();
+        frame->finished = true;
+        return false;
     }
-}
 
-/// @brief
-/// @example
-///     let
-///         m = sample(normal(0, 2))
-///     in
-///         observe(normal(f(10, m, c), sigma));
-///
-Box native_sample(FixFn *self, FixScope parent, Box distObject) {
-    native_log_call1(self, distObject);
+    iter->iter_index++;
+    return true;
+}
 
-    if(distObject.type == UBX_FLOAT) {
-        return distObject;
-    }
+/// @brief Copies a suspended generator: its locals and any streams its loops are reading
+FixGenFrame *FixGenFrame_clone(FixGenFrame *frame) {
+    require_not_null(frame);
 
-    // native_return_error_if(distObject.type != UBX_PTR_HEAP,
-    //     sMSG("Expected object argument type, got %s"), ubx_nameof(distObject.type));
+    FixGenFrame *copy = Arena_alloc(sizeof(FixGenFrame));
+    if(copy == nullptr) { error_oom(); return nullptr; }
 
-    Box fn = FlxObject_getattr_checked(
-        Box_unwrap_FixObject(distObject), s("sample"), UBX_PTR_ARENA
-    );
+    *copy = *frame;
+    FixDict_data_new(&copy->locals.data, capacity_ref(&frame->locals.data));
+    FixDict_merge(&copy->locals.data, &frame->locals.data);
 
-    native_return_error_if(Box_is_error(fn),
-        sMSG("Expected object to have a `sample` method"));
+    for(size_t d = 0; d < frame->code->depth && d < GEN_MAX_RESUME_DEPTH; d++) {
+        FixArray *sources = frame->resume[d].sources;
+        if(!frame->resume[d].active || sources == nullptr) { continue; }
 
-    return FixFn_call(Box_unwrap_FixFn(fn), parent, (FixArray) {
-        .meta.capacity = 1,
-        .meta.size = 1,
-        .data = &distObject
-    });
+        copy->resume[d].sources = FixArray_new_auto(capacity_ref(sources));
+        for(size_t i = 0; i < len_ref(sources); i++) {
+            Box source = sources->data[i];
+            if(Box_is_Boxed_type(source, BXD_FIX_ITER)) {
+                FixIter *stream = FixIter_clone(Box_unwrap_FixIter(source));
+                if(stream == nullptr) { return nullptr; }
+                source = Box_wrap_BoxedArena(stream);
+            }
+            FixArray_append(copy->resume[d].sources, source);
+        }
+    }
+    return copy;
 }
 
-Box native_take(FixFn *self, FixScope parent, FixArray args) {
-    native_log_call(self, args);
-
-    FixArray *result = FixArray_new_auto(ARRAY_SIZE_SMALL);
-
-    // @todo implement take
-    FixArray_append(result, Box_wrap_float(1.1));
-    FixArray_append(result, Box_wrap_float(2.2));
-    FixArray_append(result, Box_wrap_float(3.3));
-    FixArray_append(result, Box_wrap_float(4.4));
+#pragma region FixModelGraphImpl
 
-    return Box_wrap_BoxedArena(result);
+static bool FixModel_is_call(Ast *node, const char *name) {
+    return node != nullptr && node->type == AST_FN_DEF_CALL
+        && node->call.callee != nullptr && node->call.callee->type == AST_ID
+        && FixStr_eq_cstr(node->call.callee->id.name, name);
 }
 
+/// @brief The node binding `name`, or SIZE_MAX when it is not a model variable
+static size_t FixModelGraph_find(FixModelGraph *model, FixStr name) {
+    for(size_t j = 0; j < model->num_nodes; j++) {
+        FixModelNode *node = &model->nodes[j];
+        if(node->kind != MODEL_NODE_OBSERVE && FixStr_eq(node->name, name)) { return j; }
+    }
+    return SIZE_MAX;
+}
 
-Box native_input(FixFn *self, FixScope parent, FixArray args) {
-    native_log_call(self, args);
+/// @brief Adds an edge to `child` from each model node that `expr` reads
+/// @note child == SIZE_MAX only checks that `expr` is deterministic
+/// @return false for expressions that cannot be traced: nested sample/observe calls, and
+///     ... anything (functions, loops, mutation) whose dependencies are not syntactic
+static bool FixModelGraph_depend(FixModelGraph *model, Ast *expr, size_t child) {
+    if(expr == nullptr) { return true; }
 
-    require_not_null(self);
-    require_not_null(parent.data.data);
-    require_not_null(args.data);
+    switch(expr->type) {
+        case AST_ID: {
+            size_t parent = FixModelGraph_find(model, expr->id.name);
+            if(parent == SIZE_MAX || child == SIZE_MAX) { return true; }
+            if(model->graph->num_edges >= model->graph->edge_capacity) { return false; }
+            return FlxGraph_add_edge(model->graph, parent, child, Box_null());
+        }
+        case AST_INT:
+        case AST_FLOAT:
+        case AST_DOUBLE:
+        case AST_STR:
+        case AST_TAG:
+            return true;
+        case AST_EXPRESSION:
+            return FixModelGraph_depend(model, expr->exp_stmt.expression, child);
+        case AST_BOP:
+            return FixModelGraph_depend(model, expr->bop.left, child)
+                && FixModelGraph_depend(model, expr->bop.right, child);
+        case AST_UOP:
+            return FixModelGraph_depend(model, expr->uop.operand, child);
+        case AST_FN_DEF_CALL:
+            if(FixModel_is_call(expr, "sample") || FixModel_is_call(expr, "observe")) { return false; }
+            for(size_t i = 0; i < expr->call.num_args; i++) {
+                if(!FixModelGraph_depend(model, expr->call.args[i], child)) { return false; }
+            }
+            return FixModelGraph_depend(model, expr->call.callee, child);
+        case AST_METHOD_CALL:
+            for(size_t i = 0; i < expr->method_call.num_args; i++) {
+                if(!FixModelGraph_depend(model, expr->method_call.args[i], child)) { return false; }
+            }
+            return FixModelGraph_depend(model, expr->method_call.target, child);
+        case AST_MEMBER_ACCESS:
+            return FixModelGraph_depend(model, expr->member_access.target, child);
+        case AST_VEC:
+            for(size_t i = 0; i < expr->vec.size; i++) {
+                if(!FixModelGraph_depend(model, expr->vec.data[i], child)) { return false; }
+            }
+            return true;
+        case AST_IF:
+            return FixModelGraph_depend(model, expr->if_stmt.condition, child)
+                && FixModelGraph_depend(model, expr->if_stmt.body, child)
+                && FixModelGraph_depend(model, expr->if_stmt.else_body, child);
+        case AST_TRY:
+            return FixModelGraph_depend(model, expr->try_stmt.body, child)
+                && FixModelGraph_depend(model, expr->try_stmt.fallback, child);
+        case AST_RANGE_SUGAR:
+            return FixModelGraph_depend(model, expr->range_sugar.start, child)
+                && FixModelGraph_depend(model, expr->range_sugar.end, child)
+                && FixModelGraph_depend(model, expr->range_sugar.step, child);
+        default:
+            return false;
+    }
+}
 
-    native_return_error_if(args.meta.size != 1, sMSG("Expected 1 argument, got %zu"), len(args));
-    native_return_error_if(args.data[0].type != UBX_PTR_ARENA, sMSG("Expected string argument type, got %s"), ubx_nameof(args.data[0].type));
+static bool FixModelGraph_add(FixModelGraph *model, FixModelNodeKind kind, FixStr name, Ast *expression, Ast *data) {
+    if(model->num_nodes >= MODEL_MAX_NODES) { return false; }
+    if(kind != MODEL_NODE_OBSERVE && FixModelGraph_find(model, name) != SIZE_MAX) {
+        return false;  /// rebinding a name would give one variable two nodes
+    }
 
-    FixStr prompt = Box_unwrap_FixStr(args.data[0]);
-    FixStr_puts(prompt);
+    size_t index = FlxGraph_add_node(model->graph, Box_wrap_int((int32_t) model->num_nodes));
+    if(index == SIZE_MAX) { return false; }
+    if(!FixModelGraph_depend(model, expression, index) || !FixModelGraph_depend(model, data, index)) { return false; }
 
-    return Box_wrap_BoxedHeap(FixStr_flexible_new(FixStr_readline_new(1024)));
+    model->nodes[model->num_nodes++] = (FixModelNode) {
+        .kind = kind, .name = name, .expression = expression, .data = data,
+        .value = Box_null(), .log_density = 0.0, .step = MODEL_INITIAL_STEP,
+        .affected_start = 0, .affected_end = 0,
+    };
+    return true;
 }
 
-Box native_len(FixFn *self, FixScope parent, Box arg) {
-    native_log_call1(self, arg);
-
-    if(Box_is_Boxed(arg)) {
-        return Box_wrap_int(Box_Boxed_meta(arg).size);
-    }
+/// @brief Walks the statements of a model body, adding a node per binding and observe()
+/// @note the shape traced is nested `let`s and blocks whose final expression is the draw;
+///     ... any other statement (a loop, a mutation, a bare call) makes the model untraceable
+static bool FixModelGraph_trace_ast(FixModelGraph *model, Ast *node, bool is_tail) {
+    if(node == nullptr) { return true; }
 
-    native_error(sMSG("Expected array or string argument type, got %s"), ubx_nameof(arg.type));
-    return Box_null();
-}
+    switch(node->type) {
+        case AST_EXPRESSION:
+            return FixModelGraph_trace_ast(model, node->exp_stmt.expression, is_tail);
+        case AST_LEF_DEF:
+            for(size_t i = 0; i < node->let_stmt.num_bindings; i++) {
+                Ast *binding = node->let_stmt.bindings[i];
+                if(binding == nullptr || binding->type != AST_BINDING) { return false; }
 
-Box native_sum(FixFn *self, FixScope parent, FixArray args) {
-    native_log_call(self, args);
+                Ast *expr = binding->binding.expression;
+                while(expr != nullptr && expr->type == AST_EXPRESSION) { expr = expr->exp_stmt.expression; }
 
-    double sum = 0;
-    for(size_t i = 0; i < len(args); i++) {
-        native_return_error_if(args.data[i].type != UBX_FLOAT, sMSG("Expected float argument type, got %s"), ubx_nameof(args.data[i].type));
-        sum += Box_unwrap_float(args.data[i]);
+                bool added = FixModel_is_call(expr, "sample") && expr->call.num_args == 1
+                    ? FixModelGraph_add(model, MODEL_NODE_SAMPLE, binding->binding.identifier, expr->call.args[0], nullptr)
+                    : FixModelGraph_add(model, MODEL_NODE_DETERMINISTIC, binding->binding.identifier, expr, nullptr);
+                if(!added) { return false; }
+            }
+            return FixModelGraph_trace_ast(model, node->let_stmt.body, is_tail);
+        case AST_BLOCK:
+            for(size_t i = 0; i < node->block.num_statements; i++) {
+                bool last = i + 1 == node->block.num_statements;
+                if(!FixModelGraph_trace_ast(model, node->block.statements[i], is_tail && last)) { return false; }
+            }
+            return true;
+        default:
+            if(FixModel_is_call(node, "observe") && node->call.num_args == 2) {
+                return FixModelGraph_add(model, MODEL_NODE_OBSERVE, s("observe"), node->call.args[0], node->call.args[1]);
+            }
+            if(!is_tail || !FixModelGraph_depend(model, node, SIZE_MAX)) { return false; }
+            model->result = node;
+            return true;
     }
-
-    return Box_wrap_float(sum);
 }
 
-Box native_sum_FlxVecInt(FixFn *self, FixScope parent, Box vec) {
-    native_log_call1(self, vec);
-    FlxVecInt *a = Box_unwrap_typed_ptr(FlxVecInt, vec);
-
-    native_return_error_if(a == nullptr, sMSG("Expected non-nullptr FlxVecInt argument"));
-    native_return_error_if(Box_is_Boxed(vec), sMSG("Expected collection argument type, got %s"), ubx_nameof(vec.type));
-    native_return_error_if(Box_is_Boxed_type(vec, BXD_FLX_VEC_INT), sMSG("Expected FlxVecInt argument type, got %s"), bt_nameof(a->meta.type));
-    // native_return_error_if(len_ref(a) == 0, sMSG("Cannot sum an empty array"));
+/// @brief Marks the nodes to re-evaluate when sample node `source` changes, in program order
+/// @note edges are added child by child, so they are sorted by target and one pass suffices
+static size_t FixModelGraph_mark(FixModelGraph *model, size_t source, bool *marks) {
+    memset(marks, 0, model->num_nodes * sizeof(bool));
+    marks[source] = true;
 
-    int sum = 0;
-    for(size_t i = 0; i < len_ref(a); i++) {
-        sum += at_ref(a, i);
+    size_t count = 1;
+    for(size_t e = 0; e < model->graph->num_edges; e++) {
+        size_t from = (size_t) Box_unwrap_int(model->graph->edges[e].source);
+        size_t to = (size_t) Box_unwrap_int(model->graph->edges[e].target);
+        bool propagates = from == source || model->nodes[from].kind == MODEL_NODE_DETERMINISTIC;
+        if(marks[from] && propagates && !marks[to]) {
+            marks[to] = true;
+            count++;
+        }
     }
-
-    return Box_wrap_int(sum);
+    return count;
 }
 
-Box native_sum_FlxVecDouble(FixFn *self, FixScope parent, Box vec) {
-    native_log_call1(self, vec);
-    FlxVecDouble *a = Box_unwrap_typed_ptr(FlxVecDouble, vec);
+/// @brief Traces a `loop fn` body into a model graph, or nullptr when it has no such structure
+/// @param scope the generator's locals (its arguments): the parent of the model's bindings
+FixModelGraph *FixModelGraph_trace(Ast *body, FixScope *scope) {
+    require_not_null(body);
+    require_not_null(scope);
 
-    native_return_error_if(Box_is_Boxed(vec), sMSG("Expected collection argument type, got %s"), ubx_nameof(vec.type));
-    native_return_error_if(a == nullptr, sMSG("Expected non-nullptr FlxVecFloat argument"));
-    native_return_error_if(Box_is_Boxed_type(vec, BXD_FLX_VEC_DOUBLE_N), sMSG("Expected FlxVecFloat argument type, got %s"), bt_nameof(a->meta.type));
-    native_return_error_if(len_ref(a) == 0, sMSG("Cannot sum an empty array"));
+    FixModelGraph *model = aro_new(BXD_FIX_MODEL_GRAPH);
+    if(model == nullptr) { error_oom(); return nullptr; }
+    memset(model, 0, sizeof(FixModelGraph));
+    model->meta.type = BXD_FIX_MODEL_GRAPH;
+    model->meta.state = LIVING_ALIVE;
 
-    double sum = 0;
-    for(size_t i = 0; i < len_ref(a); i++) {
-        sum += at_ref(a, i);
-    }
+    model->nodes = Arena_alloc(MODEL_MAX_NODES * sizeof(FixModelNode));
+    model->graph = FlxGraph_new(BXD_FLX_GRAPH_DIRECTED_UNWEIGHTED, MODEL_MAX_NODES, MODEL_MAX_EDGES);
+    if(model->nodes == nullptr || model->graph == nullptr) { error_oom(); return nullptr; }
 
-    return Box_wrap_float(sum);
-}
+    if(!FixModelGraph_trace_ast(model, body, true)) { return nullptr; }
 
-Box native_max(FixFn *self, FixScope parent, FixArray args) {
-    native_log_call(self, args);
+    size_t n = model->num_nodes;
+    bool *marks = Arena_alloc(n * sizeof(bool) + 1);
+    size_t num_affected = 0;
+    for(size_t i = 0; i < n; i++) {
+        if(model->nodes[i].kind == MODEL_NODE_SAMPLE) { num_affected += FixModelGraph_mark(model, i, marks); }
+    }
+    if(num_affected == 0) { return nullptr; }  /// nothing to sample: not a model
 
-    double max = -INFINITY;
-    for(size_t i = 0; i < len(args); i++) {
-        native_return_error_if(args.data[i].type != UBX_FLOAT, sMSG("Expected float argument type, got %s"), ubx_nameof(args.data[i].type));
-        max = fmax(max, Box_unwrap_float(args.data[i]));
+    model->affected = Arena_alloc(num_affected * sizeof(size_t));
+    model->undo_nodes = Arena_alloc(n * sizeof(size_t));
+    model->undo_values = Arena_alloc(n * sizeof(Box));
+    model->undo_terms = Arena_alloc(n * sizeof(double));
+    if(marks == nullptr || model->affected == nullptr || model->undo_nodes == nullptr
+        || model->undo_values == nullptr || model->undo_terms == nullptr) { error_oom(); return nullptr; }
+
+    size_t cursor = 0;
+    for(size_t i = 0; i < n; i++) {
+        FixModelNode *node = &model->nodes[i];
+        node->affected_start = cursor;
+        if(node->kind == MODEL_NODE_SAMPLE) {
+            FixModelGraph_mark(model, i, marks);
+            for(size_t j = i; j < n; j++) {
+                if(marks[j]) { model->affected[cursor++] = j; }
+            }
+        }
+        node->affected_end = cursor;
     }
 
-    return Box_wrap_float(max);
+    model->meta.size = n;
+    FixScope_data_new(&model->scope, scope);
+    return model;
 }
 
-// Box native_min(FixFn *self, FixScope parent, FixArray args);
-// Box native_abs(FixFn *self, FixScope parent, FixArray args);
-// Box native_pow(FixFn *self, FixScope parent, FixArray args);
-// Box native_sqrt(FixFn *self, FixScope parent, FixArray args);
-// Box native_floor(FixFn *self, FixScope parent, FixArray args);
-// Box native_ceil(FixFn *self, FixScope parent, FixArray args);
-// Box native_round(FixFn *self, FixScope parent, FixArray args);
-Box native_log10(FixFn *self, FixScope parent, FixArray args);
-Box native_logB(FixFn *self, FixScope parent, FixArray args);
-Box native_logE(FixFn *self, FixScope parent, FixArray args);
-Box native_exp(FixFn *self, FixScope parent, FixArray args);
-Box native_sin(FixFn *self, FixScope parent, FixArray args);
-Box native_cos(FixFn *self, FixScope parent, FixArray args);
-Box native_tan(FixFn *self, FixScope parent, FixArray args);
-Box native_asin(FixFn *self, FixScope parent, FixArray args);
-Box native_acos(FixFn *self, FixScope parent, FixArray args);
-Box native_atan(FixFn *self, FixScope parent, FixArray args);
-Box native_atan2(FixFn *self, FixScope parent, FixArray args);
-Box native_sinh(FixFn *self, FixScope parent, FixArray args);
-Box native_cosh(FixFn *self, FixScope parent, FixArray args);
-Box native_tanh(FixFn *self, FixScope parent, FixArray args);
-Box native_asinh(FixFn *self, FixScope parent, FixArray args);
-Box native_acosh(FixFn *self, FixScope parent, FixArray args);
-Box native_atanh(FixFn *self, FixScope parent, FixArray args);
-Box native_rand(FixFn *self, FixScope parent, FixArray args);
-Box native_random_int(FixFn *self, FixScope parent, FixArray args);
-Box native_random_range(FixFn *self, FixScope parent, FixArray args);
-Box native_random_choice(FixFn *self, FixScope parent, FixArray args);
-Box native_random_shuffle(FixFn *self, FixScope parent, FixArray args);
-Box native_random_sample(FixFn *self, FixScope parent, FixArray args);
-Box native_random_seed(FixFn *self, FixScope parent, FixArray args);
-Box native_random_normal(FixFn *self, FixScope parent, FixArray args);
-Box native_random_int_normal(FixFn *self, FixScope parent, FixArray args);
-Box native_random_gamma(FixFn *self, FixScope parent, FixArray args);
-Box native_random_beta(FixFn *self, FixScope parent, FixArray args);
-Box native_random_poisson(FixFn *self, FixScope parent, FixArray args);
-Box native_random_binomial(FixFn *self, FixScope parent, FixArray args);
-Box native_random_bernoulli(FixFn *self, FixScope parent, FixArray args);
-Box native_random_exponential(FixFn *self, FixScope parent, FixArray args);
-Box native_random_uniform(FixFn *self, FixScope parent, FixArray args);
-Box native_random_beta_binomial(FixFn *self, FixScope parent, FixArray args);
-Box native_random_dirichlet(FixFn *self, FixScope parent, FixArray args);
-Box native_random_gamma_poisson(FixFn *self, FixScope parent, FixArray args);
-Box native_random_inv_gamma(FixFn *self, FixScope parent, FixArray args);
-Box native_random_laplace(FixFn *self, FixScope parent, FixArray args);
-Box native_random_log_normal(FixFn *self, FixScope parent, FixArray args);
-Box native_random_neg_binomial(FixFn *self, FixScope parent, FixArray args);
-Box native_random_pareto(FixFn *self, FixScope parent, FixArray args);
-Box native_random_triangular(FixFn *self, FixScope parent, FixArray args);
-Box native_random_uniform_int(FixFn *self, FixScope parent, FixArray args);
-Box native_random_weibull(FixFn *self, FixScope parent, FixArray args);
-Box native_random_boltzmann(FixFn *self, FixScope parent, FixArray args);
-Box native_random_gev(FixFn *self, FixScope parent, FixArray args);
-Box native_random_gumbel(FixFn *self, FixScope parent, FixArray args);
-Box native_random_rayleigh(FixFn *self, FixScope parent, FixArray args);
-Box native_random_wald(FixFn *self, FixScope parent, FixArray args);
-Box native_random_maxwell(FixFn *self, FixScope parent, FixArray args);
-Box native_random_power_law(FixFn *self, FixScope parent, FixArray args);
+/// @brief Evaluates one node against the current bindings: a deterministic value, or the
+///     ... log-density term of a sample (its prior) or observe (its likelihood)
+static bool FixModelGraph_eval(FixModelGraph *model, size_t index) {
+    FixModelNode *node = &model->nodes[index];
+    model->num_evaluations++;
 
+    if(node->kind == MODEL_NODE_DETERMINISTIC) {
+        Box value = interp_eval_ast(node->expression, &model->scope);
+        if(Box_is_error(value)) { return false; }
+        node->value = value;
+        FixScope_define_local(&model->scope, node->name, value);
+        return true;
+    }
 
+    Box dist = interp_eval_ast(node->expression, &model->scope);
+    if(!(Box_is_Boxed_type(dist, BXD_FIX_DISTRIBUTION))) { return false; }
 
+    Box data = node->value;
+    if(node->kind == MODEL_NODE_OBSERVE) {
+        data = interp_eval_ast(node->data, &model->scope);
+        if(Box_is_error(data)) { return false; }
+    }
 
+    size_t count = 0;
+    return native_observe_Box(Box_unwrap_typed_ptr(FixDist, dist), data, &node->log_density, &count);
+}
 
+/// @brief Draws every latent from its prior and scores the model
+/// @return false if a sampled expression is not a distribution, or the draw is impossible
+bool FixModelGraph_init(FixModelGraph *model) {
+    require_not_null(model);
 
-void native_add_prelude(FixScope scope) {
-    static FixFn prelude[] = {
-        FixFnFromNative(FN_NATIVE, s("log"), native_log),
-        FixFnFromNative(FN_NATIVE, s("observe"), native_log),
-        FixFnFromNative(FN_NATIVE, s("range"), native_range),
-        FixFnFromNative(FN_NATIVE_1, s("sqrt"), native_sqrtf),
-        FixFnFromNative(FN_NATIVE_2, s("infer"), native_infer),
-        FixFnFromNative(FN_NATIVE_1, s("sample"), native_sample),
-        FixFnFromNative(FN_NATIVE, s("take"), native_take),
-        FixFnFromNative(FN_NATIVE_2, s("normal"), native_lib_rand_normal),
-        FixFnFromNative(FN_NATIVE_2, s("gamma"), native_lib_rand_normal)
-    };
+    for(size_t i = 0; i < model->num_nodes; i++) {
+        FixModelNode *node = &model->nodes[i];
+        if(node->kind == MODEL_NODE_SAMPLE) {
+            Box dist = interp_eval_ast(node->expression, &model->scope);
+            if(!(Box_is_Boxed_type(dist, BXD_FIX_DISTRIBUTION))) { return false; }
 
-    size_t n = sizeof(prelude) / sizeof(FixFn);
-    for(size_t i = 0; i < n; i++) {
-        FixScope_define_local(&scope, prelude[i].name, Box_wrap_BoxedArena(&prelude[i]));
+            FixDist *prior = Box_unwrap_typed_ptr(FixDist, dist);
+            node->value = Box_wrap_float((float) prior->sample_fn_ptr(prior));
+            FixScope_define_local(&model->scope, node->name, node->value);
+        }
+        if(!FixModelGraph_eval(model, i)) { return false; }
     }
+    return FixModelGraph_recompute(model) > -INFINITY;
 }
 
+/// @brief Sets sample node `index` to `value` and re-evaluates only the nodes it affects
+/// @return the new log density (-INFINITY as soon as any term is impossible);
+///     ... FixModelGraph_revert undoes the change
+double FixModelGraph_update(FixModelGraph *model, size_t index, Box value) {
+    require_not_null(model);
+    require(index < model->num_nodes && model->nodes[index].kind == MODEL_NODE_SAMPLE);
 
-#pragma endregion
+    model->num_undo = 0;
+    model->undo_log_density = model->log_density;
 
-//#endregion
-///---------- ---------- ---------- IMPL: INTERPRETER ---------- ---------- ------ ///
-//#region Implementation_Interpreter
+    FixModelNode *changed = &model->nodes[index];
+    for(size_t k = changed->affected_start; k < changed->affected_end; k++) {
+        size_t j = model->affected[k];
+        FixModelNode *node = &model->nodes[j];
 
+        model->undo_nodes[model->num_undo] = j;
+        model->undo_values[model->num_undo] = node->value;
+        model->undo_terms[model->num_undo] = node->log_density;
+        model->num_undo++;
 
-#pragma region InterpErrorImpl
+        if(j == index) {
+            node->value = value;
+            FixScope_define_local(&model->scope, node->name, value);
+        }
 
-#define interp_return_if_error(value) \
-    if (Box_is_error(value)) {\
-        return Box_exit();\
+        double before = node->log_density;
+        if(!FixModelGraph_eval(model, j)) { model->log_density = -INFINITY; break; }
+        if(node->kind == MODEL_NODE_DETERMINISTIC) { continue; }
+
+        model->log_density += node->log_density - before;
+        if(!(model->log_density > -INFINITY)) { model->log_density = -INFINITY; break; }
     }
+    return model->log_density;
+}
 
-#pragma endregion
+/// @brief Restores the nodes (and bindings) the last update changed
+void FixModelGraph_revert(FixModelGraph *model) {
+    require_not_null(model);
 
-#pragma region BoxedPrecacheImpl
+    while(model->num_undo > 0) {
+        size_t u = --model->num_undo;
+        FixModelNode *node = &model->nodes[model->undo_nodes[u]];
+        node->value = model->undo_values[u];
+        node->log_density = model->undo_terms[u];
+        if(node->kind != MODEL_NODE_OBSERVE) {
+            FixScope_define_local(&model->scope, node->name, node->value);
+        }
+    }
+    model->log_density = model->undo_log_density;
+}
 
-void interp_init(void) {
+/// @brief The log density from the current terms, re-evaluating every node
+/// @note the reference FixModelGraph_update is checked against
+double FixModelGraph_recompute(FixModelGraph *model) {
+    require_not_null(model);
 
-    #ifdef INTERP_PRECACHE_INTERNED_STRINGS
-        /// @todo consider this interning approach, and this size
-        /// ... empirically how many vars / prog? how useful is it to intern?
-        /// @todo presumably this should be a vector of strings, not a FixDict
-        FixDict_data_new(&interp_precache().str_precache, ARRAY_SIZE_MEDIUM);
-    #endif
+    double log_density = 0.0;
+    for(size_t i = 0; i < model->num_nodes; i++) {
+        if(!FixModelGraph_eval(model, i)) { log_density = -INFINITY; break; }
+        if(model->nodes[i].kind != MODEL_NODE_DETERMINISTIC) { log_density += model->nodes[i].log_density; }
+    }
+    model->log_density = log_density;
+    return log_density;
 }
 
-/// @todo implement this
+/// @brief One Metropolis-Hastings sweep: a random-walk proposal for each latent in turn
+/// @note the first MODEL_ADAPT_SWEEPS sweeps tune each proposal scale towards roughly
+///     ... a third of proposals accepted
+bool FixModelGraph_sweep(FixModelGraph *model) {
+    require_not_null(model);
+    ctx().inference.step++;
 
-/// @brief
-/// @param str
-/// @param out
-/// @return
-bool interp_precache_getstr(FixStr str, FixKvPair *out) {
-    return true;
-}
+    for(size_t i = 0; i < model->num_nodes; i++) {
+        FixModelNode *node = &model->nodes[i];
+        if(node->kind != MODEL_NODE_SAMPLE) { continue; }
 
-void interp_precache_setstr(FixStr str) {
-    return;
-}
+        double current;
+        if(!Box_try_numeric(node->value, &current)) { return false; }
 
-void interp_precache_test_main(void) {
-    #ifndef INTERP_PRECACHE_INTERNED_STRINGS
-        log_message(LL_INFO, sMSG("Skipping interned strings test"));
-        return;
-    #endif
+        double before = model->log_density;
+        double proposed = current + node->step * sample_normal(0.0, 1.0);
+        double after = FixModelGraph_update(model, i, Box_wrap_float((float) proposed));
 
-    // Initialize the interpreter pre-cache
-    interp_init();
-    log_assert(FixStr_is_empty(interp_precache().str_precache[0]), sMSG("Interned strings should be empty"));
+        bool accept = after > -INFINITY && log(InterpContext_random()) < after - before;
+        if(accept) {
+            model->num_accepted++;
+            model->num_undo = 0;
+        } else {
+            FixModelGraph_revert(model);
+        }
 
-    // Test setting and getting a string
-    FixStr test_str = s("test_string");
-    interp_precache_setstr(test_str);
+        if(model->num_sweeps < MODEL_ADAPT_SWEEPS) {
+            node->step *= accept ? 1.1 : 0.95;
+        }
+    }
 
-    FixKvPair entry;
-    bool found = interp_precache_getstr(test_str, &entry);
-    log_assert(found, sMSG("Failed to find interned string"));
-    log_assert(Box_is_null(entry.value), sMSG("Interned string value should be nullptr"));
+    model->num_sweeps++;
+    return true;
+}
 
-    // Test retrieving a non-existent string
-    FixStr non_existent = s("non_existent");
-    found = interp_precache_getstr(non_existent, &entry);
-    log_assert(!found, sMSG("Non-existent string should not be found"));
+/// @brief The current draw: the body's final expression, or the latents when it has none
+Box FixModelGraph_result(FixModelGraph *model) {
+    require_not_null(model);
+
+    if(model->result != nullptr) {
+        return interp_eval_ast(model->result, &model->scope);
+    }
+
+    FixArray *draw = FixArray_new_auto(model->num_nodes);
+    for(size_t i = 0; i < model->num_nodes; i++) {
+        if(model->nodes[i].kind == MODEL_NODE_SAMPLE) { FixArray_append(draw, model->nodes[i].value); }
+    }
+    return Box_wrap_BoxedArena(draw);
 }
 
-#pragma endregion
+/// @brief Fits the latents of an initialised graph by ADVI or L-BFGS (cf. FixInferResult_infer)
+/// @note the graph must have the shape of a FixInferModel: one observe() whose distribution
+///     ... takes each latent once, as a bare variable, of numeric data, and latents whose
+///     ... priors read no other model variable; nullptr for any other model
+FixInferResult *FixModelGraph_fit(FixModelGraph *model, InferMethod method) {
+    require_not_null(model);
 
-#pragma region InterpEvalImpl
+    FixModelNode *observed = nullptr;
+    size_t num_latents = 0;
+    for(size_t i = 0; i < model->num_nodes; i++) {
+        if(model->nodes[i].kind == MODEL_NODE_SAMPLE) { num_latents++; }
+        if(model->nodes[i].kind != MODEL_NODE_OBSERVE) { continue; }
+        if(observed != nullptr) { return nullptr; }
+        observed = &model->nodes[i];
+    }
+    if(observed == nullptr) { return nullptr; }
 
-#define interp_trace() \
-    ctx_trace_me(FixStr_firstN(Ast_to_FixStr(node), 20));
+    Ast *call = observed->expression;
+    while(call != nullptr && call->type == AST_EXPRESSION) { call = call->exp_stmt.expression; }
+    if(call == nullptr || call->type != AST_FN_DEF_CALL || call->call.num_args != num_latents) { return nullptr; }
 
-#define interp_print_traces() Tracer_print_stack(ctx().debug.callstack, 16);
+    size_t *nodes = Arena_alloc(num_latents * sizeof(size_t) + 1);
+    FixDist **priors = Arena_alloc(num_latents * sizeof(FixDist *) + 1);
+    FixInferModel *fitted = Arena_alloc(sizeof(FixInferModel));
+    if(nodes == nullptr || priors == nullptr || fitted == nullptr) { error_oom(); return nullptr; }
 
+    for(size_t j = 0; j < num_latents; j++) {
+        Ast *arg = call->call.args[j];
+        while(arg != nullptr && arg->type == AST_EXPRESSION) { arg = arg->exp_stmt.expression; }
+        if(arg == nullptr || arg->type != AST_ID) { return nullptr; }
 
- ///@todo
-#define interp_require_type(node_type)\
-    if (node->type != node_type) {\
-        assert(false);\
-        return Box_exit();\
+        nodes[j] = FixModelGraph_find(model, arg->id.name);
+        if(nodes[j] == SIZE_MAX || model->nodes[nodes[j]].kind != MODEL_NODE_SAMPLE) { return nullptr; }
+        for(size_t k = 0; k < j; k++) {
+            if(nodes[k] == nodes[j]) { return nullptr; }
+        }
+        for(size_t e = 0; e < model->graph->num_edges; e++) {
+            if((size_t) Box_unwrap_int(model->graph->edges[e].target) == nodes[j]) { return nullptr; }
+        }
+
+        Box prior = interp_eval_ast(model->nodes[nodes[j]].expression, &model->scope);
+        if(!(Box_is_Boxed_type(prior, BXD_FIX_DISTRIBUTION))) { return nullptr; }
+        priors[j] = Box_unwrap_typed_ptr(FixDist, prior);
     }
 
+    Box likelihood = interp_eval_ast(observed->expression, &model->scope);
+    if(!(Box_is_Boxed_type(likelihood, BXD_FIX_DISTRIBUTION))
+        || Box_unwrap_typed_ptr(FixDist, likelihood)->num_params != num_latents) { return nullptr; }
 
-static inline __attribute__((always_inline))
-Box interp_eval_FixAst(Ast *node, FixScope *scope) {
-    switch(node->type) {
-        case AST_DISCARD:
-            return Box_null();
-        case AST_IF:
-            return interp_eval_if(node, scope);
-        case AST_DICT:
-            return interp_eval_dict(node, scope);
-        case AST_VEC:
-            return interp_eval_vec(node, scope);
-        case AST_FN_DEF_CALL:
-            return interp_eval_call_fn(node, scope);
-        case AST_METHOD_CALL:
-            return interp_eval_method_call(node, scope);
-        case AST_MEMBER_ACCESS:
-            return interp_eval_member_access(node, scope);
-        case AST_TAG: case AST_INT: case AST_FLOAT: case AST_DOUBLE: case AST_STR:
-            return interp_eval_literal(node, scope);
-        case AST_ID:
-            return interp_eval_identifier(node, scope);
-        case AST_MOD:
-            return interp_eval_module(node, scope);
-        case AST_BLOCK:
-            return interp_eval_block(node, scope);
-        case AST_FN_DEF:
-            return interp_eval_fn_def(node, scope);
-        case AST_LOOP:
-            return interp_eval_loop(node, scope);
-        case AST_FOR:
-            return interp_eval_for(node, scope);
-        case AST_EXPRESSION:
-            return interp_eval_expression(node, scope);
-        case AST_FN_DEF_ANON:
-            return interp_eval_fn_anon(node, scope);
-        case AST_CONST_DEF:
-            return interp_eval_const_def(node, scope);
-        case AST_LEF_DEF:
-            return interp_eval_let_def(node, scope);
-        case AST_BOP:
-            return interp_eval_binary_op(node, scope);
-        case AST_UOP:
-            return interp_eval_unary_op(node, scope);
-        case AST_USE:
-            return interp_eval_use(node, scope);
-        case AST_STRUCT_DEF:
-            return interp_eval_struct_def(node, scope);
-        case AST_OBJECT_LITERAL:
-            return interp_eval_object_literal(node, scope);
-        case AST_MATCH:
-            return interp_eval_match(node, scope);
-        case AST_RETURN:
-            return interp_eval_return(node, scope);
-        case AST_MUTATION:
-            return interp_eval_mutation(node, scope);
-        default:
-            if((node->type > 0) && (node->type < AST_ENUM_SIZE)) {
-                interp_error(sMSG("Unknown AST node type (%.*s)"), fmt(Ast_nameof(node->type)));
-            } else {
-                interp_error(sMSG("Unknown AST node type (%d)"), node->type);
-            }
-            return Box_exit();
+    size_t num_data = 0;
+    double *data = native_doubles_from_Box_cnew(interp_eval_ast(observed->data, &model->scope), &num_data);
+    if(data == nullptr) { return nullptr; }
+    if(num_data == 0) { cfree(data); return nullptr; }
+
+    *fitted = (FixInferModel) {
+        .priors = priors, .likelihood = Box_unwrap_typed_ptr(FixDist, likelihood), .params = nullptr,
+        .num_params = num_latents, .data = data, .num_data = num_data, .num_target_samples = 0
+    };
+    FixInferResult *fit = FixInferResult_infer(fitted, method);
+    cfree(data);
+    fitted->data = nullptr;
+    fitted->num_data = 0;
+    if(fit == nullptr) { return nullptr; }
+
+    model->fit_model = fitted;
+    model->fit = fit;
+    model->fit_nodes = nodes;
+    return fit;
+}
+
+/// @brief Binds the latents to the fit's location or, with `draw`, to a draw from q (#VI)
+/// @return the body's result at those latents (cf. FixModelGraph_result)
+Box FixModelGraph_fit_result(FixModelGraph *model, bool draw) {
+    require_not_null(model);
+    require_not_null(model->fit);
+
+    FixInferModel *fitted = model->fit_model;
+    double theta[fitted->num_params];
+    memcpy(theta, model->fit->location, fitted->num_params * sizeof(double));
+    if(draw && model->fit->scale != nullptr) {
+        double zeta[fitted->num_params];
+        for(size_t j = 0; j < fitted->num_params; j++) {
+            zeta[j] = FixSupport_unconstrain(FixDist_support(fitted->priors[j]), theta[j])
+                + model->fit->scale[j] * lib_rand_normal(0.0, 1.0);
+        }
+        FixInferModel_constrain(fitted, zeta, theta);
+    }
+
+    for(size_t j = 0; j < fitted->num_params; j++) {
+        FixModelNode *node = &model->nodes[model->fit_nodes[j]];
+        node->value = Box_wrap_float((float) theta[j]);
+        FixScope_define_local(&model->scope, node->name, node->value);
     }
+    for(size_t i = 0; i < model->num_nodes; i++) {
+        if(model->nodes[i].kind != MODEL_NODE_DETERMINISTIC) { continue; }
+        if(!FixModelGraph_eval(model, i)) { return Box_error_empty(); }
+    }
+    return FixModelGraph_result(model);
 }
 
+static bool FixIter_vi_next(FixIter *iter, Box *out) {
+    if(iter->iter_index >= iter->iter_to) { return false; }
 
-Box interp_eval_ast(Ast *node, FixScope *scope) {
-    require_not_null(node); require_not_null(scope);
-    require_positive(node->type);
-    Box result = interp_eval_FixAst(node, scope);
+    CallStack *traces = ctx_local().debug.callstack;
+    size_t depth = traces == nullptr ? 0 : traces->top;
+    Box draw = FixModelGraph_fit_result(Box_unwrap_typed_ptr(FixModelGraph, iter->iter_state), true);
+    if(Box_is_error(draw)) { return false; }
+    if(traces != nullptr) { traces->top = depth; }
 
-    //|| Box_is_halt(result)
-    if(Box_is_error(result)) {
-        interp_graceful_exit();
-    }
+    *out = draw;
+    iter->iter_index++;
+    return true;
+}
 
-    return result;
+/// @brief A stream of draws from a graph fitted by #VI: each pull is an independent draw from q
+FixIter *FixIter_vi_new(FixModelGraph *model) {
+    require_not_null(model);
+    require_not_null(model->fit);
+
+    FixIter *iter = FixIter_new(FixIter_vi_next, SIZE_MAX);
+    if(iter == nullptr) { return nullptr; }
+    iter->iter_state = Box_wrap_BoxedArena(model);
+    return iter;
 }
 
+/// @note the first pull runs the MODEL_ADAPT_SWEEPS adaptive sweeps as burn-in: their step
+///     ... sizes still move with each accept or reject, so they are not draws of the posterior
+static bool FixIter_mcmc_next(FixIter *iter, Box *out) {
+    if(iter->iter_index >= iter->iter_to) { return false; }
 
-void interp_graceful_exit(void) {
-    /// @note print the stack trace
-    log_message(LL_RECOVERABLE, sMSG("Interpreter Error"));
-    interp_print_traces();
-    error_print_all();
+    FixModelGraph *model = Box_unwrap_typed_ptr(FixModelGraph, iter->iter_state);
+    CallStack *traces = ctx_local().debug.callstack;
+    size_t depth = traces == nullptr ? 0 : traces->top;
+    while(model->num_sweeps < MODEL_ADAPT_SWEEPS) {
+        if(!FixModelGraph_sweep(model)) { return false; }
+        if(traces != nullptr) { traces->top = depth; }
+    }
+    if(!FixModelGraph_sweep(model)) { return false; }
 
-    /// @todo -- this should not be an abort
-    /// ... maybe a longjmp or something else
-    abort();
-    // exit(1);
+    Box draw = FixModelGraph_result(model);
+    if(Box_is_error(draw)) { return false; }
+
+    *out = draw;
+    iter->iter_index++;
+    return true;
 }
 
+/// @brief A stream of MCMC draws from an initialised model: one sweep per pull, after burn-in
+FixIter *FixIter_mcmc_new(FixModelGraph *model) {
+    require_not_null(model);
 
+    FixIter *iter = FixIter_new(FixIter_mcmc_next, SIZE_MAX);
+    if(iter == nullptr) { return nullptr; }
+    iter->iter_state = Box_wrap_BoxedArena(model);
+    return iter;
+}
 
-// Implementation of interp_run_from_source
-Box interp_run_from_source(ParseContext *p, FixStr source, int argc, char **argv) {
-    lex_source(p, source, s("    "));
-    FixStr_puts(data_to_ansi_new(p->lexer));
+/// @brief One step of a whole-body Metropolis chain: a fresh run of the model stream proposes
+///     ... a draw from the priors, moved to with probability exp(its log weight - the current's)
+/// @note an independence sampler: the prior proposal cancels the prior in the target, leaving
+///     ... the observe() weights, so it needs no trace, only ctx_local().inference.log_weight
+static bool FixIter_metropolis_next(FixIter *iter, Box *out) {
+    if(iter->iter_index >= iter->iter_to) { return false; }
+    ctx().inference.step++;
 
-    #ifdef INTERP_SHOW_PARSING
-        lex_print_all(p->lexer);
-    #endif
+    ctx_local().inference.log_weight = 0.0;
+    ctx_local().inference.num_observed = 0;
+    Box proposal;
+    if(!Box_iter_next(iter->iter_state, iter->iter_cursor++, &proposal)) { return false; }
+    double log_weight = ctx_local().inference.log_weight;
 
-    parse(p);
-    require_not_null(p->parser.data);
+    if(iter->iter_index == 0 || log(InterpContext_random()) < log_weight - iter->chain_log_weight) {
+        iter->chain_draw = proposal;
+        iter->chain_log_weight = log_weight;
+    }
 
-    #ifdef INTERP_SHOW_PARSING
-        Ast_print(p->parser.data);
-    #endif
+    *out = iter->chain_draw;
+    iter->iter_index++;
+    return true;
+}
 
-    log_assert(p->parser.data->type == AST_BLOCK, sMSG("Top-level node must be a block"));
+/// @brief A stream of MCMC draws from a model stream that cannot be traced: one run per pull
+FixIter *FixIter_metropolis_new(FixIter *model) {
+    require_not_null(model);
+
+    FixIter *iter = FixIter_new(FixIter_metropolis_next, SIZE_MAX);
+    if(iter == nullptr) { return nullptr; }
+    iter->iter_state = Box_wrap_BoxedArena(model);
+    return iter;
+}
+
+FixStr FixModelGraph_to_FixStr(FixModelGraph *model) {
+    double rate = model->num_sweeps == 0 ? 0.0 : (double) model->num_accepted / (double) model->num_sweeps;
+    return FixStr_fmt_new(s("ModelGraph(%zu nodes, %zu edges, log p %.4g, %zu sweeps, %.2f accepted/sweep)"),
+        model->num_nodes, model->graph->num_edges, model->log_density, model->num_sweeps, rate);
+}
+
+int FixModelGraph_test_main(void) {
+    InterpTestFixture fixture;
+    InterpTestFixture_enter(&fixture);
+    FixScope root = fixture.root;
+    FixScope_define_local(&root, s("ya"), Box_wrap_float(1.0f));
+    FixScope_define_local(&root, s("yb"), Box_wrap_float(2.0f));
+    FixScope_define_local(&root, s("yc"), Box_wrap_float(3.5f));
+    FixScope scope = FixScope_empty(sMSG("$Scope"));
+    FixScope_data_new(&scope, &root);
+
+    /// let mu = sample(normal(0, 10)), a = sample(normal(mu, 1)), b = sample(normal(mu, 1)), c = a + b in
+    ///     observe(normal(a, 1), ya); observe(normal(b, 1), yb); observe(normal(c, 1), yc); [mu, a, b]
+    Ast zero = { .type = AST_INT, .integer.value = 0 };
+    Ast one = { .type = AST_INT, .integer.value = 1 };
+    Ast ten = { .type = AST_INT, .integer.value = 10 };
+    Ast normal_id = { .type = AST_ID, .id.name = s("normal") };
+    Ast sample_id = { .type = AST_ID, .id.name = s("sample") };
+    Ast observe_id = { .type = AST_ID, .id.name = s("observe") };
+    Ast mu = { .type = AST_ID, .id.name = s("mu") };
+    Ast a = { .type = AST_ID, .id.name = s("a") };
+    Ast b = { .type = AST_ID, .id.name = s("b") };
+    Ast c = { .type = AST_ID, .id.name = s("c") };
+    Ast ya = { .type = AST_ID, .id.name = s("ya") };
+    Ast yb = { .type = AST_ID, .id.name = s("yb") };
+    Ast yc = { .type = AST_ID, .id.name = s("yc") };
+
+    #define TEST_NORMAL(var, loc, scale) \
+        Ast *var##_args[] = { loc, scale }; \
+        Ast var = { .type = AST_FN_DEF_CALL, .call.callee = &normal_id, .call.args = var##_args, .call.num_args = 2 }
+    TEST_NORMAL(prior_mu, &zero, &ten);
+    TEST_NORMAL(prior_a, &mu, &one);
+    TEST_NORMAL(prior_b, &mu, &one);
+    TEST_NORMAL(like_a, &a, &one);
+    TEST_NORMAL(like_b, &b, &one);
+    TEST_NORMAL(like_c, &c, &one);
+    #undef TEST_NORMAL
+
+    Ast *sample_mu_args[] = { &prior_mu }, *sample_a_args[] = { &prior_a }, *sample_b_args[] = { &prior_b };
+    Ast sample_mu = { .type = AST_FN_DEF_CALL, .call.callee = &sample_id, .call.args = sample_mu_args, .call.num_args = 1 };
+    Ast sample_a = { .type = AST_FN_DEF_CALL, .call.callee = &sample_id, .call.args = sample_a_args, .call.num_args = 1 };
+    Ast sample_b = { .type = AST_FN_DEF_CALL, .call.callee = &sample_id, .call.args = sample_b_args, .call.num_args = 1 };
+    Ast sum = { .type = AST_BOP, .bop.op = s("+"), .bop.left = &a, .bop.right = &b };
+
+    Ast bind_mu = { .type = AST_BINDING, .binding.identifier = s("mu"), .binding.expression = &sample_mu };
+    Ast bind_a = { .type = AST_BINDING, .binding.identifier = s("a"), .binding.expression = &sample_a };
+    Ast bind_b = { .type = AST_BINDING, .binding.identifier = s("b"), .binding.expression = &sample_b };
+    Ast bind_c = { .type = AST_BINDING, .binding.identifier = s("c"), .binding.expression = &sum };
+
+    Ast *observe_a_args[] = { &like_a, &ya }, *observe_b_args[] = { &like_b, &yb }, *observe_c_args[] = { &like_c, &yc };
+    Ast observe_a = { .type = AST_FN_DEF_CALL, .call.callee = &observe_id, .call.args = observe_a_args, .call.num_args = 2 };
+    Ast observe_b = { .type = AST_FN_DEF_CALL, .call.callee = &observe_id, .call.args = observe_b_args, .call.num_args = 2 };
+    Ast observe_c = { .type = AST_FN_DEF_CALL, .call.callee = &observe_id, .call.args = observe_c_args, .call.num_args = 2 };
+    Ast *draw_data[] = { &mu, &a, &b };
+    Ast draw = { .type = AST_VEC, .vec.data = draw_data, .vec.size = 3 };
+
+    Ast *statements[] = { &observe_a, &observe_b, &observe_c, &draw };
+    Ast block = { .type = AST_BLOCK, .block.statements = statements, .block.num_statements = 4 };
+    Ast *bindings[] = { &bind_mu, &bind_a, &bind_b, &bind_c };
+    Ast body = { .type = AST_LEF_DEF, .let_stmt.bindings = bindings, .let_stmt.num_bindings = 4, .let_stmt.body = &block };
+
+    FixModelGraph *model = FixModelGraph_trace(&body, &scope);
+    log_assert(model != nullptr && model->num_nodes == 7 && model->result == &draw, sMSG("The model should trace to 7 nodes"));
+    log_assert(model->graph->num_edges == 7, sMSG("The model graph should have one edge per read"));
+    log_assert(FlxGraph_has_edge(model->graph, 0, 1) && FlxGraph_has_edge(model->graph, 0, 2)
+        && FlxGraph_has_edge(model->graph, 1, 3) && FlxGraph_has_edge(model->graph, 3, 6)
+        && !FlxGraph_has_edge(model->graph, 0, 3), sMSG("Edges should run from each variable to its readers"));
+
+    FixModelNode *node_mu = &model->nodes[0], *node_a = &model->nodes[1];
+    log_assert(node_mu->affected_end - node_mu->affected_start == 3, sMSG("mu should affect only its own and its children's priors"));
+    log_assert(node_a->affected_end - node_a->affected_start == 4, sMSG("a should affect c and both likelihoods reading it"));
+
+    log_assert(FixModelGraph_init(model), sMSG("The model should initialise from its priors"));
+    double initial = model->log_density;
+
+    fixture.traces.top = 0;
+    size_t before = model->num_evaluations;
+    FixModelGraph_update(model, 0, Box_wrap_float(0.5f));
+    log_assert(model->num_evaluations - before == 3, sMSG("Updating mu should re-evaluate three nodes, not the model"));
+    FixModelGraph_revert(model);
+    log_assert(model->log_density == initial, sMSG("Reverting should restore the log density"));
+
+    for(size_t sweep = 0; sweep < 100; sweep++) {
+        fixture.traces.top = 0;
+        log_assert(FixModelGraph_sweep(model), sMSG("A sweep should succeed"));
+    }
+    fixture.traces.top = 0;
+    double incremental = model->log_density;
+    log_assert(fabs(FixModelGraph_recompute(model) - incremental) < 1e-6 * (1.0 + fabs(incremental)),
+        sMSG("The incremental log density should match a full recompute"));
+    log_assert(model->num_accepted > 0, sMSG("Some proposals should be accepted"));
+
+    /// infer(model(), #MCMC) on a `loop fn` with this body streams MH sweeps
+    fixture.traces.top = 0;
+    FixFn *model_fn = FixFn_new(FN_GENERATOR, s("model"), (FixDict) {0}, scope,
+        (void *) FixFn_interp_generator_fn, FixGenCode_new(&body));
+    FixFn infer = { .name = s("infer") };
+    Box draws = native_infer(&infer, scope, FixFn_call(model_fn, scope, (FixArray) {0}), Box_wrap_tag(s("#MCMC")));
+    FixIter *chain = Box_unwrap_FixIter(draws);
+    log_assert(Box_is_Boxed_type(chain->iter_state, BXD_FIX_MODEL_GRAPH), sMSG("#MCMC should run on the traced graph"));
+
+    fixture.traces.top = 0;
+    Box item;
+    log_assert(FixIter_next(chain, &item) && !Box_is_error(item), sMSG("The chain should produce a draw"));
+    FixModelGraph *chain_model = Box_unwrap_typed_ptr(FixModelGraph, chain->iter_state);
+    log_assert(chain_model->num_sweeps == MODEL_ADAPT_SWEEPS + 1, sMSG("The first draw should follow the adaptive burn-in"));
+    double frozen_step = chain_model->nodes[0].step;
+    log_assert(FixIter_next(chain, &item) && chain_model->nodes[0].step == frozen_step, sMSG("Draws should not move the steps"));
+
+    InterpTestFixture_leave(&fixture);
+    return 0;
+}
 
-    /// @todo revise the FixScope new'ing to ensure data are initialized
-    FixScope globals = FixScope_empty(s("Global scope"));
-    FixScope_data_new(&globals, nullptr);
-    native_add_prelude(globals);
+#pragma endregion
 
-    Box result = interp_eval_ast(p->parser.data, &globals);
-    interp_return_if_error(result);
+/// @brief Compiles the body of a `loop fn` at its definition
+FixGenCode *FixGenCode_new(Ast *body) {
+    require_not_null(body);
 
-    /// @note we find and run the main function
-    // FixArray *main_args = CliArgs_to_FixArray(argc, argv);
-    FixArray main_args = {0}; //CliArgs_to_FixArray(argc, argv);
-    Box main_fn;
-    if(FixScope_lookup(&globals, s("main"), &main_fn)) {
-        return FixFn_call(Box_unwrap_FixFn(main_fn), globals, main_args);
-    } else {
-        FixScope_debug_print(globals);
-        interp_error(sMSG("No main function found"));
-        return Box_exit();
-    }
+    FixGenCode *code = Arena_alloc(sizeof(FixGenCode));
+    if(code == nullptr) { error_oom(); return nullptr; }
+
+    code->body = body;
+    code->has_yield = false;
+    code->depth = FixGen_compile(body, &code->has_yield);
+    return code;
 }
 
-Box FixFn_interp_user_fn(FixFn *fn, FixScope function_scope, FixArray args) {
+/// @brief Calling a `loop fn`: binds the arguments into a fresh frame and returns its stream
+/// @example
+///      loop fn example_generator() :=
+///         for(i <- range(3)) yield i
+Box FixFn_interp_generator_fn(FixFn *fn, FixScope function_scope, FixArray args) {
     require_not_null(fn);
-    log_assert(fn->type == FN_USER, sMSG("Function must be user-defined!"));
+    log_assert(fn->type == FN_GENERATOR || fn->type == FN_LOOP, sMSG("Function must be a generator!"));
 
-    Ast *body = (Ast *) fn->code;
-    require_not_null(body);
+    FixGenCode *code = (FixGenCode *) fn->code;
+    require_not_null(code);
+
+    FixGenFrame *frame = Arena_alloc(sizeof(FixGenFrame));
+    if(frame == nullptr) { error_oom(); return Box_error_empty(); }
+    memset(frame, 0, sizeof(FixGenFrame));
+
+    /// @note each call gets its own locals, so frames (and copies of them) never share bindings
+    FixScope *enclosing = Arena_alloc(sizeof(FixScope));
+    if(enclosing == nullptr) { error_oom(); return Box_error_empty(); }
+    *enclosing = function_scope;
+
+    frame->code = code;
+    frame->locals = FixScope_empty(fn->name);
+    FixScope_data_new(&frame->locals, enclosing);
+    frame->yielded = Box_null();
 
     size_t i = 0;
     FixDict_iter_items(fn->signature, arg) {
@@ -10612,68 +20048,102 @@ Box FixFn_interp_user_fn(FixFn *fn, FixScope function_scope, FixArray args) {
         if(Box_is_null(value)) {
             value = arg->value;
         }
-        FixScope_define_local(&function_scope, arg->key, value);
+        FixScope_define_local(&frame->locals, arg->key, value);
     }
 
-    return interp_eval_ast(body, &function_scope);
+    FixIter *iter = FixIter_new(FixIter_generator_next, SIZE_MAX);
+    if(iter == nullptr) { return Box_error_empty(); }
+
+    iter->gen_frame = frame;
+    return Box_wrap_BoxedArena(iter);
+}
+
+/// @brief A test model stream: pull i yields i, with observe() weight 1 when i is even, 0 when odd
+static bool FixGen_test_weighted_next(FixIter *iter, Box *out) {
+    ctx_local().inference.log_weight += iter->iter_index % 2 == 0 ? 0.0 : -INFINITY;
+    *out = Box_wrap_int((int64_t) iter->iter_index++);
+    return true;
 }
 
+int FixGen_test_main(void) {
+    InterpTestFixture fixture;
+    InterpTestFixture_enter(&fixture);
+    FixScope root = fixture.root;
+    FixScope scope = FixScope_empty(sMSG("$Scope"));
+    FixScope_data_new(&scope, &root);
 
+    /// loop fn each(xs) := for(i <- xs) yield i
+    Ast xs = { .type = AST_ID, .id.name = s("xs") };
+    Ast i = { .type = AST_ID, .id.name = s("i") };
+    Ast binding = { .type = AST_BINDING, .binding.identifier = s("i"), .binding.expression = &xs };
+    Ast *bindings[] = { &binding };
+    Ast yield = { .type = AST_YIELD, .yield_stmt.value = &i };
+    Ast loop = { .type = AST_FOR, .loop.bindings = bindings, .loop.num_bindings = 1, .loop.body = &yield };
+    Ast *statements[] = { &loop };
+    Ast body = { .type = AST_BLOCK, .block.statements = statements, .block.num_statements = 1 };
 
-/// @brief
-/// interp_eval_call_generator:
-///     Creates a new FixIter to keep track of the generator's state.
-///     Initializes the iterator with the original function and other necessary information.
-///     Creates a new generator function that wraps the original function and the iterator.
-///     Appends the iterator to the arguments.
-///     Returns the new generator function.
-/// FixFn_interp_generator_fn:
-///     Extracts the iterator from the last argument.
-///     Calls the original function.
-///     Checks the result:
-///     If it's a yield, updates the iterator state and returns the yielded value.
-///     If it's done, returns a "done" signal.
-///     If it's unexpected, returns an error.
-/// @example
-///      loop fn example_generator() :=
-///         for(i <- range(3)) yield i
-/// @param fn
-/// @param function_scope
-/// @param args
-/// @return
-Box interp_eval_call_generator(FixFn *fn, FixScope function_scope, FixArray args) {
-    require_not_null(fn);
-    require_not_null(fn->fnptr);
-    require(fn->type == FN_LOOP);
-    return Box_error_empty();
+    FixGenCode *code = FixGenCode_new(&body);
+    log_assert(code->has_yield && code->depth == 3, sMSG("FixGenCode should size the resume stack"));
 
-    // FixIter *iter = FixIter_new(fn, args);
-    // FixFn *gen_fn = FixFn_new(FN_GENERATOR, fn->name, fn->signature, function_scope,
-    //     (void *) FixFn_interp_generator_fn, (void *) iter
-    // );
+    FixDict signature;
+    FixDict_data_new(&signature, ARRAY_SIZE_SMALL);
+    FixDict_set(&signature, s("xs"), Box_null());
+    FixFn *each = FixFn_new(FN_GENERATOR, s("each"), signature, scope, (void *) FixFn_interp_generator_fn, code);
 
-    // FixArray_append(&args, Box_wrap_BoxedArena(iter));
-    // return Box_wrap_BoxedArena(gen_fn);
-}
+    FixArray *items = FixArray_new_auto(3);
+    for(int n = 1; n <= 3; n++) { FixArray_append(items, Box_wrap_int(10 * n)); }
+    FixArray *args = FixArray_new_auto(1);
+    FixArray_append(args, Box_wrap_BoxedArena(items));
 
-Box FixFn_interp_generator_fn(FixFn *fn, FixScope function_scope, FixArray args) {
-    require_not_null(fn);
-    require_not_null(fn->fnptr);
-    require(fn->type == FN_GENERATOR);
-    return Box_error_empty();
-
-    // FixIter *iter = Box_unwrap_FixIter(last(args));
-    // Box result = FixFn_call(fn, function_scope, args);
-
-    // if(Box_is_state_end(result)) {
-    //     return Box_null();
-    // } else if(Box_is_state_yield(result)) {
-    //     FixIter_update(iter, result);
-    //     return FixIter_get(iter);
-    // } else {
-    //     interp_error(sMSG("Unexpected generator state"));
-    //     return Box_exit();
-    // }
+    Box stream = FixFn_call(each, scope, *args);
+    log_assert(Box_is_Boxed_type(stream, BXD_FIX_ITER), sMSG("Calling a generator should return a stream"));
+
+    Box item;
+    int64_t total = 0;
+    size_t count = 0;
+    while(Box_iter_next(stream, count, &item)) { total += Box_unwrap_int(item); count++; }
+    log_assert(count == 3 && total == 60, sMSG("Generator should resume after each yield"));
+    log_assert(!Box_iter_next(stream, count, &item), sMSG("A finished generator should stay finished"));
+
+    /// a copy resumes from the same suspended yield, independently of the original
+    FixIter *original = Box_unwrap_FixIter(FixFn_call(each, scope, *args));
+    log_assert(FixIter_next(original, &item) && Box_unwrap_int(item) == 10, sMSG("Generator should yield its first item"));
+    FixIter *copy = FixIter_clone(original);
+    log_assert(FixIter_next(copy, &item) && Box_unwrap_int(item) == 20, sMSG("A copy should resume where it was taken"));
+    log_assert(FixIter_next(copy, &item) && Box_unwrap_int(item) == 30, sMSG("A copy should keep its own position"));
+    log_assert(FixIter_next(original, &item) && Box_unwrap_int(item) == 20, sMSG("The original should not see the copy's pulls"));
+
+    /// loop fn model() := 7 -- no yield, so each pull is one run of the body
+    Ast seven = { .type = AST_INT, .integer.value = 7 };
+    FixFn *model = FixFn_new(FN_GENERATOR, s("model"), (FixDict) {0}, scope,
+        (void *) FixFn_interp_generator_fn, FixGenCode_new(&seven));
+
+    FixFn infer = { .name = s("infer") };
+    Box draws = native_infer(&infer, scope, FixFn_call(model, scope, (FixArray) {0}), Box_wrap_tag(s("#MCMC")));
+    Box first = Box_wrap_BoxedArena(FixIter_take_new(draws, 4));
+    for(count = 0; Box_iter_next(first, count, &item); count++) {
+        log_assert(Box_unwrap_int(item) == 7, sMSG("Each draw should run the model body"));
+    }
+    log_assert(count == 4, sMSG("infer(...).take(4) should pull four draws"));
+
+    /// #HMC has no kernel of its own yet, so it runs the same whole-body chain as untraced #MCMC
+    draws = native_infer(&infer, scope, FixFn_call(model, scope, (FixArray) {0}), Box_wrap_tag(s("#HMC")));
+    log_assert(Box_iter_next(draws, 0, &item) && Box_unwrap_int(item) == 7, sMSG("#HMC draws should run the model body"));
+
+    /// runs of zero weight are rejected: the chain stays at the previous draw
+    FixIter *chain = FixIter_metropolis_new(FixIter_new(FixGen_test_weighted_next, SIZE_MAX));
+    int64_t expected[] = { 0, 0, 2, 2, 4 };
+    for(size_t k = 0; k < sizeof(expected) / sizeof(expected[0]); k++) {
+        log_assert(FixIter_next(chain, &item) && Box_unwrap_int(item) == expected[k],
+            sMSG("Whole-body Metropolis should keep its draw when a run has zero weight"));
+    }
+
+    /// @note few particles: every run of the body is traced, and the debug tracer is bounded
+    FixIter *particles = FixIter_smc_new(Box_unwrap_FixIter(FixFn_call(model, scope, (FixArray) {0})), 8);
+    log_assert(FixIter_next(particles, &item) && Box_unwrap_int(item) == 7, sMSG("SMC draws should run the model body"));
+
+    InterpTestFixture_leave(&fixture);
+    return 0;
 }
 
 Box interp_eval_if(Ast *node, FixScope *scope) {
@@ -10695,6 +20165,22 @@ Box interp_eval_if(Ast *node, FixScope *scope) {
     }
 }
 
+Box interp_eval_try(Ast *node, FixScope *scope) {
+    require_not_null(node); require_not_null(scope); interp_trace();
+    interp_require_type(AST_TRY);
+
+    InterpRecover point;
+    interp_try(&point) {
+        Box result = interp_eval_ast(node->try_stmt.body, scope);
+        interp_try_end(&point);
+        return result;
+    }
+
+    interp_log_debug(sMSG("Recovered from an error in `try`"));
+    if(node->try_stmt.fallback == nullptr) { return Box_null(); }
+    return interp_eval_ast(node->try_stmt.fallback, scope);
+}
+
 
 
 /// @brief
@@ -10712,10 +20198,6 @@ Box interp_eval_range_sugar(Ast *node, FixScope *scope) {
     Box end = interp_eval_ast(node->range_sugar.end, scope);
     Box step = interp_eval_ast(node->range_sugar.step, scope);
 
-    interp_return_if_error(start);
-    interp_return_if_error(end);
-    interp_return_if_error(step);
-
     // if(start.type != UBX_INT) {
     //     interp_error(sMSG("Expected integer start value, got %s"), ubx_nameof(start.type));
     //     return Box_exit();
@@ -10809,18 +20291,39 @@ Box interp_eval_fn_def(Ast *node, FixScope *scope) {
     FixDict_data_new(&args, ARRAY_SIZE_SMALL);
 
     for (size_t i = 0; i < node->fn.num_params; i++) {
-        Box value = (node->fn.params->default_value != nullptr) ?
-            interp_eval_ast(node->fn.params->default_value, scope) :
+        Box value = (node->fn.params[i].default_value != nullptr) ?
+            interp_eval_ast(node->fn.params[i].default_value, scope) :
             Box_null();
 
         FixDict_set(&args, node->fn.params[i].name, value);
     }
 
-    FixFnType fnt = node->fn.is_generator ? FN_GENERATOR : FN_USER;
+    FixFn *fn;
+    if(node->fn.is_memo) {
+        FixMemoCode *memo = FixMemoCode_new(node->fn.body);
+        if(memo == nullptr) { return Box_exit(); }
 
-    FixFn *fn = FixFn_new(fnt, node->fn.name, args, *scope,
-        (void *) FixFn_interp_user_fn, (void*) node->fn.body
-    );
+        fn = FixFn_new(FN_MEMO, node->fn.name, args, *scope,
+            (void *) FixFn_interp_memo_fn, (void *) memo
+        );
+    } else if(node->fn.is_generator) {
+        FixGenCode *code = FixGenCode_new(node->fn.body);
+        if(code == nullptr) { return Box_exit(); }
+
+        if(code->depth > GEN_MAX_RESUME_DEPTH) {
+            interp_error(sMSG("Generator `%.*s` nests statements deeper than %d levels."),
+                fmt(node->fn.name), GEN_MAX_RESUME_DEPTH);
+            return Box_exit();
+        }
+
+        fn = FixFn_new(FN_GENERATOR, node->fn.name, args, *scope,
+            (void *) FixFn_interp_generator_fn, (void *) code
+        );
+    } else {
+        fn = FixFn_new(FN_USER, node->fn.name, args, *scope,
+            (void *) FixFn_interp_user_fn, (void*) node->fn.body
+        );
+    }
 
     FixScope_define_local(scope, node->fn.name, Box_wrap_BoxedArena(fn));
     require_scope_has(scope, node->fn.name);
@@ -10861,7 +20364,17 @@ Box interp_eval_member_access(Ast *node, FixScope *scope) {
     interp_require_type(AST_MEMBER_ACCESS);
 
     Box object = interp_eval_ast(node->member_access.target, scope);
-    interp_return_if_error(object);
+
+    /// @note df.name is the column itself, unboxed (cf. native_column)
+    if(Box_is_Boxed_type(object, BXD_FLX_DATAFRAME)) {
+        FixStr name = node->member_access.property;
+        Boxed *column = FlxDataFrame_column(Box_unwrap_typed_ptr(FlxDataFrame, object), name);
+        if(column == nullptr) {
+            interp_error(sMSG("DataFrame has no column '%.*s'"), fmt(name));
+            return Box_exit();
+        }
+        return Box_wrap_BoxedHeap(column);
+    }
 
     if (!Box_is_object(object)) {
         interp_error(sMSG("Attempted to access member on non-object type: %s"), ubx_nameof(object.type));
@@ -10883,8 +20396,6 @@ Box interp_eval_method_call(Ast *node, FixScope *scope) {
     Box object = interp_eval_ast(node->method_call.target, scope);
     // Box_print(object);
 
-    interp_return_if_error(object);
-
     FixStr method_name = node->method_call.method;
     Box method = FlxObject_find_method(object, scope, method_name);
     interp_return_if_error(method);
@@ -10895,7 +20406,6 @@ Box interp_eval_method_call(Ast *node, FixScope *scope) {
     FixArray_append(args, object);
     for (size_t i = 0; i < node->method_call.num_args; i++) {
         Box arg = interp_eval_ast(node->method_call.args[i], scope);
-        interp_return_if_error(arg);
         FixArray_append(args, arg);
     }
 
@@ -10987,7 +20497,6 @@ Box interp_eval_loop_with_condition(Ast *node, FixScope *scope) {
     Box result = Box_null();
     while(true) {
         Box cond_val = interp_eval_ast(condition, scope);
-        interp_return_if_error(cond_val);
 
         if(!Box_is_truthy(cond_val)) {
             break;
@@ -11001,6 +20510,59 @@ Box interp_eval_loop_with_condition(Ast *node, FixScope *scope) {
 
     return result;
 }
+/// @brief Runs `body` once per element of the bound streams, in lockstep until the shortest ends
+/// @note elements are pulled one at a time (cf. Box_iter_next): arrays and views are read in
+///     ... place and iterators compute each element on demand, so nothing is materialised;
+///     ... non-iterable bindings keep their value on every pass, and with nothing iterable
+///     ... bound the body runs once
+/// @note a bound stream is looped over through a copy (cf. Box_iter_pass), so a second loop
+///     ... over the same `range(...)` sees the same elements
+static Box interp_eval_bound_iterations(Ast **bindings, size_t num_bindings, Ast *body, FixScope *scope, FixScope *iter_scope) {
+    FixArray *sources = FixArray_new_auto(num_bindings > 0 ? num_bindings : 1);
+    bool has_sequence = false;
+
+    for(size_t i = 0; i < num_bindings; i++) {
+        Ast *binding = bindings[i];
+        // Assuming binding is an AST_BINDING node
+        if(binding->type != AST_BINDING) {
+            interp_error(sMSG("Expected binding in loop."));
+            return Box_exit();
+        }
+
+        Box expr_val = Box_iter_pass(interp_eval_ast(binding->binding.expression, scope));
+        if(Box_is_error(expr_val)) {
+            interp_error(sMSG("Could not start a pass over a loop's stream"));
+            return Box_exit();
+        }
+        FixArray_append(sources, expr_val);
+
+        if(Box_is_iterable(expr_val)) {
+            has_sequence = true;
+        } else {
+            FixScope_define_local(iter_scope, binding->binding.identifier, expr_val);
+        }
+    }
+
+    if(!has_sequence) {
+        return interp_eval_ast(body, iter_scope);
+    }
+
+    Box result = Box_null();
+    for(size_t n = 0; ; n++) {
+        for(size_t i = 0; i < num_bindings; i++) {
+            Box item;
+            if(!Box_is_iterable(sources->data[i])) { continue; }
+            if(!Box_iter_next(sources->data[i], n, &item)) { return result; }
+            FixScope_define_local(iter_scope, bindings[i]->binding.identifier, item);
+        }
+
+        result = interp_eval_ast(body, iter_scope);
+        if(Box_is_state_end(result)) {
+            return result;
+        }
+    }
+}
+
 Box interp_eval_loop_with_streams(Ast *node, FixScope *scope) {
     require_not_null(node);
     require_not_null(scope);
@@ -11015,23 +20577,7 @@ Box interp_eval_loop_with_streams(Ast *node, FixScope *scope) {
     FixScope iter_scope = FixScope_empty(sMSG("$Scope"));
     FixScope_data_new(&iter_scope, scope);
 
-    // Iterate over bindings
-    for(size_t i = 0; i < num_bindings; i++) {
-        Ast *binding = bindings[i];
-        // Assuming binding is an AST_BINDING node
-        if(binding->type != AST_BINDING) {
-            interp_error(sMSG("Expected binding in loop statement."));
-            return Box_exit();
-        }
-
-        FixStr var_name = binding->binding.identifier;
-        Box expr_val = interp_eval_ast(binding->binding.expression, scope);
-        interp_return_if_error(expr_val);
-        FixScope_define_local(&iter_scope, var_name, expr_val);
-    }
-
-    // Execute the loop body
-    Box result = interp_eval_ast(body, &iter_scope);
+    Box result = interp_eval_bound_iterations(bindings, num_bindings, body, scope, &iter_scope);
 
     return result;
     // Cleanup
@@ -11059,6 +20605,55 @@ Box interp_eval_loop_with_infinite(Ast *node, FixScope *scope) {
 
 
 
+/// @brief `par for`: the body per element of the bound sources, collected in order into an array
+/// @note iterable bindings are read in lockstep up to the shortest (streams are pulled up front,
+///     ... so they must be finite); the others are defined once, in a scope the workers share
+/// @note with nothing iterable bound the body runs once (cf. interp_eval_bound_iterations)
+static Box interp_eval_par_for(Ast *node, FixScope *scope) {
+    size_t num_bindings = node->loop.num_bindings;
+
+    FixScope shared_scope = FixScope_empty(sMSG("$Scope"));
+    FixScope_data_new(&shared_scope, scope);
+
+    Box **items = Arena_alloc((num_bindings > 0 ? num_bindings : 1) * sizeof(Box *));
+    if(items == nullptr) { error_oom(); return Box_exit(); }
+
+    size_t num_items = SIZE_MAX;
+    for(size_t i = 0; i < num_bindings; i++) {
+        Ast *binding = node->loop.bindings[i];
+        if(binding->type != AST_BINDING) {
+            interp_error(sMSG("Expected binding in loop."));
+            return Box_exit();
+        }
+
+        Box expr_val = interp_eval_ast(binding->binding.expression, &shared_scope);
+
+        items[i] = nullptr;
+        if(!Box_is_iterable(expr_val)) {
+            FixScope_define_local(&shared_scope, binding->binding.identifier, expr_val);
+            continue;
+        }
+
+        size_t num_source = 0;
+        items[i] = FixPar_items(expr_val, &num_source);
+        if(items[i] == nullptr) { return Box_exit(); }
+        num_items = num_source < num_items ? num_source : num_items;
+    }
+
+    FixParJob job = {
+        .scope = &shared_scope,
+        .body = node->loop.body,
+        .bindings = node->loop.bindings,
+        .items = items,
+        .num_sources = num_bindings,
+        .num_items = num_items == SIZE_MAX ? 1 : num_items
+    };
+
+    Box result = FixPar_map(&job);
+    interp_return_if_error(result);
+    return result;
+}
+
 /// @brief
 /// @param node
 /// @param scope
@@ -11086,6 +20681,10 @@ Box interp_eval_for(Ast *node, FixScope *scope) {
     interp_trace();
     interp_require_type(AST_FOR);
 
+    if(node->loop.parallel) {
+        return interp_eval_par_for(node, scope);
+    }
+
     // Extract bindings and body
     Ast **bindings = node->loop.bindings;
     size_t num_bindings = node->loop.num_bindings;
@@ -11095,23 +20694,7 @@ Box interp_eval_for(Ast *node, FixScope *scope) {
     FixScope iter_scope = FixScope_empty(sMSG("$Scope"));
     FixScope_data_new(&iter_scope, scope);
 
-    // Iterate over bindings
-    for(size_t i = 0; i < num_bindings; i++) {
-        Ast *binding = bindings[i];
-        // Assuming binding is an AST_BINDING node
-        if(binding->type != AST_BINDING) {
-            interp_error(sMSG("Expected binding in for-loop."));
-            return Box_exit();
-        }
-
-        FixStr var_name = binding->binding.identifier;
-        Box expr_val = interp_eval_ast(binding->binding.expression, scope);
-        interp_return_if_error(expr_val);
-        FixScope_define_local(&iter_scope, var_name, expr_val);
-    }
-
-    // Execute the loop body
-    Box result = interp_eval_ast(body, &iter_scope);
+    Box result = interp_eval_bound_iterations(bindings, num_bindings, body, scope, &iter_scope);
 
     // Cleanup
     // TODO: Implement scope cleanup if necessary
@@ -11119,6 +20702,86 @@ Box interp_eval_for(Ast *node, FixScope *scope) {
     return result;
 }
 
+static FixFn *FixPar_test_fn(FixScope root, FixStr name, Ast *body, FixStr *params, size_t num_params) {
+    FixDict signature;
+    FixDict_data_new(&signature, ARRAY_SIZE_SMALL);
+    for(size_t i = 0; i < num_params; i++) { FixDict_set(&signature, params[i], Box_null()); }
+    return FixFn_new(FN_USER, name, signature, root, (void *) FixFn_interp_user_fn, body);
+}
+
+int FixPar_test_main(void) {
+    InterpTestFixture fixture;
+    InterpTestFixture_enter(&fixture);
+    FixScope root = fixture.root;
+    TaskPool_stop();
+    log_assert(TaskPool_start(4), sMSG("The pool should start"));
+
+    FixFn self = FixFnFromNative(FN_NATIVE_2, s("par_map"), native_par_map);
+    FixArray *xs = FixArray_new_auto(100);
+    for(int i = 0; i < 100; i++) { FixArray_append(xs, Box_wrap_int(i)); }
+
+    /// fn square(x) = x * x
+    FixStr x_param[1] = { s("x") };
+    Ast x = { .type = AST_ID, .id.name = s("x") };
+    Ast square_body = { .type = AST_BOP, .bop.op = s("*"), .bop.left = &x, .bop.right = &x };
+    FixFn *square = FixPar_test_fn(root, s("square"), &square_body, x_param, 1);
+
+    Box squares = native_par_map(&self, root, Box_wrap_BoxedArena(square), Box_wrap_BoxedArena(xs));
+    log_assert(!Box_is_error(squares), sMSG("par_map should succeed"));
+    FixArray *mapped = Box_unwrap_FixArray(squares);
+    bool in_order = len_ref(mapped) == 100;
+    for(int i = 0; in_order && i < 100; i++) { in_order = Box_unwrap_int(mapped->data[i]) == i * i; }
+    log_assert(in_order, sMSG("par_map should keep element order"));
+
+    /// fn add(a, b) = a + b
+    FixStr ab_params[2] = { s("a"), s("b") };
+    Ast a = { .type = AST_ID, .id.name = s("a") };
+    Ast b = { .type = AST_ID, .id.name = s("b") };
+    Ast add_body = { .type = AST_BOP, .bop.op = s("+"), .bop.left = &a, .bop.right = &b };
+    FixFn *add = FixPar_test_fn(root, s("add"), &add_body, ab_params, 2);
+
+    Box total = native_par_reduce(&self, root, Box_wrap_BoxedArena(add), Box_wrap_BoxedArena(xs), Box_wrap_int(7));
+    log_assert(Box_unwrap_int(total) == 4950 + 7, sMSG("par_reduce should fold every element into init"));
+    Box empty = native_par_reduce(&self, root, Box_wrap_BoxedArena(add),
+        Box_wrap_BoxedArena(FixArray_new_auto(1)), Box_wrap_int(7));
+    log_assert(Box_unwrap_int(empty) == 7, sMSG("par_reduce of nothing should be init"));
+
+    /// par for(x <- xs, k = 3) x * k
+    Ast xs_id = { .type = AST_ID, .id.name = s("xs") };
+    Ast three = { .type = AST_INT, .integer.value = 3 };
+    Ast x_binding = { .type = AST_BINDING, .binding.identifier = s("x"), .binding.expression = &xs_id };
+    Ast k_binding = { .type = AST_BINDING, .binding.identifier = s("k"), .binding.expression = &three };
+    Ast k = { .type = AST_ID, .id.name = s("k") };
+    Ast times_k = { .type = AST_BOP, .bop.op = s("*"), .bop.left = &x, .bop.right = &k };
+    Ast *bindings[2] = { &x_binding, &k_binding };
+    Ast par_for = {
+        .type = AST_FOR, .loop.bindings = bindings, .loop.num_bindings = 2,
+        .loop.body = &times_k, .loop.parallel = true
+    };
+    FixScope_define_local(&root, s("xs"), Box_wrap_BoxedArena(xs));
+
+    Box collected = interp_eval_ast(&par_for, &root);
+    log_assert(!Box_is_error(collected), sMSG("par for should succeed"));
+    FixArray *tripled = Box_unwrap_FixArray(collected);
+    in_order = len_ref(tripled) == 100;
+    for(int i = 0; in_order && i < 100; i++) { in_order = Box_unwrap_int(tripled->data[i]) == 3 * i; }
+    log_assert(in_order, sMSG("par for should collect its iterations in order"));
+    log_assert(fixture.traces.top < 8, sMSG("Parallel iterations should not accumulate traces"));
+
+    /// a memo fn shared by the workers
+    FixFn *memo_square = FixFn_new(FN_MEMO, s("memo_square"), square->signature, root,
+        (void *) FixFn_interp_memo_fn, FixMemoCode_new(&square_body));
+    Box memoed = native_par_map(&self, root, Box_wrap_BoxedArena(memo_square), Box_wrap_BoxedArena(xs));
+    FixArray *memo_mapped = Box_unwrap_FixArray(memoed);
+    in_order = len_ref(memo_mapped) == 100;
+    for(int i = 0; in_order && i < 100; i++) { in_order = Box_unwrap_int(memo_mapped->data[i]) == i * i; }
+    log_assert(in_order, sMSG("A memo fn should be safe to call from par_map"));
+
+    TaskPool_stop();
+    InterpTestFixture_leave(&fixture);
+    return 0;
+}
+
 
 Box interp_eval_expression(Ast *node, FixScope *scope) {
     require_not_null(node);
@@ -11140,8 +20803,6 @@ Box interp_eval_const_def(Ast *node, FixScope *scope) {
 
     Box value = interp_eval_ast(expr, scope);
 
-    interp_return_if_error(value);
-
     FixScope_define_local(scope, var_name, value);
 
     interp_log_debug(sMSG("Defined constant '%.*s' with value '%.*s'"), fmt(var_name), fmt(Box_to_FixStr(value)));
@@ -11160,7 +20821,6 @@ Box interp_eval_vec(Ast *node, FixScope *scope) {
     FixArray *array = FixArray_new_auto(size);
     for(size_t i = 0; i < size; i++) {
         Box element = interp_eval_ast(data[i], scope);
-        interp_return_if_error(element);
         FixArray_append(array, element);
     }
 
@@ -11188,7 +20848,6 @@ Box interp_eval_let_def(Ast *node, FixScope *scope) {
 
         FixStr var_name = binding->binding.identifier;
         Box expr_val = interp_eval_ast(binding->binding.expression, scope);
-        interp_return_if_error(expr_val);
         FixScope_define_local(scope, var_name, expr_val);
     }
 
@@ -11203,9 +20862,7 @@ Box interp_eval_binary_op(Ast *node, FixScope *scope) {
     interp_require_type(AST_BOP);
 
     Box left = interp_eval_ast(node->bop.left, scope);
-    interp_return_if_error(left);
     Box right = interp_eval_ast(node->bop.right, scope);
-    interp_return_if_error(right);
 
     return interp_eval_bop(node->bop.op, left, right);
 }
@@ -11217,7 +20874,6 @@ Box interp_eval_unary_op(Ast *node, FixScope *scope) {
     interp_require_type(AST_UOP);
 
     Box operand = interp_eval_ast(node->uop.operand, scope);
-    interp_return_if_error(operand);
 
     return interp_eval_uop(node->uop.op, operand);
 }
@@ -11229,14 +20885,12 @@ Box interp_eval_match(Ast *node, FixScope *scope) {
     interp_require_type(AST_MATCH);
 
     Box expr_val = interp_eval_ast(node->match.expression, scope);
-    interp_return_if_error(expr_val);
 
     for(size_t i = 0; i < node->match.num_cases; i++) {
         Ast *case_node = node->match.cases[i].condition;
 
         if(case_node) {
             Box test_val = interp_eval_ast(case_node, scope);
-            interp_return_if_error(test_val);
 
             if(Box_eq(expr_val, test_val)) {
                 return interp_eval_ast(node->match.cases[i].expression, scope);
@@ -11272,13 +20926,38 @@ Box interp_eval_return(Ast *node, FixScope *scope) {
     interp_require_type(AST_RETURN);
 
     Box return_val = interp_eval_ast(node->return_stmt.value, scope);
-    interp_return_if_error(return_val);
-
 
     /// @todo check if this implementation is correct
     return return_val;
 }
 
+/// @brief `mut* x op= y` on a tensor, matrix or double vector: one kernel pass over the data,
+///     ... rather than an interpreted update per element
+static Box interp_eval_broadcast_mutation(FixStr op, Box target, Box value) {
+    FlxElemOp elem_op;
+    if(!FlxElemOp_from_FixStr(op, &elem_op)) {
+        interp_error(sMSG("Unsupported broadcast mutation operator: %.*s"), fmt(op));
+        return Box_exit();
+    }
+
+    FlxTensorF dst;
+    if(!FlxTensorF_view_of_Box(target, &dst)) {
+        interp_error(sMSG("Broadcast mutation target is not numeric data: %.*s"), fmt(ubx_nameof(target.type)));
+        return Box_exit();
+    }
+
+    double scalar = 0.0;
+    FlxTensorF src;
+    if(Box_try_numeric(value, &scalar)) {
+        FlxTensorF_apply_scalar(&dst, elem_op, scalar);
+    }
+    else if(!FlxTensorF_view_of_Box(value, &src) || !FlxTensorF_apply(&dst, elem_op, &src)) {
+        interp_error(sMSG("Cannot broadcast %.*s onto the mutation target"), fmt(ubx_nameof(value.type)));
+        return Box_exit();
+    }
+    return target;
+}
+
 Box interp_eval_mutation(Ast *node, FixScope *scope) {
     require_not_null(node);
     require_not_null(scope);
@@ -11287,12 +20966,13 @@ Box interp_eval_mutation(Ast *node, FixScope *scope) {
 
     // Evaluate target and value
     Box target = interp_eval_ast(node->mutation.target, scope);
-    interp_return_if_error(target);
     Box value = interp_eval_ast(node->mutation.value, scope);
-    interp_return_if_error(value);
 
-    /// @todo perform the mutation
-    ///     nb. we have broadcast/vector'd mutations and ordinary updates
+    if(node->mutation.is_broadcast) {
+        return interp_eval_broadcast_mutation(node->mutation.op, target, value);
+    }
+
+    /// @todo perform the (non-broadcast) mutation
 
     // if(target.type != UBX_PTR) {
     //     interp_error(sMSG("Mutation target is not a mutable reference."));
@@ -11328,7 +21008,6 @@ Box interp_eval_call_fn(Ast *node, FixScope *scope) {
     interp_require_type(AST_FN_DEF_CALL);
 
     Box callee_fn = interp_eval_ast(node->call.callee, scope);
-    interp_return_if_error(callee_fn);
 
     if(callee_fn.type != UBX_PTR_ARENA) {
         interp_error(sMSG("Not a function, type is: %.*s"), fmt(ubx_nameof(callee_fn.type)));
@@ -11353,7 +21032,10 @@ Box interp_eval_call_fn(Ast *node, FixScope *scope) {
     FixScope fn_scope = FixScope_empty(sMSG("$Scope"));
     FixScope_data_new(&fn_scope, scope);
 
-    return FixFn_call(fn, fn_scope, *args);
+    interp_frame_push(fn->name, node);
+    Box result = FixFn_call(fn, fn_scope, *args);
+    interp_frame_pop();
+    return result;
 }
 
 
@@ -11430,7 +21112,6 @@ Box interp_eval_object_literal(Ast *node, FixScope *scope) {
         Ast *field_value = node->object_literal.fields[i].value;
 
         Box value = interp_eval_ast(field_value, scope);
-        interp_return_if_error(value);
 
         FixDict_set(fields, field_name, value);
     }
@@ -11503,7 +21184,40 @@ Box interp_eval_uop(FixStr op, Box operand) {
 
 // Evaluate a binary operation
 /// @todo make the type jugglery more robust
+/// @brief Elementwise tensor arithmetic; the other operand may be a scalar, matrix or double vector
+static Box interp_eval_tensor_bop(FixStr op, Box left, Box right) {
+    FlxElemOp elem_op;
+    double scalar = 0.0;
+    FlxTensorF a, b;
+    bool left_scalar = Box_try_numeric(left, &scalar);
+    bool right_scalar = Box_try_numeric(right, &scalar);
+
+    if(!FlxElemOp_from_FixStr(op, &elem_op) || elem_op == ELEM_ASSIGN || op.size != 1
+        || (!left_scalar && !FlxTensorF_view_of_Box(left, &a))
+        || (!right_scalar && !FlxTensorF_view_of_Box(right, &b))
+    ) {
+        interp_error(sMSG("Unsupported operand types for '%.*s': %.*s, %.*s"),
+            fmt(op), fmt(ubx_nameof(left.type)), fmt(ubx_nameof(right.type)));
+        return Box_exit();
+    }
+
+    /// @note a scalar operand is a rank-1, stride-0 view of one element
+    FlxTensorF scalar_view = { .data = &scalar, .ndim = 1, .shape = {1}, .strides = {0} };
+    scalar_view.meta.size = 1;
+
+    FlxTensorF *out = FlxTensorF_binary_new(left_scalar ? &scalar_view : &a, elem_op, right_scalar ? &scalar_view : &b);
+    if(out == nullptr) {
+        interp_error(sMSG("Tensor shapes are not broadcast-compatible for '%.*s'"), fmt(op));
+        return Box_exit();
+    }
+    return Box_wrap_BoxedHeap(out);
+}
+
 Box interp_eval_bop(FixStr op, Box left, Box right) {
+    if((Box_is_Boxed_type(left, BXD_FLX_TENSOR_DOUBLE)) || (Box_is_Boxed_type(right, BXD_FLX_TENSOR_DOUBLE))) {
+        return interp_eval_tensor_bop(op, left, right);
+    }
+
     if(FixStr_eq_chr(op, '+')) {
         if(left.type == UBX_INT && right.type == UBX_INT) {
             return Box_wrap_int(Box_unwrap_int(left) + Box_unwrap_int(right));
@@ -11587,6 +21301,716 @@ int interp_error_test_main(void) {
 }
 #pragma endregion
 
+#pragma region EmbeddingImpl
+
+#define DOUBT_ARENA_BLOCK (64 * 1024)
+
+/// @brief Makes `instance` the current thread's evaluation, allocating on `arena`
+static void DoubtInstance_enter(DoubtInstance *instance, Arena *arena, InterpContext *saved) {
+    *saved = ctx_local();
+    ctx_local() = instance->context;
+    ctx_current_arena() = arena;
+    instance->traces.top = 0;
+}
+
+/// @brief Restores the host's evaluation state, recording the latest error raised since
+///     ... `num_errors` if the load or call failed
+static bool DoubtInstance_leave(DoubtInstance *instance, InterpContext *saved, size_t num_errors, bool ok) {
+    size_t last = ctx_local().debug.num_errors;
+    if(!ok) {
+        FixError error = last > num_errors ?
+            ctx_local().debug.errors[(last - 1) % ARRAY_SIZE_SMALL] :
+            (FixError) { .code = BXE_INTERPRETER, .message = s("Evaluation failed") };
+
+        /// @note the message is usually formatted on the scratch arena, which the next call frees
+        size_t size = error.message.size < DOUBT_ERROR_MESSAGE_MAX ? error.message.size : DOUBT_ERROR_MESSAGE_MAX;
+        if(size > 0) { memcpy(instance->error_message, error.message.cstr, size); }
+        error.message = (FixStr) { .cstr = instance->error_message, .size = size };
+        instance->error = error;
+    }
+
+    instance->context = ctx_local();
+    ctx_local() = *saved;
+    return ok;
+}
+
+DoubtInstance *DoubtInstance_new(void) {
+    DoubtInstance *instance = cnew(sizeof(DoubtInstance));
+    if(instance == nullptr) { error_oom(); return nullptr; }
+    memset(instance, 0, sizeof(DoubtInstance));
+
+    if(!Arena_init(&instance->program, DOUBT_ARENA_BLOCK) || !Arena_init(&instance->scratch, DOUBT_ARENA_BLOCK)) {
+        error_oom();
+        DoubtInstance_free(instance);
+        return nullptr;
+    }
+
+    instance->context.heaps.current = &instance->heap;
+    instance->context.debug.callstack = &instance->traces;
+
+    InterpContext saved;
+    DoubtInstance_enter(instance, &instance->program, &saved);
+    Heap_data_cnew(ARRAY_SIZE_MEDIUM, HEAP_GC_1MB);
+    DoubtInstance_leave(instance, &saved, 0, true);
+    return instance;
+}
+
+void DoubtInstance_free(DoubtInstance *instance) {
+    if(instance == nullptr) { return; }
+
+    if(instance->heap.data != nullptr) { Heap_destroy(&instance->heap); }
+    Arena_aro_free_underlying(&instance->program);
+    Arena_aro_free_underlying(&instance->scratch);
+    cfree(instance);
+}
+
+/// @brief Parses `source` and evaluates its top level into the instance's globals
+/// @note the parser logs its errors and carries on, rather than unwinding
+static bool DoubtInstance_load_program(DoubtInstance *instance, FixStr source) {
+    size_t num_errors = ctx_local().debug.num_errors;
+
+    ParseContext *p = &instance->pctx;
+    *p = (ParseContext) {0};
+    /// @note a token is at least a character or a line's indent/end marker
+    lex_init(p, 3 * source.size + ARRAY_SIZE_SMALL, s("    "));
+    p->source.lines = FixStr_lines(FixStr_copy(source), &p->source.size);
+    lex(&p->lexer, &p->source);
+    parse(p);
+    if(ctx_local().debug.num_errors != num_errors || p->parser.data == nullptr) { return false; }
+
+    instance->globals = FixScope_empty(s("Global scope"));
+    FixDict_data_new(&instance->globals.data, ARRAY_SIZE_MEDIUM);
+    native_add_prelude(instance->globals);
+    interp_eval_ast(p->parser.data, &instance->globals);
+    return true;
+}
+
+/// @brief Parses `source` and evaluates its top level (definitions and constants)
+/// @note the source is copied: the instance does not refer to the caller's buffer
+bool DoubtInstance_load(DoubtInstance *instance, FixStr source) {
+    require_not_null(instance);
+
+    InterpContext saved;
+    DoubtInstance_enter(instance, &instance->program, &saved);
+    size_t num_errors = ctx_local().debug.num_errors;
+
+    bool ok = false;
+    InterpRecover point;
+    interp_try(&point) {
+        ok = DoubtInstance_load_program(instance, source);
+        interp_try_end(&point);
+    }
+
+    instance->loaded = ok;
+    return DoubtInstance_leave(instance, &saved, num_errors, ok);
+}
+
+/// @brief Looks up and calls `fn_name`: a failure either returns false or unwinds
+static bool DoubtInstance_call_fn(DoubtInstance *instance, FixStr fn_name, FixArray args, Box *out_result) {
+    Box fn;
+    if(!FixScope_lookup(&instance->globals, fn_name, &fn) || fn.type != UBX_PTR_ARENA) {
+        error_push_runtime(BXE_INTERPRETER, FixStr_fmt_new(sMSG("No function `%.*s`"), fmt(fn_name)),
+            s(__FILE__ ":" _STR(__LINE__)));
+        return false;
+    }
+    if(len(args) < Box_unwrap_FixFn(fn)->signature.meta.size) {
+        error_push_runtime(BXE_INTERPRETER, FixStr_fmt_new(sMSG("Function `%.*s` expects at least %zu arguments, but %zu were provided."),
+            fmt(fn_name), Box_unwrap_FixFn(fn)->signature.meta.size, len(args)), s(__FILE__ ":" _STR(__LINE__)));
+        return false;
+    }
+
+    FixScope call_scope = FixScope_empty(sMSG("$Scope"));
+    FixScope_data_new(&call_scope, &instance->globals);
+    *out_result = FixFn_call(Box_unwrap_FixFn(fn), call_scope, args);
+    return !Box_is_failed((*out_result));
+}
+
+/// @brief Calls the loaded program's function `fn_name` on `args`
+/// @note `out_result` is valid until the next call on the instance, which frees its arena:
+///     ... copy out anything that has to outlive it
+/// @return false, with the reason in DoubtInstance_error, if the call failed
+bool DoubtInstance_call(DoubtInstance *instance, FixStr fn_name, FixArray args, Box *out_result) {
+    require_not_null(instance);
+    require_not_null(out_result);
+
+    if(!instance->loaded) {
+        instance->error = (FixError) { .code = BXE_INTERPRETER, .message = s("No program loaded") };
+        return false;
+    }
+
+    /// @note the previous call's values go, and with them any memo entries that refer to them
+    Arena_aro_free_underlying(&instance->scratch);
+    if(!Arena_init(&instance->scratch, DOUBT_ARENA_BLOCK)) {
+        instance->error = (FixError) { .code = BXE_NATIVE, .message = s("Allocation failed") };
+        return false;
+    }
+    ctx().inference.step++;
+
+    InterpContext saved;
+    DoubtInstance_enter(instance, &instance->scratch, &saved);
+    size_t num_errors = ctx_local().debug.num_errors;
+
+    bool ok = false;
+    InterpRecover point;
+    interp_try(&point) {
+        ok = DoubtInstance_call_fn(instance, fn_name, args, out_result);
+        interp_try_end(&point);
+    }
+
+    return DoubtInstance_leave(instance, &saved, num_errors, ok);
+}
+
+bool DoubtInstance_run_main(DoubtInstance *instance, Box *out_result) {
+    return DoubtInstance_call(instance, s("main"), (FixArray) {0}, out_result);
+}
+
+FixError DoubtInstance_error(DoubtInstance *instance) {
+    require_not_null(instance);
+    return instance->error;
+}
+
+typedef struct DoubtInstanceTestRun {
+    Thread thread;
+    DoubtInstance *instance;
+    long total;
+} DoubtInstanceTestRun;
+
+static void *DoubtInstance_test_run(void *arg) {
+    DoubtInstanceTestRun *run = (DoubtInstanceTestRun *) arg;
+    for(int i = 0; i < 100; i++) {
+        Box x = Box_wrap_int(i), result;
+        if(DoubtInstance_call(run->instance, s("shift"), (FixArray) { .meta.size = 1, .meta.capacity = 1, .data = &x }, &result)) {
+            run->total += Box_unwrap_int(result);
+        }
+    }
+    return nullptr;
+}
+
+void DoubtInstance_test_main(void) {
+    FixStr sources[2] = {
+        s("const offset = 10\n\nfn shift(x) :=\n    x + offset\n\nfn main() :=\n    shift(5)\n\nfn broken() :=\n    missing + 1\n\n"
+          "fn guarded() :=\n    try broken() else 7\n\n"
+          "fn par_broken() :=\n    par_map(fn(x) -> x + missing, range(0, 40))\n\n"
+          "fn failing_stream() :=\n    for(x <- infer(take, #HMC)) x\n\n"
+          "fn twice_over() :=\n    let\n        xs = range(1, 3)\n    in\n        for(x <- xs) x\n        for(x <- xs) x\n\n"
+          "loop fn gaussian() :=\n    let\n        mu = sample(normal(0, 10))\n        sigma = sample(gamma(2, 0.5))\n    in\n"
+          "        observe(normal(mu, sigma), [1.9, 2.6, 3.4, 2.8, 3.3, 2.2, 3.9, 3.1, 2.7, 3.0, 3.6, 3.5])\n        [mu, sigma]\n\n"
+          "fn mode() :=\n    infer(gaussian(), #MAP)\n\n"
+          "fn approximate() :=\n    summarize(infer(gaussian(), #VI), 400)\n\n"
+          "fn unfit() :=\n    infer(take, #VI)\n"),
+        s("const offset = 1000\n\nfn shift(x) :=\n    x + offset\n")
+    };
+
+    DoubtInstance *instances[2];
+    for(size_t k = 0; k < 2; k++) {
+        instances[k] = DoubtInstance_new();
+        log_assert(instances[k] != nullptr && DoubtInstance_load(instances[k], sources[k]), sMSG("A program should load"));
+    }
+
+    Box result;
+    log_assert(DoubtInstance_run_main(instances[0], &result) && Box_unwrap_int(result) == 15, sMSG("main() should run"));
+
+    /// a failing call reports its error and leaves the instance usable
+    size_t host_errors = ctx_local().debug.num_errors;
+    log_assert(!DoubtInstance_call(instances[0], s("broken"), (FixArray) {0}, &result), sMSG("A failing call should return false"));
+    log_assert(DoubtInstance_error(instances[0]).code == BXE_INTERPRETER, sMSG("The failure should be reported as an error value"));
+    log_assert(!DoubtInstance_call(instances[0], s("absent"), (FixArray) {0}, &result), sMSG("Calling an undefined function should fail"));
+    log_assert(ctx_local().debug.num_errors == host_errors, sMSG("Instance errors should not reach the host's log"));
+    log_assert(DoubtInstance_run_main(instances[0], &result) && Box_unwrap_int(result) == 15, sMSG("The instance should survive a failed call"));
+    log_assert(FixStr_contains(DoubtInstance_error(instances[0]).message, s("No function `absent`")),
+        sMSG("The last error's message should outlive the next call"));
+
+    /// errors unwind to the innermost `try`, or from a parallel worker back to the caller
+    log_assert(DoubtInstance_call(instances[0], s("guarded"), (FixArray) {0}, &result) && Box_unwrap_int(result) == 7,
+        sMSG("A `try` should recover with its `else` value"));
+    log_assert(!DoubtInstance_call(instances[0], s("par_broken"), (FixArray) {0}, &result)
+        && DoubtInstance_error(instances[0]).code == BXE_INTERPRETER, sMSG("A worker's error should fail the call"));
+    log_assert(ctx_local().debug.recover == nullptr, sMSG("Calls should leave no recovery point behind"));
+    log_assert(!DoubtInstance_call(instances[1], s("main"), (FixArray) {0}, &result), sMSG("Instances should not share globals"));
+
+    /// a stream whose function fails raises the failure, rather than just ending
+    log_assert(!DoubtInstance_call(instances[0], s("failing_stream"), (FixArray) {0}, &result)
+        && DoubtInstance_error(instances[0]).code == BXE_NATIVE, sMSG("A failing stream function should fail the call"));
+
+    /// a bound range is not used up by the first loop over it
+    log_assert(DoubtInstance_call(instances[0], s("twice_over"), (FixArray) {0}, &result)
+        && result.type == UBX_INT && Box_unwrap_int(result) == 3, sMSG("A second loop over a range should see its elements"));
+
+    /// #MAP and #VI fit a traced `loop fn` model (the data have mean 3)
+    Box *mode = nullptr;
+    size_t mode_len = 0;
+    double location;
+    log_assert(DoubtInstance_call(instances[0], s("mode"), (FixArray) {0}, &result)
+        && Box_as_sequence(result, &mode, &mode_len) && mode_len == 2, sMSG("#MAP should give the model's result at the mode"));
+    log_assert(Box_try_numeric(mode[0], &location) && fabs(location - 3.0) < 0.05,
+        sMSG("The mode of mu should be near the data's mean"));
+    log_assert(DoubtInstance_call(instances[0], s("approximate"), (FixArray) {0}, &result)
+        && Box_is_Boxed_type(result, BXD_FLX_SAMPLE_SINK), sMSG("#VI should stream draws"));
+    FlxSampleSink *approximation = Box_unwrap_typed_ptr(FlxSampleSink, result);
+    log_assert(approximation->num_draws == 400 && fabs(FlxSampleSink_mean(approximation, 0) - 3.0) < 0.15
+        && FlxSampleSink_mean(approximation, 1) > 0.0, sMSG("Draws from q should centre on the posterior"));
+    log_assert(!DoubtInstance_call(instances[0], s("unfit"), (FixArray) {0}, &result)
+        && DoubtInstance_error(instances[0]).code == BXE_NATIVE, sMSG("#VI of an untraceable model should fail"));
+
+    /// instances evaluate concurrently, one thread each
+    DoubtInstanceTestRun runs[2] = { { .instance = instances[0] }, { .instance = instances[1] } };
+    for(size_t k = 0; k < 2; k++) {
+        Thread_init(&runs[k].thread);
+        Thread_start(&runs[k].thread, DoubtInstance_test_run, &runs[k]);
+    }
+    for(size_t k = 0; k < 2; k++) {
+        Thread_join(&runs[k].thread);
+        Thread_destroy(&runs[k].thread);
+    }
+    log_assert(runs[0].total == 4950 + 100 * 10 && runs[1].total == 4950 + 100 * 1000,
+        sMSG("Concurrent instances should each see their own program"));
+
+    /// the pool started inside one instance outlives it: another's tasks run in their own heap
+    TaskPool_stop();
+    FixStr par_source = s("fn pairs() :=\n    par_map(fn(x) -> [x, {\"x\": x}], range(0, 2000))\n");
+    DoubtInstance *starter = DoubtInstance_new();
+    log_assert(DoubtInstance_load(starter, par_source), sMSG("A program should load"));
+    InterpContext host;
+    DoubtInstance_enter(starter, &starter->scratch, &host);
+    log_assert(TaskPool_start(4), sMSG("The pool should start inside an instance"));
+    DoubtInstance_leave(starter, &host, 0, true);
+    log_assert(DoubtInstance_call(starter, s("pairs"), (FixArray) {0}, &result), sMSG("par_map should run in the starting instance"));
+    DoubtInstance_free(starter);
+
+    DoubtInstance *later = DoubtInstance_new();
+    log_assert(DoubtInstance_load(later, par_source), sMSG("A program should load"));
+    for(size_t k = 0; k < 2; k++) {
+        log_assert(DoubtInstance_call(later, s("pairs"), (FixArray) {0}, &result), sMSG("par_map should run in a later instance"));
+        FixArray *pairs = Box_unwrap_FixArray(result);
+        log_assert(len_ref(pairs) == 2001 && Box_unwrap_int(Box_unwrap_FixArray(pairs->data[2000])->data[0]) == 2000,
+            sMSG("Each task's values should live in the calling instance"));
+    }
+    DoubtInstance_free(later);
+
+    DoubtInstance *unloaded = DoubtInstance_new();
+    log_assert(!DoubtInstance_load(unloaded, s("memo main\n")), sMSG("A parse error should fail the load"));
+    log_assert(DoubtInstance_error(unloaded).code == BXE_PARSER, sMSG("The load should report the parse error"));
+
+    DoubtInstance_free(unloaded);
+    DoubtInstance_free(instances[0]);
+    DoubtInstance_free(instances[1]);
+}
+
+void AstCounters_test_main(void) {
+    FixStr source = s("fn shift(x) :=\n    x + 1\n\nfn main() :=\n    shift(5)\n");
+    DoubtInstance *instance = DoubtInstance_new();
+    log_assert(instance != nullptr && DoubtInstance_load(instance, source), sMSG("A program should load"));
+
+    AstCounters *counters = AstCounters_start();
+    log_assert(counters != nullptr, sMSG("Node counters should start"));
+    log_assert(AstCounters_start() == nullptr, sMSG("Only one set of counters should run at once"));
+
+    Box result;
+    for(size_t i = 0; i < 3; i++) {
+        log_assert(DoubtInstance_run_main(instance, &result) && Box_unwrap_int(result) == 6, sMSG("main() should run"));
+    }
+    AstCounters_stop();
+    log_assert(DoubtInstance_run_main(instance, &result), sMSG("main() should run uncounted"));
+
+    log_assert(atomic_load(&counters->by_type[AST_BOP].count) == 3, sMSG("Each `x + 1` should be counted once a call"));
+    log_assert(atomic_load(&counters->by_type[AST_FN_DEF_CALL].count) == 3, sMSG("Each call should be counted"));
+    log_assert(atomic_load(&counters->by_line[0].count) == 0, sMSG("Definitions evaluated before the start should not be counted"));
+    log_assert(atomic_load(&counters->by_line[1].count) >= 3 && atomic_load(&counters->by_line[4].count) >= 3,
+        sMSG("Nodes should be counted on their own lines"));
+
+    size_t num_lines;
+    FixStr *lines = FixStr_lines(source, &num_lines);
+    AstCounters_print_listing(counters, lines, num_lines);
+
+    AstCounters_free(counters);
+    DoubtInstance_free(instance);
+}
+
+#pragma endregion
+
+#pragma region BenchImpl
+
+constexpr char __glo_bench_source[] =
+"fn id(x) :=\n"
+"    x\n"
+"loop fn model() :=\n"
+"    let \n"
+"        mu = sample(normal(0, 10))\n"
+"        a = sample(normal(mu, 1))\n"
+"        b = sample(normal(mu, 1))\n"
+"        c = a + b\n"
+"    in\n"
+"        observe(normal(a, 1), 1.0)\n"
+"        observe(normal(b, 1), 2.0)\n"
+"        observe(normal(c, 1), 3.5)\n"
+"        [mu, a, b]\n"
+"fn chain() :=\n"
+"    infer(model(), #MCMC)\n";
+
+/// @brief What the benchmarks share: set up once, before any timing
+/// @note each repetition allocates on `arena`, which is replaced (untimed) before the next,
+///     ... so every repetition starts from the same empty block
+static struct BenchState {
+    DoubtInstance *instance;
+    InterpContext saved;
+    Arena arena;
+    FixStr source;
+    ParseContext pctx;
+    FixFn *id_fn;
+    FixFn *sample_fn;
+    Box dist;                       /// normal(0, 1)
+    FixIter *chain;                 /// infer(model(), #MCMC)
+    FixStr keys[BENCH_DICT_KEYS];
+    uint64_t sink;                  /// results accumulate here so the work is not optimised away
+} __glo_bench = {0};
+
+#define bench_state() __glo_bench
+
+static void bench_lex_source(ParseContext *p) {
+    p->source = (struct Source) {0};
+    p->lexer = (struct Lexer) {0};
+    p->parser.meta = (MetaData) {0};
+    p->parser.data = nullptr;
+    p->parser.depth = 0;
+    p->parser.current_token = 0;
+    p->parser.traces.top = 0;
+
+    FixStr source = bench_state().source;
+    lex_init(p, 3 * source.size + ARRAY_SIZE_SMALL, s("    "));
+    p->source.lines = FixStr_lines(FixStr_copy(source), &p->source.size);
+    lex(&p->lexer, &p->source);
+}
+
+static void bench_lex(size_t ops) {
+    for(size_t i = 0; i < ops; i++) {
+        bench_lex_source(&bench_state().pctx);
+        bench_state().sink += bench_state().pctx.lexer.meta.size;
+    }
+}
+
+/// @note includes lexing: subtract `lex` for the parser alone
+static void bench_parse(size_t ops) {
+    for(size_t i = 0; i < ops; i++) {
+        ParseContext *p = &bench_state().pctx;
+        bench_lex_source(p);
+        parse(p);
+        bench_state().sink += (uint64_t) p->parser.data;
+    }
+}
+
+/// @brief One set and one get, the first BENCH_DICT_KEYS sets inserting and the rest updating
+static void bench_dict(size_t ops) {
+    FixDict dict;
+    FixDict_data_new(&dict, ARRAY_SIZE_MEDIUM);
+    for(size_t i = 0; i < ops; i++) {
+        FixStr key = bench_state().keys[i % BENCH_DICT_KEYS];
+        FixDict_set(&dict, key, Box_wrap_int(i));
+        bench_state().sink += FixDict_get(&dict, key).payload;
+    }
+}
+
+/// @brief Ints, floats and strings in turn
+static void bench_box_hash(size_t ops) {
+    for(size_t i = 0; i < ops; i++) {
+        Box box;
+        switch(i % 3) {
+            case 0: box = Box_wrap_int(i); break;
+            case 1: box = Box_wrap_float((float) i); break;
+            default: box = Box_wrap_BoxedArena(&bench_state().keys[i % BENCH_DICT_KEYS]); break;
+        }
+        bench_state().sink += Box_hash(box);
+    }
+}
+
+/// @brief Calling `id(x)` as interp_eval_call_fn does: a fresh scope, then FixFn_call
+static void bench_call(size_t ops) {
+    FixScope *globals = &bench_state().instance->globals;
+    for(size_t i = 0; i < ops; i++) {
+        Box x = Box_wrap_int(i);
+        FixScope call_scope = FixScope_empty(sMSG("$Scope"));
+        FixScope_data_new(&call_scope, globals);
+        Box result = FixFn_call(bench_state().id_fn, call_scope, (FixArray) { .meta.size = 1, .meta.capacity = 1, .data = &x });
+        bench_state().sink += result.payload;
+        bench_state().instance->traces.top = 0;
+    }
+}
+
+static void bench_eval_bop(size_t ops) {
+    Ast left = { .type = AST_INT, .integer.value = 2 };
+    Ast right = { .type = AST_INT, .integer.value = 3 };
+    Ast node = { .type = AST_BOP, .bop.op = s("+"), .bop.left = &left, .bop.right = &right };
+    for(size_t i = 0; i < ops; i++) {
+        bench_state().sink += interp_eval_binary_op(&node, &bench_state().instance->globals).payload;
+    }
+}
+
+static void bench_sample(size_t ops) {
+    FixScope globals = bench_state().instance->globals;
+    for(size_t i = 0; i < ops; i++) {
+        bench_state().sink += native_sample(bench_state().sample_fn, globals, bench_state().dist).payload;
+    }
+}
+
+/// @brief One Metropolis-Hastings sweep of the model per operation (cf. FixIter_mcmc_new)
+static void bench_mcmc(size_t ops) {
+    for(size_t i = 0; i < ops; i++) {
+        Box draw;
+        bench_state().instance->traces.top = 0;
+        if(!FixIter_next(bench_state().chain, &draw)) {
+            log_message(LL_WARNING, sMSG("The MCMC chain stopped after %zu sweeps"), i);
+            return;
+        }
+        bench_state().sink += draw.payload;
+    }
+}
+
+static BenchCase __glo_bench_cases[] = {
+    { .name = "lex",        .ops = 50,     .run = bench_lex },
+    { .name = "parse",      .ops = 50,     .run = bench_parse },
+    { .name = "dict_set_get", .ops = 10000, .run = bench_dict },
+    { .name = "box_hash",   .ops = 100000, .run = bench_box_hash },
+    { .name = "call",       .ops = 10000,  .run = bench_call },
+    { .name = "eval_bop",   .ops = 100000, .run = bench_eval_bop },
+    { .name = "sample",     .ops = 100000, .run = bench_sample },
+    { .name = "mcmc_sweep", .ops = 1000,   .run = bench_mcmc },
+};
+
+/// @brief Loads the benchmark program and leaves its instance entered, allocating on the bench arena
+/// @brief Undoes a Bench_setup that failed after entering the instance
+static void Bench_abandon(void) {
+    DoubtInstance_leave(bench_state().instance, &bench_state().saved, 0, true);
+    DoubtInstance_free(bench_state().instance);
+    bench_state().instance = nullptr;
+    bench_state().chain = nullptr;
+}
+
+static bool Bench_setup(void) {
+    bench_state().source = (FixStr) { .cstr = __glo_bench_source, .size = sizeof(__glo_bench_source) - 1 };
+
+    DoubtInstance *instance = DoubtInstance_new();
+    if(instance == nullptr) { return false; }
+
+    Box chain;
+    if(!DoubtInstance_load(instance, bench_state().source)
+        || !DoubtInstance_call(instance, s("chain"), (FixArray) {0}, &chain)
+        || !(Box_is_Boxed_type(chain, BXD_FIX_ITER))
+        || !(Box_is_Boxed_type(Box_unwrap_FixIter(chain)->iter_state, BXD_FIX_MODEL_GRAPH))) {
+        log_message(LL_ERROR, sMSG("Could not set up the benchmark program: %.*s"),
+            fmt(DoubtInstance_error(instance).message));
+        DoubtInstance_free(instance);
+        return false;
+    }
+    bench_state().instance = instance;
+    bench_state().chain = Box_unwrap_FixIter(chain);
+
+    /// @note what's set up here lives with the program, and the chain in the scratch arena of
+    ///     ... the call that made it: no further DoubtInstance_call may run
+    DoubtInstance_enter(instance, &instance->program, &bench_state().saved);
+    Box id_fn, sample_fn, normal_fn;
+    if(!FixScope_lookup(&instance->globals, s("id"), &id_fn)
+        || !FixScope_lookup(&instance->globals, s("sample"), &sample_fn)
+        || !FixScope_lookup(&instance->globals, s("normal"), &normal_fn)) {
+        log_message(LL_ERROR, sMSG("Could not set up the benchmarks: the prelude lacks id, sample or normal"));
+        Bench_abandon();
+        return false;
+    }
+    bench_state().id_fn = Box_unwrap_FixFn(id_fn);
+    bench_state().sample_fn = Box_unwrap_FixFn(sample_fn);
+
+    Box params[2] = { Box_wrap_int(0), Box_wrap_int(1) };
+    bench_state().dist = native_normal(Box_unwrap_FixFn(normal_fn), instance->globals,
+        (FixArray) { .meta.size = 2, .meta.capacity = 2, .data = params });
+    for(size_t k = 0; k < BENCH_DICT_KEYS; k++) {
+        bench_state().keys[k] = FixStr_fmt_new(s("key%zu"), k);
+    }
+
+    if(!Arena_init(&bench_state().arena, BENCH_ARENA_BLOCK)) {
+        error_oom();
+        Bench_abandon();
+        return false;
+    }
+    ctx_current_arena() = &bench_state().arena;
+    return true;
+}
+
+static void Bench_teardown(void) {
+    DoubtInstance_leave(bench_state().instance, &bench_state().saved, 0, true);
+    Arena_aro_free_underlying(&bench_state().arena);
+    DoubtInstance_free(bench_state().instance);
+    bench_state().instance = nullptr;
+}
+
+/// @brief Replaces the previous repetition's allocations with an empty block
+static void Bench_reset(void) {
+    Arena_aro_free_underlying(&bench_state().arena);
+    if(!Arena_init(&bench_state().arena, BENCH_ARENA_BLOCK)) { error_oom(); }
+    bench_state().instance->traces.top = 0;
+}
+
+static int Bench_cmp_double(const void *a, const void *b) {
+    double left = *(const double *) a;
+    double right = *(const double *) b;
+    return (left > right) - (left < right);
+}
+
+/// @brief Runs `warmup` untimed repetitions, then `reps` timed ones
+/// @note a repetition is timed as a whole, by the monotonic clock and Tracer_ticks(), and
+///     ... the median and p99 are over repetitions (divided through by the ops in each)
+BenchResult Bench_run(BenchCase *bench, size_t warmup, size_t reps) {
+    require_not_null(bench);
+    require_positive(bench->ops);
+
+    if(reps == 0) { reps = 1; }
+    if(reps > BENCH_MAX_REPS) { reps = BENCH_MAX_REPS; }
+
+    double ns[BENCH_MAX_REPS], ticks[BENCH_MAX_REPS];
+    for(size_t r = 0; r < warmup + reps; r++) {
+        Bench_reset();
+
+        struct timespec start, end;
+        clock_gettime(CLOCK_MONOTONIC, &start);
+        uint64_t ticks_start = Tracer_ticks();
+        bench->run(bench->ops);
+        uint64_t ticks_end = Tracer_ticks();
+        clock_gettime(CLOCK_MONOTONIC, &end);
+
+        if(r < warmup) { continue; }
+        ns[r - warmup] = (double) (end.tv_sec - start.tv_sec) * 1e9 + (double) (end.tv_nsec - start.tv_nsec);
+        ticks[r - warmup] = (double) (ticks_end - ticks_start);
+    }
+
+    qsort(ns, reps, sizeof(double), Bench_cmp_double);
+    qsort(ticks, reps, sizeof(double), Bench_cmp_double);
+
+    double ops = (double) bench->ops;
+    size_t p99 = (size_t) ceil(0.99 * (double) reps) - 1;
+    double median_ns = reps % 2 == 1 ? ns[reps / 2] : (ns[reps / 2 - 1] + ns[reps / 2]) / 2.0;
+    double median_ticks = reps % 2 == 1 ? ticks[reps / 2] : (ticks[reps / 2 - 1] + ticks[reps / 2]) / 2.0;
+
+    return (BenchResult) {
+        .name = bench->name, .ops = bench->ops, .reps = reps,
+        .median_ns = median_ns / ops,
+        .p99_ns = ns[p99] / ops,
+        .median_ticks = median_ticks / ops,
+        .ops_per_sec = median_ns > 0.0 ? ops * 1e9 / median_ns : 0.0,
+    };
+}
+
+/// @brief Writes the results as JSON, one benchmark per line so runs diff line-by-line
+void Bench_write_json(BenchResult *results, size_t num_results, size_t warmup, FILE *out) {
+    require_not_null(out);
+
+    fprintf(out, "{\n  \"commit\": \"%s\",\n  \"reps\": %zu,\n  \"warmup\": %zu,\n  \"benchmarks\": [\n",
+        BENCH_COMMIT, num_results > 0 ? results[0].reps : 0, warmup);
+    for(size_t i = 0; i < num_results; i++) {
+        BenchResult *r = &results[i];
+        fprintf(out, "    {\"name\": \"%s\", \"ops_per_rep\": %zu, \"median_ns_per_op\": %.3f, \"p99_ns_per_op\": %.3f, "
+            "\"median_ticks_per_op\": %.3f, \"ops_per_sec\": %.1f}%s\n",
+            r->name, r->ops, r->median_ns, r->p99_ns, r->median_ticks, r->ops_per_sec, i + 1 < num_results ? "," : "");
+    }
+    fprintf(out, "  ]\n}\n");
+}
+
+/// @brief Prints each result's change in median against a file from Bench_write_json
+/// @return how many benchmarks are slower than the baseline by more than `threshold_pct`
+size_t Bench_compare(BenchResult *results, size_t num_results, FILE *baseline, double threshold_pct) {
+    require_not_null(baseline);
+
+    static const char name_key[] = "\"name\": \"";
+    static const char median_key[] = "\"median_ns_per_op\": ";
+
+    printf("%-14s %14s %14s %9s\n", "benchmark", "baseline ns/op", "current ns/op", "change");
+    size_t num_regressed = 0;
+    char line[512];
+    while(fgets(line, sizeof(line), baseline) != nullptr) {
+        char *name_at = strstr(line, name_key), *median_at = strstr(line, median_key);
+        char name[64];
+        double before;
+        if(name_at == nullptr || median_at == nullptr
+            || sscanf(name_at + sizeof(name_key) - 1, "%63[^\"]", name) != 1
+            || sscanf(median_at + sizeof(median_key) - 1, "%lf", &before) != 1) {
+            continue;
+        }
+
+        for(size_t i = 0; i < num_results; i++) {
+            if(strcmp(name, results[i].name) != 0) { continue; }
+
+            double change = before > 0.0 ? 100.0 * (results[i].median_ns - before) / before : 0.0;
+            bool is_regression = change > threshold_pct;
+            num_regressed += is_regression;
+            printf("%-14s %14.3f %14.3f %+8.1f%%%s\n", name, before, results[i].median_ns, change,
+                is_regression ? "  REGRESSION" : "");
+        }
+    }
+    return num_regressed;
+}
+
+/// @brief Runs the benchmarks, writes their results to --out and, given a previous run's
+///     ... file with --compare, exits non-zero if any median regressed past --threshold percent
+/// @note a positional argument (or --filter) runs only the benchmarks whose names contain it
+/// @example
+///     ./doubt_bench --reps 50 --out after.json --compare before.json
+///     ./doubt_bench mcmc
+int bench_main(int argc, char **argv) {
+    enum {
+        CLI_POSITIONAL = 0, CLI_REPS, CLI_WARMUP, CLI_OUT, CLI_COMPARE, CLI_THRESHOLD,
+        CLI_ENUM_SIZE
+    };
+
+    CliOption options[] = {
+        [CLI_POSITIONAL] = cli_opt_flag(s("--filter")),
+        [CLI_REPS] = cli_opt_default(s("--reps"), s(_STR(BENCH_DEFAULT_REPS))),
+        [CLI_WARMUP] = cli_opt_default(s("--warmup"), s(_STR(BENCH_DEFAULT_WARMUP))),
+        [CLI_OUT] = cli_opt_default(s("--out"), s("bench.json")),
+        [CLI_COMPARE] = cli_opt_flag(s("--compare")),
+        [CLI_THRESHOLD] = cli_opt_default(s("--threshold"), s(_STR(BENCH_REGRESSION_PCT))),
+    };
+
+    cli_parse_opts(options);
+    size_t reps = strtoul(cli_opt_get(options, CLI_REPS).cstr, nullptr, 10);
+    size_t warmup = strtoul(cli_opt_get(options, CLI_WARMUP).cstr, nullptr, 10);
+    FixStr filter = cli_opt_get(options, CLI_POSITIONAL);
+
+    if(!Bench_setup()) { return 1; }
+
+    size_t num_cases = sizeof(__glo_bench_cases) / sizeof(BenchCase), num_results = 0;
+    BenchResult results[sizeof(__glo_bench_cases) / sizeof(BenchCase)];
+
+    printf("%-14s %12s %12s %12s %14s\n", "benchmark", "median ns/op", "p99 ns/op", "ticks/op", "ops/sec");
+    for(size_t i = 0; i < num_cases; i++) {
+        if(options[CLI_POSITIONAL].is_set && strstr(__glo_bench_cases[i].name, filter.cstr) == nullptr) { continue; }
+
+        BenchResult *r = &results[num_results++];
+        *r = Bench_run(&__glo_bench_cases[i], warmup, reps);
+        printf("%-14s %12.1f %12.1f %12.1f %14.0f\n", r->name, r->median_ns, r->p99_ns, r->median_ticks, r->ops_per_sec);
+    }
+    Bench_teardown();
+
+    FixStr out_path = cli_opt_get(options, CLI_OUT);
+    FILE *out = fopen(out_path.cstr, "w");
+    if(out == nullptr) {
+        log_message(LL_WARNING, sMSG("Could not write the benchmark results to %.*s"), fmt(out_path));
+        return 1;
+    }
+    Bench_write_json(results, num_results, warmup, out);
+    fclose(out);
+    printf("Benchmark results written to %.*s\n", fmt(out_path));
+
+    if(!options[CLI_COMPARE].is_set) { return 0; }
+
+    FixStr baseline_path = cli_opt_get(options, CLI_COMPARE);
+    FILE *baseline = fopen(baseline_path.cstr, "r");
+    if(baseline == nullptr) {
+        log_message(LL_WARNING, sMSG("Could not read the baseline %.*s"), fmt(baseline_path));
+        return 1;
+    }
+    size_t num_regressed = Bench_compare(results, num_results, baseline, strtod(cli_opt_get(options, CLI_THRESHOLD).cstr, nullptr));
+    fclose(baseline);
+    return num_regressed == 0 ? 0 : 1;
+}
+
+#pragma endregion
+
 #pragma region InterpreterTestMain
 
 int interpreter_member_access_test(void) {
@@ -11738,9 +22162,25 @@ void interpreter_test_main(void) {
     FixArray_test_main();
     FixDict_test_main();
     FixArray_test_main();
+    FixArrayView_test_main();
+    FixIter_test_main();
     // FlxDict_test_main();
     FixScope_test_main();
     FixFn_test_main();
+    FlxDataFrame_test_main();
+    FlxDataFrame_io_test_main();
+    FlxMatrixF_test_main();
+    FlxTensorF_test_main();
+    FlxSampleSink_test_main();
+    FlxParticles_test_main();
+    FixInfer_test_main();
+    FixDist_test_main();
+    FixGen_test_main();
+    FixModelGraph_test_main();
+    FixMemo_test_main();
+    FixPar_test_main();
+    DoubtInstance_test_main();
+    AstCounters_test_main();
 
     interpreter_scope_tests();
     interpreter_member_access_test();
@@ -11764,20 +22204,81 @@ void interpreter_examples_main(int argc, char **argv) {
 
 
 void interpreter_main(int argc, char **argv) {
-    enum {CLI_POSITIONAL = 0, CLI_SOURCE, CLI_HELP, CLI_INDENT, CLI_ENUM_SIZE};
+    enum {
+        CLI_POSITIONAL = 0, CLI_SOURCE, CLI_HELP, CLI_INDENT,
+        CLI_PROFILE, CLI_PROFILE_OUT, CLI_COUNT_NODES, CLI_ALLOC_PROFILE, CLI_ALLOC_PROFILE_OUT,
+        CLI_ENUM_SIZE
+    };
 
     CliOption options[] = {
         [CLI_POSITIONAL] = cli_opt_default(s("--source"), s("main.doubt")),
         [CLI_HELP]   = cli_opt_flag(s("--help")),
         [CLI_INDENT] = cli_opt_default(s("--indent"), s("    ")),
+        [CLI_PROFILE] = cli_opt_flag(s("--profile")),
+        [CLI_PROFILE_OUT] = cli_opt_default(s("--profile-out"), s("doubt.folded")),
+        [CLI_COUNT_NODES] = cli_opt_flag(s("--count-nodes")),
+        [CLI_ALLOC_PROFILE] = cli_opt_flag(s("--alloc-profile")),
+        [CLI_ALLOC_PROFILE_OUT] = cli_opt_default(s("--alloc-profile-out"), s("doubt.alloc.json")),
     };
 
+    cli_parse_opts(options);
     cli_print_opts(options, CLI_ENUM_SIZE);
     /// @todo file reading
     // FixStr source = FixStr_read_file_new(cli_opt_get(options, CLI_POSITIONAL).cstr);
     //
 
+    /// @note --profile samples the run (cf. Profiler): a hot-lines table goes to stdout and
+    ///     ... the collapsed stacks, for a flamegraph, to --profile-out
+    Profiler profiler;
+    bool profiling = options[CLI_PROFILE].is_set
+        && Profiler_start(&profiler, PROFILER_INTERVAL_US, PROFILER_MAX_SAMPLES);
+
+    /// @note --count-nodes counts and times every node evaluated (cf. AstCounters), and
+    ///     ... prints the program annotated with them at exit
+    AstCounters *counters = options[CLI_COUNT_NODES].is_set ? AstCounters_start() : nullptr;
+
+    /// @note --alloc-profile counts allocations per site, allocator and type (cf. AllocProfile)
+    ///     ... and writes them, with each arena's live and peak bytes, to --alloc-profile-out
+    AllocProfile *allocs = options[CLI_ALLOC_PROFILE].is_set ? AllocProfile_start() : nullptr;
+
     interp_run_from_source(ctx_parser(), code_example(1), argc, argv);
+
+    if(profiling) {
+        Profiler_stop(&profiler);
+        Profiler_print_hot_lines(&profiler, ctx_parser()->source.lines, ctx_parser()->source.size, PROFILER_TOP_N);
+
+        FixStr out_path = cli_opt_get(options, CLI_PROFILE_OUT);
+        FILE *out = fopen(out_path.cstr, "w");
+        if(out != nullptr) {
+            Profiler_write_collapsed(&profiler, out);
+            fclose(out);
+            printf("Collapsed stacks written to %.*s\n", fmt(out_path));
+        } else {
+            log_message(LL_WARNING, sMSG("Could not write the profile to %.*s"), fmt(out_path));
+        }
+        Profiler_free(&profiler);
+    }
+
+    if(counters != nullptr) {
+        AstCounters_stop();
+        AstCounters_print_listing(counters, ctx_parser()->source.lines, ctx_parser()->source.size);
+        AstCounters_free(counters);
+    }
+
+    if(allocs != nullptr) {
+        AllocProfile_stop();
+
+        FixStr out_path = cli_opt_get(options, CLI_ALLOC_PROFILE_OUT);
+        FILE *out = fopen(out_path.cstr, "w");
+        if(out != nullptr) {
+            AllocProfile_write_json(allocs, out);
+            fclose(out);
+            printf("Allocation profile written to %.*s\n", fmt(out_path));
+        } else {
+            log_message(LL_WARNING, sMSG("Could not write the allocation profile to %.*s"), fmt(out_path));
+        }
+        AllocProfile_free(allocs);
+    }
 }
 
 
@@ -11788,6 +22289,9 @@ void interpreter_main(int argc, char **argv) {
 int main(int argc, char **argv) {
     GlobalContext_setup();
 
+    #if defined(BENCH)
+        return bench_main(argc, argv);
+    #endif
 
     #if defined(EXAMPLES)
         interpreter_examples_main(argc, argv);